@@ -151,7 +151,7 @@ void MoveOrderer::InitContinuationHistoryPointers(NodeInfo& node)
     }
 }
 
-void MoveOrderer::NewSearch()
+void MoveOrderer::NewSearch(uint32_t rootShift)
 {
     const CounterType scaleDownFactor = 2;
 
@@ -161,7 +161,16 @@ void MoveOrderer::NewSearch()
     for (uint32_t i = 0; i < sizeof(capturesHistory) / sizeof(CounterType); ++i)
         reinterpret_cast<CounterType*>(capturesHistory)[i] /= scaleDownFactor;
 
-    memset(killerMoves, 0, sizeof(killerMoves));
+    if (rootShift > 0 && rootShift <= MaxSearchDepth)
+    {
+        const uint32_t numKeptMoves = MaxSearchDepth + 1 - rootShift;
+        memmove(killerMoves, killerMoves + rootShift, sizeof(Move) * numKeptMoves);
+        memset(killerMoves + numKeptMoves, 0, sizeof(Move) * rootShift);
+    }
+    else
+    {
+        memset(killerMoves, 0, sizeof(killerMoves));
+    }
 }
 
 void MoveOrderer::Clear()
@@ -397,9 +406,9 @@ void MoveOrderer::ScoreMoves(
             // use node cache for scoring moves near the root
             if (nodeCacheEntry && nodeCacheEntry->nodesSum > 512)
             {
-                if (const NodeCacheEntry::MoveInfo* moveInfo = nodeCacheEntry->GetMove(move))
+                if (const uint64_t moveNodes = nodeCacheEntry->GetMoveNodes(move))
                 {
-                    const float fraction = static_cast<float>(moveInfo->nodesSearched) / static_cast<float>(nodeCacheEntry->nodesSum);
+                    const float fraction = static_cast<float>(moveNodes) / static_cast<float>(nodeCacheEntry->nodesSum);
                     ASSERT(fraction >= 0.0f);
                     ASSERT(fraction <= 1.0f);
                     score += static_cast<int32_t>(4096.0f * sqrtf(fraction) * FastLog2(static_cast<float>(nodeCacheEntry->nodesSum) / 512.0f));
@@ -27,7 +27,8 @@ public:
 
     MoveOrderer();
 
-    void NewSearch();
+    // age histories, killer moves are shifted if the new search root is 'rootShift' plies below the previous one
+    void NewSearch(uint32_t rootShift = 0);
     void Clear();
 
     void InitContinuationHistoryPointers(NodeInfo& node);
@@ -4,9 +4,12 @@
 #include "Position.hpp"
 #include "TranspositionTable.hpp"
 #include "Search.hpp"
+#include "Profiler.hpp"
 
 bool MovePicker::PickMove(const NodeInfo& node, Move& outMove, int32_t& outScore)
 {
+    PROFILE_ZONE("MovePicker::PickMove");
+
     switch (m_stage)
     {
         case Stage::TTMove:
@@ -1,5 +1,6 @@
 #include "NeuralNetworkEvaluator.hpp"
 #include "Search.hpp"
+#include "Profiler.hpp"
 
 // enable validation of NN output (check if incremental updates work correctly)
 //#define VALIDATE_NETWORK_OUTPUT
@@ -339,6 +340,8 @@ INLINE static void UpdateAccumulator(const nn::PackedNeuralNetwork& network, con
 template<Color perspective>
 INLINE static void RefreshAccumulator(const nn::PackedNeuralNetwork& network, NodeInfo& node, AccumulatorCache& cache)
 {
+    PROFILE_ZONE("RefreshAccumulator");
+
     constexpr uint32_t color = (uint32_t)perspective;
     const Position& pos = node.position;
 
@@ -395,10 +398,14 @@ INLINE static void RefreshAccumulator(const nn::PackedNeuralNetwork& network, No
         // this way, sibling nodes can reuse parent's accumulator
         UpdateAccumulator<perspective>(network, prevAccumNode, *parentInfo, kingBucketCache);
         UpdateAccumulator<perspective>(network, parentInfo, node, kingBucketCache);
+        cache.numUpdates.store(cache.numUpdates.load(std::memory_order_relaxed) + 2, std::memory_order_relaxed);
     }
     else
     {
         UpdateAccumulator<perspective>(network, prevAccumNode, node, kingBucketCache);
+
+        std::atomic<uint64_t>& counter = prevAccumNode ? cache.numUpdates : cache.numRefreshes;
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
     }
 }
 
@@ -411,6 +418,8 @@ int32_t NNEvaluator::Evaluate(const nn::PackedNeuralNetwork& network, NodeInfo&
     }
 #endif // VALIDATE_NETWORK_OUTPUT
 
+    PROFILE_ZONE("NNEvaluator::Evaluate");
+
     RefreshAccumulator<White>(network, node, cache);
     RefreshAccumulator<Black>(network, node, cache);
 
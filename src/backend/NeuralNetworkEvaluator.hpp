@@ -5,6 +5,8 @@
 #include "Memory.hpp"
 #include "Position.hpp"
 
+#include <atomic>
+
 //#define NN_ACCUMULATOR_STATS
 
 struct DirtyPiece
@@ -54,6 +56,11 @@ struct AccumulatorCache
     KingBucket kingBuckets[2][2 * nn::NumKingBuckets]; // [side to move][king side * king bucket]
     const nn::PackedNeuralNetwork* currentNet = nullptr;
 
+    // number of incremental accumulator updates and full refreshes (from king bucket cache),
+    // written only by the owning thread, but can be read from other threads for monitoring
+    std::atomic<uint64_t> numUpdates = 0;
+    std::atomic<uint64_t> numRefreshes = 0;
+
     void Init(const nn::PackedNeuralNetwork* net);
 };
 
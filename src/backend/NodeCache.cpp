@@ -6,100 +6,125 @@
 
 void NodeCacheEntry::PrintMoves() const
 {
-    std::vector<MoveInfo> sortedMoves;
-
-    uint64_t totalNodesSearched = 0;
-    for (const MoveInfo& info : moves)
+    std::vector<uint32_t> sortedMoves;
+    for (uint32_t i = 0; i < numMoves; ++i)
     {
-        if (!info.move.IsValid()) continue;
-        sortedMoves.push_back(info);
-        totalNodesSearched += info.nodesSearched;
+        sortedMoves.push_back(i);
     }
 
-    std::sort(sortedMoves.begin(), sortedMoves.end(), [](const MoveInfo& a, const MoveInfo& b)
+    std::sort(sortedMoves.begin(), sortedMoves.end(), [this](const uint32_t a, const uint32_t b)
     {
-        return a.nodesSearched >= b.nodesSearched;
+        return moveNodes[a] > moveNodes[b];
     });
 
-    for (const MoveInfo& info : sortedMoves)
+    for (const uint32_t i : sortedMoves)
     {
         std::cout
-            << info.move.ToString() << " "
-            << std::setw(10) << info.nodesSearched
-            << " (" << std::setprecision(4) << (100.0f * static_cast<float>(info.nodesSearched) / static_cast<float>(totalNodesSearched)) << "%)"
+            << moves[i].ToString() << " "
+            << std::setw(10) << moveNodes[i]
+            << " (" << std::setprecision(4) << (100.0f * static_cast<float>(moveNodes[i]) / static_cast<float>(nodesSum)) << "%)"
             << std::endl;
     }
 }
 
+void NodeCacheEntry::Clear()
+{
+    *this = NodeCacheEntry{};
+}
+
 void NodeCacheEntry::ScaleDown()
 {
     nodesSum = 0;
 
-    for (MoveInfo& moveInfo : moves)
+    for (uint32_t i = 0; i < numMoves; ++i)
     {
-        moveInfo.nodesSearched /= 2;
-        nodesSum += moveInfo.nodesSearched;
+        moveNodes[i] /= 2;
+        nodesSum += moveNodes[i];
     }
 }
 
-const NodeCacheEntry::MoveInfo* NodeCacheEntry::GetMove(const Move move) const
+uint64_t NodeCacheEntry::GetMoveNodes(const Move move) const
 {
-    for (const MoveInfo& moveInfo : moves)
+    const PackedMove packedMove(move);
+
+    for (uint32_t i = 0; i < numMoves; ++i)
     {
-        if (moveInfo.move == move)
+        if (moves[i] == packedMove)
         {
-            return &moveInfo;
+            return moveNodes[i];
         }
     }
-    return nullptr;
+
+    return 0;
 }
 
 void NodeCacheEntry::AddMoveStats(const Move& move, uint64_t numNodes)
 {
-    // for replacing least-visited move
-    uint64_t minNodes = UINT64_MAX;
-    uint32_t minNodesMoveIndex = UINT32_MAX;
-
-    bool moveFound = false;
+    const PackedMove packedMove(move);
 
-    for (uint32_t i = 0; i < MaxMoves; ++i)
+    uint32_t index = 0;
+    while (index < numMoves && moves[index] != packedMove)
     {
-        MoveInfo& moveInfo = moves[i];
+        index++;
+    }
 
-        if (moveInfo.move == move)
+    if (index == numMoves)
+    {
+        if (numMoves < MaxMoves)
         {
-            moveInfo.nodesSearched += numNodes;
-            nodesSum += numNodes;
-            moveFound = true;
-
-            // scale down to avoid overflow
-            if (moveInfo.nodesSearched >= UINT64_MAX / MaxMoves)
+            // append new move
+            moves[numMoves] = packedMove;
+            moveNodes[numMoves] = 0;
+            numMoves++;
+        }
+        else
+        {
+            // replace move with least amount of visits
+            index = 0;
+            for (uint32_t i = 1; i < MaxMoves; ++i)
             {
-                ScaleDown();
+                if (moveNodes[i] < moveNodes[index]) index = i;
             }
 
-            break;
-        }
+            if (moveNodes[index] >= numNodes)
+            {
+                return;
+            }
 
-        if (!moveInfo.move.IsValid() ||
-            (moveInfo.nodesSearched < minNodes && moveInfo.nodesSearched < numNodes))
-        {
-            minNodes = moveInfo.nodesSearched;
-            minNodesMoveIndex = i;
+            nodesSum -= moveNodes[index];
+            moves[index] = packedMove;
+            moveNodes[index] = 0;
         }
     }
 
-    // if no existing move found, replace move with least amount of visits
-    if (!moveFound && minNodesMoveIndex < MaxMoves)
+    // scale down to avoid overflow
+    while (numNodes > UINT32_MAX - static_cast<uint64_t>(moveNodes[index]))
     {
-        MoveInfo& moveInfo = moves[minNodesMoveIndex];
+        ScaleDown();
+        numNodes /= 2;
+    }
 
-        nodesSum -= moveInfo.nodesSearched;
-        nodesSum += numNodes;
-        
-        moveInfo.move = move;
-        moveInfo.nodesSearched = numNodes;
+    moveNodes[index] += static_cast<uint32_t>(numNodes);
+    nodesSum += numNodes;
+}
+
+NodeCache::NodeCache()
+{
+    Resize(DefaultSize);
+}
+
+void NodeCache::Resize(size_t sizeInBytes)
+{
+    const size_t numEntries = std::max<size_t>(NumWays, sizeInBytes / sizeof(NodeCacheEntry) / NumWays * NumWays);
+
+    if (entries.size() != numEntries)
+    {
+        entries.clear();
+        entries.shrink_to_fit();
+        entries.resize(numEntries);
     }
+
+    Reset();
 }
 
 void NodeCache::Reset()
@@ -107,7 +132,7 @@ void NodeCache::Reset()
     generation = 0;
     for (NodeCacheEntry& entry : entries)
     {
-        entry = NodeCacheEntry{};
+        entry.Clear();
     }
 }
 
@@ -116,46 +141,128 @@ void NodeCache::OnNewSearch()
     generation++;
 }
 
+void NodeCache::OnNewSearch(const Position& newRoot, uint32_t rootShift)
+{
+    generation++;
+
+    if (rootShift > 0)
+    {
+        ReRootSubtree(newRoot, 0, rootShift);
+    }
+}
+
+void NodeCache::ReRootSubtree(const Position& pos, uint32_t distanceFromRoot, uint32_t rootShift)
+{
+    if (!ShouldCache(distanceFromRoot))
+    {
+        return;
+    }
+
+    const uint64_t hash = pos.GetHash();
+    NodeCacheEntry* bucket = entries.data() + GetBucketIndex(hash);
+
+    // only entries from the previous search that were searched below the previous root are re-rooted
+    // (entries already re-rooted via a transposition are skipped)
+    NodeCacheEntry* entry = nullptr;
+    for (uint32_t i = 0; i < NumWays; ++i)
+    {
+        if (bucket[i].key == hash &&
+            bucket[i].generation + 1 == generation &&
+            bucket[i].distanceFromRoot == distanceFromRoot + rootShift)
+        {
+            entry = bucket + i;
+            break;
+        }
+    }
+
+    if (!entry)
+    {
+        return;
+    }
+
+    entry->generation = generation;
+    entry->distanceFromRoot = static_cast<uint16_t>(distanceFromRoot);
+
+    for (uint32_t i = 0; i < entry->numMoves; ++i)
+    {
+        // moves are validated, because the entry may be a hash collision
+        const Move move = pos.MoveFromPacked(entry->moves[i]);
+        if (!move.IsValid() || !pos.IsMoveLegal(move))
+        {
+            continue;
+        }
+
+        Position childPos = pos;
+        if (childPos.DoMove(move))
+        {
+            ReRootSubtree(childPos, distanceFromRoot + 1, rootShift);
+        }
+    }
+}
+
 const NodeCacheEntry* NodeCache::TryGetEntry(const Position& pos) const
 {
-    const uint32_t index = pos.GetHash() % Size;
-    const NodeCacheEntry* entry = entries + index;
+    const uint64_t hash = pos.GetHash();
+    const NodeCacheEntry* bucket = entries.data() + GetBucketIndex(hash);
 
-    if (entry->position == pos)
+    for (uint32_t i = 0; i < NumWays; ++i)
     {
-        return entry;
+        if (bucket[i].key == hash && bucket[i].generation > 0)
+        {
+            return bucket + i;
+        }
     }
 
     return nullptr;
 }
 
-
 NodeCacheEntry* NodeCache::GetEntry(const Position& pos, uint32_t distanceFromRoot)
 {
-    const uint32_t index = pos.GetHash() % Size;
-    NodeCacheEntry* entry = entries + index;
+    const uint64_t hash = pos.GetHash();
+    NodeCacheEntry* bucket = entries.data() + GetBucketIndex(hash);
 
     // return existing entry
-    if (entry->position == pos)
+    for (uint32_t i = 0; i < NumWays; ++i)
     {
-        entry->generation = generation;
-        entry->distanceFromRoot = distanceFromRoot;
-
-        return entry;
+        NodeCacheEntry& entry = bucket[i];
+        if (entry.key == hash && entry.generation > 0)
+        {
+            entry.generation = generation;
+            entry.distanceFromRoot = static_cast<uint16_t>(distanceFromRoot);
+            return &entry;
+        }
     }
 
-    // allocate new entry
-    if (entry->generation < generation)
+    // find replacement candidate:
+    // entries from previous searches are replaced first, then entries further from the root than the new one
+    NodeCacheEntry* replacedEntry = nullptr;
+    for (uint32_t i = 0; i < NumWays; ++i)
     {
-        *entry = NodeCacheEntry{};
-        entry->position = pos;
-        entry->generation = generation;
-        entry->distanceFromRoot = distanceFromRoot;
+        NodeCacheEntry& entry = bucket[i];
+        if (entry.generation < generation)
+        {
+            if (!replacedEntry || replacedEntry->generation == generation || entry.generation < replacedEntry->generation)
+            {
+                replacedEntry = &entry;
+            }
+        }
+        else if (entry.distanceFromRoot > distanceFromRoot)
+        {
+            if (!replacedEntry || (replacedEntry->generation == generation && entry.distanceFromRoot > replacedEntry->distanceFromRoot))
+            {
+                replacedEntry = &entry;
+            }
+        }
+    }
 
-        return entry;
+    if (replacedEntry)
+    {
+        replacedEntry->Clear();
+        replacedEntry->key = hash;
+        replacedEntry->generation = generation;
+        replacedEntry->distanceFromRoot = static_cast<uint16_t>(distanceFromRoot);
     }
 
-    // allocation failed
-    // TODO try other entry index
-    return nullptr;
+    // Note: allocation fails if all entries in the bucket are used by nodes closer to the root
+    return replacedEntry;
 }
@@ -2,49 +2,81 @@
 
 #include "Position.hpp"
 #include "Move.hpp"
+#include "Memory.hpp"
+#include "Math.hpp"
 
 #include <vector>
 #include <atomic>
 
-struct NodeCacheEntry
+// Per-position statistics of nodes searched under each move, used for time management and move ordering.
+// Moves and node counts are stored in separate arrays, so searching for a move scans a single cacheline.
+struct alignas(CACHELINE_SIZE) NodeCacheEntry
 {
-    struct MoveInfo
-    {
-        Move move = Move::Invalid();
-        uint64_t nodesSearched = 0;
-    };
-
     static constexpr uint32_t MaxMoves = 32;
 
-    uint32_t generation = 0;
-    uint32_t distanceFromRoot = 0;
+    PackedMove moves[MaxMoves] = {};        // first cacheline
+    uint64_t key = 0;                       // full position hash
     uint64_t nodesSum = 0;
+    uint32_t generation = 0;
+    uint16_t distanceFromRoot = 0;
+    uint16_t numMoves = 0;
+    uint32_t moveNodes[MaxMoves] = {};      // number of nodes searched under the move (scaled down on overflow)
 
-    Position position;
-    MoveInfo moves[MaxMoves];
-
-    const MoveInfo* GetMove(const Move move) const;
+    // returns number of nodes searched under a move, zero if the move is not in the entry
+    uint64_t GetMoveNodes(const Move move) const;
 
+    void Clear();
     void ScaleDown();
     void AddMoveStats(const Move& move, uint64_t numNodes);
     void PrintMoves() const;
 };
 
+static_assert(sizeof(NodeCacheEntry) == 4 * CACHELINE_SIZE, "Unexpected node cache entry size");
+
 class NodeCache
 {
 public:
 
+    static constexpr size_t DefaultSize = 256 * 1024;
+    static constexpr uint32_t DefaultMaxDistanceFromRoot = 3;
+
+    NodeCache();
+
+    // resize (in bytes) and clear the cache
+    void Resize(size_t sizeInBytes);
+
+    // maximum distance from the root for which nodes are cached
+    void SetMaxDistanceFromRoot(uint32_t distance) { maxDistanceFromRoot = distance; }
+    INLINE bool ShouldCache(uint32_t distanceFromRoot) const { return distanceFromRoot < maxDistanceFromRoot; }
+
+    size_t GetSize() const { return entries.size() * sizeof(NodeCacheEntry); }
+
     void Reset();
+
+    // mark all entries as old, so they can be replaced
     void OnNewSearch();
 
+    // same as above, but entries of the subtree of the new root (reached from the previous root in 'rootShift' plies)
+    // are kept and re-rooted
+    void OnNewSearch(const Position& newRoot, uint32_t rootShift);
+
     const NodeCacheEntry* TryGetEntry(const Position& pos) const;
     NodeCacheEntry* GetEntry(const Position& pos, uint32_t distanceFromRoot);
 
 private:
 
-    static constexpr uint32_t Size = 256;
+    // each position can be stored in one of the entries in a bucket
+    static constexpr uint32_t NumWays = 2;
 
     uint32_t generation = 0;
+    uint32_t maxDistanceFromRoot = DefaultMaxDistanceFromRoot;
+
+    std::vector<NodeCacheEntry, AlignmentAllocator<NodeCacheEntry, CACHELINE_SIZE>> entries;
+
+    INLINE size_t GetBucketIndex(uint64_t hash) const
+    {
+        return static_cast<size_t>(MulHi64(hash, entries.size() / NumWays)) * NumWays;
+    }
 
-    NodeCacheEntry entries[Size];
+    void ReRootSubtree(const Position& pos, uint32_t distanceFromRoot, uint32_t rootShift);
 };
@@ -0,0 +1,316 @@
+#include "OpeningBook.hpp"
+#include "Position.hpp"
+#include "MoveList.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+#if defined(PLATFORM_LINUX)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif // PLATFORM_LINUX
+
+static_assert(sizeof(OpeningBook::Header) % alignof(OpeningBookEntry) == 0, "Book entries must be aligned");
+
+OpeningBook::~OpeningBook()
+{
+    Release();
+}
+
+void OpeningBook::Release()
+{
+#if defined(PLATFORM_WINDOWS)
+    if (mMappedData)
+    {
+        UnmapViewOfFile(mMappedData);
+    }
+
+    if (mFileMapping != INVALID_HANDLE_VALUE && mFileMapping != NULL)
+    {
+        CloseHandle(mFileMapping);
+        mFileMapping = INVALID_HANDLE_VALUE;
+    }
+
+    if (mFileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(mFileHandle);
+        mFileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (mMappedData)
+    {
+        if (0 != munmap(mMappedData, mMappedSize))
+        {
+            perror("munmap");
+        }
+    }
+
+    if (mFileDesc != -1)
+    {
+        close(mFileDesc);
+        mFileDesc = -1;
+    }
+#endif // PLATFORM_WINDOWS
+
+    mMappedData = nullptr;
+    mMappedSize = 0;
+    mEntries = nullptr;
+    mNumEntries = 0;
+}
+
+bool OpeningBook::LoadFromFile(const char* filePath)
+{
+    Release();
+
+#if defined(PLATFORM_WINDOWS)
+
+    DWORD sizeLow = 0, sizeHigh = 0;
+
+#ifdef _UNICODE
+    wchar_t wideFilePath[4096];
+    size_t len = 0;
+    mbstowcs_s(&len, wideFilePath, 4096, filePath, _TRUNCATE);
+    mFileHandle = ::CreateFile(wideFilePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+#else
+    mFileHandle = ::CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+#endif
+
+    if (mFileHandle == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "CreateFile() failed, error = %lu.\n", GetLastError());
+        Release();
+        return false;
+    }
+
+    sizeLow = ::GetFileSize(mFileHandle, &sizeHigh);
+    mMappedSize = (uint64_t)sizeLow + ((uint64_t)sizeHigh << 32);
+
+    if (mMappedSize < sizeof(Header))
+    {
+        std::cerr << "Failed to load opening book: " << "file too small" << std::endl;
+        Release();
+        return false;
+    }
+
+    mFileMapping = ::CreateFileMapping(mFileHandle, NULL, PAGE_READONLY, sizeHigh, sizeLow, NULL);
+    if (mFileMapping == NULL)
+    {
+        fprintf(stderr, "CreateFileMapping() failed, error = %lu.\n", GetLastError());
+        Release();
+        return false;
+    }
+
+    mMappedData = (void*)MapViewOfFile(mFileMapping, FILE_MAP_READ, 0, 0, 0);
+    if (mMappedData == nullptr)
+    {
+        fprintf(stderr, "MapViewOfFile() failed, error = %lu.\n", GetLastError());
+        Release();
+        return false;
+    }
+
+#else
+
+    mFileDesc = open(filePath, O_RDONLY);
+    if (mFileDesc == -1)
+    {
+        perror("open");
+        Release();
+        return false;
+    }
+
+    struct stat statbuf;
+    if (fstat(mFileDesc, &statbuf))
+    {
+        perror("fstat");
+        Release();
+        return false;
+    }
+
+    if (static_cast<size_t>(statbuf.st_size) < sizeof(Header))
+    {
+        std::cerr << "Failed to load opening book: " << "file too small" << std::endl;
+        Release();
+        return false;
+    }
+
+    mMappedSize = statbuf.st_size;
+    mMappedData = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, mFileDesc, 0);
+    if (mMappedData == MAP_FAILED)
+    {
+        perror("mmap");
+        mMappedData = nullptr;
+        Release();
+        return false;
+    }
+
+#endif // PLATFORM_WINDOWS
+
+    Header header;
+    memcpy(&header, mMappedData, sizeof(Header));
+
+    if (header.magic != MagicNumber)
+    {
+        std::cerr << "Failed to load opening book: " << "invalid magic" << std::endl;
+        Release();
+        return false;
+    }
+
+    if (header.version != CurrentVersion)
+    {
+        std::cerr << "Failed to load opening book: " << "unsupported version" << std::endl;
+        Release();
+        return false;
+    }
+
+    if (header.zobristSignature != GetZobristSignature())
+    {
+        std::cerr << "Failed to load opening book: " << "position hash keys mismatch" << std::endl;
+        Release();
+        return false;
+    }
+
+    if (header.numEntries == 0 || header.numEntries > (mMappedSize - sizeof(Header)) / sizeof(OpeningBookEntry))
+    {
+        std::cerr << "Failed to load opening book: " << "invalid number of entries" << std::endl;
+        Release();
+        return false;
+    }
+
+    mEntries = reinterpret_cast<const OpeningBookEntry*>(reinterpret_cast<const uint8_t*>(mMappedData) + sizeof(Header));
+    mNumEntries = header.numEntries;
+
+    return true;
+}
+
+uint32_t OpeningBook::GetEntries(const Position& pos, const OpeningBookEntry*& outEntries) const
+{
+    if (!mEntries)
+    {
+        return 0;
+    }
+
+    const uint64_t hash = pos.GetHash();
+
+    // branchless lower bound search (the comparison compiles to conditional move)
+    const OpeningBookEntry* base = mEntries;
+    uint64_t size = mNumEntries;
+    while (size > 1)
+    {
+        const uint64_t half = size / 2;
+        base = (base[half - 1].hash < hash) ? (base + half) : base;
+        size -= half;
+    }
+    base += (base->hash < hash);
+
+    const OpeningBookEntry* end = mEntries + mNumEntries;
+    const OpeningBookEntry* last = base;
+    while (last < end && last->hash == hash)
+    {
+        last++;
+    }
+
+    outEntries = base;
+    return static_cast<uint32_t>(last - base);
+}
+
+bool OpeningBook::Probe(const Position& pos, Move& outMove, bool randomize, const OpeningBookEntry** outEntry) const
+{
+    const OpeningBookEntry* entries = nullptr;
+    const uint32_t numEntries = GetEntries(pos, entries);
+
+    // gather legal moves only (hash collisions are possible)
+    uint32_t numMoves = 0;
+    Move moves[MoveList::MaxMoves];
+    const OpeningBookEntry* movesEntries[MoveList::MaxMoves];
+    uint64_t totalWeight = 0;
+
+    for (uint32_t i = 0; i < numEntries && numMoves < MoveList::MaxMoves; ++i)
+    {
+        const Move move = pos.MoveFromPacked(entries[i].move);
+        if (move.IsValid() && pos.IsMoveLegal(move) && entries[i].weight > 0)
+        {
+            moves[numMoves] = move;
+            movesEntries[numMoves] = entries + i;
+            numMoves++;
+            totalWeight += entries[i].weight;
+        }
+    }
+
+    if (numMoves == 0)
+    {
+        return false;
+    }
+
+    // entries are sorted by weight, so the first one is the best
+    uint32_t selected = 0;
+
+    if (randomize)
+    {
+        thread_local std::mt19937_64 randomGenerator{ std::random_device{}() };
+        uint64_t value = std::uniform_int_distribution<uint64_t>(0, totalWeight - 1)(randomGenerator);
+        for (selected = 0; selected + 1 < numMoves; ++selected)
+        {
+            if (value < movesEntries[selected]->weight) break;
+            value -= movesEntries[selected]->weight;
+        }
+    }
+
+    outMove = moves[selected];
+    if (outEntry)
+    {
+        *outEntry = movesEntries[selected];
+    }
+
+    return true;
+}
+
+uint64_t OpeningBook::GetZobristSignature()
+{
+    // initial position hash covers piece and castling rights keys
+    return Position(Position::InitPositionFEN).GetHash();
+}
+
+bool OpeningBook::SaveToFile(const char* filePath, std::vector<OpeningBookEntry>& entries)
+{
+    std::sort(entries.begin(), entries.end(), [](const OpeningBookEntry& a, const OpeningBookEntry& b)
+    {
+        if (a.hash != b.hash) return a.hash < b.hash;
+        if (a.weight != b.weight) return a.weight > b.weight;
+        return a.move.value < b.move.value;
+    });
+
+    FILE* file = fopen(filePath, "wb");
+    if (!file)
+    {
+        std::cerr << "Failed to save opening book: " << "cannot open file" << std::endl;
+        return false;
+    }
+
+    const Header header = { MagicNumber, CurrentVersion, entries.size(), GetZobristSignature() };
+
+    if (1 != fwrite(&header, sizeof(Header), 1, file))
+    {
+        fclose(file);
+        std::cerr << "Failed to save opening book: " << "cannot write header" << std::endl;
+        return false;
+    }
+
+    if (!entries.empty() && entries.size() != fwrite(entries.data(), sizeof(OpeningBookEntry), entries.size(), file))
+    {
+        fclose(file);
+        std::cerr << "Failed to save opening book: " << "cannot write entries" << std::endl;
+        return false;
+    }
+
+    // buffered data is flushed on close, so write errors may be reported only here
+    if (fclose(file) != 0)
+    {
+        std::cerr << "Failed to save opening book: " << "cannot flush file" << std::endl;
+        return false;
+    }
+
+    return true;
+}
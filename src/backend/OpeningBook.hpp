@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Move.hpp"
+
+#include <vector>
+
+#if defined(PLATFORM_WINDOWS)
+    #define WIN32_LEAN_AND_MEAN
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif // NOMINMAX
+    #include <Windows.h>
+#endif // PLATFORM_WINDOWS
+
+struct OpeningBookEntry
+{
+    uint64_t hash;          // position hash
+    PackedMove move;
+    uint16_t weight;        // relative move weight (higher is better)
+    int16_t score;          // average game result for the side to move, in permills (-1000...1000)
+    uint16_t padding;
+};
+
+static_assert(sizeof(OpeningBookEntry) == 16, "Invalid opening book entry size");
+
+/**
+ * @brief Opening book stored as an array of entries sorted by position hash (and by weight within a position).
+ * @remarks The book file is memory-mapped, so it's shared between engine instances and loaded lazily by the OS.
+ *          File layout: [Header][OpeningBookEntry 0]...[OpeningBookEntry N-1]
+ */
+class OpeningBook
+{
+public:
+    static constexpr uint32_t MagicNumber = 'CBOK';
+    static constexpr uint32_t CurrentVersion = 2;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t numEntries;
+        uint64_t zobristSignature;  // books are keyed by position hashes, so they're valid only for the same Zobrist keys
+    };
+
+    static_assert(sizeof(Header) == 24, "Invalid opening book header size");
+
+    OpeningBook() = default;
+    ~OpeningBook();
+
+    bool LoadFromFile(const char* filePath);
+    void Release();
+
+    bool IsLoaded() const { return mEntries != nullptr; }
+    uint64_t GetNumEntries() const { return mNumEntries; }
+
+    // get all moves stored for given position, returns number of entries
+    uint32_t GetEntries(const Position& pos, const OpeningBookEntry*& outEntries) const;
+
+    // pick a legal book move for given position
+    // if 'randomize' is set, the move is chosen randomly with probability proportional to its weight,
+    // otherwise the move with the highest weight is returned
+    bool Probe(const Position& pos, Move& outMove, bool randomize = false, const OpeningBookEntry** outEntry = nullptr) const;
+
+    // sort entries and write them to a book file
+    static bool SaveToFile(const char* filePath, std::vector<OpeningBookEntry>& entries);
+
+    // identifies Zobrist keys used to compute position hashes
+    static uint64_t GetZobristSignature();
+
+private:
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator = (const OpeningBook&) = delete;
+
+    const OpeningBookEntry* mEntries = nullptr;
+    uint64_t mNumEntries = 0;
+
+#if defined(PLATFORM_WINDOWS)
+    HANDLE mFileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mFileMapping = INVALID_HANDLE_VALUE;
+#else
+    int mFileDesc = -1;
+#endif // PLATFORM_WINDOWS
+
+    void* mMappedData = nullptr;
+    size_t mMappedSize = 0;
+};
@@ -34,9 +34,11 @@ INLINE static int32_t m256_hadd(__m256i a)
 #ifdef USE_AVX512
 INLINE static int32_t m512_hadd(__m512i v)
 {
+    // zero-masked extracts with a full mask: same instruction, but GCC's unmasked variants pass
+    // _mm256_undefined_si256() through and trip -Wuninitialized once inlined under LTO
     const __m256i sum256 = _mm256_add_epi32(
-        _mm512_castsi512_si256(v),
-        _mm512_extracti64x4_epi64(v, 1));
+        _mm512_maskz_extracti64x4_epi64(0xFF, v, 0),
+        _mm512_maskz_extracti64x4_epi64(0xFF, v, 1));
     return m256_hadd(sum256);
 }
 #endif // USE_AVX512
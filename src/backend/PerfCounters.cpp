@@ -0,0 +1,257 @@
+#include "PerfCounters.hpp"
+
+#if defined(PLATFORM_LINUX)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#endif // PLATFORM_LINUX
+
+const char* PerfCounterTypeToString(PerfCounterType type)
+{
+    switch (type)
+    {
+    case PerfCounterType::Cycles:       return "cycles";
+    case PerfCounterType::Instructions: return "instructions";
+    case PerfCounterType::L1DMisses:    return "l1dMisses";
+    case PerfCounterType::LLCMisses:    return "llcMisses";
+    case PerfCounterType::BranchMisses: return "branchMisses";
+    case PerfCounterType::DTLBMisses:   return "dtlbMisses";
+    default:                            return "unknown";
+    }
+}
+
+double PerfCounterValues::GetIPC() const
+{
+    if (!IsValid(PerfCounterType::Cycles) || !IsValid(PerfCounterType::Instructions) || Get(PerfCounterType::Cycles) == 0)
+    {
+        return -1.0;
+    }
+
+    return static_cast<double>(Get(PerfCounterType::Instructions)) / static_cast<double>(Get(PerfCounterType::Cycles));
+}
+
+double PerfCounterValues::GetPerKiloInstructions(PerfCounterType type) const
+{
+    if (!IsValid(type) || !IsValid(PerfCounterType::Instructions) || Get(PerfCounterType::Instructions) == 0)
+    {
+        return -1.0;
+    }
+
+    return 1000.0 * static_cast<double>(Get(type)) / static_cast<double>(Get(PerfCounterType::Instructions));
+}
+
+PerfCounterValues& PerfCounterValues::operator+=(const PerfCounterValues& rhs)
+{
+    for (uint32_t i = 0; i < NumPerfCounterTypes; ++i)
+    {
+        values[i] += rhs.values[i];
+        valid[i] = valid[i] || rhs.valid[i];
+    }
+    return *this;
+}
+
+void PerfCounterValues::Print() const
+{
+    const auto printValue = [](const char* name, double value)
+    {
+        if (value >= 0.0)
+        {
+            printf(" %s: %.3f", name, value);
+        }
+        else
+        {
+            printf(" %s: n/a", name);
+        }
+    };
+
+    printValue("IPC", GetIPC());
+    printValue("L1D MPKI", GetPerKiloInstructions(PerfCounterType::L1DMisses));
+    printValue("LLC MPKI", GetPerKiloInstructions(PerfCounterType::LLCMisses));
+    printValue("Branch MPKI", GetPerKiloInstructions(PerfCounterType::BranchMisses));
+    printValue("dTLB MPKI", GetPerKiloInstructions(PerfCounterType::DTLBMisses));
+    printf("\n");
+}
+
+#if defined(PLATFORM_LINUX)
+
+static bool GetPerfEventConfig(PerfCounterType type, perf_event_attr& attr)
+{
+    const auto cacheConfig = [](uint64_t cache, uint64_t op, uint64_t result)
+    {
+        return cache | (op << 8) | (result << 16);
+    };
+
+    switch (type)
+    {
+    case PerfCounterType::Cycles:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        return true;
+    case PerfCounterType::Instructions:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        return true;
+    case PerfCounterType::L1DMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+        return true;
+    case PerfCounterType::LLCMisses:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        return true;
+    case PerfCounterType::BranchMisses:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        return true;
+    case PerfCounterType::DTLBMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+        return true;
+    default:
+        return false;
+    }
+}
+
+PerfCounters::PerfCounters()
+{
+    for (int& fd : mFileDescs)
+    {
+        fd = -1;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int& fd : mFileDescs)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+bool PerfCounters::Init()
+{
+    for (uint32_t i = 0; i < NumPerfCounterTypes; ++i)
+    {
+        if (mFileDescs[i] >= 0)
+        {
+            continue;
+        }
+
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // counters may be multiplexed if there are not enough hardware counters, so read enabled/running times for scaling
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        if (!GetPerfEventConfig(static_cast<PerfCounterType>(i), attr))
+        {
+            continue;
+        }
+
+        // count only the calling thread on any CPU
+        mFileDescs[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    return IsAvailable();
+}
+
+bool PerfCounters::IsAvailable() const
+{
+    for (const int fd : mFileDescs)
+    {
+        if (fd >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::Start()
+{
+    for (const int fd : mFileDescs)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfCounterValues PerfCounters::Stop()
+{
+    PerfCounterValues result;
+
+    for (const int fd : mFileDescs)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    for (uint32_t i = 0; i < NumPerfCounterTypes; ++i)
+    {
+        if (mFileDescs[i] < 0)
+        {
+            continue;
+        }
+
+        // value, time enabled, time running
+        uint64_t data[3] = {};
+        if (read(mFileDescs[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+        {
+            continue;
+        }
+
+        result.values[i] = data[2] < data[1] ?
+            static_cast<uint64_t>(static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2])) :
+            data[0];
+        result.valid[i] = true;
+    }
+
+    return result;
+}
+
+#else // !PLATFORM_LINUX
+
+PerfCounters::PerfCounters()
+{
+    for (int& fd : mFileDescs)
+    {
+        fd = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::Init()
+{
+    return false;
+}
+
+bool PerfCounters::IsAvailable() const
+{
+    return false;
+}
+
+void PerfCounters::Start()
+{
+}
+
+PerfCounterValues PerfCounters::Stop()
+{
+    return {};
+}
+
+#endif // PLATFORM_LINUX
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Common.hpp"
+
+enum class PerfCounterType : uint8_t
+{
+    Cycles,
+    Instructions,
+    L1DMisses,
+    LLCMisses,
+    BranchMisses,
+    DTLBMisses,
+
+    Count
+};
+
+static constexpr uint32_t NumPerfCounterTypes = static_cast<uint32_t>(PerfCounterType::Count);
+
+const char* PerfCounterTypeToString(PerfCounterType type);
+
+struct PerfCounterValues
+{
+    uint64_t values[NumPerfCounterTypes] = {};
+    bool valid[NumPerfCounterTypes] = {};
+
+    uint64_t Get(PerfCounterType type) const { return values[static_cast<uint32_t>(type)]; }
+    bool IsValid(PerfCounterType type) const { return valid[static_cast<uint32_t>(type)]; }
+
+    // instructions per cycle, negative if not available
+    double GetIPC() const;
+
+    // number of events per 1000 instructions, negative if not available
+    double GetPerKiloInstructions(PerfCounterType type) const;
+
+    PerfCounterValues& operator+=(const PerfCounterValues& rhs);
+
+    // print single line summary: IPC and miss rates
+    void Print() const;
+};
+
+/**
+ * @brief Hardware performance counters of the calling thread.
+ * @remarks Uses perf_event_open on Linux. Counters that can't be opened (no PMU access, virtual machine,
+ *          restrictive perf_event_paranoid) are marked as invalid and reported as "n/a".
+ *          On other platforms no counters are available.
+ */
+class PerfCounters final
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    // open counters, returns false if none of the counters is available
+    bool Init();
+
+    bool IsAvailable() const;
+
+    // reset and start counting
+    void Start();
+
+    // stop counting and read counter values
+    PerfCounterValues Stop();
+
+private:
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    int mFileDescs[NumPerfCounterTypes];
+};
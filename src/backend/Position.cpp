@@ -46,6 +46,57 @@ uint64_t Position::ComputeHash() const
     return hash;
 }
 
+uint32_t Position::ComputeMaterialHash() const
+{
+    uint32_t hash = 0;
+
+    for (Color color = 0; color < 2; ++color)
+    {
+        for (Piece piece = Piece::Pawn; piece < Piece::King; piece = NextPiece(piece))
+        {
+            const uint32_t count = GetSide(color).GetPieceBitBoard(piece).Count();
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                hash ^= static_cast<uint32_t>(GetMaterialZobristHash(color, piece, i));
+            }
+        }
+    }
+
+    return hash;
+}
+
+uint32_t Position::ComputeNonPawnsHash() const
+{
+    uint32_t hash = 0;
+
+    for (Color color = 0; color < 2; ++color)
+    {
+        for (const Piece piece : { Piece::Knight, Piece::Bishop, Piece::Rook, Piece::Queen, Piece::King })
+        {
+            GetSide(color).GetPieceBitBoard(piece).Iterate([&](uint32_t square) INLINE_LAMBDA
+            {
+                hash ^= static_cast<uint32_t>(GetPieceZobristHash(color, piece, square));
+            });
+        }
+    }
+
+    return hash;
+}
+
+void Position::ComputeHashes()
+{
+    mHash = ComputeHash();
+    mPawnsHash = 0;
+
+    for (Color color = 0; color < 2; ++color)
+    {
+        mColors[color].pawns.Iterate([&](uint32_t square) INLINE_LAMBDA { mPawnsHash ^= GetPieceZobristHash(color, Piece::Pawn, square); });
+    }
+
+    mMaterialHash = ComputeMaterialHash();
+    mNonPawnsHash = ComputeNonPawnsHash();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Position::Position()
@@ -56,6 +107,8 @@ Position::Position()
     , mMoveCount(1u)
     , mHash(0u)
     , mPawnsHash(0u)
+    , mMaterialHash(0u)
+    , mNonPawnsHash(0u)
 {}
 
 void Position::SetPiece(const Square square, const Piece piece, const Color color)
@@ -75,11 +128,15 @@ void Position::SetPiece(const Square square, const Piece piece, const Color colo
     ASSERT((pos.king & mask) == 0);
     ASSERT(pos.pieces[square.Index()] == Piece::None);
 
+    Bitboard& targetBitboard = pos.GetPieceBitBoard(piece);
+
     const uint64_t pieceHash = GetPieceZobristHash(color, piece, square.Index());
     mHash ^= pieceHash;
     if (piece == Piece::Pawn) mPawnsHash ^= pieceHash;
+    else mNonPawnsHash ^= static_cast<uint32_t>(pieceHash);
+    if (piece != Piece::King) mMaterialHash ^= static_cast<uint32_t>(GetMaterialZobristHash(color, piece, targetBitboard.Count()));
 
-    pos.GetPieceBitBoard(piece) |= mask;
+    targetBitboard |= mask;
     pos.pieces[square.Index()] = piece;
 }
 
@@ -98,6 +155,8 @@ void Position::RemovePiece(const Square square, const Piece piece, const Color c
     const uint64_t pieceHash = GetPieceZobristHash(color, piece, square.Index());
     mHash ^= pieceHash;
     if (piece == Piece::Pawn) mPawnsHash ^= pieceHash;
+    else mNonPawnsHash ^= static_cast<uint32_t>(pieceHash);
+    if (piece != Piece::King) mMaterialHash ^= static_cast<uint32_t>(GetMaterialZobristHash(color, piece, targetBitboard.Count()));
 }
 
 uint64_t Position::HashAfterMove(const Move move) const
@@ -106,8 +165,10 @@ uint64_t Position::HashAfterMove(const Move move) const
 
     uint64_t hash = mHash ^ c_SideToMoveZobristHash;
 
+    // Note: en passant, castling rights and castling rook movement are ignored, so the hash is exact only for most common moves
+    const Piece targetPiece = move.GetPromoteTo() != Piece::None ? move.GetPromoteTo() : move.GetPiece();
     hash ^= GetPieceZobristHash(mSideToMove, move.GetPiece(), move.FromSquare().Index());
-    hash ^= GetPieceZobristHash(mSideToMove, move.GetPiece(), move.ToSquare().Index());
+    hash ^= GetPieceZobristHash(mSideToMove, targetPiece, move.ToSquare().Index());
 
     if (move.IsCapture() && !move.IsEnPassant())
     {
@@ -613,8 +674,10 @@ bool Position::DoMove(const Move& move, NNEvaluatorContext& nnContext)
     // board position after the move must be valid
     ASSERT(IsValid());
 
-    // validate hash
+    // validate hashes
     ASSERT(ComputeHash() == GetHash());
+    ASSERT(ComputeMaterialHash() == GetMaterialHash());
+    ASSERT(ComputeNonPawnsHash() == GetNonPawnsHash());
 
     ASSERT(nnContext.numDirtyPieces > 0 && nnContext.numDirtyPieces <= MaxNumDirtyPieces);
 
@@ -688,6 +751,8 @@ Position Position::SwappedColors() const
     result.mHalfMoveCount           = mHalfMoveCount;
     result.mHash                    = 0;
     result.mPawnsHash               = 0;
+    result.mMaterialHash            = 0;
+    result.mNonPawnsHash            = 0;
 
     return result;
 }
@@ -711,8 +776,7 @@ void Position::MirrorVertically()
     mCastlingRights[0] = 0;
     mCastlingRights[1] = 0;
 
-    mHash = ComputeHash();
-    mPawnsHash = 0; // TODO
+    ComputeHashes();
 }
 
 void Position::MirrorHorizontally()
@@ -734,8 +798,7 @@ void Position::MirrorHorizontally()
     mCastlingRights[0] = ReverseBits(mCastlingRights[0]);
     mCastlingRights[1] = ReverseBits(mCastlingRights[1]);
 
-    mHash = ComputeHash();
-    mPawnsHash = 0; // TODO
+    ComputeHashes();
 }
 
 void Position::FlipDiagonally()
@@ -757,8 +820,7 @@ void Position::FlipDiagonally()
     mCastlingRights[0] = 0;
     mCastlingRights[1] = 0;
 
-    mHash = ComputeHash();
-    mPawnsHash = 0; // TODO
+    ComputeHashes();
 }
 
 Position Position::MirroredVertically() const
@@ -280,6 +280,8 @@ public:
     // get board hash
     INLINE uint64_t GetHash() const { return mHash; }
     INLINE uint64_t GetPawnsHash() const { return mPawnsHash; }
+    INLINE uint32_t GetMaterialHash() const { return mMaterialHash; }
+    INLINE uint32_t GetNonPawnsHash() const { return mNonPawnsHash; }
     uint64_t HashAfterMove(const Move move) const;
 
     INLINE Color GetSideToMove() const { return mSideToMove; }
@@ -311,6 +313,11 @@ private:
 
     Square ExtractEnPassantSquareFromMove(const Move& move) const;
 
+    // recompute all hashes from scratch
+    void ComputeHashes();
+    uint32_t ComputeMaterialHash() const;
+    uint32_t ComputeNonPawnsHash() const;
+
     void ClearRookCastlingRights(const Square affectedSquare);
 
     // BOARD STATE & FLAGS
@@ -332,7 +339,10 @@ private:
     // METADATA
 
     uint64_t mHash;
-    uint64_t mPawnsHash;
+    uint64_t mPawnsHash;        // pawns only
+    // keys below only index small tables, so they're truncated to 32 bits to keep position within 256 bytes
+    uint32_t mMaterialHash;     // piece counts
+    uint32_t mNonPawnsHash;     // pieces other than pawns (including kings)
 };
 
 static_assert(sizeof(Position) <= 256, "Invalid position size");
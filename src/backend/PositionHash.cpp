@@ -1,16 +1,6 @@
 #include "PositionHash.hpp"
 
-// 800 random bytes to store Zobrist hash
-// 
-// 2*6*64 for pieces piece
-// 8 for en passant square
-// 16 for castling rights
-// 
-// This gives 792 64-bit hashes required. We overlap all the hashes (1 byte offsets),
-// so required storage is 8x smaller.
-// Note: side-to-move hash is stored separately
-alignas(64) uint64_t s_ZobristHash[c_ZobristHashSize];
-
+ZobristKeys s_ZobristKeys;
 
 static inline uint64_t rotl(const uint64_t x, int k)
 {
@@ -33,8 +23,15 @@ void InitZobristHash()
 {
     uint64_t s[2] = { 0x2b2fa1f53b24b9f2, 0x0203c66609c7f249 };
 
-    for (uint32_t i = 0; i < c_ZobristHashSize; ++i)
-    {
-        s_ZobristHash[i] = xoroshiro128(s);
-    }
+    for (uint32_t color = 0; color < 2; ++color)
+        for (uint32_t piece = 0; piece < 6; ++piece)
+            for (uint32_t square = 0; square < 64; ++square)
+                s_ZobristKeys.pieces[color][piece][square] = xoroshiro128(s);
+
+    for (uint32_t file = 0; file < 8; ++file)
+        s_ZobristKeys.enPassantFile[file] = xoroshiro128(s);
+
+    for (uint32_t color = 0; color < 2; ++color)
+        for (uint32_t file = 0; file < 8; ++file)
+            s_ZobristKeys.castlingRights[color][file] = xoroshiro128(s);
 }
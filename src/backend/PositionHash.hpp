@@ -4,37 +4,44 @@
 #include "Piece.hpp"
 #include "Square.hpp"
 
-static constexpr uint32_t c_ZobristHashSize = 100;
-
 static constexpr uint64_t c_SideToMoveZobristHash = 1u;
-extern uint64_t s_ZobristHash[c_ZobristHashSize];
+
+// Zobrist keys, each [color][piece] row of square keys occupies whole cachelines
+struct alignas(CACHELINE_SIZE) ZobristKeys
+{
+    uint64_t pieces[2][6][64];          // [color][piece - Pawn][square]
+    uint64_t enPassantFile[8];
+    uint64_t castlingRights[2][8];      // [color][rook file]
+};
+
+extern ZobristKeys s_ZobristKeys;
 
 void InitZobristHash();
 
 INLINE static uint64_t GetPieceZobristHash(const Color color, const Piece piece, const uint32_t squareIndex)
 {
     const uint32_t pieceIndex = (uint32_t)piece - (uint32_t)Piece::Pawn;
-    const uint32_t offset = (uint32_t)color + 2 * (squareIndex + 64 * pieceIndex);
-    ASSERT(offset < 2 * 6 * 64);
-    return *(const uint64_t*)((const uint8_t*)s_ZobristHash + offset);
+    ASSERT(color < 2);
+    ASSERT(pieceIndex < 6);
+    ASSERT(squareIndex < 64);
+    return s_ZobristKeys.pieces[color][pieceIndex][squareIndex];
+}
+
+// material key is a XOR of keys indexed by piece counts (instead of squares)
+INLINE static uint64_t GetMaterialZobristHash(const Color color, const Piece piece, const uint32_t pieceCount)
+{
+    return GetPieceZobristHash(color, piece, pieceCount);
 }
 
 INLINE static uint64_t GetEnPassantFileZobristHash(uint32_t fileIndex)
 {
     ASSERT(fileIndex < 8);
-
-    // skip position hashes
-    const uint32_t offset = (2 * 6 * 64) + fileIndex;
-    ASSERT(offset < 2 * 6 * 64 + 8);
-    return *(const uint64_t*)((const uint8_t*)s_ZobristHash + offset);
+    return s_ZobristKeys.enPassantFile[fileIndex];
 }
 
 INLINE static uint64_t GetCastlingRightsZobristHash(const Color color, uint32_t rookIndex)
 {
+    ASSERT(color < 2);
     ASSERT(rookIndex < 8);
-
-    // skip position hashes and en passant hashes
-    const uint32_t offset = (2 * 6 * 64 + 8) + 2 * rookIndex + (uint32_t)color;
-    ASSERT(offset < 2 * 6 * 64 + 8 + 16);
-    return *(const uint64_t*)((const uint8_t*)s_ZobristHash + offset);
+    return s_ZobristKeys.castlingRights[color][rookIndex];
 }
@@ -0,0 +1,193 @@
+#include "Profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <algorithm>
+#include <stdio.h>
+
+namespace Profiler
+{
+    std::atomic<bool> g_enabled = false;
+    std::atomic<uint32_t> g_samplingRate = 1;
+    thread_local ThreadState tl_state;
+
+    namespace
+    {
+        // limit memory usage in case profiling is left enabled
+        static constexpr size_t MaxEventsPerThread = 4 * 1024 * 1024;
+
+        struct ZoneEvent
+        {
+            const char* name;
+            TimePoint begin;
+            TimePoint end;
+        };
+
+        struct ThreadBuffer
+        {
+            uint32_t threadIndex = 0;
+            uint64_t numDroppedEvents = 0;
+            std::vector<ZoneEvent> events;
+        };
+
+        // buffers are never freed, so they outlive the threads
+        static std::mutex g_buffersMutex;
+        static std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+        static TimePoint g_startTime = TimePoint::Invalid();
+
+        static NO_INLINE ThreadBuffer* RegisterThread()
+        {
+            std::unique_lock<std::mutex> lock(g_buffersMutex);
+
+            g_buffers.emplace_back(std::make_unique<ThreadBuffer>());
+            ThreadBuffer* buffer = g_buffers.back().get();
+            buffer->threadIndex = static_cast<uint32_t>(g_buffers.size() - 1);
+            buffer->events.reserve(64 * 1024);
+
+            tl_state.buffer = buffer;
+            return buffer;
+        }
+    }
+
+    void Start(uint32_t samplingRate)
+    {
+        if (!g_startTime.IsValid())
+        {
+            g_startTime = TimePoint::GetCurrent();
+        }
+
+        g_samplingRate = std::max(1u, samplingRate);
+        g_enabled = true;
+    }
+
+    void Stop()
+    {
+        g_enabled = false;
+    }
+
+    void Clear()
+    {
+        ASSERT(!g_enabled);
+
+        std::unique_lock<std::mutex> lock(g_buffersMutex);
+        for (const auto& buffer : g_buffers)
+        {
+            buffer->events.clear();
+            buffer->numDroppedEvents = 0;
+        }
+        g_startTime = TimePoint::Invalid();
+    }
+
+    void ZoneEnd(const char* name, const TimePoint& beginTime)
+    {
+        const TimePoint endTime = TimePoint::GetCurrentFast();
+
+        ThreadBuffer* buffer = static_cast<ThreadBuffer*>(tl_state.buffer);
+        if (!buffer) [[unlikely]]
+        {
+            buffer = RegisterThread();
+        }
+
+        if (buffer->events.size() < MaxEventsPerThread)
+        {
+            buffer->events.push_back({ name, beginTime, endTime });
+        }
+        else
+        {
+            buffer->numDroppedEvents++;
+        }
+    }
+
+    bool ExportChromeTrace(const char* path)
+    {
+        ASSERT(!g_enabled);
+
+        FILE* file = fopen(path, "w");
+        if (!file)
+        {
+            std::cout << "ERROR: Failed to open file: " << path << std::endl;
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(g_buffersMutex);
+
+        fprintf(file, "{\"traceEvents\":[\n");
+
+        bool first = true;
+        for (const auto& buffer : g_buffers)
+        {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+                first ? "" : ",\n", buffer->threadIndex, buffer->threadIndex);
+            first = false;
+
+            for (const ZoneEvent& event : buffer->events)
+            {
+                // timestamps and durations in microseconds
+                const double timestamp = 1.0e+6 * (event.begin - g_startTime).ToSeconds();
+                const double duration = 1.0e+6 * (event.end - event.begin).ToSeconds();
+                fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"engine\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+                    event.name, timestamp, duration, buffer->threadIndex);
+            }
+        }
+
+        fprintf(file, "\n]}\n");
+
+        const bool success = ferror(file) == 0;
+        fclose(file);
+
+        if (!success)
+        {
+            std::cout << "ERROR: Failed to write file: " << path << std::endl;
+        }
+
+        return success;
+    }
+
+    void PrintSummary()
+    {
+        ASSERT(!g_enabled);
+
+        struct ZoneStats
+        {
+            uint64_t count = 0;
+            double totalTime = 0.0;
+        };
+
+        std::map<std::string, ZoneStats> zones;
+        uint64_t numDroppedEvents = 0;
+        {
+            std::unique_lock<std::mutex> lock(g_buffersMutex);
+            for (const auto& buffer : g_buffers)
+            {
+                for (const ZoneEvent& event : buffer->events)
+                {
+                    ZoneStats& stats = zones[event.name];
+                    stats.count++;
+                    stats.totalTime += (event.end - event.begin).ToSeconds();
+                }
+                numDroppedEvents += buffer->numDroppedEvents;
+            }
+        }
+
+        std::vector<std::pair<std::string, ZoneStats>> sortedZones(zones.begin(), zones.end());
+        std::sort(sortedZones.begin(), sortedZones.end(), [](const auto& a, const auto& b) { return a.second.totalTime > b.second.totalTime; });
+
+        printf("%-32s %12s %14s %12s\n", "Zone", "Samples", "Total [ms]", "Avg [ns]");
+        for (const auto& [name, stats] : sortedZones)
+        {
+            printf("%-32s %12" PRIu64 " %14.3f %12.1f\n", name.c_str(), stats.count, 1.0e+3 * stats.totalTime, 1.0e+9 * stats.totalTime / stats.count);
+        }
+
+        if (numDroppedEvents > 0)
+        {
+            printf("Dropped events: %" PRIu64 "\n", numDroppedEvents);
+        }
+    }
+
+} // namespace Profiler
+
+#endif // ENABLE_PROFILER
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Common.hpp"
+
+// Enables sampled profiling zones in the engine hot paths.
+// Recorded zones can be exported to Chrome trace JSON format (chrome://tracing, Perfetto) with "profile" UCI command.
+// #define ENABLE_PROFILER
+
+#ifdef ENABLE_PROFILER
+
+#include "Time.hpp"
+
+namespace Profiler
+{
+    // start recording zones, every 'samplingRate'-th zone is recorded on each thread
+    void Start(uint32_t samplingRate);
+
+    // stop recording zones
+    void Stop();
+
+    // discard recorded zones
+    void Clear();
+
+    // write recorded zones to Chrome trace JSON file
+    // Note: must not be called while zones are being recorded
+    bool ExportChromeTrace(const char* path);
+
+    // print number of recorded zones and their total time grouped by zone name
+    // Note: must not be called while zones are being recorded
+    void PrintSummary();
+
+    struct ThreadState
+    {
+        uint32_t sampleCountdown = 1;
+        void* buffer = nullptr;
+    };
+
+    extern std::atomic<bool> g_enabled;
+    extern std::atomic<uint32_t> g_samplingRate;
+    extern thread_local ThreadState tl_state;
+
+    void ZoneEnd(const char* name, const TimePoint& beginTime);
+
+    class ScopedZone final
+    {
+    public:
+        INLINE ScopedZone(const char* name)
+        {
+            if (g_enabled.load(std::memory_order_relaxed)) [[unlikely]]
+            {
+                if (--tl_state.sampleCountdown == 0)
+                {
+                    tl_state.sampleCountdown = g_samplingRate.load(std::memory_order_relaxed);
+                    mName = name;
+                    mBeginTime = TimePoint::GetCurrentFast();
+                }
+            }
+        }
+
+        INLINE ~ScopedZone()
+        {
+            if (mName) [[unlikely]]
+            {
+                ZoneEnd(mName, mBeginTime);
+            }
+        }
+
+    private:
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+        const char* mName = nullptr;
+        TimePoint mBeginTime;
+    };
+
+} // namespace Profiler
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) Profiler::ScopedZone PROFILE_ZONE_CONCAT(profileZone_, __LINE__)(name)
+
+#else // !ENABLE_PROFILER
+
+#define PROFILE_ZONE(name)
+
+#endif // ENABLE_PROFILER
@@ -11,12 +11,14 @@
 #include "PositionHash.hpp"
 #include "Score.hpp"
 #include "Tuning.hpp"
+#include "Profiler.hpp"
 
 #include <iostream>
 #include <sstream>
 #include <cstring>
 #include <string>
 #include <thread>
+#include <chrono>
 #include <math.h>
 
 // silent warning C4127: conditional expression is constant
@@ -111,7 +113,7 @@ INLINE static int32_t GetHistoryPruningTreshold(int32_t depth)
     return 0 - HistoryPruningLinearFactor * depth - HistoryPruningQuadraticFactor * depth * depth;
 }
 
-void SearchStats::Append(SearchThreadStats& threadStats, bool flush)
+bool SearchStats::Append(SearchThreadStats& threadStats, bool flush)
 {
     if (threadStats.nodesTemp >= 128 || flush)
     {
@@ -125,7 +127,10 @@ void SearchStats::Append(SearchThreadStats& threadStats, bool flush)
         threadStats.tbHits = 0;
 
         AtomicMax(maxDepth, threadStats.maxDepth);
+        return true;
     }
+
+    return false;
 }
 
 Search::Search()
@@ -138,6 +143,16 @@ Search::Search()
 Search::~Search()
 {
     StopWorkerThreads();
+
+    if (mTimerThread.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mTimerMutex);
+            mStopTimerThread = true;
+        }
+        mTimerCV.notify_one();
+        mTimerThread.join();
+    }
 }
 
 void Search::StopWorkerThreads()
@@ -155,6 +170,7 @@ void Search::StopWorkerThreads()
         mThreadData[i]->thread.join();
     }
 
+    std::unique_lock<std::mutex> lock(mTelemetryMutex);
     mThreadData.erase(mThreadData.begin() + 1, mThreadData.end());
 }
 
@@ -188,6 +204,8 @@ void Search::BuildMoveReductionTable()
 
 void Search::Clear()
 {
+    mPrevRootValid = false;
+
     for (const ThreadDataPtr& threadData : mThreadData)
     {
         ASSERT(threadData);
@@ -196,6 +214,7 @@ void Search::Clear()
         threadData->stats = SearchThreadStats{};
         memset(threadData->matScoreCorrection, 0, sizeof(threadData->matScoreCorrection));
         memset(threadData->pawnStructureCorrection, 0, sizeof(threadData->pawnStructureCorrection));
+        memset(threadData->nonPawnsCorrection, 0, sizeof(threadData->nonPawnsCorrection));
     }
 }
 
@@ -209,7 +228,51 @@ const NodeCache& Search::GetNodeCache() const
     return mThreadData.front()->nodeCache;
 }
 
-bool Search::CheckStopCondition(const ThreadData& thread, const SearchContext& ctx, bool isRootNode)
+void Search::SetNodeCacheParams(size_t sizeInBytes, uint32_t maxDistanceFromRoot)
+{
+    mNodeCacheSize = sizeInBytes;
+    mNodeCacheMaxDistance = maxDistanceFromRoot;
+
+    for (const ThreadDataPtr& threadData : mThreadData)
+    {
+        threadData->nodeCache.Resize(mNodeCacheSize);
+        threadData->nodeCache.SetMaxDistanceFromRoot(mNodeCacheMaxDistance);
+    }
+}
+
+void Search::GetTelemetry(SearchTelemetry& outTelemetry) const
+{
+    std::unique_lock<std::mutex> lock(mTelemetryMutex);
+
+    outTelemetry.isSearching = mIsSearching;
+    outTelemetry.elapsedTime = 0.0f;
+    if (mSearchStartTime.IsValid())
+    {
+        const TimePoint endTime = mSearchEndTime.IsValid() ? mSearchEndTime : TimePoint::GetCurrent();
+        outTelemetry.elapsedTime = (endTime - mSearchStartTime).ToSeconds();
+    }
+    outTelemetry.idealTime = mIdealTime.load(std::memory_order_relaxed);
+    outTelemetry.maxTime = mMaxTime.load(std::memory_order_relaxed);
+    outTelemetry.stabilityCounter = mStabilityCounter.load(std::memory_order_relaxed);
+    outTelemetry.hashFull = mHashFull.load(std::memory_order_relaxed);
+
+    // per-thread counters are read without synchronization with the search threads
+    const size_t numThreads = std::min<size_t>(std::max(mNumSearchThreads, 1u), mThreadData.size());
+    outTelemetry.threads.resize(numThreads);
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        const ThreadData& thread = *mThreadData[i];
+        SearchTelemetry::ThreadInfo& info = outTelemetry.threads[i];
+        info.nodes = thread.telemetry.nodes.load(std::memory_order_relaxed);
+        info.tbHits = thread.telemetry.tbHits.load(std::memory_order_relaxed);
+        info.rootDepth = thread.telemetry.rootDepth.load(std::memory_order_relaxed);
+        info.depthCompleted = thread.telemetry.depthCompleted.load(std::memory_order_relaxed);
+        info.accumulatorUpdates = thread.accumulatorCache.numUpdates.load(std::memory_order_relaxed);
+        info.accumulatorRefreshes = thread.accumulatorCache.numRefreshes.load(std::memory_order_relaxed);
+    }
+}
+
+bool Search::CheckStopCondition(ThreadData& thread, const SearchContext& ctx, bool isRootNode)
 {
     SearchParam& param = ctx.searchParam;
 
@@ -229,11 +292,15 @@ bool Search::CheckStopCondition(const ThreadData& thread, const SearchContext& c
         }
 
         // check inner nodes periodically
-        if (isRootNode || (thread.stats.nodesTotal % 512 == 0)) [[unlikely]]
+        // Note: the timer thread stops the search as well, this check is a fallback in case the timer thread wakes up late
+        if (isRootNode || thread.stats.nodesTotal >= thread.nextTimeCheckNodes) [[unlikely]]
         {
+            const TimePoint currentTime = TimePoint::GetCurrentFast();
+            UpdateTimeCheckInterval(thread, currentTime);
+
             if (param.limits.maxTime.IsValid() &&
                 param.limits.startTimePoint.IsValid() &&
-                TimePoint::GetCurrent() >= param.limits.startTimePoint + param.limits.maxTime) [[unlikely]]
+                currentTime >= param.limits.startTimePoint + param.limits.maxTime) [[unlikely]]
             {
                 // time limit exceeded
                 param.stopSearch = true;
@@ -245,12 +312,102 @@ bool Search::CheckStopCondition(const ThreadData& thread, const SearchContext& c
     return false;
 }
 
+void Search::UpdateTimeCheckInterval(ThreadData& thread, const TimePoint& currentTime)
+{
+    const uint64_t nodes = thread.stats.nodesTotal;
+
+    if (thread.lastTimeCheck.IsValid() && nodes > thread.lastTimeCheckNodes)
+    {
+        const float elapsedTime = (currentTime - thread.lastTimeCheck).ToSeconds();
+        if (elapsedTime > 0.0f)
+        {
+            const float nodesPerInterval = static_cast<float>(nodes - thread.lastTimeCheckNodes) * (1.0e-6f * TimeCheckInterval) / elapsedTime;
+            thread.timeCheckNodesInterval = static_cast<uint32_t>(std::clamp(nodesPerInterval,
+                static_cast<float>(MinTimeCheckNodesInterval),
+                static_cast<float>(MaxTimeCheckNodesInterval)));
+        }
+    }
+
+    thread.lastTimeCheck = currentTime;
+    thread.lastTimeCheckNodes = nodes;
+    thread.nextTimeCheckNodes = nodes + thread.timeCheckNodesInterval;
+}
+
+void Search::StartTimer(SearchParam& param)
+{
+    if (!param.limits.maxTime.IsValid() || !param.limits.startTimePoint.IsValid())
+    {
+        return;
+    }
+
+    if (!mTimerThread.joinable())
+    {
+        mTimerThread = std::thread(&Search::TimerThreadCallback, this);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mTimerMutex);
+        ASSERT(!mTimerSearchParam);
+        mTimerSearchParam = &param;
+    }
+    mTimerCV.notify_one();
+}
+
+void Search::StopTimer()
+{
+    std::unique_lock<std::mutex> lock(mTimerMutex);
+    mTimerSearchParam = nullptr;
+    mTimerCV.notify_one();
+}
+
+void Search::TimerThreadCallback()
+{
+    std::unique_lock<std::mutex> lock(mTimerMutex);
+
+    while (!mStopTimerThread)
+    {
+        if (!mTimerSearchParam)
+        {
+            mTimerCV.wait(lock);
+            continue;
+        }
+
+        SearchParam& param = *mTimerSearchParam;
+
+        // Note: the limits are not modified during the search
+        const TimePoint endTime = param.limits.startTimePoint + param.limits.maxTime;
+        const TimePoint currentTime = TimePoint::GetCurrent();
+
+        if (currentTime >= endTime)
+        {
+            if (param.isPonder.load(std::memory_order_acquire))
+            {
+                // limits don't apply while pondering, wait for 'ponderhit'
+                mTimerCV.wait_for(lock, std::chrono::milliseconds(1));
+                continue;
+            }
+
+            param.stopSearch = true;
+            mTimerSearchParam = nullptr;
+            continue;
+        }
+
+        mTimerCV.wait_for(lock, std::chrono::duration<float>((endTime - currentTime).ToSeconds()));
+    }
+}
+
 void Search::DoSearch(const Game& game, SearchParam& param, SearchResult& outResult, SearchStats* outStats)
 {
     ASSERT(!param.stopSearch);
 
     outResult.clear();
 
+    // search state is re-rooted only when the searches are played one after another
+    const bool prevRootValid = mPrevRootValid;
+    mPrevRootValid = false;
+    mRootShift = 0;
+    mReusedPvLine = PvLine{};
+
     if (!game.GetPosition().IsValid())
     {
         return;
@@ -341,7 +498,7 @@ void Search::DoSearch(const Game& game, SearchParam& param, SearchResult& outRes
         SearchUtils::GetPvLine(rootNode, DefaultMaxPvLineLength, outResult.front().moves);
 
         // flush pending stats
-        searchContext.stats.Append(thread.stats, true);
+        thread.FlushStats(searchContext.stats, true);
 
         const AspirationWindowSearchParam aspirationWindowSearchParam =
         {
@@ -355,13 +512,35 @@ void Search::DoSearch(const Game& game, SearchParam& param, SearchResult& outRes
         ReportPV(aspirationWindowSearchParam, outResult[0], BoundsType::Exact, TimePoint());
     }
 
+    // publish search state for monitoring
+    {
+        std::unique_lock<std::mutex> lock(mTelemetryMutex);
+        mSearchStartTime = TimePoint::GetCurrent();
+        mSearchEndTime = TimePoint::Invalid();
+        mNumSearchThreads = param.numThreads;
+        mIdealTime.store(param.limits.idealTimeCurrent.IsValid() ? param.limits.idealTimeCurrent.ToSeconds() : -1.0f, std::memory_order_relaxed);
+        mMaxTime.store(param.limits.maxTime.IsValid() ? param.limits.maxTime.ToSeconds() : -1.0f, std::memory_order_relaxed);
+        mStabilityCounter.store(0, std::memory_order_relaxed);
+        mIsSearching = true;
+    }
+
+    if (prevRootValid && param.reuseSearchTree)
+    {
+        PrepareSearchTreeReuse(game, param);
+    }
+
+    StartTimer(param);
+
     // kick off worker threads
     for (uint32_t i = 1; i < param.numThreads; ++i)
     {
         // spawn missing threads
         if (mThreadData.size() < param.numThreads)
         {
+            std::unique_lock<std::mutex> lock(mTelemetryMutex);
             mThreadData.emplace_back(std::make_unique<ThreadData>());
+            mThreadData.back()->nodeCache.Resize(mNodeCacheSize);
+            mThreadData.back()->nodeCache.SetMaxDistanceFromRoot(mNodeCacheMaxDistance);
             mThreadData.back()->thread = std::thread(Search::WorkerThreadCallback, mThreadData.back().get());
         }
 
@@ -441,14 +620,78 @@ void Search::DoSearch(const Game& game, SearchParam& param, SearchResult& outRes
         outResult = std::move(mThreadData[bestThreadIndex]->pvLines);
     }
 
+    // remember the root, so the next search can start from this search tree
+    if (!outResult.front().moves.empty())
+    {
+        mPrevRootPosition = game.GetPosition();
+        mPrevRootPvLine = outResult.front();
+        mPrevRootValid = true;
+    }
+
     if (outStats)
     {
         *outStats = globalStats;
     }
 
+    // make sure the timer thread no longer accesses the search parameters
+    StopTimer();
+
+    {
+        std::unique_lock<std::mutex> lock(mTelemetryMutex);
+        mSearchEndTime = TimePoint::GetCurrent();
+        mIsSearching = false;
+    }
+
     param.stopSearch = false;
 }
 
+void Search::PrepareSearchTreeReuse(const Game& game, const SearchParam& param)
+{
+    constexpr uint32_t rootShift = SearchTreeReuseRootShift;
+
+    const std::vector<Move>& gameMoves = game.GetMoves();
+    if (gameMoves.size() < rootShift)
+    {
+        return;
+    }
+
+    Position pos = mPrevRootPosition;
+    for (size_t i = gameMoves.size() - rootShift; i < gameMoves.size(); ++i)
+    {
+        const Move move = gameMoves[i];
+        if (!pos.IsMoveValid(move) || !pos.IsMoveLegal(move) || !pos.DoMove(move))
+        {
+            return;
+        }
+    }
+
+    if (pos != game.GetPosition())
+    {
+        return;
+    }
+
+    mRootShift = rootShift;
+
+    // if the opponent played the predicted move, continue with the rest of the previous PV
+    const std::vector<Move>& prevPv = mPrevRootPvLine.moves;
+    if (prevPv.size() > rootShift &&
+        prevPv[0] == gameMoves[gameMoves.size() - 2] &&
+        prevPv[1] == gameMoves[gameMoves.size() - 1] &&
+        !IsMate(mPrevRootPvLine.score) &&
+        std::find(param.excludedMoves.begin(), param.excludedMoves.end(), prevPv[rootShift]) == param.excludedMoves.end())
+    {
+        for (size_t i = rootShift; i < prevPv.size(); ++i)
+        {
+            if (!pos.IsMoveValid(prevPv[i]) || !pos.IsMoveLegal(prevPv[i]) || !pos.DoMove(prevPv[i]))
+            {
+                break;
+            }
+            mReusedPvLine.moves.push_back(prevPv[i]);
+        }
+        mReusedPvLine.score = mPrevRootPvLine.score;
+    }
+}
+
 void Search::WorkerThreadCallback(ThreadData* threadData)
 {
     while (!threadData->stopThread)
@@ -618,13 +861,34 @@ void Search::Search_Internal(const uint32_t threadID, const uint32_t numPvLines,
 
     // clear per-thread data for new search
     thread.stats = SearchThreadStats{};
+    thread.nextTimeCheckNodes = InitialTimeCheckNodesInterval;
+    thread.lastTimeCheckNodes = 0;
+    thread.timeCheckNodesInterval = InitialTimeCheckNodesInterval;
+    thread.lastTimeCheck = TimePoint::Invalid();
     thread.depthCompleted = 0;
+    thread.telemetry.nodes.store(0, std::memory_order_relaxed);
+    thread.telemetry.tbHits.store(0, std::memory_order_relaxed);
+    thread.telemetry.rootDepth.store(0, std::memory_order_relaxed);
+    thread.telemetry.depthCompleted.store(0, std::memory_order_relaxed);
+    thread.accumulatorCache.numUpdates.store(0, std::memory_order_relaxed);
+    thread.accumulatorCache.numRefreshes.store(0, std::memory_order_relaxed);
     thread.pvLines.clear();
     thread.pvLines.resize(numPvLines);
     thread.avgScores.clear();
     thread.avgScores.resize(numPvLines, 0);
-    thread.moveOrderer.NewSearch();
-    thread.nodeCache.OnNewSearch();
+    thread.moveOrderer.NewSearch(mRootShift);
+    thread.nodeCache.SetMaxDistanceFromRoot(
+        mNodeCacheMaxDistance > 0 && param.reuseSearchTree ?
+        mNodeCacheMaxDistance + SearchTreeReuseRootShift :
+        mNodeCacheMaxDistance);
+    thread.nodeCache.OnNewSearch(game.GetPosition(), mRootShift);
+
+    // start with the previous search PV (if opponent played the expected move)
+    if (!mReusedPvLine.moves.empty())
+    {
+        thread.pvLines.front() = mReusedPvLine;
+        thread.avgScores.front() = mReusedPvLine.score;
+    }
 
     uint32_t mateCounter = 0;
     TimeManagerState timeManagerState;
@@ -642,6 +906,7 @@ void Search::Search_Internal(const uint32_t threadID, const uint32_t numPvLines,
         searchContext.excludedRootMoves = param.excludedMoves;
 
         thread.rootDepth = depth;
+        thread.telemetry.rootDepth.store(depth, std::memory_order_relaxed);
 
         bool abortSearch = false;
 
@@ -729,14 +994,17 @@ void Search::Search_Internal(const uint32_t threadID, const uint32_t numPvLines,
             // compute fraction of nodes spent on searching best move
             if (const NodeCacheEntry* nodeCacheEntry = thread.nodeCache.GetEntry(game.GetPosition(), 0))
             {
-                if (const NodeCacheEntry::MoveInfo* moveInfo = nodeCacheEntry->GetMove(primaryMove))
+                if (const uint64_t moveNodes = nodeCacheEntry->GetMoveNodes(primaryMove))
                 {
                     data.bestMoveNodeFraction = nodeCacheEntry->nodesSum > 0 ?
-                        (static_cast<double>(moveInfo->nodesSearched) / static_cast<double>(nodeCacheEntry->nodesSum)) : 0.0;
+                        (static_cast<double>(moveNodes) / static_cast<double>(nodeCacheEntry->nodesSum)) : 0.0;
                 }
             }
 
             UpdateTimeManager(data, searchContext.searchParam.limits, timeManagerState);
+
+            mStabilityCounter.store(timeManagerState.stabilityCounter, std::memory_order_relaxed);
+            mIdealTime.store(param.limits.idealTimeCurrent.IsValid() ? param.limits.idealTimeCurrent.ToSeconds() : -1.0f, std::memory_order_relaxed);
         }
 
         // remember PV lines so they can be used in next iteration
@@ -746,6 +1014,17 @@ void Search::Search_Internal(const uint32_t threadID, const uint32_t numPvLines,
         {
             // search stopped due to hard time limit is not considered fully completed
             thread.depthCompleted = depth;
+            thread.telemetry.depthCompleted.store(depth, std::memory_order_relaxed);
+
+            if (isMainThread)
+            {
+                mHashFull.store(param.transpositionTable.GetHashFull(), std::memory_order_relaxed);
+            }
+
+            if (isMainThread && param.iterationCallback)
+            {
+                param.iterationCallback(depth, thread.pvLines.front(), searchContext.stats.nodes);
+            }
         }
 
         if (isMainThread &&
@@ -866,7 +1145,7 @@ PvLine Search::AspirationWindowSearch(ThreadData& thread, const AspirationWindow
         SearchUtils::GetPvLine(rootNode, maxPvLine, pvLine.moves);
 
         // flush pending per-thread stats
-        param.searchContext.stats.Append(thread.stats, true);
+        thread.FlushStats(param.searchContext.stats, true);
 
         BoundsType boundsType = BoundsType::Exact;
 
@@ -955,9 +1234,10 @@ INLINE static bool OppCanWinMaterial(const Position& position, const Threats& th
 
 ScoreType Search::ThreadData::GetEvalCorrection(const Position& pos) const
 {
-    const int32_t matIndex = Murmur3(pos.GetMaterialKey().value) % MaterialCorrectionTableSize;
+    const int32_t matIndex = pos.GetMaterialHash() % MaterialCorrectionTableSize;
     const int32_t pawnIndex = pos.GetPawnsHash() % PawnStructureCorrectionTableSize;
-    return (matScoreCorrection[matIndex] + pawnStructureCorrection[pawnIndex]) / EvalCorrectionScale;
+    const int32_t nonPawnsIndex = pos.GetNonPawnsHash() % NonPawnsCorrectionTableSize;
+    return (matScoreCorrection[matIndex] + pawnStructureCorrection[pawnIndex] + nonPawnsCorrection[nonPawnsIndex]) / EvalCorrectionScale;
 }
 
 void Search::ThreadData::UpdateEvalCorrection(const Position& pos, ScoreType evalScore, ScoreType trueScore)
@@ -967,7 +1247,7 @@ void Search::ThreadData::UpdateEvalCorrection(const Position& pos, ScoreType eva
 
     // material
     {
-        const int32_t index = Murmur3(pos.GetMaterialKey().value) % MaterialCorrectionTableSize;
+        const int32_t index = pos.GetMaterialHash() % MaterialCorrectionTableSize;
         int16_t& matScore = matScoreCorrection[index];
         matScore = static_cast<int16_t>((matScore * (EvalCorrectionBlendFactor - 1) + diff) / EvalCorrectionBlendFactor);
     }
@@ -978,6 +1258,13 @@ void Search::ThreadData::UpdateEvalCorrection(const Position& pos, ScoreType eva
         int16_t& pawnScore = pawnStructureCorrection[index];
         pawnScore = static_cast<int16_t>((pawnScore * (EvalCorrectionBlendFactor - 1) + diff) / EvalCorrectionBlendFactor);
     }
+
+    // pieces placement (excluding pawns)
+    {
+        const int32_t index = pos.GetNonPawnsHash() % NonPawnsCorrectionTableSize;
+        int16_t& nonPawnsScore = nonPawnsCorrection[index];
+        nonPawnsScore = static_cast<int16_t>((nonPawnsScore * (EvalCorrectionBlendFactor - 1) + diff) / EvalCorrectionBlendFactor);
+    }
 }
 
 INLINE static int32_t GetContemptFactor(const Position& pos, const Color rootStm, const SearchParam& searchParam)
@@ -1018,6 +1305,8 @@ ScoreType Search::AdjustEvalScore(const ThreadData& threadData, const NodeInfo&
 template<NodeType nodeType>
 ScoreType Search::QuiescenceNegaMax(ThreadData& thread, NodeInfo* node, SearchContext& ctx) const
 {
+    PROFILE_ZONE("QuiescenceNegaMax");
+
     ASSERT(node->ply < MaxSearchDepth);
     ASSERT(!node->filteredMove.IsValid());
     ASSERT(node->isInCheck == node->position.IsInCheck());
@@ -1035,7 +1324,7 @@ ScoreType Search::QuiescenceNegaMax(ThreadData& thread, NodeInfo* node, SearchCo
     // update stats
     thread.stats.quiescenceNodes++;
     thread.stats.OnNodeEnter(node->ply + 1);
-    ctx.stats.Append(thread.stats);
+    thread.FlushStats(ctx.stats);
 
     ScoreType alpha = node->alpha;
     ScoreType beta = node->beta;
@@ -1050,7 +1339,7 @@ ScoreType Search::QuiescenceNegaMax(ThreadData& thread, NodeInfo* node, SearchCo
             {
                 // update stats
                 thread.stats.OnNodeEnter(node->ply + 1);
-                ctx.stats.Append(thread.stats);
+                thread.FlushStats(ctx.stats);
                 return alpha;
             }
         }
@@ -1276,6 +1565,8 @@ ScoreType Search::QuiescenceNegaMax(ThreadData& thread, NodeInfo* node, SearchCo
 template<NodeType nodeType>
 ScoreType Search::NegaMax(ThreadData& thread, NodeInfo* node, SearchContext& ctx) const
 {
+    PROFILE_ZONE("NegaMax");
+
     ASSERT(node->ply < MaxSearchDepth);
 
     constexpr bool isRootNode = nodeType == NodeType::Root;
@@ -1297,7 +1588,7 @@ ScoreType Search::NegaMax(ThreadData& thread, NodeInfo* node, SearchContext& ctx
 
     // update stats
     thread.stats.OnNodeEnter(node->ply + 1);
-    ctx.stats.Append(thread.stats);
+    thread.FlushStats(ctx.stats);
 
     ScoreType alpha = node->alpha;
     ScoreType beta = node->beta;
@@ -1312,7 +1603,7 @@ ScoreType Search::NegaMax(ThreadData& thread, NodeInfo* node, SearchContext& ctx
             {
                 // update stats
                 thread.stats.OnNodeEnter(node->ply + 1);
-                ctx.stats.Append(thread.stats);
+                thread.FlushStats(ctx.stats);
                 return alpha;
             }
         }
@@ -1399,6 +1690,7 @@ ScoreType Search::NegaMax(ThreadData& thread, NodeInfo* node, SearchContext& ctx
             (ProbeSyzygy_WDL(position, &wdl) || ProbeGaviota(position, nullptr, &wdl))) [[unlikely]]
         {
             thread.stats.tbHits++;
+            thread.telemetry.tbHits.store(thread.telemetry.tbHits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 
             const ScoreType tbWinScore = TablebaseWinValue - ScoreType(100 * position.GetNumPiecesExcludingKing()) - ScoreType(node->ply);
             ASSERT(tbWinScore > KnownWinValue);
@@ -1686,7 +1978,7 @@ ScoreType Search::NegaMax(ThreadData& thread, NodeInfo* node, SearchContext& ctx
     thread.moveOrderer.InitContinuationHistoryPointers(*node);
 
     NodeCacheEntry* nodeCacheEntry = nullptr;
-    if (node->ply < 3)
+    if (thread.nodeCache.ShouldCache(node->ply))
     {
         nodeCacheEntry = thread.nodeCache.GetEntry(position, node->ply);
     }
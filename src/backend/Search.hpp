@@ -15,6 +15,7 @@
 #include <thread>
 #include <condition_variable>
 #include <functional>
+#include <mutex>
 
 #ifndef CONFIGURATION_FINAL
 #define COLLECT_SEARCH_STATS
@@ -51,6 +52,13 @@ struct SearchLimits
     bool analysisMode = false;
 };
 
+struct PvLine
+{
+    std::vector<Move> moves;
+    ScoreType score = InvalidValue;
+    ScoreType tbScore = InvalidValue;
+};
+
 struct SearchParam
 {
     // shared transposition table
@@ -100,13 +108,15 @@ struct SearchParam
 
     // show win/draw/loss probabilities along with classic cp score
     bool showWDL = false;
-};
 
-struct PvLine
-{
-    std::vector<Move> moves;
-    ScoreType score = InvalidValue;
-    ScoreType tbScore = InvalidValue;
+    // if the root is a grandchild of the previous search root, re-root node cache, killer moves, PV and aspiration window
+    // (disabled by default, not verified yet)
+    // Note: node cache stores extra plies in this mode, so that nodes below the next root are available for re-rooting
+    bool reuseSearchTree = false;
+
+    // optional callback invoked by the main search thread after each completed iterative deepening step
+    // arguments: completed depth, primary PV line, total number of nodes searched so far
+    std::function<void(uint16_t depth, const PvLine& pvLine, uint64_t nodes)> iterationCallback;
 };
 
 using SearchResult = std::vector<PvLine>;
@@ -225,7 +235,8 @@ struct SearchStats
     uint64_t evalHistogram[EvalHistogramBins] = { 0 };
 #endif // COLLECT_SEARCH_STATS
 
-    void Append(SearchThreadStats& threadStats, bool flush = false);
+    // returns true if the thread stats were flushed
+    bool Append(SearchThreadStats& threadStats, bool flush = false);
 
     SearchStats& operator = (const SearchStats& other)
     {
@@ -237,6 +248,28 @@ struct SearchStats
     }
 };
 
+// snapshot of the search state for external monitoring (see Search::GetTelemetry)
+struct SearchTelemetry
+{
+    struct ThreadInfo
+    {
+        uint64_t nodes = 0;
+        uint64_t tbHits = 0;
+        uint64_t accumulatorUpdates = 0;
+        uint64_t accumulatorRefreshes = 0;
+        uint16_t rootDepth = 0;
+        uint16_t depthCompleted = 0;
+    };
+
+    bool isSearching = false;
+    float elapsedTime = 0.0f;       // time since the search started (or duration of the last search), in seconds
+    float idealTime = -1.0f;        // current soft time limit in seconds, negative if not set
+    float maxTime = -1.0f;          // hard time limit in seconds, negative if not set
+    uint32_t stabilityCounter = 0;  // number of iterations in a row with unchanged best move
+    uint32_t hashFull = 0;          // transposition table usage in permills, sampled every iteration
+    std::vector<ThreadInfo> threads;
+};
+
 enum class NodeType
 {
     Root,
@@ -260,6 +293,12 @@ public:
     const MoveOrderer& GetMoveOrderer() const;
     const NodeCache& GetNodeCache() const;
 
+    // set per-thread node cache size and maximum distance from the root of cached nodes (clears the caches)
+    void SetNodeCacheParams(size_t sizeInBytes, uint32_t maxDistanceFromRoot);
+
+    // can be called from any thread, also during the search
+    void GetTelemetry(SearchTelemetry& outTelemetry) const;
+
 private:
 
     Search(const Search&) = delete;
@@ -290,6 +329,14 @@ private:
         uint32_t threadID = 0;
     };
 
+    // target time between time limit checks in search (in microseconds)
+    static constexpr uint32_t TimeCheckInterval = 100;
+
+    // number of nodes between time checks before it's adjusted
+    static constexpr uint32_t InitialTimeCheckNodesInterval = 256;
+    static constexpr uint32_t MinTimeCheckNodesInterval = 16;
+    static constexpr uint32_t MaxTimeCheckNodesInterval = 4096;
+
     struct alignas(64) ThreadData
     {
         std::atomic<bool> stopThread = false;
@@ -311,6 +358,16 @@ private:
         std::vector<ScoreType> avgScores;   // average scores for each PV line (used for aspiration windows)
         SearchThreadStats stats;            // per-thread search stats
 
+        // thread state published for monitoring, written only by the owning thread
+        struct Telemetry
+        {
+            std::atomic<uint64_t> nodes = 0;
+            std::atomic<uint64_t> tbHits = 0;
+            std::atomic<uint16_t> rootDepth = 0;
+            std::atomic<uint16_t> depthCompleted = 0;
+        };
+        Telemetry telemetry;
+
         // per-thread move orderer
         MoveOrderer moveOrderer;
 
@@ -320,11 +377,19 @@ private:
 
         NodeInfo searchStack[MaxSearchDepth];
 
+        // time checks (main thread only)
+        uint64_t nextTimeCheckNodes = 0;    // check time once 'stats.nodesTotal' reaches this value
+        uint64_t lastTimeCheckNodes = 0;
+        uint32_t timeCheckNodesInterval = InitialTimeCheckNodesInterval;
+        TimePoint lastTimeCheck = TimePoint::Invalid();
+
         static constexpr int32_t EvalCorrectionScale = 256;
         static constexpr uint32_t MaterialCorrectionTableSize = 2048;
         static constexpr uint32_t PawnStructureCorrectionTableSize = 1024;
+        static constexpr uint32_t NonPawnsCorrectionTableSize = 1024;
         int16_t matScoreCorrection[MaterialCorrectionTableSize];
         int16_t pawnStructureCorrection[PawnStructureCorrectionTableSize];
+        int16_t nonPawnsCorrection[NonPawnsCorrectionTableSize];
 
         ThreadData();
         ThreadData(const ThreadData&) = delete;
@@ -335,12 +400,56 @@ private:
 
         ScoreType GetEvalCorrection(const Position& pos) const;
         void UpdateEvalCorrection(const Position& pos, ScoreType evalScore, ScoreType trueScore);
+
+        // append per-thread stats to the global stats and publish node count for monitoring
+        INLINE void FlushStats(SearchStats& outStats, bool flush = false)
+        {
+            if (outStats.Append(stats, flush))
+            {
+                telemetry.nodes.store(stats.nodesTotal, std::memory_order_relaxed);
+            }
+        }
     };
 
     using ThreadDataPtr = std::unique_ptr<ThreadData>;
 
     std::vector<ThreadDataPtr> mThreadData;
 
+    // previous search root and result, for re-rooting search state in the next search
+    Position mPrevRootPosition;
+    PvLine mPrevRootPvLine;
+    bool mPrevRootValid = false;
+
+    // the new root must be a grandchild of the previous one (our move and opponent's reply) to reuse search state
+    static constexpr uint32_t SearchTreeReuseRootShift = 2;
+
+    // number of plies between previous and current search root (zero if search state is not reused)
+    uint32_t mRootShift = 0;
+
+    // PV line and score of the previous search, re-rooted to the current root
+    PvLine mReusedPvLine;
+
+    size_t mNodeCacheSize = NodeCache::DefaultSize;
+    uint32_t mNodeCacheMaxDistance = NodeCache::DefaultMaxDistanceFromRoot;
+
+    // search state published for GetTelemetry()
+    mutable std::mutex mTelemetryMutex;     // guards 'mThreadData' resizing and search start/end time
+    TimePoint mSearchStartTime = TimePoint::Invalid();
+    TimePoint mSearchEndTime = TimePoint::Invalid();
+    uint32_t mNumSearchThreads = 0;
+    std::atomic<bool> mIsSearching = false;
+    std::atomic<float> mIdealTime = -1.0f;
+    std::atomic<float> mMaxTime = -1.0f;
+    std::atomic<uint32_t> mStabilityCounter = 0;
+    std::atomic<uint32_t> mHashFull = 0;
+
+    // timer thread (started on first search with time limit)
+    std::thread mTimerThread;
+    std::mutex mTimerMutex;
+    std::condition_variable mTimerCV;
+    SearchParam* mTimerSearchParam = nullptr;
+    bool mStopTimerThread = false;
+
     static constexpr uint32_t LMRTableSize = 64;
     using LMRTableType = uint16_t[LMRTableSize][LMRTableSize];
     LMRTableType mMoveReductionTable_Quiets;
@@ -360,6 +469,9 @@ private:
 
     static void WorkerThreadCallback(ThreadData* threadData);
 
+    // check if the game position is a grandchild of the previous search root and prepare re-rooted search state
+    void PrepareSearchTreeReuse(const Game& game, const SearchParam& param);
+
     static ScoreType AdjustEvalScore(const ThreadData& threadData, const NodeInfo& node, const Color rootStm, const SearchParam& searchParam);
 
     void ReportPV(const AspirationWindowSearchParam& param, const PvLine& pvLine, BoundsType boundsType, const TimePoint& searchTime) const;
@@ -375,5 +487,13 @@ private:
     ScoreType NegaMax(ThreadData& thread, NodeInfo* node, SearchContext& ctx) const;
 
     // returns true if the search needs to be aborted immediately
-    static bool CheckStopCondition(const ThreadData& thread, const SearchContext& ctx, bool isRootNode);
+    static bool CheckStopCondition(ThreadData& thread, const SearchContext& ctx, bool isRootNode);
+
+    // adjust number of nodes between time checks, so the time is checked every TimeCheckInterval
+    static void UpdateTimeCheckInterval(ThreadData& thread, const TimePoint& currentTime);
+
+    // timer thread sets 'stopSearch' flag once the search time limit is exceeded
+    void StartTimer(SearchParam& param);
+    void StopTimer();
+    void TimerThreadCallback();
 };
\ No newline at end of file
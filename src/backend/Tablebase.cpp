@@ -3,6 +3,7 @@
 #include "Move.hpp"
 #include "MoveList.hpp"
 #include "MoveGen.hpp"
+#include "Profiler.hpp"
 
 uint32_t g_syzygyProbeLimit = 6;
 
@@ -88,6 +89,8 @@ static Piece TranslatePieceType(uint32_t tbPromotes)
 
 bool ProbeSyzygy_Root(const Position& pos, Move& outMove, uint32_t* outDistanceToZero, int32_t* outWDL)
 {
+    PROFILE_ZONE("ProbeSyzygy_Root");
+
     if (pos.GetNumPieces() > TB_LARGEST)
     {
         return false;
@@ -165,6 +168,8 @@ bool ProbeSyzygy_WDL(const Position& pos, int32_t* outWDL)
         return false;
     }
 
+    PROFILE_ZONE("ProbeSyzygy_WDL");
+
     // Chess960 castling rights are not handled by Syzygy
     if (pos.GetWhitesCastlingRights() & ~(c_shortCastleMask | c_longCastleMask))   return false;
     if (pos.GetBlacksCastlingRights() & ~(c_shortCastleMask | c_longCastleMask))   return false;
@@ -296,6 +301,8 @@ static TB_pieces PieceToGaviota(const Piece piece)
 
 bool ProbeGaviota(const Position& pos, uint32_t* outDTM, int32_t* outWDL)
 {
+    PROFILE_ZONE("ProbeGaviota");
+
     if (tb_availability() == 0)
     {
         return false;
@@ -46,6 +46,12 @@ TimePoint TimePoint::GetCurrent()
     return { value };
 }
 
+TimePoint TimePoint::GetCurrentFast()
+{
+    // QueryPerformanceCounter is already TSC-based on modern systems
+    return GetCurrent();
+}
+
 TimePoint TimePoint::FromSeconds(float t)
 {
     LARGE_INTEGER value = {};
@@ -86,6 +92,93 @@ bool TimePoint::operator != (const TimePoint& rhs) const
 
 #elif defined(PLATFORM_LINUX)
 
+#if defined(__x86_64__) || defined(__i386__)
+    #define USE_TSC_TIMER
+    #include <x86intrin.h>
+    #include <cpuid.h>
+#endif
+
+namespace
+{
+    static uint64_t GetMonotonicNanoseconds()
+    {
+        struct timespec value;
+        clock_gettime(CLOCK_MONOTONIC, &value);
+        return (uint64_t)value.tv_sec * 1000000000ull + value.tv_nsec;
+    }
+
+#ifdef USE_TSC_TIMER
+
+    // minimum time between the first and the last sample used for TSC frequency calibration
+    static constexpr uint64_t TscCalibrationPeriod = 50'000'000;
+
+    // TSC readings are anchored to the monotonic clock periodically, so the clocks don't drift apart
+    static constexpr uint64_t TscAnchorPeriod = 100'000'000;
+
+    static bool HasInvariantTsc()
+    {
+        uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        {
+            return false;
+        }
+        return (edx & (1u << 8)) != 0;
+    }
+
+    struct TscClock
+    {
+        const bool invariantTsc = HasInvariantTsc();
+        const uint64_t baseTsc = __rdtsc();
+        const uint64_t baseTime = GetMonotonicNanoseconds();
+
+        // calibrated lazily, 0 if not calibrated yet
+        std::atomic<double> nanosecondsPerTick = 0.0;
+    };
+
+    static TscClock gTscClock;
+
+    struct TscAnchor
+    {
+        uint64_t tsc = 0;
+        uint64_t time = 0;
+        uint64_t maxTicks = 0;
+    };
+
+    static thread_local TscAnchor tl_tscAnchor;
+
+    static NO_INLINE uint64_t GetTscTime_Slow()
+    {
+        const uint64_t time = GetMonotonicNanoseconds();
+        const uint64_t tsc = __rdtsc();
+
+        if (!gTscClock.invariantTsc || tsc <= gTscClock.baseTsc)
+        {
+            return time;
+        }
+
+        double nanosecondsPerTick = gTscClock.nanosecondsPerTick.load(std::memory_order_relaxed);
+        if (nanosecondsPerTick == 0.0)
+        {
+            if (time < gTscClock.baseTime + TscCalibrationPeriod)
+            {
+                // not enough time passed for accurate calibration
+                return time;
+            }
+
+            nanosecondsPerTick = static_cast<double>(time - gTscClock.baseTime) / static_cast<double>(tsc - gTscClock.baseTsc);
+            gTscClock.nanosecondsPerTick.store(nanosecondsPerTick, std::memory_order_relaxed);
+        }
+
+        tl_tscAnchor.tsc = tsc;
+        tl_tscAnchor.time = time;
+        tl_tscAnchor.maxTicks = static_cast<uint64_t>(TscAnchorPeriod / nanosecondsPerTick);
+
+        return time;
+    }
+
+#endif // USE_TSC_TIMER
+
+} // namespace
 
 float TimePoint::ToSeconds() const
 {
@@ -104,10 +197,22 @@ TimePoint TimePoint::Invalid()
 
 TimePoint TimePoint::GetCurrent()
 {
-    struct timespec value;
-    clock_gettime(CLOCK_MONOTONIC, &value);
+    return GetMonotonicNanoseconds();
+}
 
-    return (uint64_t)value.tv_sec * 1000000000ull + value.tv_nsec;
+TimePoint TimePoint::GetCurrentFast()
+{
+#ifdef USE_TSC_TIMER
+    const uint64_t ticks = __rdtsc() - tl_tscAnchor.tsc;
+    if (ticks < tl_tscAnchor.maxTicks) [[likely]]
+    {
+        const double nanosecondsPerTick = gTscClock.nanosecondsPerTick.load(std::memory_order_relaxed);
+        return tl_tscAnchor.time + static_cast<uint64_t>(static_cast<double>(ticks) * nanosecondsPerTick);
+    }
+    return GetTscTime_Slow();
+#else
+    return GetMonotonicNanoseconds();
+#endif // USE_TSC_TIMER
 }
 
 TimePoint TimePoint::FromSeconds(float t)
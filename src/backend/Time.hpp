@@ -30,6 +30,10 @@ public:
 
     static TimePoint Invalid();
     static TimePoint GetCurrent();
+
+    // Cheaper version of GetCurrent(), meant for frequent polling (e.g. in search).
+    // Uses CPU timestamp counter calibrated against GetCurrent() if the TSC is invariant, so the results are comparable.
+    static TimePoint GetCurrentFast();
     static TimePoint FromSeconds(float t);
 
     TimePoint operator - (const TimePoint& rhs) const;
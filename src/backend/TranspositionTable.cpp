@@ -1,6 +1,7 @@
 #include "TranspositionTable.hpp"
 #include "Position.hpp"
 #include "Memory.hpp"
+#include "Profiler.hpp"
 
 #include <algorithm>
 #include <cstring>
@@ -180,6 +181,8 @@ void TranspositionTable::Prefetch(const uint64_t hash) const
 
 bool TranspositionTable::Read(const Position& position, TTEntry& outEntry) const
 {
+    PROFILE_ZONE("TranspositionTable::Read");
+
     if (clusters)
     {
         TTCluster& cluster = GetCluster(position.GetHash());
@@ -204,6 +207,8 @@ bool TranspositionTable::Read(const Position& position, TTEntry& outEntry) const
 
 void TranspositionTable::Write(const Position& position, ScoreType score, ScoreType staticEval, int32_t depth, TTEntry::Bounds bounds, PackedMove move)
 {
+    PROFILE_ZONE("TranspositionTable::Write");
+
     ASSERT(position.GetHash() == position.ComputeHash());
 
     TTEntry entry;
@@ -0,0 +1,489 @@
+#include "../backend/Position.hpp"
+#include "../backend/PositionUtils.hpp"
+#include "../backend/MoveGen.hpp"
+#include "../backend/MoveList.hpp"
+#include "../backend/Evaluate.hpp"
+#include "../backend/NeuralNetworkEvaluator.hpp"
+#include "../backend/TranspositionTable.hpp"
+#include "../backend/Time.hpp"
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <functional>
+
+// Microbenchmarks of the backend hot kernels.
+// Usage: backend_bench [filter <substring>] [time <milliseconds per sample>]
+
+namespace {
+
+static const char* GetArchitectureName()
+{
+#if defined(USE_AVX512)
+    return "AVX-512";
+#elif defined(USE_BMI2) && defined(USE_AVX2)
+    return "BMI2";
+#elif defined(USE_AVX2)
+    return "AVX2";
+#elif defined(USE_POPCNT) && defined(USE_SSE4)
+    return "POPCNT";
+#elif defined(USE_ARM_NEON)
+    return "ARM NEON";
+#else
+    return "legacy";
+#endif
+}
+
+static constexpr uint32_t NumSamples = 7;
+
+// prevents the compiler from optimizing out benchmarked code
+static volatile uint64_t g_sink = 0;
+
+struct BenchmarkSettings
+{
+    std::string filter;
+    double sampleTime = 0.02;
+};
+
+// Benchmarked function performs 'numIterations' iterations and returns number of operations done.
+using BenchmarkFunction = std::function<uint64_t(uint32_t numIterations)>;
+
+static void Measure(const BenchmarkSettings& settings, const char* name, const BenchmarkFunction& func)
+{
+    if (!settings.filter.empty() && std::string(name).find(settings.filter) == std::string::npos)
+    {
+        return;
+    }
+
+    // warm up and find number of iterations so a single sample takes roughly the requested time
+    uint32_t numIterations = 1;
+    for (;;)
+    {
+        const TimePoint startTime = TimePoint::GetCurrent();
+        func(numIterations);
+        const double time = (TimePoint::GetCurrent() - startTime).ToSeconds();
+
+        if (time >= settings.sampleTime || numIterations >= (1u << 30))
+        {
+            break;
+        }
+
+        numIterations = time > 0.0 ?
+            static_cast<uint32_t>(std::min(numIterations * 2.0 * settings.sampleTime / time, double(1u << 30))) :
+            numIterations * 2;
+        numIterations = std::max(1u, numIterations);
+    }
+
+    double nsPerOp[NumSamples];
+    for (uint32_t i = 0; i < NumSamples; ++i)
+    {
+        const TimePoint startTime = TimePoint::GetCurrent();
+        const uint64_t numOps = func(numIterations);
+        const double time = (TimePoint::GetCurrent() - startTime).ToSeconds();
+        nsPerOp[i] = 1.0e+9 * time / static_cast<double>(std::max<uint64_t>(1, numOps));
+    }
+
+    std::sort(nsPerOp, nsPerOp + NumSamples);
+    const double median = nsPerOp[NumSamples / 2];
+
+    printf("%-40s %10.2f ns/op %10.2f ns/op (min) %10.3f Mops/s\n", name, median, nsPerOp[0], 1.0e+3 / median);
+}
+
+struct PositionMove
+{
+    uint32_t positionIndex;
+    Move move;
+};
+
+// generate positions by playing random legal moves from given start positions
+static void GenerateRandomPositions(uint32_t numPositions, std::mt19937& gen, std::vector<Position>& outPositions)
+{
+    const char* startFens[] =
+    {
+        Position::InitPositionFEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    };
+
+    outPositions.reserve(numPositions);
+
+    Position pos;
+    uint32_t ply = 0;
+    uint32_t maxPly = 0;
+
+    while (outPositions.size() < numPositions)
+    {
+        if (ply >= maxPly)
+        {
+            VERIFY(pos.FromFEN(startFens[gen() % std::size(startFens)]));
+            ply = 0;
+            maxPly = 20 + gen() % 80;
+        }
+
+        MoveList moves;
+        GenerateMoveList(pos, moves);
+
+        std::vector<Move> legalMoves;
+        for (uint32_t i = 0; i < moves.Size(); ++i)
+        {
+            Position child = pos;
+            if (child.DoMove(moves.GetMove(i)))
+            {
+                legalMoves.push_back(moves.GetMove(i));
+            }
+        }
+
+        if (legalMoves.empty() || pos.GetHalfMoveCount() >= 100)
+        {
+            ply = maxPly;
+            continue;
+        }
+
+        VERIFY(pos.DoMove(legalMoves[gen() % legalMoves.size()]));
+        ply++;
+
+        outPositions.push_back(pos);
+    }
+}
+
+static void BenchmarkMoveGen(const BenchmarkSettings& settings)
+{
+    struct PositionClass
+    {
+        const char* name;
+        const char* fen;
+    };
+
+    const PositionClass positionClasses[] =
+    {
+        { "MoveGen (opening)",      Position::InitPositionFEN },
+        { "MoveGen (middlegame)",   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" },
+        { "MoveGen (endgame)",      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" },
+        { "MoveGen (in check)",     "rnbqkbnr/ppp2ppp/3p4/1B2p3/4P3/8/PPPP1PPP/RNBQK1NR b KQkq - 1 3" },
+        { "MoveGen (promotions)",   "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1" },
+    };
+
+    for (const PositionClass& positionClass : positionClasses)
+    {
+        const Position pos(positionClass.fen);
+
+        Threats threats;
+        pos.ComputeThreats(threats);
+
+        Measure(settings, positionClass.name, [&](uint32_t numIterations)
+        {
+            uint64_t numMoves = 0;
+            for (uint32_t i = 0; i < numIterations; ++i)
+            {
+                MoveList moves;
+                GenerateMoveList(pos, threats.allThreats, moves);
+                numMoves += moves.Size();
+            }
+            g_sink = numMoves;
+            return uint64_t(numIterations);
+        });
+    }
+}
+
+static void BenchmarkPosition(const BenchmarkSettings& settings, const std::vector<Position>& positions)
+{
+    std::vector<PositionMove> allMoves;
+    std::vector<PositionMove> captures;
+
+    for (uint32_t i = 0; i < positions.size(); ++i)
+    {
+        MoveList moves;
+        GenerateMoveList(positions[i], moves);
+        for (uint32_t j = 0; j < moves.Size(); ++j)
+        {
+            const Move move = moves.GetMove(j);
+            allMoves.push_back({ i, move });
+            if (move.IsCapture())
+            {
+                captures.push_back({ i, move });
+            }
+        }
+    }
+
+    Measure(settings, "Position::DoMove (with copy)", [&](uint32_t numIterations)
+    {
+        uint64_t numLegal = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            const PositionMove& entry = allMoves[i % allMoves.size()];
+            Position child = positions[entry.positionIndex];
+            numLegal += child.DoMove(entry.move);
+        }
+        g_sink = numLegal;
+        return uint64_t(numIterations);
+    });
+
+    Measure(settings, "Position::StaticExchangeEvaluation", [&](uint32_t numIterations)
+    {
+        uint64_t numGood = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            const PositionMove& entry = captures[i % captures.size()];
+            numGood += positions[entry.positionIndex].StaticExchangeEvaluation(entry.move);
+        }
+        g_sink = numGood;
+        return uint64_t(numIterations);
+    });
+
+    std::vector<PackedPosition> packedPositions(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        VERIFY(PackPosition(positions[i], packedPositions[i]));
+    }
+
+    Measure(settings, "PackPosition", [&](uint32_t numIterations)
+    {
+        uint64_t checksum = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            PackedPosition packedPos;
+            PackPosition(positions[i % positions.size()], packedPos);
+            checksum += packedPos.occupied.value;
+        }
+        g_sink = checksum;
+        return uint64_t(numIterations);
+    });
+
+    Measure(settings, "UnpackPosition", [&](uint32_t numIterations)
+    {
+        uint64_t checksum = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            Position pos;
+            UnpackPosition(packedPositions[i % packedPositions.size()], pos);
+            checksum += pos.GetHash();
+        }
+        g_sink = checksum;
+        return uint64_t(numIterations);
+    });
+
+    std::vector<std::string> fens;
+    fens.reserve(positions.size());
+    for (const Position& pos : positions)
+    {
+        fens.push_back(pos.ToFEN());
+    }
+
+    Measure(settings, "Position::FromFEN", [&](uint32_t numIterations)
+    {
+        uint64_t checksum = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            Position pos;
+            pos.FromFEN(fens[i % fens.size()]);
+            checksum += pos.GetHash();
+        }
+        g_sink = checksum;
+        return uint64_t(numIterations);
+    });
+
+    Measure(settings, "Position::ToFEN", [&](uint32_t numIterations)
+    {
+        uint64_t checksum = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            checksum += positions[i % positions.size()].ToFEN().size();
+        }
+        g_sink = checksum;
+        return uint64_t(numIterations);
+    });
+}
+
+static void BenchmarkNeuralNetwork(const BenchmarkSettings& settings, const std::vector<Position>& positions, std::mt19937& gen)
+{
+    if (!g_mainNeuralNetwork)
+    {
+        std::cout << "WARNING: Neural network is not loaded, skipping NN benchmarks" << std::endl;
+        return;
+    }
+
+    const nn::PackedNeuralNetwork& network = *g_mainNeuralNetwork;
+
+    // typical number of active features in a middlegame position
+    const uint32_t numFeatures = 30;
+
+    std::vector<uint16_t> features(numFeatures);
+    {
+        std::uniform_int_distribution<uint32_t> distr(0, network.GetNumInputs() - 1);
+        for (uint16_t& f : features) f = static_cast<uint16_t>(distr(gen));
+        std::sort(features.begin(), features.end());
+        features.erase(std::unique(features.begin(), features.end()), features.end());
+    }
+
+    nn::Accumulator* accumulators = static_cast<nn::Accumulator*>(AlignedMalloc(2 * sizeof(nn::Accumulator), CACHELINE_SIZE));
+    nn::Accumulator& accumA = accumulators[0];
+    nn::Accumulator& accumB = accumulators[1];
+    accumA.Refresh(network.GetAccumulatorWeights(), network.GetAccumulatorBiases(), static_cast<uint32_t>(features.size()), features.data());
+    accumB = accumA;
+
+    Measure(settings, "Accumulator::Refresh (30 features)", [&](uint32_t numIterations)
+    {
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            accumA.Refresh(network.GetAccumulatorWeights(), network.GetAccumulatorBiases(), static_cast<uint32_t>(features.size()), features.data());
+        }
+        g_sink = accumA.values[0];
+        return uint64_t(numIterations);
+    });
+
+    // quiet move: one feature added, one removed
+    Measure(settings, "Accumulator::Update (1 add, 1 remove)", [&](uint32_t numIterations)
+    {
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            const uint16_t added = features[i % features.size()];
+            const uint16_t removed = features[(i + 1) % features.size()];
+            accumB.Update(accumA, network.GetAccumulatorWeights(), 1, &added, 1, &removed);
+        }
+        g_sink = accumB.values[0];
+        return uint64_t(numIterations);
+    });
+
+    // capture: one feature added, two removed
+    Measure(settings, "Accumulator::Update (1 add, 2 remove)", [&](uint32_t numIterations)
+    {
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            const uint16_t added = features[i % features.size()];
+            const uint16_t removed[2] = { features[(i + 1) % features.size()], features[(i + 2) % features.size()] };
+            accumB.Update(accumA, network.GetAccumulatorWeights(), 1, &added, 2, removed);
+        }
+        g_sink = accumB.values[0];
+        return uint64_t(numIterations);
+    });
+
+    Measure(settings, "PackedNeuralNetwork::Run", [&](uint32_t numIterations)
+    {
+        int64_t sum = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            sum += network.Run(accumA, accumB, 0);
+        }
+        g_sink = sum;
+        return uint64_t(numIterations);
+    });
+
+    Measure(settings, "NNEvaluator::Evaluate (full)", [&](uint32_t numIterations)
+    {
+        int64_t sum = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            sum += NNEvaluator::Evaluate(network, positions[i % positions.size()]);
+        }
+        g_sink = sum;
+        return uint64_t(numIterations);
+    });
+
+    AlignedFree(accumulators);
+}
+
+static void BenchmarkTranspositionTable(const BenchmarkSettings& settings, const std::vector<Position>& positions)
+{
+    // big enough to not fit in cache
+    TranspositionTable tt(64 * 1024 * 1024);
+
+    const auto writeAll = [&](uint32_t numIterations)
+    {
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            const Position& pos = positions[i % positions.size()];
+            tt.Write(pos, static_cast<ScoreType>(i % 100), 0, i % 16, TTEntry::Bounds::Exact);
+        }
+        return uint64_t(numIterations);
+    };
+
+    Measure(settings, "TranspositionTable::Write", writeAll);
+
+    // make sure all the positions are present in the table
+    writeAll(static_cast<uint32_t>(positions.size()));
+
+    Measure(settings, "TranspositionTable::Read (hit)", [&](uint32_t numIterations)
+    {
+        uint64_t numHits = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            TTEntry entry;
+            numHits += tt.Read(positions[i % positions.size()], entry);
+        }
+        g_sink = numHits;
+        return uint64_t(numIterations);
+    });
+
+    // prefetch few positions ahead, like the search does after making a move
+    Measure(settings, "TranspositionTable::Prefetch+Read", [&](uint32_t numIterations)
+    {
+        const uint32_t prefetchDistance = 8;
+        uint64_t numHits = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            tt.Prefetch(positions[(i + prefetchDistance) % positions.size()].GetHash());
+            TTEntry entry;
+            numHits += tt.Read(positions[i % positions.size()], entry);
+        }
+        g_sink = numHits;
+        return uint64_t(numIterations);
+    });
+
+    tt.Clear();
+
+    Measure(settings, "TranspositionTable::Read (miss)", [&](uint32_t numIterations)
+    {
+        uint64_t numHits = 0;
+        for (uint32_t i = 0; i < numIterations; ++i)
+        {
+            TTEntry entry;
+            numHits += tt.Read(positions[i % positions.size()], entry);
+        }
+        g_sink = numHits;
+        return uint64_t(numIterations);
+    });
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkSettings settings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "filter" && i + 1 < argc)
+        {
+            settings.filter = argv[++i];
+        }
+        else if (arg == "time" && i + 1 < argc)
+        {
+            settings.sampleTime = std::max(1, atoi(argv[++i])) / 1000.0;
+        }
+        else
+        {
+            std::cerr << "Usage: backend_bench [filter <substring>] [time <milliseconds per sample>]" << std::endl;
+            return 1;
+        }
+    }
+
+    InitEngine();
+    TryLoadingDefaultEvalFile();
+
+    std::cout << "Architecture: " << GetArchitectureName() << std::endl;
+
+    // fixed seed, so the benchmarks are repeatable
+    std::mt19937 gen(12345);
+
+    std::vector<Position> positions;
+    GenerateRandomPositions(16 * 1024, gen, positions);
+
+    BenchmarkMoveGen(settings);
+    BenchmarkPosition(settings, positions);
+    BenchmarkNeuralNetwork(settings, positions, gen);
+    BenchmarkTranspositionTable(settings, positions);
+
+    return 0;
+}
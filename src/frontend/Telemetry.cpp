@@ -0,0 +1,197 @@
+#include "Telemetry.hpp"
+
+#include <sstream>
+
+#if defined(PLATFORM_LINUX)
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#endif // PLATFORM_LINUX
+
+TelemetryServer::TelemetryServer(const Search& search)
+    : mSearch(search)
+{
+}
+
+TelemetryServer::~TelemetryServer()
+{
+    Stop();
+}
+
+std::string TelemetryServer::BuildSnapshot(const SearchTelemetry& telemetry)
+{
+    const auto nps = [&telemetry](uint64_t nodes) -> uint64_t
+    {
+        return telemetry.elapsedTime > 0.0f ? static_cast<uint64_t>(static_cast<double>(nodes) / telemetry.elapsedTime) : 0;
+    };
+
+    uint64_t totalNodes = 0;
+    uint64_t totalTbHits = 0;
+    uint16_t maxDepthCompleted = 0;
+
+    std::stringstream threadsStr;
+    for (size_t i = 0; i < telemetry.threads.size(); ++i)
+    {
+        const SearchTelemetry::ThreadInfo& info = telemetry.threads[i];
+        totalNodes += info.nodes;
+        totalTbHits += info.tbHits;
+        maxDepthCompleted = std::max(maxDepthCompleted, info.depthCompleted);
+
+        if (i > 0) threadsStr << ",";
+        threadsStr << "{\"id\":" << i
+            << ",\"nodes\":" << info.nodes
+            << ",\"nps\":" << nps(info.nodes)
+            << ",\"tbHits\":" << info.tbHits
+            << ",\"rootDepth\":" << info.rootDepth
+            << ",\"depthCompleted\":" << info.depthCompleted
+            << ",\"accumulatorUpdates\":" << info.accumulatorUpdates
+            << ",\"accumulatorRefreshes\":" << info.accumulatorRefreshes
+            << "}";
+    }
+
+    std::stringstream ss;
+    ss << "{\"searching\":" << (telemetry.isSearching ? "true" : "false")
+        << ",\"elapsed\":" << telemetry.elapsedTime
+        << ",\"nodes\":" << totalNodes
+        << ",\"nps\":" << nps(totalNodes)
+        << ",\"tbHits\":" << totalTbHits
+        << ",\"depthCompleted\":" << maxDepthCompleted
+        << ",\"hashfull\":" << telemetry.hashFull
+        << ",\"timeManager\":{\"idealTime\":" << telemetry.idealTime
+        << ",\"maxTime\":" << telemetry.maxTime
+        << ",\"stabilityCounter\":" << telemetry.stabilityCounter
+        << "},\"threads\":[" << threadsStr.str() << "]}\n";
+    return ss.str();
+}
+
+#if defined(PLATFORM_LINUX)
+
+bool TelemetryServer::Start(const std::string& socketPath)
+{
+    Stop();
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path))
+    {
+        std::cout << "ERROR: Invalid telemetry socket path: " << socketPath << std::endl;
+        return false;
+    }
+    memcpy(addr.sun_path, socketPath.c_str(), socketPath.size());
+
+    // remove stale socket file left by previous run, but never anything else
+    struct stat pathStat;
+    if (lstat(socketPath.c_str(), &pathStat) == 0)
+    {
+        if (!S_ISSOCK(pathStat.st_mode))
+        {
+            std::cout << "ERROR: Telemetry socket path exists and is not a socket: " << socketPath << std::endl;
+            return false;
+        }
+
+        if (unlink(socketPath.c_str()) != 0)
+        {
+            std::cout << "ERROR: Failed to remove stale telemetry socket " << socketPath << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    else if (errno != ENOENT)
+    {
+        std::cout << "ERROR: Failed to access telemetry socket path " << socketPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    mSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (mSocket < 0)
+    {
+        std::cout << "ERROR: Failed to create telemetry socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (bind(mSocket, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || listen(mSocket, 8) != 0)
+    {
+        std::cout << "ERROR: Failed to bind telemetry socket " << socketPath << ": " << strerror(errno) << std::endl;
+        close(mSocket);
+        mSocket = -1;
+        return false;
+    }
+
+    mSocketPath = socketPath;
+    mStop = false;
+    mThread = std::thread(&TelemetryServer::ThreadFunc, this);
+
+    return true;
+}
+
+void TelemetryServer::Stop()
+{
+    if (mThread.joinable())
+    {
+        mStop = true;
+        mThread.join();
+    }
+
+    if (mSocket >= 0)
+    {
+        close(mSocket);
+        mSocket = -1;
+        unlink(mSocketPath.c_str());
+        mSocketPath.clear();
+    }
+}
+
+void TelemetryServer::ThreadFunc()
+{
+    SearchTelemetry telemetry;
+
+    while (!mStop)
+    {
+        // wake up periodically to check the stop flag
+        pollfd pfd = { mSocket, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0 || !(pfd.revents & POLLIN))
+        {
+            continue;
+        }
+
+        const int client = accept(mSocket, nullptr, nullptr);
+        if (client < 0)
+        {
+            continue;
+        }
+
+        mSearch.GetTelemetry(telemetry);
+        const std::string snapshot = BuildSnapshot(telemetry);
+
+        size_t written = 0;
+        while (written < snapshot.size())
+        {
+            const ssize_t result = send(client, snapshot.c_str() + written, snapshot.size() - written, MSG_NOSIGNAL);
+            if (result <= 0) break;
+            written += static_cast<size_t>(result);
+        }
+
+        close(client);
+    }
+}
+
+#else // !PLATFORM_LINUX
+
+bool TelemetryServer::Start(const std::string&)
+{
+    std::cout << "ERROR: Telemetry socket is not supported on this platform" << std::endl;
+    return false;
+}
+
+void TelemetryServer::Stop()
+{
+}
+
+void TelemetryServer::ThreadFunc()
+{
+}
+
+#endif // PLATFORM_LINUX
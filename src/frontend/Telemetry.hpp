@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../backend/Search.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Serves search telemetry snapshots over a local socket.
+ * @remarks Every client connecting to the Unix domain socket receives a single JSON document
+ *          (see Search::GetTelemetry) and the connection is closed, e.g.: socat - UNIX-CONNECT:<path>
+ *          Only supported on Linux.
+ */
+class TelemetryServer final
+{
+public:
+    TelemetryServer(const Search& search);
+    ~TelemetryServer();
+
+    // start serving on given socket path (any previous server is stopped)
+    bool Start(const std::string& socketPath);
+    void Stop();
+
+    bool IsRunning() const { return mThread.joinable(); }
+
+    // serialize current search state to JSON
+    static std::string BuildSnapshot(const SearchTelemetry& telemetry);
+
+private:
+    TelemetryServer(const TelemetryServer&) = delete;
+    TelemetryServer& operator=(const TelemetryServer&) = delete;
+
+    void ThreadFunc();
+
+    const Search& mSearch;
+    std::string mSocketPath;
+    std::thread mThread;
+    std::atomic<bool> mStop = false;
+    int mSocket = -1;
+};
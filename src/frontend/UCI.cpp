@@ -9,8 +9,12 @@
 #include "../backend/TimeManager.hpp"
 #include "../backend/PositionUtils.hpp"
 #include "../backend/Tuning.hpp"
+#include "../backend/PerfCounters.hpp"
 
 #include <math.h>
+#include <fstream>
+#include <sstream>
+#include <iterator>
 
 #ifndef CAISSA_VERSION
 #define CAISSA_VERSION "1.18.5"
@@ -96,7 +100,7 @@ void UniversalChessInterface::Loop(int argc, const char* argv[])
             }
 
             // "bench" command is used to run benchmark and exit immediately to comply with OpenBench
-            if (cmd == "bench")
+            if (cmd == "bench" || cmd.starts_with("bench "))
             {
                 return;
             }
@@ -189,6 +193,14 @@ bool UniversalChessInterface::ExecuteCommand(const std::string& commandString)
         std::cout << "option name UCI_ShowWDL type check default false\n";
         std::cout << "option name UseSAN type check default false\n";
         std::cout << "option name ColorConsoleOutput type check default false\n";
+        std::cout << "option name TelemetrySocket type string default <empty>\n";
+        std::cout << "option name NodeCacheSize type spin default " << mOptions.nodeCacheSize << " min 16 max 1048576\n";
+        std::cout << "option name NodeCacheDepth type spin default " << mOptions.nodeCacheDepth << " min 0 max 64\n";
+        std::cout << "option name ReuseSearchTree type check default false\n";
+        std::cout << "option name OwnBook type check default false\n";
+        std::cout << "option name BookFile type string default <empty>\n";
+        std::cout << "option name BookDepth type spin default " << mOptions.bookDepth << " min 0 max 1000\n";
+        std::cout << "option name BookVariety type check default false\n";
 #ifdef ENABLE_TUNING
         for (const TunableParameter& param : g_TunableParameters)
         {
@@ -296,7 +308,7 @@ bool UniversalChessInterface::ExecuteCommand(const std::string& commandString)
     }
     else if (command == "bench" || command == "benchmark")
     {
-        Command_Benchmark();
+        Command_Benchmark(args);
     }
 #ifdef ENABLE_TUNING
     else if (command == "printparams")
@@ -316,6 +328,12 @@ bool UniversalChessInterface::ExecuteCommand(const std::string& commandString)
         PrintEndgameStatistics();
     }
 #endif // COLLECT_ENDGAME_STATISTICS
+#ifdef ENABLE_PROFILER
+    else if (command == "profile")
+    {
+        Command_Profile(args);
+    }
+#endif // ENABLE_PROFILER
     else if (command == "help")
     {
         // print all available commands
@@ -337,7 +355,10 @@ bool UniversalChessInterface::ExecuteCommand(const std::string& commandString)
         std::cout << " * ttprobe - probe transposition table with current position" << std::endl;
         std::cout << " * tbprobe - probe tablebases with current position" << std::endl;
         std::cout << " * cacheprobe - probe node cache" << std::endl;
-        std::cout << " * bench|benchmark - run benchmark" << std::endl;
+        std::cout << " * bench|benchmark [depth <depth>] [threads <threads>] [hash <MB>] [positions <file>] [runs <runs>] [perf] [json <path>] - run benchmark" << std::endl;
+#ifdef ENABLE_PROFILER
+        std::cout << " * profile [start <sampling rate> | stop | clear | export <path>] - record profiling zones and export them as Chrome trace" << std::endl;
+#endif // ENABLE_PROFILER
     }
     else
     {
@@ -577,6 +598,13 @@ bool UniversalChessInterface::Command_Go(const std::vector<std::string>& args)
         }
     }
 
+    // play book move without starting the search (but only in regular game mode)
+    if (!isInfinite && !isPonder && !mOptions.analysisMode && mateSearchDepth == 0 && excludedMoves.empty() &&
+        maxDepth == UINT32_MAX && maxNodes == UINT64_MAX && TryPlayBookMove())
+    {
+        return true;
+    }
+
     mSearchCtx = std::make_unique<SearchTaskContext>(mTranspositionTable);
 
     mSearchCtx->searchParam.limits.startTimePoint = startTimePoint;
@@ -633,6 +661,7 @@ bool UniversalChessInterface::Command_Go(const std::vector<std::string>& args)
     mSearchCtx->searchParam.moveNotation = mOptions.useStandardAlgebraicNotation ? MoveNotation::SAN : MoveNotation::LAN;
     mSearchCtx->searchParam.colorConsoleOutput = mOptions.colorConsoleOutput;
     mSearchCtx->searchParam.showWDL = mOptions.showWDL;
+    mSearchCtx->searchParam.reuseSearchTree = mOptions.reuseSearchTree;
 
     {
         std::unique_lock<std::mutex> lock(mSearchThreadMutex);
@@ -652,6 +681,37 @@ bool UniversalChessInterface::Command_Go(const std::vector<std::string>& args)
     return true;
 }
 
+bool UniversalChessInterface::TryPlayBookMove()
+{
+    if (!mOptions.ownBook || !mOpeningBook.IsLoaded())
+    {
+        return false;
+    }
+
+    const Position& pos = mGame.GetPosition();
+    const uint32_t ply = 2u * (pos.GetMoveCount() - 1u) + (pos.GetSideToMove() == Black ? 1u : 0u);
+    if (ply >= mOptions.bookDepth)
+    {
+        return false;
+    }
+
+    Move move;
+    const OpeningBookEntry* entry = nullptr;
+    if (!mOpeningBook.Probe(pos, move, mOptions.bookVariety, &entry))
+    {
+        return false;
+    }
+
+    const MoveNotation notation = mOptions.useStandardAlgebraicNotation ? MoveNotation::SAN : MoveNotation::LAN;
+    std::cout << "info string book move " << pos.MoveToString(move, notation) << " weight " << entry->weight << " score " << entry->score << std::endl;
+    std::cout << "bestmove " << pos.MoveToString(move, notation) << std::endl;
+
+    mPrevSearchPosition = pos;
+    mPrevSearchPvLine.clear();
+
+    return true;
+}
+
 void UniversalChessInterface::StopSearchThread()
 {
     {
@@ -934,6 +994,70 @@ bool UniversalChessInterface::Command_SetOption(const std::string& name, const s
             return false;
         }
     }
+    else if (lowerCaseName == "nodecachesize")
+    {
+        mOptions.nodeCacheSize = std::clamp(atoi(value.c_str()), 16, 1048576);
+        mSearch.SetNodeCacheParams(1024 * static_cast<size_t>(mOptions.nodeCacheSize), mOptions.nodeCacheDepth);
+    }
+    else if (lowerCaseName == "nodecachedepth")
+    {
+        mOptions.nodeCacheDepth = std::clamp(atoi(value.c_str()), 0, 64);
+        mSearch.SetNodeCacheParams(1024 * static_cast<size_t>(mOptions.nodeCacheSize), mOptions.nodeCacheDepth);
+    }
+    else if (lowerCaseName == "reusesearchtree")
+    {
+        if (!ParseBool(lowerCaseValue, mOptions.reuseSearchTree))
+        {
+            std::cout << "Invalid value" << std::endl;
+            return false;
+        }
+    }
+    else if (lowerCaseName == "ownbook")
+    {
+        if (!ParseBool(lowerCaseValue, mOptions.ownBook))
+        {
+            std::cout << "Invalid value" << std::endl;
+            return false;
+        }
+    }
+    else if (lowerCaseName == "bookfile")
+    {
+        if (value.empty() || value == "<empty>")
+        {
+            mOpeningBook.Release();
+        }
+        else if (mOpeningBook.LoadFromFile(value.c_str()))
+        {
+            std::cout << "info string Loaded opening book " << value << " (" << mOpeningBook.GetNumEntries() << " entries)" << std::endl;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else if (lowerCaseName == "bookdepth")
+    {
+        mOptions.bookDepth = std::clamp(atoi(value.c_str()), 0, 1000);
+    }
+    else if (lowerCaseName == "bookvariety")
+    {
+        if (!ParseBool(lowerCaseValue, mOptions.bookVariety))
+        {
+            std::cout << "Invalid value" << std::endl;
+            return false;
+        }
+    }
+    else if (lowerCaseName == "telemetrysocket")
+    {
+        if (value.empty() || value == "<empty>")
+        {
+            mTelemetryServer.Stop();
+        }
+        else if (!mTelemetryServer.Start(value))
+        {
+            return false;
+        }
+    }
     else
     {
 #ifdef ENABLE_TUNING
@@ -1057,7 +1181,115 @@ bool UniversalChessInterface::Command_ScoreMoves()
     return true;
 }
 
-bool UniversalChessInterface::Command_Benchmark()
+#ifdef ENABLE_PROFILER
+
+bool UniversalChessInterface::Command_Profile(const std::vector<std::string>& args)
+{
+    if (args.size() < 2)
+    {
+        std::cout << "Invalid profile command" << std::endl;
+        return false;
+    }
+
+    if (args[1] == "start")
+    {
+        uint32_t samplingRate = 1;
+        if (args.size() > 2)
+        {
+            samplingRate = std::max(1, atoi(args[2].c_str()));
+        }
+        Profiler::Start(samplingRate);
+        std::cout << "Profiler started (sampling rate: " << samplingRate << ")" << std::endl;
+    }
+    else if (args[1] == "stop")
+    {
+        Profiler::Stop();
+        std::cout << "Profiler stopped" << std::endl;
+    }
+    else if (args[1] == "clear")
+    {
+        Command_Stop();
+        Profiler::Stop();
+        Profiler::Clear();
+    }
+    else if (args[1] == "export")
+    {
+        if (args.size() < 3)
+        {
+            std::cout << "Missing output file path" << std::endl;
+            return false;
+        }
+
+        // zones can't be exported while search threads are still recording
+        Command_Stop();
+        Profiler::Stop();
+
+        if (!Profiler::ExportChromeTrace(args[2].c_str()))
+        {
+            return false;
+        }
+        Profiler::PrintSummary();
+    }
+    else
+    {
+        std::cout << "Invalid profile command" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+#endif // ENABLE_PROFILER
+
+// load positions for benchmark from FEN or EPD file (EPD operations are ignored)
+static bool LoadBenchmarkPositions(const std::string& path, std::vector<std::string>& outPositions)
+{
+    std::ifstream file(path);
+    if (!file.good())
+    {
+        std::cout << "ERROR: Failed to open positions file: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream iss(line);
+        const std::vector<std::string> tokens{ std::istream_iterator<std::string>{iss}, std::istream_iterator<std::string>() };
+
+        if (tokens.size() < 4)
+        {
+            continue;
+        }
+
+        std::string fen = tokens[0] + ' ' + tokens[1] + ' ' + tokens[2] + ' ' + tokens[3];
+
+        // half-move and full-move counters are present only in FEN
+        if (tokens.size() >= 6 && isdigit(tokens[4][0]) && isdigit(tokens[5][0]))
+        {
+            fen += ' ' + tokens[4] + ' ' + tokens[5];
+        }
+
+        Position pos;
+        if (!pos.FromFEN(fen))
+        {
+            std::cout << "ERROR: Invalid position in " << path << ": " << fen << std::endl;
+            return false;
+        }
+
+        outPositions.push_back(fen);
+    }
+
+    if (outPositions.empty())
+    {
+        std::cout << "ERROR: No positions found in " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool UniversalChessInterface::Command_Benchmark(const std::vector<std::string>& args)
 {
     const char* testPositions[] =
     {
@@ -1204,51 +1436,285 @@ bool UniversalChessInterface::Command_Benchmark()
         "rknnbqrb/pppppppp/8/8/8/8/PPPPPPPP/NQBBRKNR w HEga - 0 1",
     };
 
-    const uint32_t maxDepth = 12;
+    uint32_t maxDepth = 12;
+    uint32_t numThreads = 1;
+    uint32_t hashSizeInMB = 4;
+    uint32_t numRuns = 1;
+    bool usePerfCounters = false;
+    std::string positionsPath;
+    std::string jsonPath;
+
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool hasValue = i + 1 < args.size();
+
+        if (args[i] == "perf")
+        {
+            usePerfCounters = true;
+        }
+        else if (args[i] == "depth" && hasValue)
+        {
+            maxDepth = std::clamp(atoi(args[++i].c_str()), 1, static_cast<int32_t>(MaxSearchDepth));
+        }
+        else if (args[i] == "threads" && hasValue)
+        {
+            numThreads = std::clamp(atoi(args[++i].c_str()), 1, static_cast<int32_t>(c_MaxNumThreads));
+        }
+        else if (args[i] == "hash" && hasValue)
+        {
+            hashSizeInMB = std::max(1, atoi(args[++i].c_str()));
+        }
+        else if (args[i] == "runs" && hasValue)
+        {
+            numRuns = std::max(1, atoi(args[++i].c_str()));
+        }
+        else if (args[i] == "positions" && hasValue)
+        {
+            positionsPath = args[++i];
+        }
+        else if (args[i] == "json" && hasValue)
+        {
+            jsonPath = args[++i];
+        }
+        else
+        {
+            std::cout << "Invalid bench argument: " << args[i] << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<std::string> positions;
+    if (positionsPath.empty())
+    {
+        positions.assign(std::begin(testPositions), std::end(testPositions));
+    }
+    else if (!LoadBenchmarkPositions(positionsPath, positions))
+    {
+        return false;
+    }
+
+    PerfCounters perfCounters;
+    if (usePerfCounters && !perfCounters.Init())
+    {
+        std::cout << "WARNING: Hardware performance counters are not available" << std::endl;
+        usePerfCounters = false;
+    }
+    if (usePerfCounters && numThreads > 1)
+    {
+        std::cout << "WARNING: Performance counters measure only the main search thread" << std::endl;
+    }
+
+    // per-position results, time and counters are accumulated over all runs
+    struct PositionResult
+    {
+        std::string bestMove;
+        uint64_t nodes = 0;
+        double time = 0.0;
+        PerfCounterValues resetCounters;
+        PerfCounterValues searchCounters;
+    };
+
+    std::vector<PositionResult> results(positions.size());
+    std::vector<double> runNps;
+
+    PerfCounterValues totalResetCounters;
+    PerfCounterValues totalSearchCounters;
 
     Search search;
-    TranspositionTable tt(4 * 1024 * 1024);
+    TranspositionTable tt(static_cast<size_t>(hashSizeInMB) * 1024 * 1024);
 
     uint64_t totalNodes = 0;
     double totalTime = 0.0;
 
-    for (const char* testPosition : testPositions)
+    // total node count of a single run is the functional signature of the search
+    // Note: it's deterministic only for single threaded search
+    uint64_t signature = 0;
+    bool deterministic = true;
+
+    for (uint32_t run = 0; run < numRuns; ++run)
     {
-        printf("Benchmarking position: %s ...", testPosition);
+        uint64_t runNodes = 0;
+        double runTime = 0.0;
 
-        Position pos;
-        VERIFY(pos.FromFEN(testPosition));
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            printf("Benchmarking position: %s ...", positions[i].c_str());
+
+            Position pos;
+            VERIFY(pos.FromFEN(positions[i]));
+
+            Game game;
+            game.Reset(pos);
 
-        Game game;
-        game.Reset(pos);
+            PerfCounterValues resetCounters;
+            PerfCounterValues searchCounters;
 
-        search.Clear();
-        tt.Clear();
+            if (usePerfCounters) perfCounters.Start();
 
-        SearchParam searchParam{ tt };
-        searchParam.debugLog = false;
-        searchParam.limits.maxDepth = maxDepth;
+            search.Clear();
+            tt.Clear();
 
-        const TimePoint startTimePoint = TimePoint::GetCurrent();
+            if (usePerfCounters) resetCounters = perfCounters.Stop();
 
-        SearchStats stats;
-        SearchResult searchResult;
-        search.DoSearch(game, searchParam, searchResult, &stats);
+            SearchParam searchParam{ tt };
+            searchParam.debugLog = false;
+            searchParam.numThreads = numThreads;
+            searchParam.limits.maxDepth = maxDepth;
 
-        const TimePoint endTimePoint = TimePoint::GetCurrent();
+            const TimePoint startTimePoint = TimePoint::GetCurrent();
+            if (usePerfCounters) perfCounters.Start();
 
-        totalNodes += stats.nodes;
-        totalTime += (endTimePoint - startTimePoint).ToSeconds();
+            SearchStats stats;
+            SearchResult searchResult;
+            search.DoSearch(game, searchParam, searchResult, &stats);
 
-        // print best move and stats
-        printf(" Move: %s, Nodes: %" PRId64 ", Time: %.2f MNPS: %.2f\n",
-            searchResult[0].moves.front().ToString().c_str(),
-            stats.nodes.load(),
-            (endTimePoint - startTimePoint).ToSeconds(),
-            stats.nodes.load() / (endTimePoint - startTimePoint).ToSeconds() / 1000000.0);
+            if (usePerfCounters) searchCounters = perfCounters.Stop();
+            const TimePoint endTimePoint = TimePoint::GetCurrent();
+
+            const std::string bestMove = searchResult[0].moves.empty() ? "none" : searchResult[0].moves.front().ToString();
+            const uint64_t nodes = stats.nodes.load();
+            const double time = (endTimePoint - startTimePoint).ToSeconds();
+
+            PositionResult& result = results[i];
+            if (run == 0)
+            {
+                result.bestMove = bestMove;
+                result.nodes = nodes;
+            }
+            else if (result.nodes != nodes || result.bestMove != bestMove)
+            {
+                deterministic = false;
+            }
+            result.time += time;
+            result.resetCounters += resetCounters;
+            result.searchCounters += searchCounters;
+
+            runNodes += nodes;
+            runTime += time;
+            totalResetCounters += resetCounters;
+            totalSearchCounters += searchCounters;
+
+            // print best move and stats
+            printf(" Move: %s, Nodes: %" PRIu64 ", Time: %.2f MNPS: %.2f\n",
+                bestMove.c_str(), nodes, time, nodes / time / 1000000.0);
+
+            if (usePerfCounters)
+            {
+                printf("    Search:");
+                searchCounters.Print();
+            }
+        }
+
+        if (run == 0)
+        {
+            signature = runNodes;
+        }
+
+        totalNodes += runNodes;
+        totalTime += runTime;
+        runNps.push_back(runNodes / runTime);
+
+        std::cout << runNodes << " nodes " << static_cast<int64_t>(runNodes / runTime) << " nps" << std::endl;
+    }
+
+    if (numRuns > 1)
+    {
+        double mean = 0.0;
+        for (const double nps : runNps) mean += nps;
+        mean /= runNps.size();
+
+        double variance = 0.0;
+        for (const double nps : runNps) variance += (nps - mean) * (nps - mean);
+        variance /= (runNps.size() - 1);
+
+        printf("Runs: %u, NPS: %.0f +/- %.0f, Signature: %" PRIu64 "%s\n",
+            numRuns, mean, sqrt(variance), signature, deterministic ? "" : " (non-deterministic)");
     }
 
-    std::cout << totalNodes << " nodes " << static_cast<int64_t>(totalNodes / totalTime) << " nps" << std::endl;
+    if (usePerfCounters)
+    {
+        printf("Total reset: ");
+        totalResetCounters.Print();
+        printf("Total search:");
+        totalSearchCounters.Print();
+    }
+
+    if (!jsonPath.empty())
+    {
+        FILE* file = fopen(jsonPath.c_str(), "w");
+        if (!file)
+        {
+            std::cout << "ERROR: Failed to open file: " << jsonPath << std::endl;
+            return false;
+        }
+
+        const auto writeCounters = [file](const char* name, const PerfCounterValues& counters)
+        {
+            fprintf(file, "\"%s\":{", name);
+            for (uint32_t i = 0; i < NumPerfCounterTypes; ++i)
+            {
+                const PerfCounterType type = static_cast<PerfCounterType>(i);
+                if (counters.IsValid(type))
+                {
+                    fprintf(file, "\"%s\":%" PRIu64 ",", PerfCounterTypeToString(type), counters.Get(type));
+                }
+                else
+                {
+                    fprintf(file, "\"%s\":null,", PerfCounterTypeToString(type));
+                }
+            }
+            const double ipc = counters.GetIPC();
+            if (ipc >= 0.0)
+            {
+                fprintf(file, "\"ipc\":%.4f}", ipc);
+            }
+            else
+            {
+                fprintf(file, "\"ipc\":null}");
+            }
+        };
+
+        const auto writePhaseCounters = [&](const PerfCounterValues& resetCounters, const PerfCounterValues& searchCounters)
+        {
+            if (usePerfCounters)
+            {
+                writeCounters("reset", resetCounters);
+                fprintf(file, ",");
+                writeCounters("search", searchCounters);
+            }
+            else
+            {
+                fprintf(file, "\"reset\":null,\"search\":null");
+            }
+        };
+
+        fprintf(file, "{\n\"engine\":\"%s\",\n", c_EngineName);
+        fprintf(file, "\"depth\":%u,\n\"threads\":%u,\n\"hash\":%u,\n\"runs\":%u,\n", maxDepth, numThreads, hashSizeInMB, numRuns);
+        fprintf(file, "\"signature\":%" PRIu64 ",\n\"deterministic\":%s,\n", signature, deterministic ? "true" : "false");
+
+        fprintf(file, "\"runNps\":[");
+        for (size_t i = 0; i < runNps.size(); ++i)
+        {
+            fprintf(file, "%s%.1f", i > 0 ? "," : "", runNps[i]);
+        }
+        fprintf(file, "],\n");
+
+        fprintf(file, "\"positions\":[\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const PositionResult& result = results[i];
+            fprintf(file, "{\"fen\":\"%s\",\"bestMove\":\"%s\",\"nodes\":%" PRIu64 ",\"time\":%.6f,",
+                positions[i].c_str(), result.bestMove.c_str(), result.nodes, result.time);
+            writePhaseCounters(result.resetCounters, result.searchCounters);
+            fprintf(file, "}%s\n", i + 1 < results.size() ? "," : "");
+        }
+        fprintf(file, "],\n\"total\":{\"nodes\":%" PRIu64 ",\"time\":%.6f,\"nps\":%" PRIu64 ",",
+            totalNodes, totalTime, static_cast<uint64_t>(totalNodes / totalTime));
+        writePhaseCounters(totalResetCounters, totalSearchCounters);
+        fprintf(file, "}\n}\n");
+
+        fclose(file);
+    }
 
 #ifdef NN_ACCUMULATOR_STATS
     PrintNNEvaluatorStats();
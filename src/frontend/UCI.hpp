@@ -4,6 +4,9 @@
 #include "../backend/Search.hpp"
 #include "../backend/TranspositionTable.hpp"
 #include "../backend/Waitable.hpp"
+#include "../backend/Profiler.hpp"
+#include "../backend/OpeningBook.hpp"
+#include "Telemetry.hpp"
 
 #include <mutex>
 #include <vector>
@@ -21,6 +24,12 @@ struct Options
     bool useStandardAlgebraicNotation = false;
     bool colorConsoleOutput = false;
     bool showWDL = false;
+    bool reuseSearchTree = false;
+    bool ownBook = false;
+    bool bookVariety = false;
+    uint32_t bookDepth = 32;
+    uint32_t nodeCacheSize = NodeCache::DefaultSize / 1024;
+    uint32_t nodeCacheDepth = NodeCache::DefaultMaxDistanceFromRoot;
 };
 
 struct SearchTaskContext
@@ -47,6 +56,7 @@ public:
 private:
     bool Command_Position(const std::vector<std::string>& args);
     bool Command_Go(const std::vector<std::string>& args);
+    bool TryPlayBookMove();
     bool Command_Stop();
     bool Command_PonderHit();
     bool Command_Perft(const std::vector<std::string>& args);
@@ -55,7 +65,10 @@ private:
     bool Command_TranspositionTableProbe();
     bool Command_TablebaseProbe();
     bool Command_ScoreMoves();
-    bool Command_Benchmark();
+    bool Command_Benchmark(const std::vector<std::string>& args);
+#ifdef ENABLE_PROFILER
+    bool Command_Profile(const std::vector<std::string>& args);
+#endif // ENABLE_PROFILER
 
     void StopSearchThread();
     void DoSearch();
@@ -65,6 +78,7 @@ private:
     Game mGame;
     Search mSearch;
     TranspositionTable mTranspositionTable;
+    OpeningBook mOpeningBook;
     Options mOptions;
 
     Position mPrevSearchPosition;
@@ -79,5 +93,8 @@ private:
 
     std::unique_ptr<SearchTaskContext> mSearchCtx;
 
+    // must be destroyed before the search
+    TelemetryServer mTelemetryServer{ mSearch };
+
     std::vector<std::string> mCommandArgs;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Common.hpp"
 #include "GameCollection.hpp"
 #include "ThreadPool.hpp"
+#include "Async.hpp"
 
 #include "../backend/Position.hpp"
 #include "../backend/Material.hpp"
@@ -68,22 +69,17 @@ struct GamesStats
     double evalErrorSum_Score = 0.0;
 };
 
-void AnalyzeGames(const char* path, GamesStats& outStats)
+static threadpool::Async<void> AnalyzeGames(std::string path, GamesStats& outStats)
 {
     std::cout << "Reading " << path << "..." << std::endl;
 
-    FileInputStream gamesFile(path);
-
     GamesStats localStats;
 
-    Game game;
-    std::vector<Move> moves;
-
-    while (GameCollection::ReadGame(gamesFile, game, moves))
+    co_await GameCollection::ForEachGameInFileAsync(path, [&](const Game& game, const std::vector<Move>&)
     {
         Position pos = game.GetInitialPosition();
 
-        if (game.GetScore() == Game::Score::Unknown) continue;
+        if (game.GetScore() == Game::Score::Unknown) return;
 
         ASSERT(game.GetMoves().size() == game.GetMoveScores().size());
 
@@ -184,7 +180,7 @@ void AnalyzeGames(const char* path, GamesStats& outStats)
         }
 
         localStats.numGames++;
-    }
+    });
 
     {
         std::unique_lock<std::mutex> lock(outStats.mutex);
@@ -246,9 +242,9 @@ void AnalyzeGames()
 
         for (const std::filesystem::path& path : paths)
         {
-            taskBuilder.Task("LoadPositions", [path, &stats](const threadpool::TaskContext&)
+            taskBuilder.AsyncTask("LoadPositions", [path, &stats]()
             {
-                AnalyzeGames(path.string().c_str(), stats);
+                return AnalyzeGames(path.string(), stats);
             });
         }
     }
@@ -0,0 +1,112 @@
+#include "Async.hpp"
+
+namespace threadpool {
+
+namespace {
+
+// Eagerly started coroutine that frees itself when finished.
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        DetachedCoroutine get_return_object() const { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const { }
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+static DetachedCoroutine RunDetached(AsyncTaskFunction func, ThreadPool* pool, TaskID completionTask)
+{
+    {
+        Async<void> task = func();
+        co_await task;
+    }
+
+    pool->DispatchTask(completionTask);
+}
+
+} // namespace
+
+void ResumeOnThreadPool(ThreadPool& pool, std::coroutine_handle<> handle)
+{
+    TaskDesc desc([handle](const TaskContext&) { handle.resume(); });
+    desc.debugName = "ResumeCoroutine";
+    pool.CreateAndDispatchTask(desc);
+}
+
+IOThreadPool::IOThreadPool(uint32_t numThreads)
+{
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        mThreads.emplace_back(&IOThreadPool::ThreadFunc, this);
+    }
+}
+
+IOThreadPool::~IOThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCV.notify_all();
+
+    for (std::thread& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+IOThreadPool& IOThreadPool::GetInstance()
+{
+    static IOThreadPool sInstance(DefaultNumThreads);
+    return sInstance;
+}
+
+void IOThreadPool::Submit(Job&& job)
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mCV.notify_one();
+}
+
+void IOThreadPool::ThreadFunc()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCV.wait(lock, [this]() { return mStop || !mJobs.empty(); });
+
+            if (mJobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+void TaskBuilder::AsyncTask(const char* debugName, const AsyncTaskFunction& func)
+{
+    Task(debugName, [debugName, func](const TaskContext& context)
+    {
+        // this task is kept unfinished by the completion sub-task, until the coroutine finishes
+        TaskDesc desc;
+        desc.debugName = debugName;
+        desc.parent = context.taskId;
+        const TaskID completionTask = context.pool->CreateTask(desc);
+
+        RunDetached(func, context.pool, completionTask);
+    });
+}
+
+} // namespace threadpool
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+#include "Stream.hpp"
+
+#include "../backend/Waitable.hpp"
+#include "../backend/Memory.hpp"
+
+#include <coroutine>
+#include <optional>
+#include <exception>
+#include <type_traits>
+
+namespace threadpool {
+
+namespace detail {
+
+struct AsyncPromiseBase
+{
+    // coroutine awaiting this one, resumed when this coroutine finishes
+    std::coroutine_handle<> mContinuation;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            const std::coroutine_handle<> continuation = handle.promise().mContinuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+
+    // coroutine frame allocation ignores alignment of the locals, so align the frames
+    // to a cache line, which is enough for over-aligned types like Position
+    static void* operator new(size_t size) { return AlignedMalloc(size, CACHELINE_SIZE); }
+    static void operator delete(void* ptr) { AlignedFree(ptr); }
+};
+
+template<typename T>
+struct AsyncPromise : public AsyncPromiseBase
+{
+    std::optional<T> mValue;
+
+    Async<T> get_return_object();
+    void return_value(T value) { mValue.emplace(std::move(value)); }
+    T GetResult() { return std::move(*mValue); }
+};
+
+template<>
+struct AsyncPromise<void> : public AsyncPromiseBase
+{
+    Async<void> get_return_object();
+    void return_void() const { }
+    void GetResult() const { }
+};
+
+} // namespace detail
+
+/**
+ * @brief Lazily started coroutine.
+ * @remarks The coroutine starts when awaited (or when pushed via TaskBuilder::AsyncTask).
+ *          Awaiting coroutine is resumed on the thread that finished the awaited one.
+ *          Referenced coroutine parameters must outlive the coroutine. TaskBuilder::AsyncTask keeps
+ *          the function object alive until the coroutine finishes, so coroutine lambdas can use their captures.
+ */
+template<typename T = void>
+class Async final
+{
+public:
+    using promise_type = detail::AsyncPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Async() = default;
+    explicit Async(Handle handle) : mHandle(handle) { }
+    Async(Async&& other) noexcept : mHandle(other.mHandle) { other.mHandle = nullptr; }
+    Async& operator=(Async&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (mHandle) mHandle.destroy();
+            mHandle = other.mHandle;
+            other.mHandle = nullptr;
+        }
+        return *this;
+    }
+    ~Async() { if (mHandle) mHandle.destroy(); }
+
+    bool await_ready() const noexcept { return !mHandle || mHandle.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        mHandle.promise().mContinuation = awaiting;
+        return mHandle;
+    }
+
+    T await_resume() { return mHandle.promise().GetResult(); }
+
+private:
+    Async(const Async&) = delete;
+    Async& operator=(const Async&) = delete;
+
+    Handle mHandle = nullptr;
+};
+
+template<typename T>
+inline Async<T> detail::AsyncPromise<T>::get_return_object()
+{
+    return Async<T>(std::coroutine_handle<AsyncPromise<T>>::from_promise(*this));
+}
+
+inline Async<void> detail::AsyncPromise<void>::get_return_object()
+{
+    return Async<void>(std::coroutine_handle<AsyncPromise<void>>::from_promise(*this));
+}
+
+// resume coroutine as a new task on the thread pool
+void ResumeOnThreadPool(ThreadPool& pool, std::coroutine_handle<> handle);
+
+/**
+ * @brief Small pool of threads executing blocking calls (file reads, waiting), so the CPU workers never block.
+ */
+class IOThreadPool final
+{
+public:
+    using Job = std::function<void()>;
+
+    static constexpr uint32_t DefaultNumThreads = 2;
+
+    explicit IOThreadPool(uint32_t numThreads);
+    ~IOThreadPool();
+
+    static IOThreadPool& GetInstance();
+
+    // NOTE This function is thread-safe.
+    void Submit(Job&& job);
+
+private:
+    IOThreadPool(const IOThreadPool&) = delete;
+
+    void ThreadFunc();
+
+    std::vector<std::thread> mThreads;
+    std::deque<Job> mJobs;
+    std::mutex mMutex;
+    std::condition_variable mCV;
+    bool mStop = false;
+};
+
+// Awaitable executing a blocking function on the I/O thread pool.
+// The awaiting coroutine is resumed on the CPU thread pool afterwards.
+template<typename Func>
+class BlockingCallAwaiter
+{
+public:
+    using ResultType = std::invoke_result_t<Func>;
+
+    explicit BlockingCallAwaiter(Func&& func) : mFunc(std::move(func)) { }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        IOThreadPool::GetInstance().Submit([this, handle]()
+        {
+            if constexpr (std::is_void_v<ResultType>)
+            {
+                mFunc();
+            }
+            else
+            {
+                mResult.emplace(mFunc());
+            }
+            ResumeOnThreadPool(ThreadPool::GetInstance(), handle);
+        });
+    }
+
+    ResultType await_resume()
+    {
+        if constexpr (!std::is_void_v<ResultType>)
+        {
+            return std::move(*mResult);
+        }
+    }
+
+private:
+    struct Empty { };
+    using StorageType = std::conditional_t<std::is_void_v<ResultType>, Empty, ResultType>;
+
+    Func mFunc;
+    std::optional<StorageType> mResult;
+};
+
+// run a blocking function on the I/O thread pool
+template<typename Func>
+inline BlockingCallAwaiter<Func> RunBlocking(Func func)
+{
+    return BlockingCallAwaiter<Func>(std::move(func));
+}
+
+// read 'size' bytes at given file offset without blocking CPU workers
+// Note: multiple reads from the same stream can be in flight at the same time
+inline auto ReadAsync(FileInputStream& stream, uint64_t offset, void* data, size_t size)
+{
+    return RunBlocking([&stream, offset, data, size]() { return stream.ReadAt(offset, data, size); });
+}
+
+// wait for a waitable object without blocking CPU workers
+inline auto WaitAsync(Waitable& waitable)
+{
+    return RunBlocking([&waitable]() { waitable.Wait(); });
+}
+
+} // namespace threadpool
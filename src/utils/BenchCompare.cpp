@@ -0,0 +1,289 @@
+#include "Common.hpp"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+struct BenchReport
+{
+    uint32_t depth = 0;
+    uint32_t threads = 0;
+    uint32_t hash = 0;
+    uint64_t signature = 0;
+    std::vector<double> runNps;
+
+    double Mean() const
+    {
+        double sum = 0.0;
+        for (const double nps : runNps) sum += nps;
+        return sum / runNps.size();
+    }
+
+    double Variance() const
+    {
+        if (runNps.size() < 2)
+        {
+            return 0.0;
+        }
+
+        const double mean = Mean();
+        double sum = 0.0;
+        for (const double nps : runNps) sum += (nps - mean) * (nps - mean);
+        return sum / (runNps.size() - 1);
+    }
+};
+
+// find value stored under given top-level key in the bench JSON report, returns pointer past the colon
+static const char* FindJsonValue(const std::string& json, const char* key)
+{
+    const std::string pattern = std::string("\"") + key + "\"";
+    const size_t pos = json.find(pattern);
+    if (pos == std::string::npos)
+    {
+        return nullptr;
+    }
+
+    const char* ptr = json.c_str() + pos + pattern.size();
+    while (isspace(*ptr)) ptr++;
+    if (*ptr != ':')
+    {
+        return nullptr;
+    }
+    ptr++;
+    while (isspace(*ptr)) ptr++;
+    return ptr;
+}
+
+static bool FindJsonNumber(const std::string& json, const char* key, double& outValue)
+{
+    const char* begin = FindJsonValue(json, key);
+    if (!begin)
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    outValue = strtod(begin, &end);
+    return end != begin;
+}
+
+static bool LoadBenchReport(const std::string& path, BenchReport& outReport)
+{
+    std::ifstream file(path);
+    if (!file.good())
+    {
+        std::cout << "ERROR: Failed to open file: " << path << std::endl;
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string json = buffer.str();
+
+    double depth = 0.0, threads = 0.0, hash = 0.0, signature = 0.0;
+    if (!FindJsonNumber(json, "depth", depth) ||
+        !FindJsonNumber(json, "threads", threads) ||
+        !FindJsonNumber(json, "hash", hash) ||
+        !FindJsonNumber(json, "signature", signature))
+    {
+        std::cout << "ERROR: Invalid bench report: " << path << std::endl;
+        return false;
+    }
+
+    outReport.depth = static_cast<uint32_t>(depth);
+    outReport.threads = static_cast<uint32_t>(threads);
+    outReport.hash = static_cast<uint32_t>(hash);
+    outReport.signature = static_cast<uint64_t>(signature);
+
+    const char* ptr = FindJsonValue(json, "runNps");
+    if (ptr && *ptr == '[')
+    {
+        ptr++;
+        for (;;)
+        {
+            char* end = nullptr;
+            const double nps = strtod(ptr, &end);
+            if (end == ptr)
+            {
+                break;
+            }
+            outReport.runNps.push_back(nps);
+            ptr = end;
+            while (isspace(*ptr)) ptr++;
+            if (*ptr != ',') break;
+            ptr++;
+        }
+    }
+
+    if (outReport.runNps.empty())
+    {
+        std::cout << "ERROR: Missing NPS samples in bench report: " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// continued fraction for regularized incomplete beta function
+static double IncompleteBetaContinuedFraction(double a, double b, double x)
+{
+    const double epsilon = 1.0e-12;
+    const double tiny = 1.0e-300;
+
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    if (fabs(d) < tiny) d = tiny;
+    d = 1.0 / d;
+    double h = d;
+
+    for (int32_t m = 1; m <= 200; ++m)
+    {
+        const double m2 = 2.0 * m;
+
+        double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + aa * d;
+        if (fabs(d) < tiny) d = tiny;
+        c = 1.0 + aa / c;
+        if (fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        h *= d * c;
+
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + aa * d;
+        if (fabs(d) < tiny) d = tiny;
+        c = 1.0 + aa / c;
+        if (fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        const double delta = d * c;
+        h *= delta;
+
+        if (fabs(delta - 1.0) < epsilon)
+        {
+            break;
+        }
+    }
+
+    return h;
+}
+
+static double RegularizedIncompleteBeta(double a, double b, double x)
+{
+    if (x <= 0.0) return 0.0;
+    if (x >= 1.0) return 1.0;
+
+    const double logFront = lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1.0 - x);
+
+    if (x < (a + 1.0) / (a + b + 2.0))
+    {
+        return exp(logFront) * IncompleteBetaContinuedFraction(a, b, x) / a;
+    }
+    else
+    {
+        return 1.0 - exp(logFront) * IncompleteBetaContinuedFraction(b, a, 1.0 - x) / b;
+    }
+}
+
+// Student's t-distribution cumulative distribution function
+static double StudentTCDF(double t, double degreesOfFreedom)
+{
+    const double x = degreesOfFreedom / (degreesOfFreedom + t * t);
+    const double tail = 0.5 * RegularizedIncompleteBeta(0.5 * degreesOfFreedom, 0.5, x);
+    return t < 0.0 ? tail : 1.0 - tail;
+}
+
+// Compares NPS of two "bench ... runs <N> json <path>" reports using Welch's t-test.
+// Fails if the candidate is slower than the baseline by more than 'threshold' percent with p-value below 'alpha'.
+// Usage: benchcompare <baseline.json> <candidate.json> [threshold <percent>] [alpha <p-value>]
+bool BenchCompare(const std::vector<std::string>& args)
+{
+    if (args.size() < 2)
+    {
+        std::cout << "Usage: benchcompare <baseline.json> <candidate.json> [threshold <percent>] [alpha <p-value>]" << std::endl;
+        return false;
+    }
+
+    double threshold = 1.0;
+    double alpha = 0.05;
+
+    for (size_t i = 2; i + 1 < args.size(); i += 2)
+    {
+        if (args[i] == "threshold")
+        {
+            threshold = atof(args[i + 1].c_str());
+        }
+        else if (args[i] == "alpha")
+        {
+            alpha = atof(args[i + 1].c_str());
+        }
+        else
+        {
+            std::cout << "ERROR: Unknown argument: " << args[i] << std::endl;
+            return false;
+        }
+    }
+
+    BenchReport baseline, candidate;
+    if (!LoadBenchReport(args[0], baseline) || !LoadBenchReport(args[1], candidate))
+    {
+        return false;
+    }
+
+    if (baseline.depth != candidate.depth || baseline.threads != candidate.threads || baseline.hash != candidate.hash)
+    {
+        std::cout << "WARNING: Bench settings differ (depth/threads/hash): "
+            << baseline.depth << "/" << baseline.threads << "/" << baseline.hash << " vs. "
+            << candidate.depth << "/" << candidate.threads << "/" << candidate.hash << std::endl;
+    }
+
+    if (baseline.signature != candidate.signature)
+    {
+        std::cout << "WARNING: Signatures differ, search is functionally different: "
+            << baseline.signature << " vs. " << candidate.signature << std::endl;
+    }
+
+    const double baselineMean = baseline.Mean();
+    const double candidateMean = candidate.Mean();
+    const double change = 100.0 * (candidateMean - baselineMean) / baselineMean;
+
+    printf("Baseline:  %.0f +/- %.0f nps (%zu runs)\n", baselineMean, sqrt(baseline.Variance()), baseline.runNps.size());
+    printf("Candidate: %.0f +/- %.0f nps (%zu runs)\n", candidateMean, sqrt(candidate.Variance()), candidate.runNps.size());
+    printf("Change:    %+.2f%%\n", change);
+
+    // one-sided p-value of the candidate being slower than the baseline (without enough samples only the threshold is checked)
+    double pValue = 0.0;
+    if (baseline.runNps.size() >= 2 && candidate.runNps.size() >= 2)
+    {
+        const double baselineSE = baseline.Variance() / baseline.runNps.size();
+        const double candidateSE = candidate.Variance() / candidate.runNps.size();
+        const double standardError = sqrt(baselineSE + candidateSE);
+
+        if (standardError > 0.0)
+        {
+            const double t = (candidateMean - baselineMean) / standardError;
+
+            // Welch-Satterthwaite equation
+            const double degreesOfFreedom = (baselineSE + candidateSE) * (baselineSE + candidateSE) /
+                (baselineSE * baselineSE / (baseline.runNps.size() - 1) + candidateSE * candidateSE / (candidate.runNps.size() - 1));
+
+            pValue = StudentTCDF(t, degreesOfFreedom);
+            printf("t-value:   %.3f (df = %.1f), p-value: %.4f\n", t, degreesOfFreedom, pValue);
+        }
+    }
+    else
+    {
+        std::cout << "WARNING: At least 2 runs per report are required for significance test" << std::endl;
+    }
+
+    const bool regression = change < -threshold && pValue < alpha;
+    if (regression)
+    {
+        std::cout << "FAILED: NPS regression detected" << std::endl;
+    }
+    else
+    {
+        std::cout << "PASSED" << std::endl;
+    }
+
+    return !regression;
+}
@@ -0,0 +1,167 @@
+#include "Common.hpp"
+#include "GameCollection.hpp"
+
+#include "../backend/OpeningBook.hpp"
+#include "../backend/Position.hpp"
+#include "../backend/Time.hpp"
+
+#include <filesystem>
+#include <unordered_map>
+
+struct BookMoveKey
+{
+    uint64_t hash;
+    uint16_t move;
+
+    bool operator == (const BookMoveKey& other) const { return hash == other.hash && move == other.move; }
+};
+
+struct BookMoveKeyHasher
+{
+    size_t operator()(const BookMoveKey& key) const
+    {
+        return static_cast<size_t>(key.hash ^ (static_cast<uint64_t>(key.move) * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+struct BookMoveStats
+{
+    uint32_t wins = 0;
+    uint32_t draws = 0;
+    uint32_t losses = 0;
+};
+
+// Builds opening book from game collection files (or directories).
+// Each move played at most 'maxPly' plies from the initial position is added if it was played in at least 'minGames' games.
+// Move weight is 2 * wins + draws (from the side to move perspective).
+// Usage: buildBook <output> <input>... [maxPly <plies>] [minGames <count>]
+bool BuildBook(const std::vector<std::string>& args)
+{
+    if (args.size() < 2)
+    {
+        std::cout << "Usage: buildBook <output> <input>... [maxPly <plies>] [minGames <count>]" << std::endl;
+        return false;
+    }
+
+    uint32_t maxPly = 24;
+    uint32_t minGames = 3;
+    std::vector<std::string> inputPaths;
+
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        if (args[i] == "maxPly" && i + 1 < args.size())
+        {
+            maxPly = std::max(1, atoi(args[++i].c_str()));
+        }
+        else if (args[i] == "minGames" && i + 1 < args.size())
+        {
+            minGames = std::max(1, atoi(args[++i].c_str()));
+        }
+        else if (std::filesystem::is_directory(args[i]))
+        {
+            for (const auto& path : std::filesystem::directory_iterator(args[i]))
+            {
+                inputPaths.push_back(path.path().string());
+            }
+        }
+        else
+        {
+            inputPaths.push_back(args[i]);
+        }
+    }
+
+    const TimePoint startTime = TimePoint::GetCurrent();
+
+    std::unordered_map<BookMoveKey, BookMoveStats, BookMoveKeyHasher> stats;
+    uint64_t numGames = 0;
+
+    for (const std::string& inputPath : inputPaths)
+    {
+        std::cout << "Reading " << inputPath << "..." << std::endl;
+
+        const bool success = GameCollection::ForEachGameInFile(inputPath.c_str(), [&](const Game& game, const std::vector<Move>&)
+        {
+            const Game::Score score = game.GetScore();
+            if (score == Game::Score::Unknown)
+            {
+                return;
+            }
+
+            numGames++;
+
+            Position pos = game.GetInitialPosition();
+            const std::vector<Move>& moves = game.GetMoves();
+            const size_t numMoves = std::min<size_t>(moves.size(), maxPly);
+
+            for (size_t i = 0; i < numMoves; ++i)
+            {
+                const Move move = moves[i];
+                BookMoveStats& moveStats = stats[BookMoveKey{ pos.GetHash(), PackedMove(move).value }];
+
+                if (score == Game::Score::Draw)
+                    moveStats.draws++;
+                else if ((score == Game::Score::WhiteWins) == (pos.GetSideToMove() == White))
+                    moveStats.wins++;
+                else
+                    moveStats.losses++;
+
+                if (!pos.DoMove(move))
+                {
+                    break;
+                }
+            }
+        });
+
+        if (!success)
+        {
+            std::cout << "ERROR: Failed to read games from " << inputPath << std::endl;
+            return false;
+        }
+    }
+
+    // weights are stored as 16-bit values, so rescale them if needed
+    uint64_t maxWeight = 0;
+    for (const auto& [key, moveStats] : stats)
+    {
+        maxWeight = std::max<uint64_t>(maxWeight, 2ull * moveStats.wins + moveStats.draws);
+    }
+    const double weightScale = maxWeight > UINT16_MAX ? static_cast<double>(UINT16_MAX) / static_cast<double>(maxWeight) : 1.0;
+
+    std::vector<OpeningBookEntry> entries;
+    for (const auto& [key, moveStats] : stats)
+    {
+        const uint32_t numMoveGames = moveStats.wins + moveStats.draws + moveStats.losses;
+        const uint16_t weight = static_cast<uint16_t>(weightScale * (2.0 * moveStats.wins + moveStats.draws));
+        if (numMoveGames < minGames || weight == 0)
+        {
+            continue;
+        }
+
+        OpeningBookEntry entry;
+        entry.hash = key.hash;
+        entry.move.value = key.move;
+        entry.weight = weight;
+        entry.score = static_cast<int16_t>(1000 * (static_cast<int32_t>(moveStats.wins) - static_cast<int32_t>(moveStats.losses)) / static_cast<int32_t>(numMoveGames));
+        entry.padding = 0;
+        entries.push_back(entry);
+    }
+
+    // empty book would be rejected when loading
+    if (entries.empty())
+    {
+        std::cout << "ERROR: No book moves were played in at least " << minGames << " games" << std::endl;
+        return false;
+    }
+
+    if (!OpeningBook::SaveToFile(args[0].c_str(), entries))
+    {
+        return false;
+    }
+
+    std::cout << "Games:   " << numGames << std::endl;
+    std::cout << "Moves:   " << stats.size() << std::endl;
+    std::cout << "Entries: " << entries.size() << std::endl;
+    std::cout << "Time:    " << (TimePoint::GetCurrent() - startTime).ToSeconds() << " s" << std::endl;
+
+    return true;
+}
@@ -0,0 +1,235 @@
+#include "Common.hpp"
+#include "GameCollection.hpp"
+
+#include "../backend/Time.hpp"
+
+#include <filesystem>
+#include <random>
+#include <thread>
+
+struct ReadBenchmarkResult
+{
+    std::atomic<uint64_t> numGames = 0;
+    std::atomic<uint64_t> numMoves = 0;
+    uint64_t numBytes = 0;
+    float time = 0.0f;
+
+    void Print(const char* name) const
+    {
+        const double megabytes = static_cast<double>(numBytes) / (1024.0 * 1024.0);
+        std::cout
+            << name << ": "
+            << numGames << " games, "
+            << megabytes << " MB, "
+            << time << " s, "
+            << (megabytes / time) << " MB/s, "
+            << (numGames / time) << " games/s, "
+            << (numMoves / time) << " moves/s" << std::endl;
+    }
+};
+
+// Converts v1 game collections into compressed (v2) format and compares read throughput of both formats.
+// Usage: compressGames [inputDir] [outputDir]
+void CompressGames(const std::vector<std::string>& args)
+{
+    const std::string inputPath = args.size() > 0 ? args[0] : DATA_PATH "selfplayGames/";
+    const std::string outputPath = args.size() > 1 ? args[1] : DATA_PATH "selfplayGamesCompressed/";
+
+    std::filesystem::create_directories(outputPath);
+
+    ReadBenchmarkResult v1Result;
+    ReadBenchmarkResult v2Result;
+    ReadBenchmarkResult v2ParallelResult;
+
+    for (const auto& path : std::filesystem::directory_iterator(inputPath))
+    {
+        const std::string inputFileName = path.path().string();
+        const std::string outputFileName = outputPath + path.path().filename().string();
+
+        if (GameCollection::IsCompressedCollection(inputFileName.c_str()))
+        {
+            std::cout << "Skipping already compressed file " << inputFileName << std::endl;
+            continue;
+        }
+
+        std::cout << "Compressing " << inputFileName << "..." << std::endl;
+
+        // v1 sequential read
+        {
+            const TimePoint startTime = TimePoint::GetCurrent();
+            GameCollection::ForEachGameInFile(inputFileName.c_str(), [&](const Game& game, const std::vector<Move>&)
+            {
+                v1Result.numGames++;
+                v1Result.numMoves += game.GetMoves().size();
+            });
+            v1Result.time += (TimePoint::GetCurrent() - startTime).ToSeconds();
+            v1Result.numBytes += std::filesystem::file_size(path.path());
+        }
+
+        // convert
+        {
+            FileOutputStream outputFile(outputFileName.c_str());
+            if (!outputFile.IsOpen())
+            {
+                continue;
+            }
+
+            GameCollection::CompressedWriter writer(outputFile);
+            GameCollection::ForEachGameInFile(inputFileName.c_str(), [&](const Game& game, const std::vector<Move>&)
+            {
+                writer.WriteGame(game);
+            });
+
+            if (!writer.Finish())
+            {
+                std::cout << "Failed to write " << outputFileName << std::endl;
+                continue;
+            }
+        }
+
+        const uint64_t compressedSize = std::filesystem::file_size(outputFileName);
+
+        // v2 sequential read
+        {
+            const TimePoint startTime = TimePoint::GetCurrent();
+            GameCollection::ForEachGameInFile(outputFileName.c_str(), [&](const Game& game, const std::vector<Move>&)
+            {
+                v2Result.numGames++;
+                v2Result.numMoves += game.GetMoves().size();
+            });
+            v2Result.time += (TimePoint::GetCurrent() - startTime).ToSeconds();
+            v2Result.numBytes += compressedSize;
+        }
+
+        // v2 parallel read
+        {
+            const TimePoint startTime = TimePoint::GetCurrent();
+            GameCollection::CompressedReader reader;
+            if (reader.Open(outputFileName.c_str()))
+            {
+                GameCollection::ForEachGameInFile_Parallel(reader, [&](const Game& game, const std::vector<Move>&)
+                {
+                    v2ParallelResult.numGames++;
+                    v2ParallelResult.numMoves += game.GetMoves().size();
+                });
+            }
+            v2ParallelResult.time += (TimePoint::GetCurrent() - startTime).ToSeconds();
+            v2ParallelResult.numBytes += compressedSize;
+        }
+    }
+
+    if (v1Result.numGames == 0)
+    {
+        std::cout << "No games found in " << inputPath << std::endl;
+        return;
+    }
+
+    std::cout << std::endl;
+    std::cout << "Compression ratio: " << (static_cast<double>(v1Result.numBytes) / v2Result.numBytes) << std::endl;
+    v1Result.Print("v1 sequential read");
+    v2Result.Print("v2 sequential read");
+    v2ParallelResult.Print("v2 parallel read  ");
+}
+
+static void GenerateRandomGame(std::mt19937& gen, Game& outGame)
+{
+    Position pos(Position::InitPositionFEN);
+    outGame.Reset(pos);
+
+    std::vector<Move> moves;
+    for (uint32_t ply = 0; ply < 160 && outGame.GetScore() == Game::Score::Unknown; ++ply)
+    {
+        moves.clear();
+        if (outGame.GetPosition().GetNumLegalMoves(&moves) == 0)
+        {
+            break;
+        }
+
+        const Move move = moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(gen)];
+        const ScoreType score = static_cast<ScoreType>(std::uniform_int_distribution<int32_t>(-300, 300)(gen));
+        VERIFY(outGame.DoMove(move, score));
+    }
+}
+
+// Measures throughput of writing games from many threads into a single file:
+// v1 collection with a mutex-protected writer vs. v2 collection with per-thread block encoders.
+// Usage: benchGameWriter [numThreads] [numGamesPerThread] [outputDir]
+void BenchmarkGameWriter(const std::vector<std::string>& args)
+{
+    const uint32_t numThreads = args.size() > 0 ? std::stoi(args[0]) : 64;
+    const uint32_t numGamesPerThread = args.size() > 1 ? std::stoi(args[1]) : 2000;
+    const std::string outputPath = args.size() > 2 ? args[2] : ".";
+
+    // pre-generate games, so only writing is measured
+    const uint32_t numUniqueGames = 256;
+    std::vector<Game> games(numUniqueGames);
+    {
+        std::mt19937 gen;
+        for (Game& game : games)
+        {
+            GenerateRandomGame(gen, game);
+        }
+    }
+
+    const auto runBenchmark = [&](const char* name, const std::function<void(uint32_t threadIndex)>& threadFunc)
+    {
+        const TimePoint startTime = TimePoint::GetCurrent();
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < numThreads; ++i)
+        {
+            threads.emplace_back(threadFunc, i);
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        const float time = (TimePoint::GetCurrent() - startTime).ToSeconds();
+        const uint64_t numGames = uint64_t(numThreads) * numGamesPerThread;
+        std::cout << name << ": " << numGames << " games, " << time << " s, " << (numGames / time) << " games/s" << std::endl;
+    };
+
+    std::cout << "Writing " << numGamesPerThread << " games from " << numThreads << " threads..." << std::endl;
+
+    {
+        const std::string fileName = outputPath + "/benchGameWriter_v1.dat";
+        FileOutputStream file(fileName.c_str());
+        GameCollection::Writer writer(file);
+
+        runBenchmark("v1 shared writer      ", [&](uint32_t threadIndex)
+        {
+            for (uint32_t i = 0; i < numGamesPerThread; ++i)
+            {
+                writer.WriteGame(games[(threadIndex + i) % numUniqueGames]);
+            }
+        });
+
+        std::filesystem::remove(fileName);
+    }
+
+    {
+        const std::string fileName = outputPath + "/benchGameWriter_v2.dat";
+        FileOutputStream file(fileName.c_str());
+        GameCollection::CompressedWriter writer(file);
+
+        runBenchmark("v2 per-thread encoders", [&](uint32_t threadIndex)
+        {
+            GameCollection::BlockEncoder encoder(writer);
+            for (uint32_t i = 0; i < numGamesPerThread; ++i)
+            {
+                encoder.WriteGame(games[(threadIndex + i) % numUniqueGames]);
+            }
+        });
+
+        VERIFY(writer.Finish());
+
+        GameCollection::CompressedReader reader;
+        if (!reader.Open(fileName.c_str()) || reader.GetNumGames() != uint64_t(numThreads) * numGamesPerThread)
+        {
+            std::cout << "ERROR: Invalid number of games written" << std::endl;
+        }
+
+        std::filesystem::remove(fileName);
+    }
+}
@@ -0,0 +1,213 @@
+#include "Compression.hpp"
+
+#include <algorithm>
+
+namespace Compression
+{
+
+static constexpr uint32_t MinMatchLength = 4;
+static constexpr uint32_t LastLiterals = 5;        // last bytes of a block are always literals
+static constexpr uint32_t MatchFindLimit = 12;     // no match can start within last bytes of a block
+static constexpr uint32_t MaxOffset = UINT16_MAX;
+static constexpr uint32_t HashTableBits = 16;
+static constexpr uint32_t HashTableSize = 1u << HashTableBits;
+static constexpr uint32_t InvalidPosition = UINT32_MAX;
+
+INLINE static uint32_t Read32(const uint8_t* ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+INLINE static uint32_t HashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32u - HashTableBits);
+}
+
+static void WriteLength(size_t length, std::vector<uint8_t>& outData)
+{
+    while (length >= 255)
+    {
+        outData.push_back(255);
+        length -= 255;
+    }
+    outData.push_back(static_cast<uint8_t>(length));
+}
+
+static void WriteSequence(const uint8_t* literals, size_t numLiterals, size_t offset, size_t matchLength, std::vector<uint8_t>& outData)
+{
+    const bool hasMatch = matchLength > 0;
+    const size_t matchLengthCode = hasMatch ? matchLength - MinMatchLength : 0;
+
+    const uint8_t token = static_cast<uint8_t>((std::min<size_t>(numLiterals, 15) << 4) | std::min<size_t>(matchLengthCode, 15));
+    outData.push_back(token);
+
+    if (numLiterals >= 15)
+    {
+        WriteLength(numLiterals - 15, outData);
+    }
+
+    outData.insert(outData.end(), literals, literals + numLiterals);
+
+    if (hasMatch)
+    {
+        ASSERT(offset > 0 && offset <= MaxOffset);
+        outData.push_back(static_cast<uint8_t>(offset & 0xFF));
+        outData.push_back(static_cast<uint8_t>(offset >> 8));
+
+        if (matchLengthCode >= 15)
+        {
+            WriteLength(matchLengthCode - 15, outData);
+        }
+    }
+}
+
+size_t GetMaxCompressedSize(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+void CompressBlock(const uint8_t* data, size_t size, std::vector<uint8_t>& outData)
+{
+    outData.reserve(outData.size() + GetMaxCompressedSize(size));
+
+    size_t anchor = 0;
+
+    if (size > MatchFindLimit)
+    {
+        thread_local std::vector<uint32_t> hashTable;
+        hashTable.resize(HashTableSize);
+        std::fill(hashTable.begin(), hashTable.end(), InvalidPosition);
+
+        const size_t matchLimit = size - LastLiterals;
+        const size_t inputLimit = size - MatchFindLimit;
+
+        size_t pos = 0;
+        while (pos < inputLimit)
+        {
+            const uint32_t sequence = Read32(data + pos);
+            uint32_t& hashEntry = hashTable[HashSequence(sequence)];
+            const uint32_t matchPos = hashEntry;
+            hashEntry = static_cast<uint32_t>(pos);
+
+            if (matchPos == InvalidPosition || pos - matchPos > MaxOffset || Read32(data + matchPos) != sequence)
+            {
+                pos++;
+                continue;
+            }
+
+            size_t matchLength = MinMatchLength;
+            while (pos + matchLength < matchLimit && data[matchPos + matchLength] == data[pos + matchLength])
+            {
+                matchLength++;
+            }
+
+            WriteSequence(data + anchor, pos - anchor, pos - matchPos, matchLength, outData);
+
+            pos += matchLength;
+            anchor = pos;
+        }
+    }
+
+    // trailing literals
+    WriteSequence(data + anchor, size - anchor, 0, 0, outData);
+}
+
+static bool ReadLength(const uint8_t*& ptr, const uint8_t* end, size_t& length)
+{
+    for (;;)
+    {
+        if (ptr >= end)
+        {
+            return false;
+        }
+
+        const uint8_t value = *ptr++;
+        length += value;
+
+        if (value != 255)
+        {
+            return true;
+        }
+    }
+}
+
+bool DecompressBlock(const uint8_t* data, size_t size, uint8_t* outData, size_t outSize)
+{
+    const uint8_t* ptr = data;
+    const uint8_t* end = data + size;
+    uint8_t* outPtr = outData;
+    uint8_t* outEnd = outData + outSize;
+
+    while (ptr < end)
+    {
+        const uint8_t token = *ptr++;
+
+        // copy literals
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !ReadLength(ptr, end, numLiterals))
+        {
+            return false;
+        }
+
+        if (numLiterals > static_cast<size_t>(end - ptr) || numLiterals > static_cast<size_t>(outEnd - outPtr))
+        {
+            return false;
+        }
+
+        memcpy(outPtr, ptr, numLiterals);
+        ptr += numLiterals;
+        outPtr += numLiterals;
+
+        // last sequence contains only literals
+        if (ptr == end)
+        {
+            break;
+        }
+
+        if (end - ptr < 2)
+        {
+            return false;
+        }
+
+        const size_t offset = ptr[0] | (ptr[1] << 8);
+        ptr += 2;
+
+        if (offset == 0 || offset > static_cast<size_t>(outPtr - outData))
+        {
+            return false;
+        }
+
+        size_t matchLength = token & 0xF;
+        if (matchLength == 15 && !ReadLength(ptr, end, matchLength))
+        {
+            return false;
+        }
+        matchLength += MinMatchLength;
+
+        if (matchLength > static_cast<size_t>(outEnd - outPtr))
+        {
+            return false;
+        }
+
+        // copy match (source and destination may overlap)
+        const uint8_t* matchPtr = outPtr - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(outPtr, matchPtr, matchLength);
+            outPtr += matchLength;
+        }
+        else
+        {
+            for (size_t i = 0; i < matchLength; ++i)
+            {
+                *outPtr++ = *matchPtr++;
+            }
+        }
+    }
+
+    return outPtr == outEnd;
+}
+
+} // namespace Compression
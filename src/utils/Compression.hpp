@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../backend/Common.hpp"
+
+#include <vector>
+
+// Fast LZ77 block compression (LZ4 block format compatible).
+// Intended for data files where decoding speed is much more important than compression ratio.
+namespace Compression
+{
+    // maximum size of compressed data for given input size (worst case: incompressible input)
+    size_t GetMaxCompressedSize(size_t size);
+
+    // compress a block of data, compressed bytes are appended to the output buffer
+    void CompressBlock(const uint8_t* data, size_t size, std::vector<uint8_t>& outData);
+
+    // decompress a block of data
+    // Note: the decompressed size must be known upfront and must match exactly
+    bool DecompressBlock(const uint8_t* data, size_t size, uint8_t* outData, size_t outSize);
+
+} // namespace Compression
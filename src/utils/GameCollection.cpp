@@ -1,5 +1,10 @@
 #include "GameCollection.hpp"
+#include "Compression.hpp"
+#include "ThreadPool.hpp"
 #include "../backend/Game.hpp"
+#include "../backend/Waitable.hpp"
+
+#include <algorithm>
 
 namespace GameCollection
 {
@@ -79,7 +84,7 @@ namespace GameCollection
         return true;
     }
 
-    bool Writer::WriteGame(const Game& game)
+    bool WriteGameToStream(OutputStream& stream, const Game& game)
     {
         ASSERT(game.GetMoves().size() <= UINT16_MAX);
 
@@ -93,7 +98,8 @@ namespace GameCollection
             return false;
         }
 
-        std::vector<MoveAndScore> moves;
+        thread_local std::vector<MoveAndScore> moves;
+        moves.clear();
         moves.reserve(game.GetMoves().size());
 
         for (size_t i = 0; i < game.GetMoves().size(); ++i)
@@ -102,23 +108,676 @@ namespace GameCollection
             moves.push_back({ game.GetMoves()[i], moveScore });
         }
 
+        if (!stream.Write(&header, sizeof(header)))
+        {
+            std::cout << "Failed to write games collection stream" << std::endl;
+            return false;
+        }
+
+        if (!stream.Write(moves.data(), sizeof(MoveAndScore) * game.GetMoves().size()))
+        {
+            std::cout << "Failed to write games collection stream" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Writer::WriteGame(const Game& game)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return WriteGameToStream(mStream, game);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    bool IsCompressedCollection(const char* path)
+    {
+        FileInputStream stream(path);
+        if (!stream.IsOpen())
+        {
+            return false;
+        }
+
+        FileHeader header;
+        if (stream.GetSize() < sizeof(FileHeader) + sizeof(FileFooter) || !stream.Read(&header, sizeof(header)))
+        {
+            return false;
+        }
+
+        return header.magic == CompressedMagic;
+    }
+
+    BlockEncoder::BlockEncoder(CompressedWriter& writer)
+        : mWriter(writer)
+    {
+        mBlockData.reserve(writer.GetBlockSize() + 16 * 1024);
+    }
+
+    BlockEncoder::~BlockEncoder()
+    {
+        Flush();
+    }
+
+    bool BlockEncoder::WriteGame(const Game& game)
+    {
+        MemoryOutputStream blockStream(mBlockData);
+        if (!WriteGameToStream(blockStream, game))
+        {
+            return false;
+        }
+
+        mNumGames++;
+
+        if (mBlockData.size() >= mWriter.GetBlockSize())
+        {
+            Flush();
+        }
+
+        return mWriter.IsOK();
+    }
+
+    void BlockEncoder::Flush()
+    {
+        if (mNumGames == 0)
+        {
+            return;
+        }
+
+        ASSERT(mBlockData.size() <= UINT32_MAX);
+
+        auto block = std::make_unique<CompressedBlock>();
+        block->uncompressedSize = static_cast<uint32_t>(mBlockData.size());
+        block->numGames = mNumGames;
+        Compression::CompressBlock(mBlockData.data(), mBlockData.size(), block->data);
+
+        mWriter.PushBlock(std::move(block));
+
+        mBlockData.clear();
+        mNumGames = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    // preallocate output file space in big chunks to reduce file system fragmentation
+    static constexpr uint64_t c_preallocationSize = 64ull * 1024ull * 1024ull;
+
+    CompressedWriter::CompressedWriter(OutputStream& stream, uint32_t blockSize)
+        : mStream(stream)
+        , mBlockSize(blockSize)
+        , mQueueHead(&mQueueStub)
+        , mQueueTail(&mQueueStub)
+    {
+        const FileHeader header;
+        if (!mStream.Write(&header, sizeof(header)))
+        {
+            mFailed = true;
+        }
+        mOffset = sizeof(header);
+
+        mEncoder = std::make_unique<BlockEncoder>(*this);
+        mWriterThread = std::thread(&CompressedWriter::WriterThreadFunc, this);
+    }
+
+    CompressedWriter::~CompressedWriter()
+    {
+        Finish();
+    }
+
+    bool CompressedWriter::WriteGame(const Game& game)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        ASSERT(!mFinished);
+        if (mFinished)
+        {
+            return false;
+        }
+
+        return mEncoder->WriteGame(game);
+    }
+
+    void CompressedWriter::PushBlock(std::unique_ptr<CompressedBlock> block)
+    {
+        mNumPendingBlocks++;
+
+        CompressedBlock* node = block.release();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        CompressedBlock* prev = mQueueHead.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+
+        // wake up the writer thread
+        mWakeCounter++;
+        mWakeCounter.notify_one();
+    }
+
+    CompressedBlock* CompressedWriter::PopBlock()
+    {
+        CompressedBlock* tail = mQueueTail;
+        CompressedBlock* next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &mQueueStub)
+        {
+            if (!next)
+            {
+                return nullptr;
+            }
+
+            mQueueTail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next)
+        {
+            mQueueTail = next;
+            return tail;
+        }
+
+        // a producer is in the middle of pushing
+        if (tail != mQueueHead.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        // re-insert the stub, so the last element can be popped
+        mQueueStub.next.store(nullptr, std::memory_order_relaxed);
+        CompressedBlock* prev = mQueueHead.exchange(&mQueueStub, std::memory_order_acq_rel);
+        prev->next.store(&mQueueStub, std::memory_order_release);
+
+        next = tail->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            mQueueTail = next;
+            return tail;
+        }
+
+        return nullptr;
+    }
+
+    void CompressedWriter::WriterThreadFunc()
+    {
+        for (;;)
+        {
+            const uint32_t wakeCounter = mWakeCounter.load();
+
+            while (CompressedBlock* block = PopBlock())
+            {
+                std::unique_ptr<CompressedBlock> blockPtr(block);
+                if (!mFailed && !WriteBlock(*blockPtr))
+                {
+                    mFailed = true;
+                }
+                mNumPendingBlocks--;
+            }
+
+            if (mStopWriterThread && mNumPendingBlocks == 0)
+            {
+                break;
+            }
+
+            mWakeCounter.wait(wakeCounter);
+        }
+    }
+
+    bool CompressedWriter::WriteBlock(const CompressedBlock& block)
+    {
+        BlockHeader header;
+        header.compressedSize = static_cast<uint32_t>(block.data.size());
+        header.uncompressedSize = block.uncompressedSize;
+        header.numGames = block.numGames;
+
+        const uint64_t blockEnd = mOffset + sizeof(BlockHeader) + block.data.size();
+        if (blockEnd > mReservedSize)
+        {
+            mReservedSize = blockEnd + c_preallocationSize;
+            mStream.Reserve(mReservedSize);
+        }
+
+        BlockInfo& info = mBlocks.emplace_back();
+        info.offset = mOffset + sizeof(BlockHeader);
+        info.firstGame = mNumGames;
+        info.compressedSize = header.compressedSize;
+        info.uncompressedSize = header.uncompressedSize;
+        info.numGames = header.numGames;
+
+        if (!mStream.Write(&header, sizeof(header)) ||
+            !mStream.Write(block.data.data(), block.data.size()))
+        {
+            std::cout << "Failed to write games collection stream" << std::endl;
+            return false;
+        }
+
+        // make sure the block hits the disk, so the data survives killing the process
+        mStream.Flush();
+
+        mOffset = blockEnd;
+        mNumGames += block.numGames;
+
+        return true;
+    }
+
+    bool CompressedWriter::Finish()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        if (mFinished)
+        {
+            return !mFailed;
+        }
+
+        mFinished = true;
+
+        mEncoder->Flush();
+
+        // drain the queue and stop the writer thread
+        mStopWriterThread = true;
+        mWakeCounter++;
+        mWakeCounter.notify_one();
+        mWriterThread.join();
+
+        if (mFailed)
+        {
+            return false;
+        }
+
+        FileFooter footer;
+        footer.indexOffset = mOffset;
+        footer.numGames = mNumGames;
+        footer.numBlocks = static_cast<uint32_t>(mBlocks.size());
+
+        if (!mStream.Write(mBlocks.data(), mBlocks.size() * sizeof(BlockInfo)) ||
+            !mStream.Write(&footer, sizeof(footer)))
+        {
+            std::cout << "Failed to write games collection index" << std::endl;
+            mFailed = true;
+            return false;
+        }
+
+        mStream.Flush();
+
+        return true;
+    }
+
+    bool CompressedReader::Open(const char* path)
+    {
+        mStream = std::make_unique<FileInputStream>(path);
+        if (!mStream->IsOpen())
+        {
+            return false;
+        }
+
+        const uint64_t fileSize = mStream->GetSize();
+
+        FileHeader header;
+        if (fileSize < sizeof(FileHeader) + sizeof(FileFooter) ||
+            !mStream->Read(&header, sizeof(header)) ||
+            header.magic != CompressedMagic)
+        {
+            std::cout << "File " << path << " is not a compressed game collection" << std::endl;
+            return false;
+        }
+
+        if (header.version != CompressedVersion)
+        {
+            std::cout << "Unsupported compressed game collection version in file " << path << ": " << header.version << std::endl;
+            return false;
+        }
+
+        FileFooter footer;
+        if (!mStream->SetPosition(fileSize - sizeof(FileFooter)) ||
+            !mStream->Read(&footer, sizeof(footer)) ||
+            footer.magic != CompressedMagic ||
+            footer.indexOffset + footer.numBlocks * sizeof(BlockInfo) + sizeof(FileFooter) != fileSize)
+        {
+            std::cout << "Missing compressed game collection footer in file " << path << ", rebuilding index..." << std::endl;
+            return RebuildIndex(fileSize);
+        }
+
+        mNumGames = footer.numGames;
+        mBlocks.resize(footer.numBlocks);
+
+        if (!mStream->SetPosition(footer.indexOffset) ||
+            !mStream->Read(mBlocks.data(), mBlocks.size() * sizeof(BlockInfo)))
+        {
+            std::cout << "Failed to read compressed game collection index from file " << path << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CompressedReader::RebuildIndex(uint64_t fileSize)
+    {
+        mNumGames = 0;
+        mBlocks.clear();
+
+        uint64_t offset = sizeof(FileHeader);
+
+        // walk through block headers, a truncated block at the end is ignored
+        BlockHeader header;
+        while (offset + sizeof(BlockHeader) <= fileSize &&
+            mStream->SetPosition(offset) &&
+            mStream->Read(&header, sizeof(header)))
+        {
+            const uint64_t dataOffset = offset + sizeof(BlockHeader);
+            if (dataOffset + header.compressedSize > fileSize)
+            {
+                break;
+            }
+
+            BlockInfo& block = mBlocks.emplace_back();
+            block.offset = dataOffset;
+            block.firstGame = mNumGames;
+            block.compressedSize = header.compressedSize;
+            block.uncompressedSize = header.uncompressedSize;
+            block.numGames = header.numGames;
+
+            mNumGames += header.numGames;
+            offset = dataOffset + header.compressedSize;
+        }
+
+        return true;
+    }
+
+    bool CompressedReader::ReadBlock(uint32_t blockIndex, std::vector<uint8_t>& outData)
+    {
+        ASSERT(blockIndex < mBlocks.size());
+        const BlockInfo& block = mBlocks[blockIndex];
+
+        thread_local std::vector<uint8_t> compressedData;
+        compressedData.resize(block.compressedSize);
+
         {
             std::unique_lock<std::mutex> lock(mMutex);
 
-            if (!mStream.Write(&header, sizeof(header)))
+            if (!mStream->SetPosition(block.offset) ||
+                !mStream->Read(compressedData.data(), compressedData.size()))
+            {
+                std::cout << "Failed to read block " << blockIndex << " from file " << mStream->GetFileName() << std::endl;
+                return false;
+            }
+        }
+
+        // decompress outside of the lock, so multiple blocks can be decoded in parallel
+        return DecompressBlock(blockIndex, compressedData, outData);
+    }
+
+    threadpool::Async<bool> CompressedReader::ReadBlockAsync(uint32_t blockIndex, std::vector<uint8_t>& outData)
+    {
+        ASSERT(blockIndex < mBlocks.size());
+        const BlockInfo& block = mBlocks[blockIndex];
+
+        // can't use thread-local buffer here, the coroutine may be resumed on other thread
+        std::vector<uint8_t> compressedData(block.compressedSize);
+
+        if (!co_await threadpool::ReadAsync(*mStream, block.offset, compressedData.data(), compressedData.size()))
+        {
+            std::cout << "Failed to read block " << blockIndex << " from file " << mStream->GetFileName() << std::endl;
+            co_return false;
+        }
+
+        co_return DecompressBlock(blockIndex, compressedData, outData);
+    }
+
+    bool CompressedReader::DecompressBlock(uint32_t blockIndex, const std::vector<uint8_t>& compressedData, std::vector<uint8_t>& outData) const
+    {
+        const BlockInfo& block = mBlocks[blockIndex];
+
+        outData.resize(block.uncompressedSize);
+        if (!Compression::DecompressBlock(compressedData.data(), compressedData.size(), outData.data(), outData.size()))
+        {
+            std::cout << "Failed to decompress block " << blockIndex << " from file " << mStream->GetFileName() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CompressedReader::ReadGame(uint64_t gameIndex, Game& game, std::vector<Move>& decodedMoves)
+    {
+        if (gameIndex >= mNumGames)
+        {
+            return false;
+        }
+
+        // find the block containing the game
+        const auto iter = std::upper_bound(mBlocks.begin(), mBlocks.end(), gameIndex,
+            [](uint64_t index, const BlockInfo& block) { return index < block.firstGame; });
+        ASSERT(iter != mBlocks.begin());
+        const uint32_t blockIndex = static_cast<uint32_t>(iter - mBlocks.begin()) - 1;
+
+        thread_local std::vector<uint8_t> blockData;
+        if (!ReadBlock(blockIndex, blockData))
+        {
+            return false;
+        }
+
+        // skip preceding games within the block
+        MemoryInputStream blockStream(blockData);
+        for (uint64_t i = mBlocks[blockIndex].firstGame; i <= gameIndex; ++i)
+        {
+            if (!GameCollection::ReadGame(blockStream, game, decodedMoves))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool ForEachGameInFile(const char* path, const GameCallback& callback)
+    {
+        Game game;
+        std::vector<Move> moves;
+
+        if (IsCompressedCollection(path))
+        {
+            CompressedReader reader;
+            if (!reader.Open(path))
             {
-                std::cout << "Failed to write games collection stream" << std::endl;
                 return false;
             }
 
-            if (!mStream.Write(moves.data(), sizeof(MoveAndScore) * game.GetMoves().size()))
+            std::vector<uint8_t> blockData;
+            for (uint32_t i = 0; i < reader.GetNumBlocks(); ++i)
+            {
+                if (!reader.ReadBlock(i, blockData))
+                {
+                    return false;
+                }
+
+                MemoryInputStream blockStream(blockData);
+                while (ReadGame(blockStream, game, moves))
+                {
+                    callback(game, moves);
+                }
+
+                // block must consist of complete games only
+                if (!blockStream.IsEndOfFile())
+                {
+                    return false;
+                }
+            }
+        }
+        else
+        {
+            FileInputStream stream(path);
+            if (!stream.IsOpen())
             {
-                std::cout << "Failed to write games collection stream" << std::endl;
                 return false;
             }
+
+            while (ReadGame(stream, game, moves))
+            {
+                callback(game, moves);
+            }
         }
 
         return true;
     }
 
+    threadpool::Async<bool> ForEachGameInFileAsync(std::string path, GameCallback callback)
+    {
+        Game game;
+        std::vector<Move> moves;
+
+        if (IsCompressedCollection(path.c_str()))
+        {
+            CompressedReader reader;
+            if (!reader.Open(path.c_str()))
+            {
+                co_return false;
+            }
+
+            std::vector<uint8_t> blockData;
+            for (uint32_t i = 0; i < reader.GetNumBlocks(); ++i)
+            {
+                if (!co_await reader.ReadBlockAsync(i, blockData))
+                {
+                    co_return false;
+                }
+
+                MemoryInputStream blockStream(blockData);
+                while (ReadGame(blockStream, game, moves))
+                {
+                    callback(game, moves);
+                }
+
+                // block must consist of complete games only
+                if (!blockStream.IsEndOfFile())
+                {
+                    co_return false;
+                }
+            }
+        }
+        else
+        {
+            FileInputStream stream(path.c_str());
+            if (!stream.IsOpen())
+            {
+                co_return false;
+            }
+
+            // v1 collection has no blocks, so read fixed-size chunks and carry incomplete game over to the next chunk
+            const uint64_t fileSize = stream.GetSize();
+            uint64_t offset = 0;
+            std::vector<uint8_t> chunkData;
+            std::vector<uint8_t> incompleteGameData;
+
+            while (offset < fileSize)
+            {
+                const size_t prevSize = chunkData.size();
+                const size_t readSize = static_cast<size_t>(std::min<uint64_t>(DefaultBlockSize, fileSize - offset));
+                chunkData.resize(prevSize + readSize);
+
+                if (!co_await threadpool::ReadAsync(stream, offset, chunkData.data() + prevSize, readSize))
+                {
+                    std::cout << "Failed to read file " << path << " offset=" << offset << std::endl;
+                    co_return false;
+                }
+                offset += readSize;
+
+                // find end of the last complete game
+                size_t completeSize = 0;
+                while (completeSize + sizeof(GameHeader) <= chunkData.size())
+                {
+                    GameHeader header;
+                    memcpy(&header, chunkData.data() + completeSize, sizeof(GameHeader));
+
+                    const size_t gameSize = sizeof(GameHeader) + header.numMoves * sizeof(MoveAndScore);
+                    if (completeSize + gameSize > chunkData.size())
+                    {
+                        break;
+                    }
+                    completeSize += gameSize;
+                }
+
+                incompleteGameData.assign(chunkData.begin() + completeSize, chunkData.end());
+                chunkData.resize(completeSize);
+
+                MemoryInputStream chunkStream(chunkData);
+                while (ReadGame(chunkStream, game, moves))
+                {
+                    callback(game, moves);
+                }
+
+                if (!chunkStream.IsEndOfFile())
+                {
+                    co_return false;
+                }
+
+                std::swap(chunkData, incompleteGameData);
+            }
+
+            if (!chunkData.empty())
+            {
+                std::cout << "Unexpected end of file " << path << std::endl;
+                co_return false;
+            }
+        }
+
+        co_return true;
+    }
+
+    // decode blocks until there are no more blocks left
+    static threadpool::Async<void> DecodeBlocks(CompressedReader& reader, const GameCallback& callback, std::atomic<uint32_t>& nextBlock, std::atomic<bool>& success)
+    {
+        std::vector<uint8_t> blockData;
+        Game game;
+        std::vector<Move> moves;
+
+        for (;;)
+        {
+            const uint32_t blockIndex = nextBlock++;
+            if (blockIndex >= reader.GetNumBlocks() || !success)
+            {
+                break;
+            }
+
+            if (!co_await reader.ReadBlockAsync(blockIndex, blockData))
+            {
+                success = false;
+                break;
+            }
+
+            MemoryInputStream blockStream(blockData);
+            while (ReadGame(blockStream, game, moves))
+            {
+                callback(game, moves);
+            }
+
+            // block must consist of complete games only
+            if (!blockStream.IsEndOfFile())
+            {
+                success = false;
+                break;
+            }
+        }
+    }
+
+    bool ForEachGameInFile_Parallel(CompressedReader& reader, const GameCallback& callback)
+    {
+        std::atomic<bool> success = true;
+        std::atomic<uint32_t> nextBlock = 0;
+
+        // more decoding coroutines than worker threads, so the workers can decode blocks while other blocks are being read
+        const uint32_t numCoroutines = std::min(reader.GetNumBlocks(), 2 * threadpool::ThreadPool::GetInstance().GetNumThreads());
+
+        Waitable waitable;
+        {
+            threadpool::TaskBuilder taskBuilder(waitable);
+            for (uint32_t i = 0; i < numCoroutines; ++i)
+            {
+                taskBuilder.AsyncTask("DecodeGamesBlocks", [&]()
+                {
+                    return DecodeBlocks(reader, callback, nextBlock, success);
+                });
+            }
+        }
+        waitable.Wait();
+
+        return success;
+    }
+
 } // namespace GameCollection
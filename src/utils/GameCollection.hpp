@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Stream.hpp"
+#include "Async.hpp"
 
 #include "../backend/PositionUtils.hpp"
 #include "../backend/Move.hpp"
@@ -8,6 +9,10 @@
 
 #include <string>
 #include <mutex>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <atomic>
 
 namespace GameCollection
 {
@@ -33,6 +38,9 @@ namespace GameCollection
 
     bool ReadGame(InputStream& stream, Game& game, std::vector<Move>& decodedMoves);
 
+    // serialize a game (header + moves) to a stream
+    bool WriteGameToStream(OutputStream& stream, const Game& game);
+
     class Writer
     {
     public:
@@ -46,4 +54,185 @@ namespace GameCollection
         std::mutex mMutex;
     };
 
+    //////////////////////////////////////////////////////////////////////////
+
+    // Compressed game collection (v2) file layout:
+    //  [FileHeader][BlockHeader 0][block 0]...[BlockHeader N-1][block N-1][BlockInfo 0]...[BlockInfo N-1][FileFooter]
+    // Each block contains compressed, serialized games (the same encoding as v1 collection).
+    // Games never cross block boundaries, so each block can be decoded independently
+    // and any game can be reached by reading a single block.
+    // If the footer is missing (e.g. self-play was interrupted) the index is rebuilt from block headers.
+
+    static constexpr uint32_t CompressedMagic = 'CGC2';
+    static constexpr uint32_t CompressedVersion = 1;
+    static constexpr uint32_t DefaultBlockSize = 1024 * 1024;
+
+    struct FileHeader
+    {
+        uint32_t magic = CompressedMagic;
+        uint32_t version = CompressedVersion;
+    };
+
+    struct BlockHeader
+    {
+        uint32_t compressedSize = 0;
+        uint32_t uncompressedSize = 0;
+        uint32_t numGames = 0;
+    };
+
+    struct BlockInfo
+    {
+        uint64_t offset = 0;            // compressed block data offset in the file
+        uint64_t firstGame = 0;         // index of the first game in the block
+        uint32_t compressedSize = 0;
+        uint32_t uncompressedSize = 0;
+        uint32_t numGames = 0;
+        uint32_t padding = 0;
+    };
+
+    struct FileFooter
+    {
+        uint64_t indexOffset = 0;       // offset of the blocks index
+        uint64_t numGames = 0;
+        uint32_t numBlocks = 0;
+        uint32_t magic = CompressedMagic;
+    };
+
+    static_assert(sizeof(BlockHeader) == 12, "BlockHeader size mismatch");
+    static_assert(sizeof(BlockInfo) == 32, "BlockInfo size mismatch");
+    static_assert(sizeof(FileFooter) == 24, "FileFooter size mismatch");
+
+    // check if a file is a compressed (v2) game collection
+    bool IsCompressedCollection(const char* path);
+
+    // compressed block waiting in the writer queue
+    struct CompressedBlock
+    {
+        std::vector<uint8_t> data;
+        uint32_t uncompressedSize = 0;
+        uint32_t numGames = 0;
+        std::atomic<CompressedBlock*> next = nullptr;
+    };
+
+    class CompressedWriter;
+
+    // Per-thread games encoder.
+    // Serializes games into a local buffer and compresses full blocks without any synchronization.
+    // Compressed blocks are handed over to the writer thread via lock-free queue.
+    // Note: all encoders must be flushed (or destroyed) before finishing the writer.
+    class BlockEncoder
+    {
+    public:
+        BlockEncoder(CompressedWriter& writer);
+        ~BlockEncoder();
+
+        bool WriteGame(const Game& game);
+
+        // compress and submit pending games
+        void Flush();
+
+    private:
+        CompressedWriter& mWriter;
+        std::vector<uint8_t> mBlockData;
+        uint32_t mNumGames = 0;
+    };
+
+    // Compressed game collection writer.
+    // Blocks are written to the output stream by a dedicated writer thread.
+    class CompressedWriter
+    {
+        friend class BlockEncoder;
+
+    public:
+        CompressedWriter(OutputStream& stream, uint32_t blockSize = DefaultBlockSize);
+        ~CompressedWriter();
+
+        // Note: this is thread-safe, but calls are serialized
+        // Use per-thread BlockEncoder objects for writing from multiple threads.
+        bool WriteGame(const Game& game);
+
+        bool IsOK() const { return mStream.IsOK() && !mFailed; }
+
+        uint32_t GetBlockSize() const { return mBlockSize; }
+
+        // flush pending blocks and write blocks index
+        // Note: no more games can be written after that
+        bool Finish();
+
+    private:
+        // push compressed block to the queue (lock-free)
+        void PushBlock(std::unique_ptr<CompressedBlock> block);
+        CompressedBlock* PopBlock();
+
+        void WriterThreadFunc();
+        bool WriteBlock(const CompressedBlock& block);
+
+        OutputStream& mStream;
+        const uint32_t mBlockSize;
+
+        std::mutex mMutex;
+        std::unique_ptr<BlockEncoder> mEncoder; // used by WriteGame()
+        bool mFinished = false;
+
+        // multiple-producer single-consumer intrusive queue
+        CompressedBlock mQueueStub;
+        std::atomic<CompressedBlock*> mQueueHead;
+        CompressedBlock* mQueueTail;
+        std::atomic<uint32_t> mNumPendingBlocks = 0;
+        std::atomic<uint32_t> mWakeCounter = 0;
+        std::atomic<bool> mStopWriterThread = false;
+        std::thread mWriterThread;
+
+        // owned by the writer thread
+        uint64_t mOffset = 0;
+        uint64_t mReservedSize = 0;
+        uint64_t mNumGames = 0;
+        std::vector<BlockInfo> mBlocks;
+        std::atomic<bool> mFailed = false;
+    };
+
+    class CompressedReader
+    {
+    public:
+        // read file header and blocks index
+        bool Open(const char* path);
+
+        uint64_t GetNumGames() const { return mNumGames; }
+        uint32_t GetNumBlocks() const { return static_cast<uint32_t>(mBlocks.size()); }
+        const BlockInfo& GetBlockInfo(uint32_t blockIndex) const { return mBlocks[blockIndex]; }
+
+        // read and decompress a block
+        // Note: this function is thread-safe
+        bool ReadBlock(uint32_t blockIndex, std::vector<uint8_t>& outData);
+
+        // read and decompress a block, without blocking the worker thread on file read
+        // Note: multiple blocks can be read at the same time
+        threadpool::Async<bool> ReadBlockAsync(uint32_t blockIndex, std::vector<uint8_t>& outData);
+
+        // random access to a game
+        bool ReadGame(uint64_t gameIndex, Game& game, std::vector<Move>& decodedMoves);
+
+    private:
+        bool RebuildIndex(uint64_t fileSize);
+        bool DecompressBlock(uint32_t blockIndex, const std::vector<uint8_t>& compressedData, std::vector<uint8_t>& outData) const;
+
+        std::unique_ptr<FileInputStream> mStream;
+        std::mutex mMutex;
+        uint64_t mNumGames = 0;
+        std::vector<BlockInfo> mBlocks;
+    };
+
+    using GameCallback = std::function<void(const Game& game, const std::vector<Move>& decodedMoves)>;
+
+    // read all games from a file (v1 or v2 format) sequentially
+    bool ForEachGameInFile(const char* path, const GameCallback& callback);
+
+    // read all games from a file (v1 or v2 format) sequentially, without blocking the worker thread on file reads
+    // Note: callback is called from worker threads, possibly different ones for consecutive games
+    threadpool::Async<bool> ForEachGameInFileAsync(std::string path, GameCallback callback);
+
+    // decode blocks of a compressed collection in parallel on the thread pool
+    // Note: callback is called from worker threads, can't be called from within a thread pool task
+    bool ForEachGameInFile_Parallel(CompressedReader& reader, const GameCallback& callback);
+
 } // namespace GameCollection
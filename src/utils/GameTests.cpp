@@ -1,8 +1,11 @@
 #include "GameCollection.hpp"
+#include "Compression.hpp"
 #include "../backend/Search.hpp"
 #include "../backend/TranspositionTable.hpp"
+#include "../backend/OpeningBook.hpp"
 
 #include <iostream>
+#include <random>
 
 #define TEST_EXPECT(x) \
     if (!(x)) { std::cout << "Test failed: " << #x << std::endl; DEBUG_BREAK(); }
@@ -28,6 +31,219 @@ static void TestGameSerialization(const Game& originalGame)
     TEST_EXPECT(readGame == originalGame);
 }
 
+static void TestCompressedGameCollection()
+{
+    const char* fileName = "test_games_v2.dat";
+
+    std::vector<Game> games;
+    {
+        Game game;
+        game.Reset(Position(Position::InitPositionFEN));
+        games.push_back(game);
+
+        TEST_EXPECT(game.DoMove(Move::Make(Square_f2, Square_f3, Piece::Pawn), 10));
+        TEST_EXPECT(game.DoMove(Move::Make(Square_e7, Square_e5, Piece::Pawn), 20));
+        TEST_EXPECT(game.DoMove(Move::Make(Square_g2, Square_g4, Piece::Pawn), -30));
+        games.push_back(game);
+
+        TEST_EXPECT(game.DoMove(Move::Make(Square_d8, Square_h4, Piece::Queen), 40));
+        games.push_back(game);
+    }
+
+    // small blocks, so the games are spread over multiple blocks
+    const uint32_t numGames = 200;
+    {
+        FileOutputStream stream(fileName);
+        GameCollection::CompressedWriter writer(stream, 256);
+        for (uint32_t i = 0; i < numGames; ++i)
+        {
+            TEST_EXPECT(writer.WriteGame(games[i % games.size()]));
+        }
+        TEST_EXPECT(writer.Finish());
+    }
+
+    TEST_EXPECT(GameCollection::IsCompressedCollection(fileName));
+
+    GameCollection::CompressedReader reader;
+    TEST_EXPECT(reader.Open(fileName));
+    TEST_EXPECT(reader.GetNumGames() == numGames);
+    TEST_EXPECT(reader.GetNumBlocks() > 1);
+
+    // random access
+    Game readGame;
+    std::vector<Move> moves;
+    for (uint32_t i : { 0u, 1u, 57u, 123u, numGames - 1 })
+    {
+        TEST_EXPECT(reader.ReadGame(i, readGame, moves));
+        TEST_EXPECT(readGame == games[i % games.size()]);
+    }
+    TEST_EXPECT(!reader.ReadGame(numGames, readGame, moves));
+
+    // sequential access
+    uint32_t gameIndex = 0;
+    TEST_EXPECT(GameCollection::ForEachGameInFile(fileName, [&](const Game& game, const std::vector<Move>&)
+    {
+        TEST_EXPECT(game == games[gameIndex % games.size()]);
+        gameIndex++;
+    }));
+    TEST_EXPECT(gameIndex == numGames);
+
+    std::remove(fileName);
+}
+
+// read games from v1 and v2 collections with coroutines
+static void TestGameCollectionAsyncRead()
+{
+    const char* fileNameV1 = "test_games_async_v1.dat";
+    const char* fileNameV2 = "test_games_async_v2.dat";
+
+    Game game;
+    game.Reset(Position(Position::InitPositionFEN));
+    TEST_EXPECT(game.DoMove(Move::Make(Square_e2, Square_e4, Piece::Pawn), 10));
+    TEST_EXPECT(game.DoMove(Move::Make(Square_e7, Square_e5, Piece::Pawn), 20));
+
+    // v1 file spans multiple read chunks, so some games cross chunk boundaries
+    const uint32_t numGames = 3 * GameCollection::DefaultBlockSize / 40;
+    {
+        FileOutputStream streamV1(fileNameV1);
+        GameCollection::Writer writerV1(streamV1);
+
+        FileOutputStream streamV2(fileNameV2);
+        GameCollection::CompressedWriter writerV2(streamV2, 4096);
+
+        for (uint32_t i = 0; i < numGames; ++i)
+        {
+            TEST_EXPECT(writerV1.WriteGame(game));
+            TEST_EXPECT(writerV2.WriteGame(game));
+        }
+        TEST_EXPECT(writerV2.Finish());
+    }
+
+    for (const char* fileName : { fileNameV1, fileNameV2 })
+    {
+        std::atomic<uint32_t> numGamesRead = 0;
+        std::atomic<bool> success = false;
+
+        Waitable waitable;
+        {
+            threadpool::TaskBuilder taskBuilder(waitable);
+            taskBuilder.AsyncTask("ReadGames", [&]() -> threadpool::Async<void>
+            {
+                success = co_await GameCollection::ForEachGameInFileAsync(fileName, [&](const Game& readGame, const std::vector<Move>&)
+                {
+                    TEST_EXPECT(readGame == game);
+                    numGamesRead++;
+                });
+            });
+        }
+        waitable.Wait();
+
+        TEST_EXPECT(success);
+        TEST_EXPECT(numGamesRead == numGames);
+    }
+
+    // parallel read
+    {
+        GameCollection::CompressedReader reader;
+        TEST_EXPECT(reader.Open(fileNameV2));
+
+        std::atomic<uint32_t> numGamesRead = 0;
+        TEST_EXPECT(GameCollection::ForEachGameInFile_Parallel(reader, [&](const Game& readGame, const std::vector<Move>&)
+        {
+            TEST_EXPECT(readGame == game);
+            numGamesRead++;
+        }));
+        TEST_EXPECT(numGamesRead == numGames);
+    }
+
+    std::remove(fileNameV1);
+    std::remove(fileNameV2);
+}
+
+extern bool BuildBook(const std::vector<std::string>& args);
+
+static void TestOpeningBook()
+{
+    const char* gamesFileName = "test_book_games.dat";
+    const char* bookFileName = "test_book.bin";
+
+    // 1.e4 wins twice, 1.d4 wins once, 1.f3 always loses
+    {
+        FileOutputStream stream(gamesFileName);
+        GameCollection::CompressedWriter writer(stream);
+
+        const auto writeGame = [&](Square from, Square to, Game::Score score)
+        {
+            Game game;
+            game.Reset(Position(Position::InitPositionFEN));
+            TEST_EXPECT(game.DoMove(Move::Make(from, to, Piece::Pawn)));
+            game.SetScore(score);
+            TEST_EXPECT(writer.WriteGame(game));
+        };
+
+        writeGame(Square_e2, Square_e4, Game::Score::WhiteWins);
+        writeGame(Square_e2, Square_e4, Game::Score::WhiteWins);
+        writeGame(Square_d2, Square_d4, Game::Score::WhiteWins);
+        writeGame(Square_f2, Square_f3, Game::Score::BlackWins);
+        TEST_EXPECT(writer.Finish());
+    }
+
+    TEST_EXPECT(BuildBook({ bookFileName, gamesFileName, "minGames", "1" }));
+
+    OpeningBook book;
+    TEST_EXPECT(book.LoadFromFile(bookFileName));
+    TEST_EXPECT(book.GetNumEntries() == 2);
+
+    const Position startPos(Position::InitPositionFEN);
+
+    const OpeningBookEntry* entries = nullptr;
+    TEST_EXPECT(book.GetEntries(startPos, entries) == 2);
+
+    Move move;
+    const OpeningBookEntry* entry = nullptr;
+    TEST_EXPECT(book.Probe(startPos, move, false, &entry));
+    TEST_EXPECT(move == Move::Make(Square_e2, Square_e4, Piece::Pawn));
+    TEST_EXPECT(entry->weight == 4);
+    TEST_EXPECT(entry->score == 1000);
+
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        TEST_EXPECT(book.Probe(startPos, move, true));
+        TEST_EXPECT(move == Move::Make(Square_e2, Square_e4, Piece::Pawn) || move == Move::Make(Square_d2, Square_d4, Piece::Pawn));
+    }
+
+    // position not in the book
+    const Position otherPos("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+    TEST_EXPECT(book.GetEntries(otherPos, entries) == 0);
+    TEST_EXPECT(!book.Probe(otherPos, move));
+
+    book.Release();
+    std::remove(gamesFileName);
+    std::remove(bookFileName);
+}
+
+static void TestCompression()
+{
+    std::vector<uint8_t> data;
+    std::mt19937 gen;
+    for (uint32_t i = 0; i < 100000; ++i)
+    {
+        // mix of random and repeated data
+        data.push_back(i % 1000 < 500 ? static_cast<uint8_t>(gen()) : static_cast<uint8_t>(i % 7));
+    }
+
+    for (size_t size : { size_t(0), size_t(1), size_t(13), size_t(100), data.size() })
+    {
+        std::vector<uint8_t> compressed;
+        Compression::CompressBlock(data.data(), size, compressed);
+        TEST_EXPECT(compressed.size() <= Compression::GetMaxCompressedSize(size));
+
+        std::vector<uint8_t> decompressed(size);
+        TEST_EXPECT(Compression::DecompressBlock(compressed.data(), compressed.size(), decompressed.data(), size));
+        TEST_EXPECT(memcmp(decompressed.data(), data.data(), size) == 0);
+    }
+}
+
 void RunGameTests()
 {
     std::cout << "Running Game tests..." << std::endl;
@@ -69,6 +285,11 @@ void RunGameTests()
         TestGameSerialization(game);
     }
 
+    TestCompression();
+    TestCompressedGameCollection();
+    TestGameCollectionAsyncRead();
+    TestOpeningBook();
+
     {
         Search search;
         TranspositionTable tt{ 16 * 1024 };
@@ -8,15 +8,23 @@
 #include <string>
 
 extern void RunUnitTests();
-extern bool RunPerformanceTests(const std::vector<std::string>& paths);
+extern bool RunPerformanceTests(const std::vector<std::string>& args);
 extern void SelfPlay(const std::vector<std::string>& args);
 extern void PrepareTrainingData(const std::vector<std::string>& args);
 extern void PlainTextToTrainingData(const std::vector<std::string>& args);
 extern void GenerateEndgamePositions();
 extern bool TestNetwork();
-extern bool TrainNetwork();
+extern bool TrainNetwork(const std::vector<std::string>& args);
 extern void ValidateEndgame();
 extern void AnalyzeGames();
+extern void CompressGames(const std::vector<std::string>& args);
+extern void BenchmarkGameWriter(const std::vector<std::string>& args);
+extern void BenchmarkTrainingDataLoader(const std::vector<std::string>& args);
+extern void BenchmarkTrainerNodes(const std::vector<std::string>& args);
+extern void BenchmarkThreadPool(const std::vector<std::string>& args);
+extern bool BenchCompare(const std::vector<std::string>& args);
+extern bool BuildBook(const std::vector<std::string>& args);
+extern bool BenchmarkSearchTreeReuse(const std::vector<std::string>& args);
 
 int main(int argc, const char* argv[])
 {
@@ -71,8 +79,24 @@ int main(int argc, const char* argv[])
         ValidateEndgame();
     else if (toolName == "analyzeGames")
         AnalyzeGames();
+    else if (toolName == "compressGames")
+        CompressGames(args);
+    else if (toolName == "benchGameWriter")
+        BenchmarkGameWriter(args);
+    else if (toolName == "benchTrainingDataLoader")
+        BenchmarkTrainingDataLoader(args);
+    else if (toolName == "benchTrainerNodes")
+        BenchmarkTrainerNodes(args);
+    else if (toolName == "benchThreadPool")
+        BenchmarkThreadPool(args);
+    else if (toolName == "benchcompare")
+        return BenchCompare(args) ? 0 : 1;
+    else if (toolName == "buildBook")
+        return BuildBook(args) ? 0 : 1;
+    else if (toolName == "benchTreeReuse")
+        return BenchmarkSearchTreeReuse(args) ? 0 : 1;
     else if (toolName == "trainNetwork")
-        TrainNetwork();
+        TrainNetwork(args);
     else if (toolName == "generateEndgamePositions")
         GenerateEndgamePositions();
     else
@@ -32,7 +32,6 @@
 #include <cmath>
 
 #define USE_PACKED_NET
-// #define USE_VIRTUAL_FEATURES
 
 using namespace threadpool;
 
@@ -40,6 +39,7 @@ static const uint32_t cMaxIterations = 1'000'000'000;
 static const uint32_t cNumTrainingVectorsPerIteration = 512 * 1024;
 static const uint32_t cNumValidationVectorsPerIteration = 128 * 1024;
 static const uint32_t cBatchSize = 32 * 1024;
+static const uint32_t cMaxFeaturesPerEntry = MaxFeaturesPerEntry;
 #ifdef USE_VIRTUAL_FEATURES
 static const uint32_t cNumVirtualFeatures = 12 * 64;
 #endif // USE_VIRTUAL_FEATURES
@@ -52,15 +52,17 @@ public:
         : m_randomGenerator(m_randomDevice())
         , m_trainingLog("training.log")
     {
-        m_validationSet.resize(cNumTrainingVectorsPerIteration);
-        m_trainingSet.resize(cNumTrainingVectorsPerIteration);
-        m_trainingSetCopy.resize(cNumTrainingVectorsPerIteration);
-        m_validationPerThreadData.resize(ThreadPool::GetInstance().GetNumThreads());
+        m_validationSet.Reserve(cNumTrainingVectorsPerIteration, cMaxFeaturesPerEntry, true);
+        m_trainingSet.Reserve(cNumTrainingVectorsPerIteration, cMaxFeaturesPerEntry, false);
+        m_nextTrainingSet.Reserve(cNumTrainingVectorsPerIteration, cMaxFeaturesPerEntry, false);
+        m_validationRunContexts.resize(ThreadPool::GetInstance().GetNumThreads());
     }
 
     void InitNetwork();
 
-    bool Train();
+    // usePrefeaturizedData - train on pre-featurized data (see ConvertTrainingDataToFeatures)
+    // Note: pawnless positions symmetry augmentation is not applied in this mode
+    bool Train(bool usePrefeaturizedData);
 
 private:
 
@@ -77,16 +79,13 @@ private:
 
         float evalMinError = std::numeric_limits<float>::max();
         float evalMaxError = 0.0f, evalErrorSum = 0.0f;
-    };
 
-    struct alignas(CACHELINE_SIZE) ValidationPerThreadData
-    {
-        ValidationStats stats;
-        nn::NeuralNetworkRunContext networkRunContext;
-        uint8_t __padding[CACHELINE_SIZE];
+        void Accumulate(const ValidationStats& rhs);
     };
 
     TrainingDataLoader m_dataLoader;
+    FeaturesDataLoader m_featuresLoader;
+    bool m_usePrefeaturizedData = false;
 
     nn::WeightsStoragePtr m_featureTransformerWeights;
     nn::WeightsStoragePtr m_lastLayerWeights;
@@ -98,10 +97,10 @@ private:
     nn::PackedNeuralNetwork m_packedNet;
 #endif // USE_PACKED_NET
 
-    std::vector<TrainingEntry> m_validationSet;
-    std::vector<TrainingEntry> m_trainingSet;
-    std::vector<TrainingEntry> m_trainingSetCopy; // copy, because training set generation runs in parallel with training
-    std::vector<ValidationPerThreadData> m_validationPerThreadData;
+    TrainingEntrySet m_validationSet;
+    TrainingEntrySet m_trainingSet;
+    TrainingEntrySet m_nextTrainingSet; // double buffering, because training set generation runs in parallel with training
+    std::vector<nn::NeuralNetworkRunContext> m_validationRunContexts; // per thread
 
     alignas(CACHELINE_SIZE)
         std::atomic<uint64_t> m_numTrainingVectorsPassed = 0;
@@ -114,7 +113,8 @@ private:
 
     std::ofstream m_trainingLog;
 
-    bool GenerateTrainingSet(std::vector<TrainingEntry>& outEntries, uint64_t kingBucketMask, float baseLambda);
+    bool GenerateTrainingSet(TrainingEntrySet& outEntries, uint64_t kingBucketMask, float baseLambda);
+    bool GenerateTrainingSetFromFeatures(TrainingEntrySet& outEntries, uint64_t kingBucketMask, float baseLambda);
 
     void Validate(size_t iteration);
 
@@ -174,59 +174,62 @@ void NetworkTrainer::InitNetwork()
 
     for (size_t i = 0; i < ThreadPool::GetInstance().GetNumThreads(); ++i)
     {
-        m_validationPerThreadData[i].networkRunContext.Init(m_network);
+        m_validationRunContexts[i].Init(m_network);
     }
 }
 
-static void PositionToTrainingEntry(const Position& pos, TrainingEntry& outEntry)
+static void AddTrainingEntry(const Position& pos, float output, TrainingEntrySet& outEntries)
 {
     ASSERT(pos.GetSideToMove() == White);
 
-    constexpr uint32_t maxFeatures = 64;
-#ifdef USE_VIRTUAL_FEATURES
-    constexpr bool useVirtualFeatures = true;
-#else
-    constexpr bool useVirtualFeatures = false;
-#endif // USE_VIRTUAL_FEATURES
-
-    uint16_t whiteFeatures[maxFeatures];
-    uint32_t numWhiteFeatures = PositionToFeaturesVector<useVirtualFeatures>(pos, whiteFeatures, pos.GetSideToMove());
-    ASSERT(numWhiteFeatures <= maxFeatures);
+    uint16_t whiteFeatures[cMaxFeaturesPerEntry];
+    uint32_t numWhiteFeatures = PositionToFeaturesVector<UseVirtualFeatures>(pos, whiteFeatures, pos.GetSideToMove());
+    ASSERT(numWhiteFeatures <= cMaxFeaturesPerEntry);
 
-    uint16_t blackFeatures[maxFeatures];
-    uint32_t numBlackFeatures = PositionToFeaturesVector<useVirtualFeatures>(pos, blackFeatures, pos.GetSideToMove() ^ 1);
+    uint16_t blackFeatures[cMaxFeaturesPerEntry];
+    uint32_t numBlackFeatures = PositionToFeaturesVector<UseVirtualFeatures>(pos, blackFeatures, pos.GetSideToMove() ^ 1);
     ASSERT(numBlackFeatures == numWhiteFeatures);
+    UNUSED(numBlackFeatures);
 
-    outEntry.whiteFeatures.clear();
-    outEntry.whiteFeatures.reserve(numWhiteFeatures);
-    for (uint32_t i = 0; i < numWhiteFeatures; ++i)
-        outEntry.whiteFeatures.emplace_back(whiteFeatures[i]);
-
-    outEntry.blackFeatures.clear();
-    outEntry.blackFeatures.reserve(numBlackFeatures);
-    for (uint32_t i = 0; i < numBlackFeatures; ++i)
-        outEntry.blackFeatures.emplace_back(blackFeatures[i]);
-
-    outEntry.networkVariant = GetNetworkVariant(pos);
+    outEntries.AddEntry(whiteFeatures, blackFeatures, numWhiteFeatures, GetNetworkVariant(pos), output, &pos);
 }
 
-static void TrainingEntryToNetworkInput(const TrainingEntry& entry, nn::InputDesc& inputDesc)
+static float ComputeTrainingTarget(ScoreType eval, uint8_t wdl, uint8_t tb, uint32_t moveCount, float baseLambda)
 {
-    inputDesc.variant = entry.networkVariant;
+    // make game score more important for high move count
+    const float wdlLambda = baseLambda * expf(-(float)moveCount / 120.0f);
+
+    const Game::Score gameScore = (Game::Score)wdl;
+    const Game::Score tbScore = (Game::Score)tb;
+    float score = InternalEvalToExpectedGameScore(eval);
+
+    if (gameScore != Game::Score::Unknown)
+    {
+        const float wdlScore = gameScore == Game::Score::WhiteWins ? 1.0f : (gameScore == Game::Score::BlackWins ? 0.0f : 0.5f);
+        score = std::lerp(wdlScore, score, wdlLambda);
+    }
 
-    inputDesc.inputs[0].mode = nn::InputMode::SparseBinary;
-    inputDesc.inputs[0].binaryFeatures = entry.whiteFeatures.data();
-    inputDesc.inputs[0].numFeatures = static_cast<uint32_t>(entry.whiteFeatures.size());
+    if (tbScore == Game::Score::Draw)
+    {
+        const float tbDrawLambda = 0.0f;
+        score = std::lerp(0.5f, score, tbDrawLambda);
+    }
+    else if (tbScore != Game::Score::Unknown)
+    {
+        const float tbLambda = 0.0f;
+        const float wdlScore = tbScore == Game::Score::WhiteWins ? 1.0f : (tbScore == Game::Score::BlackWins ? 0.0f : 0.5f);
+        score = std::lerp(wdlScore, score, tbLambda);
+    }
 
-    inputDesc.inputs[1].mode = nn::InputMode::SparseBinary;
-    inputDesc.inputs[1].binaryFeatures = entry.blackFeatures.data();
-    inputDesc.inputs[1].numFeatures = static_cast<uint32_t>(entry.blackFeatures.size());
+    return score;
 }
 
-bool NetworkTrainer::GenerateTrainingSet(std::vector<TrainingEntry>& outEntries, uint64_t kingBucketMask, float baseLambda)
+bool NetworkTrainer::GenerateTrainingSet(TrainingEntrySet& outEntries, uint64_t kingBucketMask, float baseLambda)
 {
     Position pos;
-    PositionEntry entry;
+    const PositionEntry* entry = nullptr;
+
+    outEntries.Clear();
 
     for (uint32_t i = 0; i < cNumTrainingVectorsPerIteration; ++i)
     {
@@ -242,34 +245,26 @@ bool NetworkTrainer::GenerateTrainingSet(std::vector<TrainingEntry>& outEntries,
                 pos.FlipDiagonally();
         }
 
-        // make game score more important for high move count
-        const float wdlLambda = baseLambda * expf(-(float)pos.GetMoveCount() / 120.0f);
+        const float output = ComputeTrainingTarget(entry->score, entry->wdlScore, entry->tbScore, pos.GetMoveCount(), baseLambda);
+        AddTrainingEntry(pos, output, outEntries);
+    }
 
-        const Game::Score gameScore = (Game::Score)entry.wdlScore;
-        const Game::Score tbScore = (Game::Score)entry.tbScore;
-        float score = InternalEvalToExpectedGameScore(entry.score);
+    return true;
+}
 
-        if (gameScore != Game::Score::Unknown)
-        {
-            const float wdlScore = gameScore == Game::Score::WhiteWins ? 1.0f : (gameScore == Game::Score::BlackWins ? 0.0f : 0.5f);
-            score = std::lerp(wdlScore, score, wdlLambda);
-        }
+bool NetworkTrainer::GenerateTrainingSetFromFeatures(TrainingEntrySet& outEntries, uint64_t kingBucketMask, float baseLambda)
+{
+    const FeaturesEntryHeader* entry = nullptr;
 
-        if (tbScore == Game::Score::Draw)
-        {
-            const float tbDrawLambda = 0.0f;
-            score = std::lerp(0.5f, score, tbDrawLambda);
-        }
-        else if (tbScore != Game::Score::Unknown)
-        {
-            const float tbLambda = 0.0f;
-            const float wdlScore = tbScore == Game::Score::WhiteWins ? 1.0f : (tbScore == Game::Score::BlackWins ? 0.0f : 0.5f);
-            score = std::lerp(wdlScore, score, tbLambda);
-        }
+    outEntries.Clear();
 
-        PositionToTrainingEntry(pos, outEntries[i]);
-        outEntries[i].output = score;
-        outEntries[i].pos = pos;
+    for (uint32_t i = 0; i < cNumTrainingVectorsPerIteration; ++i)
+    {
+        if (!m_featuresLoader.FetchNextEntry(m_randomGenerator, entry, kingBucketMask))
+            return false;
+
+        const float output = ComputeTrainingTarget(entry->score, entry->wdlScore, entry->tbScore, entry->moveCount, baseLambda);
+        outEntries.AddEntry(entry->GetWhiteFeatures(), entry->GetBlackFeatures(), entry->numFeatures, entry->networkVariant, output);
     }
 
     return true;
@@ -286,128 +281,129 @@ static void ParallelFor(const char* debugName, uint32_t arraySize, const threadp
 }
 
 #ifdef USE_PACKED_NET
-static float EvalPackedNetwork(const TrainingEntry& entry, const nn::PackedNeuralNetwork& net)
+static float EvalPackedNetwork(const TrainingEntrySet& entries, size_t index, const nn::PackedNeuralNetwork& net)
 {
+    const uint16_t* whiteFeatures = entries.GetWhiteFeatures(index);
+    const uint16_t* blackFeatures = entries.GetBlackFeatures(index);
+    const uint32_t numFeatures = entries.GetEntry(index).numFeatures;
+
     uint32_t numWhiteFeatures = 0;
     uint32_t numBlackFeatures = 0;
 
     // skip virtual features
-    for (size_t i = 0; i < entry.whiteFeatures.size(); ++i)
+    for (uint32_t i = 0; i < numFeatures; ++i)
     {
-        if (entry.whiteFeatures[i] >= nn::NumNetworkInputs) break;
+        if (whiteFeatures[i] >= nn::NumNetworkInputs) break;
         ++numWhiteFeatures;
     }
-    for (size_t i = 0; i < entry.blackFeatures.size(); ++i)
+    for (uint32_t i = 0; i < numFeatures; ++i)
     {
-        if (entry.blackFeatures[i] >= nn::NumNetworkInputs) break;
+        if (blackFeatures[i] >= nn::NumNetworkInputs) break;
         ++numBlackFeatures;
     }
 
     const int32_t packedNetworkOutput = net.Run(
-        entry.whiteFeatures.data(), numWhiteFeatures,
-        entry.blackFeatures.data(), numBlackFeatures,
-        entry.networkVariant);
+        whiteFeatures, numWhiteFeatures,
+        blackFeatures, numBlackFeatures,
+        entries.GetEntry(index).networkVariant);
     const float scaledPackedNetworkOutput = (float)packedNetworkOutput / (float)(nn::OutputScale * nn::WeightScale) * c_nnOutputToCentiPawns / 100.0f;
     return EvalToExpectedGameScore(scaledPackedNetworkOutput);
 }
 #endif // USE_PACKED_NET
 
+void NetworkTrainer::ValidationStats::Accumulate(const ValidationStats& rhs)
+{
+    nnErrorSum += rhs.nnErrorSum;
+    nnMinError = std::min(nnMinError, rhs.nnMinError);
+    nnMaxError = std::max(nnMaxError, rhs.nnMaxError);
+#ifdef USE_PACKED_NET
+    nnPackedQuantizationErrorSum += rhs.nnPackedQuantizationErrorSum;
+    nnPackedErrorSum += rhs.nnPackedErrorSum;
+    nnPackedMinError = std::min(nnPackedMinError, rhs.nnPackedMinError);
+    nnPackedMaxError = std::max(nnPackedMaxError, rhs.nnPackedMaxError);
+#endif // USE_PACKED_NET
+    evalErrorSum += rhs.evalErrorSum;
+    evalMinError = std::min(evalMinError, rhs.evalMinError);
+    evalMaxError = std::max(evalMaxError, rhs.evalMaxError);
+}
+
 void NetworkTrainer::Validate(size_t iteration)
 {
-    // reset stats
-    for (size_t i = 0; i < ThreadPool::GetInstance().GetNumThreads(); ++i)
-    {
-        m_validationPerThreadData[i].stats = ValidationStats();
-    }
+    ValidationStats stats;
 
     Waitable waitable;
     {
         TaskBuilder taskBuilder(waitable);
-        taskBuilder.ParallelFor("Validate", cNumValidationVectorsPerIteration, [this](const TaskContext& ctx, uint32_t i)
+        taskBuilder.ParallelReduce("Validate", cNumValidationVectorsPerIteration, stats,
+            [this](const TaskContext& ctx, uint32_t begin, uint32_t end, ValidationStats& stats)
         {
-            ValidationPerThreadData& threadData = m_validationPerThreadData[ctx.threadId];
+            nn::NeuralNetworkRunContext& networkRunContext = m_validationRunContexts[ctx.threadId];
 
-            const TrainingEntry& entry = m_validationSet[i];
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                const Position& pos = m_validationSet.GetPosition(i);
 
-            const float expectedValue = entry.output;
+                const float expectedValue = m_validationSet.GetEntry(i).output;
 
-            const ScoreType evalValue = Evaluate(entry.pos);
+                const ScoreType evalValue = Evaluate(pos);
 
 #ifdef USE_PACKED_NET
-            const float nnPackedValue = EvalPackedNetwork(entry, m_packedNet);
+                const float nnPackedValue = EvalPackedNetwork(m_validationSet, i, m_packedNet);
 #endif // USE_PACKED_NET
 
-            nn::InputDesc inputDesc;
-            TrainingEntryToNetworkInput(entry, inputDesc);
+                nn::InputDesc inputDesc;
+                m_validationSet.GetNetworkInput(i, inputDesc);
 
-            const nn::Values& networkOutput = m_network.Run(inputDesc, threadData.networkRunContext);
-            const float nnValue = networkOutput[0];
+                const nn::Values& networkOutput = m_network.Run(inputDesc, networkRunContext);
+                const float nnValue = networkOutput[0];
 
-            if (i + 1 == cNumValidationVectorsPerIteration)
-            {
-                std::cout
-                    << entry.pos.ToFEN() << std::endl << entry.pos.Print() << std::endl
-                    << "True Score:     " << expectedValue << " (" << ExpectedGameScoreToInternalEval(expectedValue) << ")" << std::endl
-                    << "NN eval:        " << nnValue << " (" << ExpectedGameScoreToInternalEval(nnValue) << ")" << std::endl
+                if (i + 1 == cNumValidationVectorsPerIteration)
+                {
+                    std::cout
+                        << pos.ToFEN() << std::endl << pos.Print() << std::endl
+                        << "True Score:     " << expectedValue << " (" << ExpectedGameScoreToInternalEval(expectedValue) << ")" << std::endl
+                        << "NN eval:        " << nnValue << " (" << ExpectedGameScoreToInternalEval(nnValue) << ")" << std::endl
 #ifdef USE_PACKED_NET
-                    << "Packed NN eval: " << nnPackedValue << " (" << ExpectedGameScoreToInternalEval(nnPackedValue) << ")" << std::endl
+                        << "Packed NN eval: " << nnPackedValue << " (" << ExpectedGameScoreToInternalEval(nnPackedValue) << ")" << std::endl
 #endif // USE_PACKED_NET
-                    << "Static eval:    " << InternalEvalToExpectedGameScore(evalValue) << " (" << evalValue << ")" << std::endl
-                    << std::endl;
-            }
+                        << "Static eval:    " << InternalEvalToExpectedGameScore(evalValue) << " (" << evalValue << ")" << std::endl
+                        << std::endl;
+                }
 
-            ValidationStats& stats = threadData.stats;
-            {
-                const float error = expectedValue - nnValue;
-                const float errorDiff = std::abs(error);
-                stats.nnErrorSum += error * error;
-                stats.nnMinError = std::min(stats.nnMinError, errorDiff);
-                stats.nnMaxError = std::max(stats.nnMaxError, errorDiff);
-            }
-            {
-                const float error = expectedValue - InternalEvalToExpectedGameScore(evalValue);
-                const float errorDiff = std::abs(error);
-                stats.evalErrorSum += error * error;
-                stats.evalMinError = std::min(stats.evalMinError, errorDiff);
-                stats.evalMaxError = std::max(stats.evalMaxError, errorDiff);
-            }
+                {
+                    const float error = expectedValue - nnValue;
+                    const float errorDiff = std::abs(error);
+                    stats.nnErrorSum += error * error;
+                    stats.nnMinError = std::min(stats.nnMinError, errorDiff);
+                    stats.nnMaxError = std::max(stats.nnMaxError, errorDiff);
+                }
+                {
+                    const float error = expectedValue - InternalEvalToExpectedGameScore(evalValue);
+                    const float errorDiff = std::abs(error);
+                    stats.evalErrorSum += error * error;
+                    stats.evalMinError = std::min(stats.evalMinError, errorDiff);
+                    stats.evalMaxError = std::max(stats.evalMaxError, errorDiff);
+                }
 #ifdef USE_PACKED_NET
-            stats.nnPackedQuantizationErrorSum += (nnValue - nnPackedValue) * (nnValue - nnPackedValue);
+                stats.nnPackedQuantizationErrorSum += (nnValue - nnPackedValue) * (nnValue - nnPackedValue);
 
-            {
-                const float error = expectedValue - nnPackedValue;
-                const float errorDiff = std::abs(error);
-                stats.nnPackedErrorSum += error * error;
-                stats.nnPackedMinError = std::min(stats.nnPackedMinError, errorDiff);
-                stats.nnPackedMaxError = std::max(stats.nnPackedMaxError, errorDiff);
-            }
+                {
+                    const float error = expectedValue - nnPackedValue;
+                    const float errorDiff = std::abs(error);
+                    stats.nnPackedErrorSum += error * error;
+                    stats.nnPackedMinError = std::min(stats.nnPackedMinError, errorDiff);
+                    stats.nnPackedMaxError = std::max(stats.nnPackedMaxError, errorDiff);
+                }
 #endif // USE_PACKED_NET
-
+            }
+        },
+        [](ValidationStats& stats, const ValidationStats& threadStats)
+        {
+            stats.Accumulate(threadStats);
         });
     }
-
     waitable.Wait();
 
-    // accumulate stats
-    ValidationStats stats;
-    for (size_t i = 0; i < ThreadPool::GetInstance().GetNumThreads(); ++i)
-    {
-        const ValidationStats& threadStats = m_validationPerThreadData[i].stats;
-
-        stats.nnErrorSum += threadStats.nnErrorSum;
-        stats.nnMinError = std::min(stats.nnMinError, threadStats.nnMinError);
-        stats.nnMaxError = std::max(stats.nnMaxError, threadStats.nnMaxError);
-#ifdef USE_PACKED_NET
-        stats.nnPackedQuantizationErrorSum += threadStats.nnPackedQuantizationErrorSum;
-        stats.nnPackedErrorSum += threadStats.nnPackedErrorSum;
-        stats.nnPackedMinError = std::min(stats.nnPackedMinError, threadStats.nnPackedMinError);
-        stats.nnPackedMaxError = std::max(stats.nnPackedMaxError, threadStats.nnPackedMaxError);
-#endif // USE_PACKED_NET
-        stats.evalErrorSum += threadStats.evalErrorSum;
-        stats.evalMinError = std::min(stats.evalMinError, threadStats.evalMinError);
-        stats.evalMaxError = std::max(stats.evalMaxError, threadStats.evalMaxError);
-    }
-
     stats.nnErrorSum = sqrtf(stats.nnErrorSum / cNumValidationVectorsPerIteration);
     stats.evalErrorSum = sqrtf(stats.evalErrorSum / cNumValidationVectorsPerIteration);
 #ifdef USE_PACKED_NET
@@ -444,20 +440,23 @@ void NetworkTrainer::Validate(size_t iteration)
             "8/8/8/p7/K5R1/1n6/1k1r4/8 w - - 0 1", // should be 0
         };
 
+        TrainingEntrySet testEntries;
+        testEntries.Reserve(1, cMaxFeaturesPerEntry, true);
+
         for (const char* testPosition : s_testPositions)
         {
             Position pos(testPosition);
 
-            TrainingEntry entry;
-            PositionToTrainingEntry(pos, entry);
+            testEntries.Clear();
+            AddTrainingEntry(pos, 0.0f, testEntries);
 
             nn::InputDesc inputDesc;
-            TrainingEntryToNetworkInput(entry, inputDesc);
+            testEntries.GetNetworkInput(0, inputDesc);
 
             const float nnValue = m_network.Run(inputDesc, m_runCtx)[0];
 
 #ifdef USE_PACKED_NET
-            const float scaledPackedNetworkOutput = EvalPackedNetwork(entry, m_packedNet);
+            const float scaledPackedNetworkOutput = EvalPackedNetwork(testEntries, 0, m_packedNet);
 #endif // USE_PACKED_NET
 
             std::cout
@@ -676,7 +675,7 @@ static volatile float g_learningRateScale = 0.2f;
 static volatile float g_lambdaScale = 0.00f;
 static volatile float g_weightDecay = 0.001f;
 
-bool NetworkTrainer::Train()
+bool NetworkTrainer::Train(bool usePrefeaturizedData)
 {
     InitNetwork();
 
@@ -693,6 +692,22 @@ bool NetworkTrainer::Train()
         return false;
     }
 
+    // validation set is always generated from positions
+    m_usePrefeaturizedData = usePrefeaturizedData;
+    if (m_usePrefeaturizedData && !m_featuresLoader.Init(m_randomGenerator))
+    {
+        std::cout << "ERROR: Failed to initialize features data loader" << std::endl;
+        return false;
+    }
+    std::cout << "Training data: " << (m_usePrefeaturizedData ? "pre-featurized" : "positions") << std::endl;
+
+    const auto generateTrainingSet = [this](TrainingEntrySet& outEntries, uint64_t kingBucketMask, float baseLambda)
+    {
+        return m_usePrefeaturizedData ?
+            GenerateTrainingSetFromFeatures(outEntries, kingBucketMask, baseLambda) :
+            GenerateTrainingSet(outEntries, kingBucketMask, baseLambda);
+    };
+
     std::vector<nn::TrainingVector> batch(cNumTrainingVectorsPerIteration);
 
     TimePoint prevIterationStartTime = TimePoint::GetCurrent();
@@ -716,7 +731,7 @@ bool NetworkTrainer::Train()
 
         if (iteration == 0)
         {
-            if (!GenerateTrainingSet(m_trainingSet, kingBucketMask, lambda))
+            if (!generateTrainingSet(m_nextTrainingSet, kingBucketMask, lambda))
                 return false;
         }
 
@@ -724,28 +739,34 @@ bool NetworkTrainer::Train()
         float iterationTime = (iterationStartTime - prevIterationStartTime).ToSeconds();
         prevIterationStartTime = iterationStartTime;
 
-        // use validation set from previous iteration as training set in the current one
-        ParallelFor("PrepareBatch", cNumTrainingVectorsPerIteration, [&batch, this](const TaskContext&, uint32_t i)
-        {
-            m_trainingSetCopy[i] = m_trainingSet[i];
+        // use training set generated during previous iteration, the other buffer is refilled in parallel with training
+        m_trainingSet.Swap(m_nextTrainingSet);
 
-            const TrainingEntry& entry = m_trainingSetCopy[i];
+        if (m_trainingSet.GetSize() != cNumTrainingVectorsPerIteration)
+        {
+            std::cout << "ERROR: Failed to generate training set" << std::endl;
+            return false;
+        }
 
+        ParallelFor("PrepareBatch", cNumTrainingVectorsPerIteration, [&batch, this](const TaskContext&, uint32_t i)
+        {
             nn::TrainingVector& trainingVector = batch[i];
-            trainingVector.input.variant = entry.networkVariant;
             trainingVector.output.mode = nn::OutputMode::Single;
-            trainingVector.output.singleValue = entry.output;
+            trainingVector.output.singleValue = m_trainingSet.GetEntry(i).output;
 
-            TrainingEntryToNetworkInput(entry, trainingVector.input);
+            m_trainingSet.GetNetworkInput(i, trainingVector.input);
         });
 
         // validation vectors generation can be done in parallel with training
+        float generateSetTime = 0.0f;
         Waitable waitable;
         {
             TaskBuilder taskBuilder{ waitable };
             taskBuilder.Task("GenerateSet", [&](const TaskContext&)
             {
-                GenerateTrainingSet(m_trainingSet, kingBucketMask, lambda);
+                const TimePoint startTime = TimePoint::GetCurrent();
+                generateTrainingSet(m_nextTrainingSet, kingBucketMask, lambda);
+                generateSetTime = (TimePoint::GetCurrent() - startTime).ToSeconds();
             });
 
             taskBuilder.Task("Train", [this, kingBucketMask, &epoch, &batch, learningRate](const TaskContext& ctx)
@@ -800,6 +821,7 @@ bool NetworkTrainer::Train()
         Validate(iteration);
 
         std::cout << "Iteration time:   " << 1000.0f * iterationTime << " ms" << std::endl;
+        std::cout << "Generate set time:" << 1000.0f * generateSetTime << " ms" << std::endl;
         std::cout << "Training rate :   " << ((float)cNumTrainingVectorsPerIteration / iterationTime) << " pos/sec" << std::endl << std::endl;
 
         if (iteration % 10 == 0)
@@ -816,8 +838,12 @@ bool NetworkTrainer::Train()
 }
 
 
-bool TrainNetwork()
+// Usage: trainNetwork [--features]
+// --features  train on pre-featurized data (written by prepareTrainingData --features)
+bool TrainNetwork(const std::vector<std::string>& args)
 {
+    const bool usePrefeaturizedData = std::find(args.begin(), args.end(), "--features") != args.end();
+
     NetworkTrainer trainer;
-    return trainer.Train();
+    return trainer.Train(usePrefeaturizedData);
 }
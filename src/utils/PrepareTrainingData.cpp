@@ -1,5 +1,6 @@
 #include "Common.hpp"
 #include "ThreadPool.hpp"
+#include "Async.hpp"
 #include "TrainerCommon.hpp"
 #include "GameCollection.hpp"
 
@@ -19,24 +20,16 @@ using namespace threadpool;
 
 static std::mutex g_mutex;
 
-static bool ConvertGamesToTrainingData(const std::string& inputPath, const std::string& outputPath)
+// Note: this is a coroutine, so the worker thread is not blocked while the files are being read or written
+static Async<void> ConvertGamesToTrainingData(std::string inputPath, std::string outputPath)
 {
     std::vector<PositionEntry> entries;
-    std::vector<Move> moves;
 
     if (std::filesystem::exists(outputPath))
     {
         std::unique_lock<std::mutex> lock(g_mutex);
         std::cout << "INFO: Output training data file " << outputPath << " already exists. Skipping" << std::endl;
-        return true;
-    }
-
-    FileInputStream gamesFile(inputPath.c_str());
-    if (!gamesFile.IsOpen())
-    {
-        std::unique_lock<std::mutex> lock(g_mutex);
-        std::cout << "ERROR: Failed to load selfplay data file: " << inputPath << std::endl;
-        return false;
+        co_return;
     }
 
 #ifndef OUTPUT_TEXT_FILE
@@ -45,15 +38,14 @@ static bool ConvertGamesToTrainingData(const std::string& inputPath, const std::
     {
         std::unique_lock<std::mutex> lock(g_mutex);
         std::cout << "ERROR: Failed to load output training data file: " << outputPath << std::endl;
-        return false;
+        co_return;
     }
 #endif // OUTPUT_TEXT_FILE
 
     uint32_t numGames = 0;
     uint32_t numPositions = 0;
 
-    Game game;
-    while (GameCollection::ReadGame(gamesFile, game, moves))
+    const bool readSuccess = co_await GameCollection::ForEachGameInFileAsync(inputPath, [&](const Game& game, const std::vector<Move>& moves)
     {
         Game::Score gameScore = game.GetScore();
 
@@ -61,7 +53,7 @@ static bool ConvertGamesToTrainingData(const std::string& inputPath, const std::
 
         if (game.GetScore() == Game::Score::Unknown)
         {
-            continue;
+            return;
         }
 
         Position pos = game.GetInitialPosition();
@@ -118,6 +110,13 @@ static bool ConvertGamesToTrainingData(const std::string& inputPath, const std::
         }
 
         numGames++;
+    });
+
+    if (!readSuccess)
+    {
+        std::unique_lock<std::mutex> lock(g_mutex);
+        std::cout << "ERROR: Failed to load selfplay data file: " << inputPath << std::endl;
+        co_return;
     }
 
     {
@@ -152,24 +151,30 @@ static bool ConvertGamesToTrainingData(const std::string& inputPath, const std::
     }
 #else // !OUTPUT_TEXT_FILE
 
-    if (!trainingDataFile.Write(entries.data(), entries.size() * sizeof(PositionEntry)))
+    const bool writeSuccess = co_await RunBlocking([&]()
+    {
+        return trainingDataFile.Write(entries.data(), entries.size() * sizeof(PositionEntry));
+    });
+
+    if (!writeSuccess)
     {
         std::unique_lock<std::mutex> lock(g_mutex);
         std::cout << "ERROR: Failed to write training data file: " << outputPath << std::endl;
-        return false;
+        co_return;
     }
 
 #endif // OUTPUT_TEXT_FILE
-
-    return true;
 }
 
+// Usage: prepareTrainingData [--features]
+// --features  additionally convert training data to pre-featurized format (used by trainNetwork --features)
 void PrepareTrainingData(const std::vector<std::string>& args)
 {
-    (void)args;
+    const bool writeFeatures = std::find(args.begin(), args.end(), "--features") != args.end();
 
     const std::string gamesPath = DATA_PATH "selfplayGames/";
     const std::string trainingDataPath = DATA_PATH "trainingData/";
+    const std::string featuresDataPath = DATA_PATH "trainingDataFeatures/";
 
     Waitable waitable;
     {
@@ -182,13 +187,43 @@ void PrepareTrainingData(const std::vector<std::string>& args)
                 std::cout << "Loading " << path.path().string() << "..." << std::endl;
             }
 
-            taskBuilder.Task("LoadPositions", [path, &trainingDataPath](const TaskContext&)
+            taskBuilder.AsyncTask("LoadPositions", [path, &trainingDataPath]()
             {
                 const std::string outputPath = trainingDataPath + path.path().stem().string() + ".dat";
-                ConvertGamesToTrainingData(path.path().string().c_str(), outputPath);
+                return ConvertGamesToTrainingData(path.path().string(), outputPath);
             });
         }
     }
 
     waitable.Wait();
+
+    if (writeFeatures)
+    {
+        std::filesystem::create_directories(featuresDataPath);
+
+        Waitable featuresWaitable;
+        {
+            TaskBuilder taskBuilder(featuresWaitable);
+
+            for (const auto& path : std::filesystem::directory_iterator(trainingDataPath))
+            {
+                const std::string outputPath = featuresDataPath + path.path().filename().string();
+                if (std::filesystem::exists(outputPath))
+                {
+                    continue;
+                }
+
+                taskBuilder.Task("ConvertToFeatures", [path, outputPath](const TaskContext&)
+                {
+                    if (ConvertTrainingDataToFeatures(path.path().string(), outputPath))
+                    {
+                        std::unique_lock<std::mutex> lock(g_mutex);
+                        std::cout << "Written features data " << outputPath << std::endl;
+                    }
+                });
+            }
+        }
+
+        featuresWaitable.Wait();
+    }
 }
@@ -0,0 +1,143 @@
+#include "Common.hpp"
+#include "GameCollection.hpp"
+
+#include "../backend/Search.hpp"
+#include "../backend/TranspositionTable.hpp"
+#include "../backend/Time.hpp"
+
+#include <iomanip>
+
+struct SearchTreeReuseStats
+{
+    uint64_t numSearches = 0;
+    uint64_t nodes = 0;
+    double time = 0.0;
+};
+
+// Replays games from a game collection file, searching each position to fixed depth.
+// Each side has its own search and transposition table, so consecutive searches of one side are
+// two plies apart. Games are replayed twice: with search tree reuse enabled and disabled.
+// Usage: benchTreeReuse <games file> [depth <depth>] [maxGames <count>] [maxPly <plies>] [hash <MB>]
+bool BenchmarkSearchTreeReuse(const std::vector<std::string>& args)
+{
+    if (args.empty())
+    {
+        std::cout << "Usage: benchTreeReuse <games file> [depth <depth>] [maxGames <count>] [maxPly <plies>] [hash <MB>]" << std::endl;
+        return false;
+    }
+
+    uint16_t depth = 12;
+    uint32_t maxGames = 20;
+    uint32_t maxPly = 80;
+    size_t hashSizeMB = 16;
+
+    for (size_t i = 1; i + 1 < args.size(); i += 2)
+    {
+        if (args[i] == "depth")
+            depth = static_cast<uint16_t>(std::max(1, atoi(args[i + 1].c_str())));
+        else if (args[i] == "maxGames")
+            maxGames = std::max(1, atoi(args[i + 1].c_str()));
+        else if (args[i] == "maxPly")
+            maxPly = std::max(1, atoi(args[i + 1].c_str()));
+        else if (args[i] == "hash")
+            hashSizeMB = std::max(1, atoi(args[i + 1].c_str()));
+        else
+        {
+            std::cout << "ERROR: Unknown argument: " << args[i] << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<Game> games;
+    const bool success = GameCollection::ForEachGameInFile(args[0].c_str(), [&](const Game& game, const std::vector<Move>&)
+    {
+        if (games.size() < maxGames && !game.GetMoves().empty())
+        {
+            games.push_back(game);
+        }
+    });
+
+    if (!success)
+    {
+        std::cout << "ERROR: Failed to read games from " << args[0] << std::endl;
+        return false;
+    }
+
+    const auto replayGames = [&](bool reuseSearchTree) -> SearchTreeReuseStats
+    {
+        SearchTreeReuseStats stats;
+
+        Search searches[2];
+        TranspositionTable tts[2] = { TranspositionTable{ hashSizeMB * 1024 * 1024 }, TranspositionTable{ hashSizeMB * 1024 * 1024 } };
+
+        for (const Game& sourceGame : games)
+        {
+            for (uint32_t side = 0; side < 2; ++side)
+            {
+                searches[side].Clear();
+                tts[side].Clear();
+            }
+
+            Game game;
+            game.Reset(sourceGame.GetInitialPosition());
+
+            const std::vector<Move>& moves = sourceGame.GetMoves();
+            const size_t numMoves = std::min<size_t>(moves.size(), maxPly);
+
+            for (size_t i = 0; i < numMoves; ++i)
+            {
+                const uint32_t side = game.GetPosition().GetSideToMove() == White ? 0 : 1;
+
+                SearchParam searchParam{ tts[side] };
+                searchParam.debugLog = false;
+                searchParam.useRootTablebase = false;
+                searchParam.reuseSearchTree = reuseSearchTree;
+                searchParam.limits.maxDepth = depth;
+
+                SearchResult searchResult;
+                SearchStats searchStats;
+
+                const TimePoint startTime = TimePoint::GetCurrent();
+                searches[side].DoSearch(game, searchParam, searchResult, &searchStats);
+                stats.time += (TimePoint::GetCurrent() - startTime).ToSeconds();
+                stats.nodes += searchStats.nodes;
+                stats.numSearches++;
+
+                tts[side].NextGeneration();
+
+                if (!game.DoMove(moves[i]))
+                {
+                    break;
+                }
+            }
+        }
+
+        return stats;
+    };
+
+    std::cout << "Games: " << games.size() << ", depth: " << depth << std::endl;
+
+    const SearchTreeReuseStats withReuse = replayGames(true);
+    const SearchTreeReuseStats withoutReuse = replayGames(false);
+
+    const auto printStats = [](const char* name, const SearchTreeReuseStats& stats)
+    {
+        std::cout << name
+            << " searches: " << stats.numSearches
+            << ", nodes: " << stats.nodes
+            << ", time: " << std::fixed << std::setprecision(3) << stats.time << " s"
+            << ", avg time-to-depth: " << (stats.numSearches > 0 ? 1000.0 * stats.time / stats.numSearches : 0.0) << " ms"
+            << std::endl;
+    };
+
+    printStats("Reuse on:  ", withReuse);
+    printStats("Reuse off: ", withoutReuse);
+
+    if (withoutReuse.time > 0.0 && withoutReuse.nodes > 0)
+    {
+        std::cout << "Time ratio:  " << std::setprecision(4) << withReuse.time / withoutReuse.time << std::endl;
+        std::cout << "Nodes ratio: " << std::setprecision(4) << static_cast<double>(withReuse.nodes) / static_cast<double>(withoutReuse.nodes) << std::endl;
+    }
+
+    return true;
+}
@@ -13,6 +13,7 @@
 #include "../backend/Endgame.hpp"
 #include "../backend/Tablebase.hpp"
 #include "../backend/Waitable.hpp"
+#include "../backend/Time.hpp"
 
 #include <chrono>
 #include <random>
@@ -20,20 +21,197 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <limits>
 #include <limits.h>
 
-static const bool randomizeOrder = true;
-static const uint32_t c_printPgnFrequency = 1;
-static const uint32_t c_minNodes = 15000;
-static const uint32_t c_maxNodes = 15000;
-static const uint32_t c_maxDepth = 25;
-static const int32_t c_maxEval = 1000;
-static const int32_t c_openingMaxEval = 2000;
-static const int32_t c_multiPv = 1;
-static const int32_t c_multiPvMaxPly = 0;
-static const int32_t c_multiPvScoreTreshold = 50;
-static const uint32_t c_minRandomMoves = 1;
-static const uint32_t c_maxRandomMoves = 8;
+// Self-play pipeline settings.
+// Each of them can be overridden via command line ("--name value") or via config file ("--config path").
+struct SelfPlayParams
+{
+    std::string openingsPath;
+
+    uint32_t numThreads = 0;            // number of worker threads (0 means number of logical cores)
+    uint32_t numGamesPerThread = 8;     // number of games interleaved by a single worker thread
+    uint32_t maxGames = 0;              // stop after playing that many games (0 means no limit)
+    uint32_t ttSizeMB = 2;              // transposition table size per interleaved game
+    bool sharedOutputFile = false;      // write games from all threads into a single file
+
+    bool randomizeOrder = true;
+    uint32_t printPgnFrequency = 1;
+
+    uint32_t minNodes = 15000;
+    uint32_t maxNodes = 15000;
+    uint32_t maxDepth = 25;
+
+    int32_t maxEval = 1000;
+    int32_t openingMaxEval = 2000;
+
+    int32_t multiPv = 1;
+    int32_t multiPvMaxPly = 0;
+    int32_t multiPvScoreTreshold = 50;
+
+    uint32_t minRandomMoves = 1;
+    uint32_t maxRandomMoves = 8;
+
+    // draw adjudication: eval is close to zero for that many moves after given ply
+    int32_t drawScoreTreshold = 4;
+    uint32_t drawMovesCount = 8;
+    int32_t drawMinPly = 60;
+
+    // win adjudication: eval exceeds "maxEval" for that many moves after given ply
+    uint32_t winMovesCount = 3;
+    int32_t winMinPly = 20;
+
+    bool Set(const std::string& name, const std::string& value);
+    bool LoadFromFile(const std::string& path);
+    bool ParseArgs(const std::vector<std::string>& args);
+    void Print() const;
+};
+
+#define SELF_PLAY_PARAMS(X) \
+    X(numThreads) \
+    X(numGamesPerThread) \
+    X(maxGames) \
+    X(ttSizeMB) \
+    X(sharedOutputFile) \
+    X(randomizeOrder) \
+    X(printPgnFrequency) \
+    X(minNodes) \
+    X(maxNodes) \
+    X(maxDepth) \
+    X(maxEval) \
+    X(openingMaxEval) \
+    X(multiPv) \
+    X(multiPvMaxPly) \
+    X(multiPvScoreTreshold) \
+    X(minRandomMoves) \
+    X(maxRandomMoves) \
+    X(drawScoreTreshold) \
+    X(drawMovesCount) \
+    X(drawMinPly) \
+    X(winMovesCount) \
+    X(winMinPly)
+
+template<typename T>
+static bool ParseSelfPlayParamValue(const std::string& str, T& outValue)
+{
+    std::istringstream stream(str);
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        if (str == "true") { outValue = true; return true; }
+        if (str == "false") { outValue = false; return true; }
+    }
+    static_assert(sizeof(T) < sizeof(int64_t), "Parameter type range must fit in int64");
+    int64_t value = 0;
+    if (!(stream >> value) || !stream.eof())
+    {
+        return false;
+    }
+    // reject out of range values (including negative values of unsigned parameters) instead of wrapping them
+    if (value < static_cast<int64_t>(std::numeric_limits<T>::min()) || value > static_cast<int64_t>(std::numeric_limits<T>::max()))
+    {
+        return false;
+    }
+    outValue = static_cast<T>(value);
+    return true;
+}
+
+bool SelfPlayParams::Set(const std::string& name, const std::string& value)
+{
+    if (name == "openings")
+    {
+        openingsPath = value;
+        return true;
+    }
+
+#define X(param) \
+    if (name == #param) \
+    { \
+        if (ParseSelfPlayParamValue(value, param)) return true; \
+        std::cout << "Invalid value for self-play parameter '" << name << "': " << value << std::endl; \
+        return false; \
+    }
+    SELF_PLAY_PARAMS(X)
+#undef X
+
+    std::cout << "Unknown self-play parameter: " << name << std::endl;
+    return false;
+}
+
+bool SelfPlayParams::LoadFromFile(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.good())
+    {
+        std::cout << "Failed to load self-play config file " << path << std::endl;
+        return false;
+    }
+
+    // expected format: one "name value" or "name = value" pair per line, '#' starts a comment
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::replace(line.begin(), line.end(), '=', ' ');
+
+        std::istringstream lineStream(line);
+        std::string name, value;
+        if (!(lineStream >> name))
+            continue;
+
+        if (!(lineStream >> value) || !Set(name, value))
+        {
+            std::cout << "Invalid line in self-play config file " << path << ": " << line << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SelfPlayParams::ParseArgs(const std::vector<std::string>& args)
+{
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        if (args[i].size() > 2 && args[i][0] == '-' && args[i][1] == '-')
+        {
+            if (i + 1 >= args.size())
+            {
+                std::cout << "Missing value for self-play parameter " << args[i] << std::endl;
+                return false;
+            }
+
+            const std::string name = args[i].substr(2);
+            const std::string& value = args[++i];
+
+            if (name == "config" ? !LoadFromFile(value) : !Set(name, value))
+                return false;
+        }
+        else
+        {
+            // positional argument for backward compatibility
+            openingsPath = args[i];
+        }
+    }
+
+    if (minNodes > maxNodes || maxNodes == 0 || maxDepth == 0 || maxDepth >= MaxSearchDepth ||
+        minRandomMoves > maxRandomMoves || numGamesPerThread == 0 || multiPv < 1)
+    {
+        std::cout << "Inconsistent self-play parameters" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void SelfPlayParams::Print() const
+{
+    std::cout << "Self-play parameters:" << std::endl;
+    std::cout << "  openings " << (openingsPath.empty() ? "<none>" : openingsPath) << std::endl;
+#define X(param) std::cout << "  " #param " " << param << std::endl;
+    SELF_PLAY_PARAMS(X)
+#undef X
+}
 
 bool LoadOpeningPositions(const std::string& path, std::vector<PackedPosition>& outPositions)
 {
@@ -96,253 +274,362 @@ static Move GetRandomMove(std::mt19937& randomGenerator, const Position& pos)
 
 struct SelfPlayStats
 {
+    std::atomic<uint32_t> numStartedGames = 0;
     std::atomic<uint32_t> numWhiteWins = 0;
     std::atomic<uint32_t> numBlackWins = 0;
     std::atomic<uint32_t> numDraws = 0;
+    std::atomic<uint32_t> numAdjudicatedGames = 0;
+    std::atomic<uint64_t> numPositions = 0;
+    std::atomic<uint64_t> numFinishedGamesPlies = 0;
+    std::atomic<uint64_t> numNodes = 0;
+
+    TimePoint startTime = TimePoint::GetCurrent();
+
+    // reserve a game from the global games budget (0 means no limit)
+    bool TryReserveGame(uint32_t maxGames)
+    {
+        uint32_t numGames = numStartedGames.load();
+        do
+        {
+            if (maxGames > 0 && numGames >= maxGames)
+                return false;
+        } while (!numStartedGames.compare_exchange_weak(numGames, numGames + 1));
+        return true;
+    }
+
+    void Print() const
+    {
+        const uint32_t numGames = numWhiteWins + numBlackWins + numDraws;
+        const float elapsedTime = (TimePoint::GetCurrent() - startTime).ToSeconds();
+
+        std::cout << std::endl;
+        std::cout << "White wins:  " << numWhiteWins << " (" << (numWhiteWins * 100.0 / numGames) << "%)" << std::endl;
+        std::cout << "Black wins:  " << numBlackWins << " (" << (numBlackWins * 100.0 / numGames) << "%)" << std::endl;
+        std::cout << "Draws:       " << numDraws << " (" << (numDraws * 100.0 / numGames) << "%)" << std::endl;
+        std::cout << "Adjudicated: " << numAdjudicatedGames << " (" << (numAdjudicatedGames * 100.0 / numGames) << "%)" << std::endl;
+        std::cout << "Avg. length: " << (static_cast<double>(numFinishedGamesPlies) / numGames) << " plies" << std::endl;
+        std::cout << "Games/hour:  " << (3600.0 * numGames / elapsedTime) << std::endl;
+        std::cout << "Pos/sec:     " << (numPositions / elapsedTime) << std::endl;
+        std::cout << "Nodes/sec:   " << (numNodes / elapsedTime) << std::endl;
+    }
 };
 
-static bool SelfPlayThreadFunc(
-    uint32_t nameSeed,
-    uint32_t threadIndex,
-    const std::vector<PackedPosition>& openingPositions,
-    SelfPlayStats& stats)
+// State of a single game played by a self-play worker.
+// Each worker interleaves multiple games, searching one move of each in turn.
+struct SelfPlayGame
 {
-    const size_t c_transpositionTableSize = 2ull * 1024ull * 1024ull;
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    Game game;
+    uint32_t index = 0;
+    uint32_t searchSeed = 0;
+    int32_t multiPvScoreTreshold = 0;
+    int32_t halfMoveNumber = 0;
+    uint32_t drawScoreCounter = 0;
+    uint32_t whiteWinsCounter = 0;
+    uint32_t blackWinsCounter = 0;
+    bool isActive = false;
+    bool isRetired = false;
+};
 
-    Search search;
-    TranspositionTable tt{ c_transpositionTableSize };
+static bool StartSelfPlayGame(
+    const SelfPlayParams& params,
+    SelfPlayGame& slot,
+    uint32_t index,
+    std::mt19937& gen,
+    const std::vector<PackedPosition>& openingPositions)
+{
+    // generate opening position
+    Position openingPos;
 
-    const std::string outputFileName = DATA_PATH "selfplayGames/selfplay_" +
-        std::to_string(nameSeed) + "_" +
-        std::to_string(c_maxNodes / 1000) + "kn_" +
-        "t" + std::to_string(threadIndex) + ".dat";
+    if (!openingPositions.empty())
+    {
+        uint32_t openingIndex = index % openingPositions.size();
+        if (params.randomizeOrder)
+        {
+            std::uniform_int_distribution<size_t> distrib(0, openingPositions.size() - 1);
+            openingIndex = uint32_t(distrib(gen));
+        }
+        UnpackPosition(openingPositions[openingIndex], openingPos);
+    }
+    else
+    {
+        VERIFY(openingPos.FromFEN(Position::InitPositionFEN));
+    }
 
-    FileOutputStream gamesFile(outputFileName.c_str());
-    GameCollection::Writer writer(gamesFile);
-    if (!writer.IsOK())
+    if (params.maxRandomMoves > 0)
     {
-        std::cerr << "Failed to open output file (games)!" << std::endl;
-        return false;
+        // play few random moves in the opening
+        const uint32_t numRandomMoves = std::uniform_int_distribution<uint32_t>(params.minRandomMoves, params.maxRandomMoves)(gen);
+        for (uint32_t i = 0; i < numRandomMoves; ++i)
+        {
+            Move move = GetRandomMove(gen, openingPos);
+            if (!move.IsValid())
+                break;
+
+            const bool moveSuccess = openingPos.DoMove(move);
+            ASSERT(moveSuccess);
+            (void)moveSuccess;
+        }
     }
 
-    uint32_t gameIndex = 0;
+    if (openingPos.IsMate() || openingPos.IsStalemate())
+        return false;
 
-    for (;;)
-    {
-        SearchResult searchResult;
+    slot.game.Reset(openingPos);
+    slot.index = index;
+    slot.searchSeed = gen();
+    slot.multiPvScoreTreshold = params.multiPvScoreTreshold;
+    slot.halfMoveNumber = 0;
+    slot.drawScoreCounter = 0;
+    slot.whiteWinsCounter = 0;
+    slot.blackWinsCounter = 0;
+    slot.isActive = true;
 
-        // generate opening position
-        Position openingPos;
+    return true;
+}
 
-        const uint32_t index = gameIndex++;
+// search and play a single move in the game
+// returns true if the game has finished
+static bool PlaySelfPlayGameMove(
+    const SelfPlayParams& params,
+    SelfPlayGame& slot,
+    Search& search,
+    TranspositionTable& tt,
+    std::mt19937& gen,
+    SelfPlayStats& stats)
+{
+    Game& game = slot.game;
+    const int32_t halfMoveNumber = slot.halfMoveNumber;
+
+    SearchResult searchResult;
+
+    SearchParam searchParam{ tt };
+    searchParam.debugLog = false;
+    searchParam.useRootTablebase = false;
+    searchParam.evalRandomization = 2;
+    searchParam.seed = slot.searchSeed;
+    searchParam.numPvLines = (halfMoveNumber < params.multiPvMaxPly) ? params.multiPv : 1;
+    searchParam.limits.maxDepth = static_cast<uint16_t>(params.maxDepth);
+    searchParam.limits.maxNodesSoft = params.minNodes + static_cast<uint64_t>(params.maxNodes - params.minNodes) * std::max(0, 80 - halfMoveNumber) / 80;
+    searchParam.limits.maxNodes = 5 * searchParam.limits.maxNodesSoft;
+
+    SearchStats searchStats;
+    tt.NextGeneration();
+    search.DoSearch(game, searchParam, searchResult, &searchStats);
+    stats.numNodes += searchStats.nodes;
+
+    ASSERT(!searchResult.empty());
+
+    // skip game if starting position is unbalanced
+    if (halfMoveNumber == 0 && std::abs(searchResult.begin()->score) > params.openingMaxEval)
+        return true;
+
+    // sort moves by score
+    std::sort(searchResult.begin(), searchResult.end(), [](const PvLine& a, const PvLine& b)
+    {
+        return a.score > b.score;
+    });
 
-        if (!openingPositions.empty())
+    // if one of the move is much worse than the best candidate, ignore it and the rest
+    for (size_t i = 1; i < searchResult.size(); ++i)
+    {
+        ASSERT(searchResult[i].score <= searchResult[0].score);
+        const int32_t diff = std::abs((int32_t)searchResult[i].score - (int32_t)searchResult[0].score);
+        if (diff > slot.multiPvScoreTreshold)
         {
-            uint32_t openingIndex = index;
-            if (randomizeOrder)
-            {
-                std::uniform_int_distribution<size_t> distrib(0, openingPositions.size() - 1);
-                openingIndex = uint32_t(distrib(gen));
-            }
-            UnpackPosition(openingPositions[openingIndex], openingPos);
+            searchResult.erase(searchResult.begin() + i, searchResult.end());
+            break;
         }
+    }
 
-        if constexpr (c_maxRandomMoves > 0)
-        {
-            // play few random moves in the opening
-            const uint32_t numRandomMoves = std::uniform_int_distribution<uint32_t>(c_minRandomMoves, c_maxRandomMoves)(gen);
-            for (uint32_t i = 0; i < numRandomMoves; ++i)
-            {
-                Move move = GetRandomMove(gen, openingPos);
-                if (!move.IsValid())
-                    break;
+    // select random move
+    // TODO prefer moves with higher score
+    std::uniform_int_distribution<size_t> distrib(0, searchResult.size() - 1);
+    const size_t moveIndex = distrib(gen);
+    ASSERT(!searchResult[moveIndex].moves.empty());
+    Move move = searchResult[moveIndex].moves.front();
 
-                const bool moveSuccess = openingPos.DoMove(move);
-                ASSERT(moveSuccess);
-                (void)moveSuccess;
-            }
-        }
+    // reduce threshold of picking worse move
+    // this way the game will be more random at the beginning and there will be less blunders later in the game
+    slot.multiPvScoreTreshold = std::max(10, slot.multiPvScoreTreshold - 2);
 
-        if (openingPos.IsMate() || openingPos.IsStalemate())
-            continue;
+    ScoreType moveScore = searchResult[moveIndex].score;
+    ScoreType eval = Evaluate(game.GetPosition());
+
+    if (game.GetSideToMove() == Black)
+    {
+        moveScore = -moveScore;
+        eval = -eval;
+    }
+
+    const bool isCheck = game.GetPosition().IsInCheck();
+
+    const bool moveSuccess = game.DoMove(move, moveScore);
+    ASSERT(moveSuccess);
+    (void)moveSuccess;
 
-        // start new game
-        Game game;
-        tt.Clear();
-        search.Clear();
-        game.Reset(openingPos);
+    slot.halfMoveNumber++;
+    stats.numPositions++;
 
-        int32_t multiPvScoreTreshold = c_multiPvScoreTreshold;
-        int32_t halfMoveNumber = 0;
-        uint32_t drawScoreCounter = 0;
-        uint32_t whiteWinsCounter = 0;
-        uint32_t blackWinsCounter = 0;
+    if (std::abs(moveScore) < params.drawScoreTreshold)
+        slot.drawScoreCounter++;
+    else
+        slot.drawScoreCounter = 0;
 
-        const uint32_t searchSeed = gen();
+    // adjudicate draw if eval is zero
+    if (slot.drawScoreCounter > params.drawMovesCount && halfMoveNumber >= params.drawMinPly)
+    {
+        game.SetScore(Game::Score::Draw);
+    }
 
-        for (;; ++halfMoveNumber)
+    // adjudicate win
+    if (halfMoveNumber >= params.winMinPly)
+    {
+        if (moveScore > params.maxEval && eval > params.maxEval / 4)
         {
-            SearchParam searchParam{ tt };
-            searchParam.debugLog = false;
-            searchParam.useRootTablebase = false;
-            searchParam.evalRandomization = 2;
-            searchParam.seed = searchSeed;
-            searchParam.numPvLines = (halfMoveNumber < c_multiPvMaxPly) ? c_multiPv : 1;
-            searchParam.limits.maxDepth = c_maxDepth;
-            searchParam.limits.maxNodesSoft = c_minNodes + (c_maxNodes - c_minNodes) * std::max(0, 80 - halfMoveNumber) / 80;
-            searchParam.limits.maxNodes = 5 * searchParam.limits.maxNodesSoft;
-
-            searchResult.clear();
-            tt.NextGeneration();
-            search.DoSearch(game, searchParam, searchResult);
-
-            ASSERT(!searchResult.empty());
-
-            // skip game if starting position is unbalanced
-            if (halfMoveNumber == 0 && std::abs(searchResult.begin()->score) > c_openingMaxEval)
-                break;
+            slot.whiteWinsCounter++;
+            if (slot.whiteWinsCounter > params.winMovesCount) game.SetScore(Game::Score::WhiteWins);
+        }
+        else
+        {
+            slot.whiteWinsCounter = 0;
+        }
 
-            // sort moves by score
-            std::sort(searchResult.begin(), searchResult.end(), [](const PvLine& a, const PvLine& b)
-            {
-                return a.score > b.score;
-            });
+        if (moveScore < -params.maxEval && eval < -params.maxEval / 4)
+        {
+            slot.blackWinsCounter++;
+            if (slot.blackWinsCounter > params.winMovesCount) game.SetScore(Game::Score::BlackWins);
+        }
+        else
+        {
+            slot.blackWinsCounter = 0;
+        }
+    }
 
-            // if one of the move is much worse than the best candidate, ignore it and the rest
-            for (size_t i = 1; i < searchResult.size(); ++i)
-            {
-                ASSERT(searchResult[i].score <= searchResult[0].score);
-                const int32_t diff = std::abs((int32_t)searchResult[i].score - (int32_t)searchResult[0].score);
-                if (diff > multiPvScoreTreshold)
-                {
-                    searchResult.erase(searchResult.begin() + i, searchResult.end());
-                    break;
-                }
-            }
+    // tablebase adjudication
+    int32_t wdlScore = 0;
+    if (!isCheck && ProbeSyzygy_WDL(game.GetPosition(), &wdlScore))
+    {
+        const auto stm = game.GetPosition().GetSideToMove();
+        if (wdlScore == 1) game.SetScore(stm == White ? Game::Score::WhiteWins : Game::Score::BlackWins);
+        if (wdlScore == 0) game.SetScore(Game::Score::Draw);
+        if (wdlScore == -1) game.SetScore(stm == White ? Game::Score::BlackWins : Game::Score::WhiteWins);
+    }
 
-            // select random move
-            // TODO prefer moves with higher score
-            std::uniform_int_distribution<size_t> distrib(0, searchResult.size() - 1);
-            const size_t moveIndex = distrib(gen);
-            ASSERT(!searchResult[moveIndex].moves.empty());
-            Move move = searchResult[moveIndex].moves.front();
+    if (game.GetPosition().IsMate())
+    {
+        ASSERT(moveScore >= TablebaseWinValue || moveScore <= -TablebaseWinValue);
+    }
 
-            // reduce threshold of picking worse move
-            // this way the game will be more random at the beginning and there will be less blunders later in the game
-            multiPvScoreTreshold = std::max(10, multiPvScoreTreshold - 2);
+    if (game.GetScore() != Game::Score::Unknown)
+    {
+        if (game.GetScore() == Game::Score::WhiteWins) stats.numWhiteWins++;
+        if (game.GetScore() == Game::Score::BlackWins) stats.numBlackWins++;
+        if (game.GetScore() == Game::Score::Draw) stats.numDraws++;
+        if (game.GetForcedScore() != Game::Score::Unknown) stats.numAdjudicatedGames++;
+        stats.numFinishedGamesPlies += slot.halfMoveNumber;
+        return true;
+    }
 
-            ScoreType moveScore = searchResult[moveIndex].score;
-            ScoreType eval = Evaluate(game.GetPosition());
+    return false;
+}
 
-            if (game.GetSideToMove() == Black)
-            {
-                moveScore = -moveScore;
-                eval = -eval;
-            }
+static void SelfPlayThreadFunc(
+    const SelfPlayParams& params,
+    uint32_t threadIndex,
+    const std::vector<PackedPosition>& openingPositions,
+    GameCollection::CompressedWriter& writer,
+    SelfPlayStats& stats)
+{
+    // transposition table and search state are shared by all games played by this thread
+    // and reused between games (TT entries are aged via generations instead of clearing)
+    const size_t transpositionTableSize = params.numGamesPerThread * params.ttSizeMB * 1024ull * 1024ull;
 
-            const bool isCheck = game.GetPosition().IsInCheck();
+    std::random_device rd;
+    std::mt19937 gen(rd());
 
-            const bool moveSuccess = game.DoMove(move, moveScore);
-            ASSERT(moveSuccess);
-            (void)moveSuccess;
+    Search search;
+    TranspositionTable tt{ transpositionTableSize };
 
-            if (std::abs(moveScore) < 4)
-                drawScoreCounter++;
-            else
-                drawScoreCounter = 0;
+    // games are encoded and compressed locally, the writer only receives complete blocks
+    GameCollection::BlockEncoder encoder(writer);
 
-            // adjudicate draw if eval is zero
-            if (drawScoreCounter > 8 && halfMoveNumber >= 60)
-            {
-                game.SetScore(Game::Score::Draw);
-            }
+    search.Clear();
 
-            // adjudicate win
-            if (halfMoveNumber >= 20)
-            {
-                if (moveScore > c_maxEval && eval > c_maxEval / 4)
-                {
-                    whiteWinsCounter++;
-                    if (whiteWinsCounter > 3) game.SetScore(Game::Score::WhiteWins);
-                }
-                else
-                {
-                    whiteWinsCounter = 0;
-                }
-
-                if (moveScore < -c_maxEval && eval < -c_maxEval / 4)
-                {
-                    blackWinsCounter++;
-                    if (blackWinsCounter > 3) game.SetScore(Game::Score::BlackWins);
-                }
-                else
-                {
-                    blackWinsCounter = 0;
-                }
-            }
+    uint32_t gameIndex = 0;
 
-            // tablebase adjudication
-            int32_t wdlScore = 0;
-            if (!isCheck && ProbeSyzygy_WDL(game.GetPosition(), &wdlScore))
-            {
-                const auto stm = game.GetPosition().GetSideToMove();
-                if (wdlScore == 1) game.SetScore(stm == White ? Game::Score::WhiteWins : Game::Score::BlackWins);
-                if (wdlScore == 0) game.SetScore(Game::Score::Draw);
-                if (wdlScore == -1) game.SetScore(stm == White ? Game::Score::BlackWins : Game::Score::WhiteWins);
-            }
+    std::vector<SelfPlayGame> games(params.numGamesPerThread);
+    uint32_t numRunningSlots = params.numGamesPerThread;
 
-            if (game.GetPosition().IsMate())
+    // play all the games in round-robin fashion, one move at a time
+    for (uint32_t slotIndex = 0; numRunningSlots > 0; slotIndex = (slotIndex + 1) % params.numGamesPerThread)
+    {
+        SelfPlayGame& slot = games[slotIndex];
+
+        if (slot.isRetired)
+            continue;
+
+        if (!slot.isActive)
+        {
+            // stop using the slot if the global games budget is exhausted
+            if (!stats.TryReserveGame(params.maxGames))
             {
-                ASSERT(moveScore >= TablebaseWinValue || moveScore <= -TablebaseWinValue);
+                slot.isRetired = true;
+                numRunningSlots--;
+                continue;
             }
 
-            if (game.GetScore() != Game::Score::Unknown)
+            if (!StartSelfPlayGame(params, slot, gameIndex++, gen, openingPositions))
             {
-                if (game.GetScore() == Game::Score::WhiteWins) stats.numWhiteWins++;
-                if (game.GetScore() == Game::Score::BlackWins) stats.numBlackWins++;
-                if (game.GetScore() == Game::Score::Draw) stats.numDraws++;
-                break;
+                // game wasn't started, give it back to the budget
+                stats.numStartedGames--;
+                continue;
             }
         }
 
+        if (!PlaySelfPlayGameMove(params, slot, search, tt, gen, stats))
+            continue;
+
+        slot.isActive = false;
+
         // save game
-        if (halfMoveNumber > 0)
+        if (slot.halfMoveNumber > 0)
         {
-            writer.WriteGame(game);
+            Game& game = slot.game;
+            const uint32_t index = slot.index;
+
+            encoder.WriteGame(game);
 
             GameMetadata metadata;
             metadata.roundNumber = index;
             game.SetMetadata(metadata);
 
-            if (threadIndex == 0 && c_printPgnFrequency != 0 && (index % c_printPgnFrequency == 0))
+            if (threadIndex == 0 && params.printPgnFrequency != 0 && (index % params.printPgnFrequency == 0))
             {
                 const std::string pgn = game.ToPGN(true);
                 std::cout << std::endl << pgn << std::endl;
-
-                const uint32_t numGames = stats.numWhiteWins + stats.numBlackWins + stats.numDraws;
-                std::cout << std::endl;
-                std::cout << "White wins: " << stats.numWhiteWins << " (" << (stats.numWhiteWins * 100.0 / numGames) << "%)" << std::endl;
-                std::cout << "Black wins: " << stats.numBlackWins << " (" << (stats.numBlackWins * 100.0 / numGames) << "%)" << std::endl;
-                std::cout << "Draws:      " << stats.numDraws << " (" << (stats.numDraws * 100.0 / numGames) << "%)" << std::endl;
+                stats.Print();
             }
 
             if (index % 64 == 0)
             {
-                gamesFile.Flush();
+                encoder.Flush();
             }
         }
     }
 
-    return true;
 }
 
 void SelfPlay(const std::vector<std::string>& args)
 {
     g_syzygyProbeLimit = 7;
 
+    SelfPlayParams params;
+    if (!params.ParseArgs(args))
+    {
+        return;
+    }
+    params.Print();
+
     uint32_t nameSeed = 0;
     {
         std::random_device rd;
@@ -353,23 +640,44 @@ void SelfPlay(const std::vector<std::string>& args)
 
     std::cout << "Loading opening positions..." << std::endl;
     std::vector<PackedPosition> openingPositions;
-    if (!args.empty())
+    if (!params.openingsPath.empty())
     {
-        LoadOpeningPositions(args[0], openingPositions);
+        LoadOpeningPositions(params.openingsPath, openingPositions);
     }
 
     alignas(CACHELINE_SIZE) SelfPlayStats stats;
 
     std::cout << "Starting games..." << std::endl;
 
-    const uint32_t numThreads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+    const uint32_t numThreads = params.numThreads > 0 ? params.numThreads : std::max<uint32_t>(1, std::thread::hardware_concurrency());
+
+    // open output files (one per thread or a single file shared by all threads)
+    const uint32_t numOutputFiles = params.sharedOutputFile ? 1 : numThreads;
+    std::vector<std::unique_ptr<FileOutputStream>> outputFiles;
+    std::vector<std::unique_ptr<GameCollection::CompressedWriter>> writers;
+    for (uint32_t i = 0; i < numOutputFiles; ++i)
+    {
+        const std::string outputFileName = DATA_PATH "selfplayGames/selfplay_" +
+            std::to_string(nameSeed) + "_" +
+            std::to_string(params.maxNodes / 1000) + "kn" +
+            (params.sharedOutputFile ? "" : "_t" + std::to_string(i)) + ".dat";
+
+        outputFiles.push_back(std::make_unique<FileOutputStream>(outputFileName.c_str()));
+        writers.push_back(std::make_unique<GameCollection::CompressedWriter>(*outputFiles.back()));
+        if (!writers.back()->IsOK())
+        {
+            std::cerr << "Failed to open output file (games)!" << std::endl;
+            return;
+        }
+    }
 
     std::vector<std::thread> threads;
     for (uint32_t i = 0; i < numThreads; ++i)
     {
-        threads.emplace_back([i, nameSeed, &openingPositions, &stats]()
+        GameCollection::CompressedWriter& writer = *writers[i % numOutputFiles];
+        threads.emplace_back([i, &params, &openingPositions, &writer, &stats]()
         {
-            SelfPlayThreadFunc(nameSeed, i, openingPositions, stats);
+            SelfPlayThreadFunc(params, i, openingPositions, writer, stats);
         });
     }
 
@@ -377,4 +685,12 @@ void SelfPlay(const std::vector<std::string>& args)
     {
         thread.join();
     }
+
+    for (const auto& writer : writers)
+    {
+        writer->Finish();
+    }
+
+    std::cout << std::endl << "Self-play finished" << std::endl;
+    stats.Print();
 }
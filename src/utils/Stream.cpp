@@ -1,5 +1,19 @@
 #include "Stream.hpp"
 
+#include <algorithm>
+
+#if defined(PLATFORM_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#endif // PLATFORM_LINUX
+
+#if defined(PLATFORM_WINDOWS)
+#include <io.h>
+#endif // PLATFORM_WINDOWS
+
 MemoryInputStream::MemoryInputStream(const std::vector<uint8_t>& buffer)
     : mBuffer(buffer)
     , mPosition(0)
@@ -117,9 +131,9 @@ uint64_t FileInputStream::GetPosition() const
 bool FileInputStream::SetPosition(uint64_t offset)
 {
 #if defined(_MSC_VER)
-    return 0 != _fseeki64(mFile, offset, SEEK_SET);
+    return 0 == _fseeki64(mFile, offset, SEEK_SET);
 #else
-    return 0 != fseeko64(mFile, offset, SEEK_SET);
+    return 0 == fseeko64(mFile, offset, SEEK_SET);
 #endif
 }
 
@@ -133,6 +147,207 @@ bool FileInputStream::Read(void* data, size_t size)
     return fread(data, size, 1, mFile) == 1;
 }
 
+bool FileInputStream::ReadAt(uint64_t offset, void* data, size_t size) const
+{
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(data);
+
+#if defined(PLATFORM_WINDOWS)
+    const HANDLE fileHandle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(mFile)));
+    while (size > 0)
+    {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD numRead = 0;
+        const DWORD toRead = static_cast<DWORD>(std::min<size_t>(size, UINT32_MAX));
+        if (!::ReadFile(fileHandle, bytes, toRead, &numRead, &overlapped) || numRead == 0)
+        {
+            return false;
+        }
+
+        bytes += numRead;
+        offset += numRead;
+        size -= numRead;
+    }
+#else
+    const int fileDesc = fileno(mFile);
+    while (size > 0)
+    {
+        const ssize_t numRead = pread(fileDesc, bytes, size, static_cast<off_t>(offset));
+        if (numRead <= 0)
+        {
+            if (numRead < 0 && errno == EINTR) continue;
+            return false;
+        }
+
+        bytes += numRead;
+        offset += numRead;
+        size -= numRead;
+    }
+#endif // PLATFORM_WINDOWS
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+MmapInputStream::MmapInputStream(const char* filePath)
+    : mPath(filePath)
+{
+#if defined(PLATFORM_WINDOWS)
+
+    mFileHandle = ::CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mFileHandle == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "CreateFile() failed, error = %lu.\n", GetLastError());
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(mFileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        Release();
+        return;
+    }
+
+    mFileMapping = ::CreateFileMapping(mFileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mFileMapping == NULL)
+    {
+        fprintf(stderr, "CreateFileMapping() failed, error = %lu.\n", GetLastError());
+        Release();
+        return;
+    }
+
+    mData = reinterpret_cast<const uint8_t*>(::MapViewOfFile(mFileMapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr)
+    {
+        fprintf(stderr, "MapViewOfFile() failed, error = %lu.\n", GetLastError());
+        Release();
+        return;
+    }
+
+    mSize = static_cast<uint64_t>(fileSize.QuadPart);
+
+#else
+
+    mFileDesc = open(filePath, O_RDONLY);
+    if (mFileDesc == -1)
+    {
+        perror(filePath);
+        return;
+    }
+
+    struct stat statbuf;
+    if (fstat(mFileDesc, &statbuf) || statbuf.st_size == 0)
+    {
+        Release();
+        return;
+    }
+
+    void* data = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, mFileDesc, 0);
+    if (data == MAP_FAILED)
+    {
+        perror("mmap");
+        Release();
+        return;
+    }
+
+    mData = reinterpret_cast<const uint8_t*>(data);
+    mSize = statbuf.st_size;
+
+#endif // PLATFORM_WINDOWS
+}
+
+MmapInputStream::~MmapInputStream()
+{
+    Release();
+}
+
+void MmapInputStream::Release()
+{
+#if defined(PLATFORM_WINDOWS)
+    if (mData)
+    {
+        ::UnmapViewOfFile(mData);
+    }
+    if (mFileMapping != NULL)
+    {
+        ::CloseHandle(mFileMapping);
+        mFileMapping = NULL;
+    }
+    if (mFileHandle != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(mFileHandle);
+        mFileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (mData)
+    {
+        if (0 != munmap(const_cast<uint8_t*>(mData), mSize))
+        {
+            perror("munmap");
+        }
+    }
+    if (mFileDesc != -1)
+    {
+        close(mFileDesc);
+        mFileDesc = -1;
+    }
+#endif // PLATFORM_WINDOWS
+
+    mData = nullptr;
+    mSize = 0;
+    mPosition = 0;
+}
+
+bool MmapInputStream::SetPosition(uint64_t offset)
+{
+    if (offset > mSize)
+    {
+        return false;
+    }
+
+    mPosition = offset;
+    return true;
+}
+
+bool MmapInputStream::Read(void* data, size_t size)
+{
+    if (size > 0)
+    {
+        ASSERT(data);
+
+        if (mPosition + size > mSize)
+        {
+            return false;
+        }
+
+        memcpy(data, mData + mPosition, size);
+
+        mPosition += size;
+    }
+
+    return true;
+}
+
+void MmapInputStream::Advise(AccessPattern pattern)
+{
+#if defined(PLATFORM_LINUX)
+    if (mData)
+    {
+        int advice = MADV_NORMAL;
+        if (pattern == AccessPattern::Sequential) advice = MADV_SEQUENTIAL;
+        if (pattern == AccessPattern::Random) advice = MADV_RANDOM;
+
+        // Note: it's just a hint, ignore failure
+        (void)madvise(const_cast<uint8_t*>(mData), mSize, advice);
+    }
+#else
+    (void)pattern;
+#endif // PLATFORM_LINUX
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 FileOutputStream::FileOutputStream(const char* filePath)
@@ -197,3 +412,17 @@ bool FileOutputStream::IsOK() const
 {
     return mFile;
 }
+
+void FileOutputStream::Reserve(uint64_t size)
+{
+#if defined(PLATFORM_LINUX)
+    if (mFile != nullptr)
+    {
+        // allocate disk space without changing the file size
+        // Note: it's just a hint, ignore failure (e.g. if not supported by the file system)
+        (void)fallocate(fileno(mFile), FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+    }
+#else
+    (void)size;
+#endif // PLATFORM_LINUX
+}
@@ -5,6 +5,14 @@
 #include <vector>
 #include <stdio.h>
 
+#if defined(PLATFORM_WINDOWS)
+    #define WIN32_LEAN_AND_MEAN
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif // NOMINMAX
+    #include <Windows.h>
+#endif // PLATFORM_WINDOWS
+
 class InputStream
 {
 public:
@@ -23,6 +31,9 @@ public:
     virtual uint64_t GetSize() = 0;
     virtual bool Write(const void* data, size_t size) = 0;
     virtual bool IsOK() const { return true; }
+    virtual void Flush() { }
+    // hint the expected final size of the stream (e.g. for file space preallocation)
+    virtual void Reserve(uint64_t size) { (void)size; }
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -64,12 +75,60 @@ public:
     virtual bool IsEndOfFile() const override;
     virtual bool Read(void* data, size_t size) override;
     virtual const char* GetFileName() const override { return mPath.c_str(); }
+
+    // read at given offset, can be called from multiple threads at the same time
+    // Note: doesn't use the current stream position (but may modify it on Windows)
+    bool ReadAt(uint64_t offset, void* data, size_t size) const;
+
 private:
     FILE* mFile;
     uint64_t mSize = 0;
     std::string mPath;
 };
 
+// Read-only memory mapped file.
+// Allows direct (zero-copy) access to the file contents via GetData().
+class MmapInputStream : public InputStream
+{
+public:
+    enum class AccessPattern : uint8_t
+    {
+        Normal,
+        Sequential,
+        Random,
+    };
+
+    MmapInputStream(const char* filePath);
+    virtual ~MmapInputStream();
+    bool IsOpen() const { return mData != nullptr; }
+    virtual uint64_t GetPosition() const override { return mPosition; }
+    bool SetPosition(uint64_t offset);
+    virtual uint64_t GetSize() override { return mSize; }
+    virtual bool IsEndOfFile() const override { return mPosition >= mSize; }
+    virtual bool Read(void* data, size_t size) override;
+    virtual const char* GetFileName() const override { return mPath.c_str(); }
+
+    const uint8_t* GetData() const { return mData; }
+
+    // hint the OS about expected access pattern (affects read-ahead)
+    void Advise(AccessPattern pattern);
+
+private:
+    void Release();
+
+#if defined(PLATFORM_WINDOWS)
+    HANDLE mFileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mFileMapping = NULL;
+#else
+    int mFileDesc = -1;
+#endif // PLATFORM_WINDOWS
+
+    const uint8_t* mData = nullptr;
+    uint64_t mSize = 0;
+    uint64_t mPosition = 0;
+    std::string mPath;
+};
+
 class FileOutputStream : public OutputStream
 {
 public:
@@ -77,10 +136,11 @@ public:
     virtual ~FileOutputStream();
     bool IsOpen() const;
     bool Seek(uint64_t pos);
-    void Flush();
+    virtual void Flush() override;
     virtual uint64_t GetSize() override;
     virtual bool Write(const void* data, size_t size) override;
     virtual bool IsOK() const override;
+    virtual void Reserve(uint64_t size) override;
 private:
     FILE* mFile;
 };
@@ -1,4 +1,5 @@
 #include "ThreadPool.hpp"
+#include "Async.hpp"
 
 #include "../backend/Position.hpp"
 #include "../backend/MoveList.hpp"
@@ -13,6 +14,7 @@
 #include "../backend/MovePicker.hpp"
 #include "../backend/MoveOrderer.hpp"
 #include "../backend/Waitable.hpp"
+#include "../backend/NodeCache.hpp"
 
 #include <iostream>
 #include <chrono>
@@ -140,6 +142,41 @@ static void RunPositionTests()
         TEST_EXPECT(Position("rnbqkbnr/1pp1pppp/p7/3pP3/8/8/PPPP1PPP/RNBQKBNR w Qkq d6 0 3").GetHash() != Position("rnbqkbnr/1pp1pppp/p7/3pP3/8/8/PPPP1PPP/RNBQKBNR w Qkq - 0 3").GetHash());
     }
 
+    // pawns, material and non-pawns hashes
+    {
+        const Position posA("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+        const Position posB("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b Kkq e3 2 3");
+        const Position posC("rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2");
+        const Position posD("rnbqkbnr/pppp1ppp/8/4p3/8/4P3/PPPP1PPP/RNBQKBNR w KQkq - 0 2");
+
+        TEST_EXPECT(posA.GetPawnsHash() == posB.GetPawnsHash());
+        TEST_EXPECT(posA.GetPawnsHash() == posC.GetPawnsHash());
+        TEST_EXPECT(posA.GetMaterialHash() == posC.GetMaterialHash());
+        TEST_EXPECT(posC.GetPawnsHash() != posD.GetPawnsHash());
+        TEST_EXPECT(posC.GetMaterialHash() == posD.GetMaterialHash());
+        TEST_EXPECT(posC.GetMaterialHash() != Position("rnbqkbnr/pppp1ppp/8/4p3/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2").GetMaterialHash());
+        TEST_EXPECT(posA.GetNonPawnsHash() == posB.GetNonPawnsHash());
+        TEST_EXPECT(posC.GetNonPawnsHash() == posD.GetNonPawnsHash());
+        TEST_EXPECT(posA.GetNonPawnsHash() != posC.GetNonPawnsHash());
+
+        // incremental update
+        Position pos = posC;
+        TEST_EXPECT(pos.DoMove(pos.MoveFromString("g1f3")));
+        TEST_EXPECT(pos.DoMove(pos.MoveFromString("b8c6")));
+        TEST_EXPECT(pos.GetMaterialHash() == posA.GetMaterialHash());
+        TEST_EXPECT(pos.GetNonPawnsHash() == posA.GetNonPawnsHash());
+        TEST_EXPECT(pos.DoMove(pos.MoveFromString("f3e5")));
+        TEST_EXPECT(pos.GetMaterialHash() == Position("r1bqkbnr/pppp1ppp/2n5/4N3/4P3/8/PPPP1PPP/RNBQKB1R b KQkq - 0 3").GetMaterialHash());
+        TEST_EXPECT(pos.GetMaterialHash() != posA.GetMaterialHash());
+        TEST_EXPECT(pos.GetNonPawnsHash() == Position("r1bqkbnr/pppp1ppp/2n5/4N3/4P3/8/PPPP1PPP/RNBQKB1R b KQkq - 0 3").GetNonPawnsHash());
+
+        // hash after move
+        const Move move = posA.MoveFromString("f1c4");
+        Position posAfterMove = posA;
+        TEST_EXPECT(posAfterMove.DoMove(move));
+        TEST_EXPECT(posA.HashAfterMove(move) == posAfterMove.GetHash());
+    }
+
     // equality
     {
         TEST_EXPECT(Position("rn1qkb1r/pp2pppp/5n2/3p1b2/3P4/1QN1P3/PP3PPP/R1B1KBNR b KQkq - 0 1") == Position("rn1qkb1r/pp2pppp/5n2/3p1b2/3P4/1QN1P3/PP3PPP/R1B1KBNR b KQkq - 0 1"));
@@ -1410,6 +1447,213 @@ static void RunMaterialTests()
     }
 }
 
+static void RunNodeCacheTests()
+{
+    const Position pos(Position::InitPositionFEN);
+    const Move e2e4 = Move::Make(Square_e2, Square_e4, Piece::Pawn);
+    const Move d2d4 = Move::Make(Square_d2, Square_d4, Piece::Pawn);
+
+    NodeCache cache;
+    cache.Resize(64 * 1024);
+    TEST_EXPECT(cache.GetSize() == 64 * 1024);
+    cache.OnNewSearch();
+
+    TEST_EXPECT(!cache.TryGetEntry(pos));
+
+    NodeCacheEntry* entry = cache.GetEntry(pos, 0);
+    TEST_EXPECT(entry);
+    TEST_EXPECT(cache.TryGetEntry(pos) == entry);
+    TEST_EXPECT(cache.GetEntry(pos, 0) == entry);
+
+    entry->AddMoveStats(e2e4, 300);
+    entry->AddMoveStats(d2d4, 100);
+    entry->AddMoveStats(e2e4, 200);
+    TEST_EXPECT(entry->GetMoveNodes(e2e4) == 500);
+    TEST_EXPECT(entry->GetMoveNodes(d2d4) == 100);
+    TEST_EXPECT(entry->GetMoveNodes(Move::Make(Square_g1, Square_f3, Piece::Knight)) == 0);
+    TEST_EXPECT(entry->nodesSum == 600);
+
+    // counters are scaled down instead of overflowing
+    entry->AddMoveStats(d2d4, 8000000000ull);
+    TEST_EXPECT(entry->GetMoveNodes(d2d4) > entry->GetMoveNodes(e2e4));
+    TEST_EXPECT(entry->nodesSum == entry->GetMoveNodes(d2d4) + entry->GetMoveNodes(e2e4));
+
+    // entries from previous search are reused
+    cache.OnNewSearch();
+    TEST_EXPECT(cache.GetEntry(pos, 1) == entry);
+    TEST_EXPECT(entry->distanceFromRoot == 1);
+
+    cache.Reset();
+    TEST_EXPECT(!cache.TryGetEntry(pos));
+
+    // re-rooting keeps only the subtree of the new root
+    {
+        cache.SetMaxDistanceFromRoot(4);
+        cache.OnNewSearch();
+
+        const auto addEntry = [&](const Position& entryPos, uint32_t distance, const char* moveStr) -> NodeCacheEntry*
+        {
+            NodeCacheEntry* e = cache.GetEntry(entryPos, distance);
+            TEST_EXPECT(e);
+            e->AddMoveStats(entryPos.MoveFromString(moveStr), 100);
+            return e;
+        };
+
+        Position posE4 = pos;
+        TEST_EXPECT(posE4.DoMove(e2e4));
+        Position posE4E5 = posE4;
+        TEST_EXPECT(posE4E5.DoMove(posE4E5.MoveFromString("e7e5")));
+        Position posE4E5Nf3 = posE4E5;
+        TEST_EXPECT(posE4E5Nf3.DoMove(posE4E5Nf3.MoveFromString("g1f3")));
+        Position posD4 = pos;
+        TEST_EXPECT(posD4.DoMove(d2d4));
+        Position posD4D5 = posD4;
+        TEST_EXPECT(posD4D5.DoMove(posD4D5.MoveFromString("d7d5")));
+
+        addEntry(pos, 0, "e2e4")->AddMoveStats(d2d4, 100);
+        addEntry(posE4, 1, "e7e5");
+        addEntry(posD4, 1, "d7d5");
+        NodeCacheEntry* newRootEntry = addEntry(posE4E5, 2, "g1f3");
+        NodeCacheEntry* childEntry = addEntry(posE4E5Nf3, 3, "b8c6");
+        NodeCacheEntry* siblingEntry = addEntry(posD4D5, 2, "c2c4");
+
+        cache.OnNewSearch(posE4E5, 2);
+        TEST_EXPECT(newRootEntry->distanceFromRoot == 0);
+        TEST_EXPECT(childEntry->distanceFromRoot == 1);
+        TEST_EXPECT(childEntry->generation == newRootEntry->generation);
+        TEST_EXPECT(siblingEntry->distanceFromRoot == 2);
+        TEST_EXPECT(siblingEntry->generation < newRootEntry->generation);
+        TEST_EXPECT(newRootEntry->GetMoveNodes(posE4E5.MoveFromString("g1f3")) == 100);
+
+        cache.SetMaxDistanceFromRoot(NodeCache::DefaultMaxDistanceFromRoot);
+        cache.Reset();
+    }
+}
+
+static void RunThreadPoolTests()
+{
+    std::cout << "Running ThreadPool tests..." << std::endl;
+
+    // fences: each stage must see all the tasks of the previous stage finished
+    {
+        constexpr uint32_t numStages = 8;
+        constexpr uint32_t numTasksPerStage = 64;
+        std::atomic<uint32_t> counter = 0;
+        std::atomic<bool> orderViolated = false;
+
+        Waitable waitable;
+        {
+            TaskBuilder taskBuilder(waitable);
+            for (uint32_t stage = 0; stage < numStages; ++stage)
+            {
+                for (uint32_t i = 0; i < numTasksPerStage; ++i)
+                {
+                    taskBuilder.Task("Stage", [stage, &counter, &orderViolated](const TaskContext&)
+                    {
+                        if (counter.fetch_add(1) < stage * numTasksPerStage) orderViolated = true;
+                    });
+                }
+                taskBuilder.Fence();
+            }
+        }
+        waitable.Wait();
+
+        TEST_EXPECT(counter == numStages * numTasksPerStage);
+        TEST_EXPECT(!orderViolated);
+    }
+
+    // parallel-for ranges cover every element exactly once, reduction sees all of them
+    {
+        constexpr uint32_t numElements = 100003;
+        std::vector<uint8_t> visited(numElements, 0);
+        uint64_t sum = 0;
+
+        Waitable waitable;
+        {
+            TaskBuilder taskBuilder(waitable);
+            taskBuilder.ParallelForRange("Range", numElements, [&visited](const TaskContext&, uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; ++i) visited[i]++;
+            }, 7);
+            taskBuilder.Fence();
+            taskBuilder.ParallelReduce("Reduce", numElements, sum,
+                [&visited](const TaskContext&, uint32_t begin, uint32_t end, uint64_t& partialSum)
+                {
+                    for (uint32_t i = begin; i < end; ++i) partialSum += visited[i] * i;
+                },
+                [](uint64_t& result, const uint64_t& partialSum) { result += partialSum; });
+        }
+        waitable.Wait();
+
+        TEST_EXPECT(std::all_of(visited.begin(), visited.end(), [](uint8_t x) { return x == 1; }));
+        TEST_EXPECT(sum == uint64_t(numElements) * (numElements - 1) / 2);
+    }
+
+    // coroutine tasks: awaiting other coroutines, waitable objects and blocking calls
+    {
+        constexpr uint32_t numCoroutines = 64;
+        std::atomic<uint32_t> sum = 0;
+
+        Waitable signal;
+        Waitable waitable;
+        {
+            TaskBuilder taskBuilder(waitable);
+            for (uint32_t i = 0; i < numCoroutines; ++i)
+            {
+                taskBuilder.AsyncTask("Coroutine", [i, &sum, &signal]() -> Async<void>
+                {
+                    const auto square = [](uint32_t x) -> Async<uint32_t> { co_return x * x; };
+                    const uint32_t value = co_await square(i);
+                    const uint32_t blockingValue = co_await RunBlocking([value]() { return value + 1; });
+                    co_await WaitAsync(signal);
+                    sum += blockingValue;
+                });
+            }
+            taskBuilder.Task("Signal", [&signal](const TaskContext&) { signal.OnFinished(); });
+            taskBuilder.Fence();
+            taskBuilder.Task("Check", [&sum](const TaskContext&)
+            {
+                TEST_EXPECT(sum == numCoroutines + (numCoroutines - 1) * numCoroutines * (2 * numCoroutines - 1) / 6);
+            });
+        }
+        waitable.Wait();
+
+        TEST_EXPECT(sum == numCoroutines + (numCoroutines - 1) * numCoroutines * (2 * numCoroutines - 1) / 6);
+    }
+
+    // nested tasks spawned from worker threads on a standalone pool
+    {
+        ThreadPool pool(4);
+        std::atomic<uint32_t> counter = 0;
+
+        Waitable waitable;
+        {
+            TaskDesc rootDesc([&counter](const TaskContext& ctx)
+            {
+                for (uint32_t i = 0; i < 100; ++i)
+                {
+                    TaskDesc desc([&counter](const TaskContext& childCtx)
+                    {
+                        for (uint32_t j = 0; j < 10; ++j)
+                        {
+                            TaskDesc leafDesc([&counter](const TaskContext&) { counter++; });
+                            leafDesc.parent = childCtx.taskId;
+                            childCtx.pool->CreateAndDispatchTask(leafDesc);
+                        }
+                    });
+                    desc.parent = ctx.taskId;
+                    ctx.pool->CreateAndDispatchTask(desc);
+                }
+            });
+            rootDesc.waitable = &waitable;
+            pool.CreateAndDispatchTask(rootDesc);
+        }
+        waitable.Wait();
+
+        TEST_EXPECT(counter == 1000u);
+    }
+}
+
 static void RunPerftTests()
 {
     std::cout << "Running Perft tests..." << std::endl;
@@ -2082,15 +2326,57 @@ void RunUnitTests()
     RunBitboardTests();
     RunPositionTests();
     RunMaterialTests();
+    RunNodeCacheTests();
     RunEvalTests();
     RunPackedPositionTests();
     RunGameTests();
+    RunThreadPoolTests();
     RunPerftTests();
     RunSearchTests();
 }
 
-bool RunPerformanceTests(const std::vector<std::string>& paths)
+// Runs EPD test suites (bm/am operations) and reports time-to-solve and nodes-to-solve statistics.
+// Positions are distributed across the thread pool, each worker slot has its own Search and transposition table.
+// Usage: perftest <files...> [--time <ms>] [--nodes <nodes>] [--hash <MB>] [--threads-per-position <threads>] [--verbose]
+bool RunPerformanceTests(const std::vector<std::string>& args)
 {
+    uint32_t maxTimeMs = 1000;
+    uint64_t maxNodes = UINT64_MAX;
+    uint32_t hashSizeInMB = 16;
+    uint32_t threadsPerPosition = 1;
+    bool verbose = false;
+
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        const bool hasValue = i + 1 < args.size();
+
+        if (args[i] == "--time" && hasValue)
+        {
+            maxTimeMs = std::max(1, atoi(args[++i].c_str()));
+        }
+        else if (args[i] == "--nodes" && hasValue)
+        {
+            maxNodes = std::max<uint64_t>(1, strtoull(args[++i].c_str(), nullptr, 10));
+        }
+        else if (args[i] == "--hash" && hasValue)
+        {
+            hashSizeInMB = std::max(1, atoi(args[++i].c_str()));
+        }
+        else if (args[i] == "--threads-per-position" && hasValue)
+        {
+            threadsPerPosition = std::max(1, atoi(args[++i].c_str()));
+        }
+        else if (args[i] == "--verbose")
+        {
+            verbose = true;
+        }
+        else
+        {
+            paths.push_back(args[i]);
+        }
+    }
+
     using MovesListType = std::vector<std::string>;
 
     struct TestCaseEntry
@@ -2206,39 +2492,86 @@ bool RunPerformanceTests(const std::vector<std::string>& paths)
 
     std::cout << testVector.size() << " test positions loaded" << std::endl << std::endl;
 
-    std::cout << "MaxNodes; Correct; CorrectRate; Time; Time/Correct" << std::endl;
+    // run as many positions in parallel as there are free hardware threads
+    const uint32_t numHardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t numSlots = std::max(1u, numHardwareThreads / threadsPerPosition);
 
-    bool verbose = false;
+    std::cout << "Time limit: " << maxTimeMs << " ms, ";
+    if (maxNodes < UINT64_MAX) std::cout << "node limit: " << maxNodes << ", ";
+    std::cout << "threads per position: " << threadsPerPosition << ", parallel positions: " << numSlots << std::endl << std::endl;
 
-    std::vector<Search> searchArray{ std::thread::hardware_concurrency() };
+    const auto isCorrectMove = [](const TestCaseEntry& testCase, const Position& position, const Move move)
+    {
+        if (!move.IsValid())
+        {
+            return false;
+        }
 
-    std::vector<TranspositionTable> ttArray;
-    ttArray.resize(std::thread::hardware_concurrency());
+        const std::string moveStrLAN = position.MoveToString(move, MoveNotation::LAN);
+        const std::string moveStrSAN = position.MoveToString(move, MoveNotation::SAN);
 
-    uint32_t maxNodes = 2048;
+        if (!testCase.bestMoves.empty())
+        {
+            for (const std::string& bestMoveStr : testCase.bestMoves)
+            {
+                if (moveStrLAN == bestMoveStr || moveStrSAN == bestMoveStr)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
 
-    for (;;)
+        for (const std::string& avoidMoveStr : testCase.avoidMoves)
+        {
+            if (moveStrLAN == avoidMoveStr || moveStrSAN == avoidMoveStr)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    struct TestCaseResult
     {
-        std::mutex mutex;
-        std::atomic<uint32_t> success = 0;
-        float accumTime = 0.0f;
+        bool solved = false;
+        float solveTime = 0.0f;     // time when correct move was found and not changed since
+        uint64_t solveNodes = 0;    // nodes searched when correct move was found and not changed since
+        uint16_t solveDepth = 0;
+        float totalTime = 0.0f;
+        uint64_t totalNodes = 0;
+        std::string foundMove;
+    };
 
-        Waitable waitable;
-        {
-            TaskBuilder taskBuilder(waitable);
+    std::vector<TestCaseResult> results(testVector.size());
+    std::atomic<uint32_t> nextTestCase = 0;
+    std::mutex mutex;
+
+    const TimePoint startTime = TimePoint::GetCurrent();
+
+    Waitable waitable;
+    {
+        TaskBuilder taskBuilder(waitable);
 
-            for (const TestCaseEntry& testCase : testVector)
+        for (uint32_t slot = 0; slot < numSlots; ++slot)
+        {
+            taskBuilder.Task("TestSuiteSlot", [&](const TaskContext&)
             {
-                taskBuilder.Task("SearchTest", [testCase, &searchArray, maxNodes, &mutex, verbose, &success, &ttArray, &accumTime](const TaskContext& ctx)
-                {
-                    Search& search = searchArray[ctx.threadId];
-                    search.Clear();
+                Search search;
+                TranspositionTable tt(static_cast<size_t>(hashSizeInMB) * 1024 * 1024);
 
-                    TranspositionTable& tt = ttArray[ctx.threadId];
-                    if (tt.GetSize() == 0)
+                for (;;)
+                {
+                    const uint32_t testCaseIndex = nextTestCase++;
+                    if (testCaseIndex >= testVector.size())
                     {
-                        tt.Resize(16 * 1024 * 1024);
+                        break;
                     }
+
+                    const TestCaseEntry& testCase = testVector[testCaseIndex];
+                    TestCaseResult& result = results[testCaseIndex];
+
+                    search.Clear();
                     tt.Clear();
 
                     const Position position(testCase.positionStr);
@@ -2247,111 +2580,129 @@ bool RunPerformanceTests(const std::vector<std::string>& paths)
                     Game game;
                     game.Reset(position);
 
+                    const TimePoint searchStartTime = TimePoint::GetCurrent();
+
                     SearchParam searchParam{ tt };
                     searchParam.debugLog = false;
+                    searchParam.numThreads = threadsPerPosition;
+                    searchParam.limits.startTimePoint = searchStartTime;
+                    searchParam.limits.maxTime = TimePoint::FromSeconds(0.001f * maxTimeMs);
                     searchParam.limits.maxNodes = maxNodes;
 
-                    const TimePoint startTimePoint = TimePoint::GetCurrent();
+                    // track when the correct move appeared as the best move for the last time
+                    bool correctSoFar = false;
+                    searchParam.iterationCallback = [&](uint16_t depth, const PvLine& pvLine, uint64_t nodes)
+                    {
+                        const bool correct = !pvLine.moves.empty() && isCorrectMove(testCase, position, pvLine.moves.front());
+                        if (correct && !correctSoFar)
+                        {
+                            result.solveTime = (TimePoint::GetCurrent() - searchStartTime).ToSeconds();
+                            result.solveNodes = nodes;
+                            result.solveDepth = depth;
+                        }
+                        correctSoFar = correct;
+                    };
 
+                    SearchStats stats;
                     SearchResult searchResult;
-                    search.DoSearch(game, searchParam, searchResult);
+                    search.DoSearch(game, searchParam, searchResult, &stats);
 
-                    const TimePoint endTimePoint = TimePoint::GetCurrent();
+                    result.totalTime = (TimePoint::GetCurrent() - searchStartTime).ToSeconds();
+                    result.totalNodes = stats.nodes;
 
-                    {
-                        std::unique_lock<std::mutex> lock(mutex);
-                        accumTime += (endTimePoint - startTimePoint).ToSeconds();
-                    }
+                    const Move foundMove = !searchResult.empty() && !searchResult[0].moves.empty() ? searchResult[0].moves.front() : Move::Invalid();
+                    result.foundMove = foundMove.IsValid() ? position.MoveToString(foundMove, MoveNotation::SAN) : "none";
+                    result.solved = correctSoFar && isCorrectMove(testCase, position, foundMove);
 
-                    Move foundMove = Move::Invalid();
-                    if (!searchResult[0].moves.empty())
-                    {
-                        foundMove = searchResult[0].moves[0];
-                    }
-
-                    if (!foundMove.IsValid())
+                    if (verbose)
                     {
                         std::unique_lock<std::mutex> lock(mutex);
-                        std::cout << "[FAILURE] No move found! position: " << testCase.positionStr << std::endl;
-                        return;
-                    }
-
-                    const std::string foundMoveStrLAN = position.MoveToString(foundMove, MoveNotation::LAN);
-                    const std::string foundMoveStrSAN = position.MoveToString(foundMove, MoveNotation::SAN);
-                    bool correctMoveFound = false;
-                    if (!testCase.bestMoves.empty())
-                    {
-                        for (const std::string& bestMoveStr : testCase.bestMoves)
+                        if (result.solved)
                         {
-                            if (foundMoveStrLAN == bestMoveStr || foundMoveStrSAN == bestMoveStr)
-                            {
-                                correctMoveFound = true;
-                            }
+                            std::cout << "[SOLVED] " << result.foundMove << " time: " << result.solveTime << " s, nodes: " << result.solveNodes
+                                << ", depth: " << result.solveDepth << ", position: " << testCase.positionStr << std::endl;
                         }
-                    }
-                    else
-                    {
-                        correctMoveFound = true;
-                        for (const std::string& avoidMoveStr : testCase.avoidMoves)
+                        else
                         {
-                            if (foundMoveStrLAN == avoidMoveStr || foundMoveStrSAN == avoidMoveStr)
-                            {
-                                correctMoveFound = false;
-                            }
+                            std::cout << "[FAILED] found: " << result.foundMove << ", position: " << testCase.positionStr << std::endl;
                         }
                     }
+                }
+            });
+        }
+    }
 
-                    if (!correctMoveFound)
-                    {
-                        if (verbose)
-                        {
-                            std::unique_lock<std::mutex> lock(mutex);
-                            std::cout << "[FAILURE] Wrong move found! ";
-
-                            if (!testCase.bestMoves.empty())
-                            {
-                                std::cout << "expected: ";
-                                for (const std::string& bestMoveStr : testCase.bestMoves) std::cout << bestMoveStr << " ";
-                            }
-                            else if (!testCase.avoidMoves.empty())
-                            {
-                                std::cout << "not expected: ";
-                                for (const std::string& bestMoveStr : testCase.avoidMoves) std::cout << bestMoveStr << " ";
-                            }
-
-                            std::cout << "found: " << foundMoveStrLAN << " position: " << testCase.positionStr << std::endl;
-                        }
-                        return;
-                    }
+    waitable.Wait();
 
-                    {
-                        if (verbose)
-                        {
-                            std::unique_lock<std::mutex> lock(mutex);
-                            std::cout << "[SUCCESS] Found valid move: " << foundMoveStrLAN << std::endl;
-                        }
-                        success++;
-                    }
-                });
-            }
+    const float wallTime = (TimePoint::GetCurrent() - startTime).ToSeconds();
+
+    uint32_t numSolved = 0;
+    float sumSolveTime = 0.0f;
+    uint64_t sumSolveNodes = 0;
+    float sumSearchTime = 0.0f;
+    uint64_t sumSearchNodes = 0;
+    std::vector<float> solveTimes;
+    std::vector<uint64_t> solveNodes;
 
-            //taskBuilder.Fence();
+    for (const TestCaseResult& result : results)
+    {
+        sumSearchTime += result.totalTime;
+        sumSearchNodes += result.totalNodes;
+
+        if (result.solved)
+        {
+            numSolved++;
+            sumSolveTime += result.solveTime;
+            sumSolveNodes += result.solveNodes;
+            solveTimes.push_back(result.solveTime);
+            solveNodes.push_back(result.solveNodes);
         }
+    }
 
-        waitable.Wait();
+    std::sort(solveTimes.begin(), solveTimes.end());
+    std::sort(solveNodes.begin(), solveNodes.end());
 
-        const float passRate = !testVector.empty() ? (float)success / (float)testVector.size() : 0.0f;
-        const float factor = accumTime / passRate;
+    const float numPositions = static_cast<float>(std::max<size_t>(1, testVector.size()));
 
+    // solved positions versus time/nodes limit
+    std::cout << "Time [ms]; Solved; SolvedRate" << std::endl;
+    for (uint32_t timeLimit = 1; ; timeLimit *= 2)
+    {
+        const uint32_t clampedLimit = std::min(timeLimit, maxTimeMs);
+        const size_t count = std::upper_bound(solveTimes.begin(), solveTimes.end(), 0.001f * clampedLimit) - solveTimes.begin();
         std::cout
-            << std::setw(10) << maxNodes << "; "
-            << std::setw(4) << success << "; "
-            << std::setw(8) << std::setprecision(4) << passRate << "; "
-            << std::setw(8) << std::setprecision(4) << accumTime << "; "
-            << std::setw(8) << std::setprecision(4) << factor << std::endl;
+            << std::setw(9) << clampedLimit << "; "
+            << std::setw(6) << count << "; "
+            << std::setw(10) << std::setprecision(4) << count / numPositions << std::endl;
+        if (clampedLimit >= maxTimeMs) break;
+    }
+    std::cout << std::endl;
+
+    if (!solveNodes.empty())
+    {
+        std::cout << "Nodes; Solved; SolvedRate" << std::endl;
+        for (uint64_t nodesLimit = 1024; ; nodesLimit *= 4)
+        {
+            const size_t count = std::upper_bound(solveNodes.begin(), solveNodes.end(), nodesLimit) - solveNodes.begin();
+            std::cout
+                << std::setw(10) << nodesLimit << "; "
+                << std::setw(6) << count << "; "
+                << std::setw(10) << std::setprecision(4) << count / numPositions << std::endl;
+            if (nodesLimit >= solveNodes.back()) break;
+        }
+        std::cout << std::endl;
+    }
 
-        maxNodes *= 2;
+    std::cout << "Solved:              " << numSolved << " / " << testVector.size() << std::endl;
+    if (numSolved > 0)
+    {
+        std::cout << "Avg. time to solve:  " << 1000.0f * sumSolveTime / numSolved << " ms" << std::endl;
+        std::cout << "Avg. nodes to solve: " << sumSolveNodes / numSolved << std::endl;
     }
+    std::cout << "Wall time:           " << wallTime << " s" << std::endl;
+    std::cout << "Positions/s:         " << testVector.size() / wallTime << std::endl;
+    std::cout << "Total NPS:           " << static_cast<uint64_t>(sumSearchNodes / wallTime) << std::endl;
+    std::cout << "NPS per position:    " << static_cast<uint64_t>(sumSearchNodes / std::max(sumSearchTime, 0.001f)) << std::endl;
 
     return true;
 }
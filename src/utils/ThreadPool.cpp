@@ -6,6 +6,12 @@
 
 namespace threadpool {
 
+static constexpr int64_t TaskDequeInitialSize = 1024;
+
+// worker thread (and its pool) the current thread belongs to
+static thread_local ThreadPool* tl_currentPool = nullptr;
+static thread_local WorkerThread* tl_currentWorker = nullptr;
+
 Task::Task()
 {
     Reset();
@@ -14,13 +20,13 @@ Task::Task()
 void Task::Reset()
 {
     mState = State::Invalid;
-    mDependencyState = 0;
+    mBlockersLeft = 0;
     mTasksLeft = 0;
     mParent = InvalidTaskID;
     mDependency = InvalidTaskID;
     mHead = InvalidTaskID;
-    mTail = InvalidTaskID;
     mSibling = InvalidTaskID;
+    mContinuation = InvalidTaskID;
     mWaitable = nullptr;
     mDebugName = nullptr;
 }
@@ -30,10 +36,11 @@ Task::Task(Task&& other)
     mState = other.mState.load();
     mTasksLeft = other.mTasksLeft.load();
     mParent = other.mParent;
+    mNextFree = other.mNextFree.load();
     mDependency = other.mDependency;
-    mHead = other.mHead;
-    mTail = other.mTail;
+    mHead = other.mHead.load();
     mSibling = other.mSibling;
+    mContinuation = other.mContinuation;
     mWaitable = other.mWaitable;
 }
 
@@ -41,9 +48,113 @@ Task::Task(Task&& other)
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
-WorkerThread::WorkerThread(ThreadPool* pool, uint32_t id)
-    : mThread{&ThreadPool::SchedulerCallback, pool, this}
-    , mId(id)
+TaskDeque::Buffer::Buffer(int64_t size)
+    : mask(size - 1)
+    , elements(new std::atomic<TaskID>[size])
+{
+    assert((size & mask) == 0); // size must be power of two
+}
+
+TaskDeque::TaskDeque()
+    : mTop(0)
+    , mBottom(0)
+{
+    mBuffers.emplace_back(std::make_unique<Buffer>(TaskDequeInitialSize));
+    mBuffer = mBuffers.back().get();
+}
+
+TaskDeque::~TaskDeque() = default;
+
+TaskDeque::Buffer* TaskDeque::Grow(Buffer* buffer, int64_t bottom, int64_t top)
+{
+    std::unique_ptr<Buffer> newBuffer = std::make_unique<Buffer>(2 * (buffer->mask + 1));
+    for (int64_t i = top; i < bottom; ++i)
+    {
+        newBuffer->Put(i, buffer->Get(i));
+    }
+
+    // old buffer can't be freed here, because thieves may still read from it
+    Buffer* newBufferPtr = newBuffer.get();
+    mBuffers.push_back(std::move(newBuffer));
+    mBuffer.store(newBufferPtr, std::memory_order_release);
+    return newBufferPtr;
+}
+
+void TaskDeque::Push(TaskID taskID)
+{
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    const int64_t top = mTop.load(std::memory_order_acquire);
+    Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+
+    if (bottom - top > buffer->mask)
+    {
+        buffer = Grow(buffer, bottom, top);
+    }
+
+    buffer->Put(bottom, taskID);
+    std::atomic_thread_fence(std::memory_order_release);
+    mBottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+TaskID TaskDeque::Pop()
+{
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = mTop.load(std::memory_order_relaxed);
+
+    TaskID result = InvalidTaskID;
+
+    if (top <= bottom)
+    {
+        result = buffer->Get(bottom);
+        if (top == bottom)
+        {
+            // last element, race against thieves
+            if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                result = InvalidTaskID;
+            }
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+    }
+    else
+    {
+        // deque was empty
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+TaskID TaskDeque::Steal()
+{
+    int64_t top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = mBottom.load(std::memory_order_acquire);
+
+    if (top < bottom)
+    {
+        const Buffer* buffer = mBuffer.load(std::memory_order_acquire);
+        const TaskID result = buffer->Get(top);
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            // lost the race against the owner or other thief
+            return InvalidTaskID;
+        }
+        return result;
+    }
+
+    return InvalidTaskID;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
+WorkerThread::WorkerThread(uint32_t id)
+    : mId(id)
     , mStarted(true)
 {
 }
@@ -64,30 +175,44 @@ ThreadPool& ThreadPool::GetInstance()
 }
 
 ThreadPool::ThreadPool()
-    : mFirstFreeTask(InvalidTaskID)
+    : ThreadPool(std::max<int32_t>(1, (int32_t)std::thread::hardware_concurrency() - 2), true)
+{
+}
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+    : ThreadPool(numThreads, false)
 {
-    mtr_init("trace.json");
+}
+
+ThreadPool::ThreadPool(uint32_t numThreads, bool isGlobalInstance)
+    : mNumSharedTasks(0)
+    , mNumSleepingThreads(0)
+    , mIsGlobalInstance(isGlobalInstance)
+{
+    if (mIsGlobalInstance)
+    {
+        mtr_init("trace.json");
 
-    MTR_META_THREAD_NAME("Main Thread");
+        MTR_META_THREAD_NAME("Main Thread");
+    }
 
     // TODO make it configurable
     InitTasksTable(TasksCapacity);
 
-    const uint32_t numThreads = std::max<uint32_t>(1, std::thread::hardware_concurrency() - 2);
-    SpawnWorkerThreads(numThreads);
+    SpawnWorkerThreads(std::max(1u, numThreads));
 }
 
 ThreadPool::~ThreadPool()
 {
     {
-        std::unique_lock<std::mutex> lock(mTasksQueueMutex);
+        std::unique_lock<std::mutex> lock(mSleepMutex);
 
         for (const WorkerThreadPtr& thread : mThreads)
         {
             thread->mStarted = false;
         }
 
-        mTaskQueueCV.notify_all();
+        mSleepCV.notify_all();
     }
 
     for (const WorkerThreadPtr& thread : mThreads)
@@ -95,30 +220,83 @@ ThreadPool::~ThreadPool()
         thread->mThread.join();
     }
 
-    mtr_flush();
-    mtr_shutdown();
+    if (mIsGlobalInstance)
+    {
+        mtr_flush();
+        mtr_shutdown();
+    }
 }
 
 bool ThreadPool::InitTasksTable(uint32_t newSize)
 {
     mTasks.resize(newSize);
 
-    mFirstFreeTask = 0;
     for (uint32_t i = 0; i < newSize - 1; ++i)
     {
         mTasks[i].mNextFree = i + 1;
     }
     mTasks[newSize - 1].mNextFree = InvalidTaskID;
 
+    mFreeListHead = 0;
+
     return true;
 }
 
 void ThreadPool::SpawnWorkerThreads(uint32_t num)
 {
+    assert(mThreads.empty()); // workers access thread list without locking, so it can't change once they are running
+
     for (uint32_t i = 0; i < num; ++i)
     {
-        mThreads.emplace_back(std::make_unique<WorkerThread>(this, i));
+        mThreads.emplace_back(std::make_unique<WorkerThread>(i));
+    }
+
+    for (const WorkerThreadPtr& thread : mThreads)
+    {
+        thread->mThread = std::thread(&ThreadPool::SchedulerCallback, this, thread.get());
+    }
+}
+
+TaskID ThreadPool::FindTask(WorkerThread* thread)
+{
+    const uint32_t numThreads = GetNumThreads();
+
+    for (uint32_t priority = 0; priority < NumPriorities; ++priority)
+    {
+        // own queue first
+        TaskID taskID = thread->mQueues[priority].Pop();
+        if (taskID != InvalidTaskID)
+        {
+            return taskID;
+        }
+
+        // tasks pushed from outside of the worker threads
+        if (mNumSharedTasks.load(std::memory_order_relaxed) > 0)
+        {
+            std::unique_lock<std::mutex> lock(mSharedQueueMutex);
+            std::deque<TaskID>& queue = mSharedQueues[priority];
+            if (!queue.empty())
+            {
+                taskID = queue.front();
+                queue.pop_front();
+                mNumSharedTasks--;
+                return taskID;
+            }
+        }
+
+        // try to steal from other workers, starting from the next one
+        for (uint32_t i = 1; i < numThreads; ++i)
+        {
+            const uint32_t victimIndex = (thread->mId + i) % numThreads;
+            taskID = mThreads[victimIndex]->mQueues[priority].Steal();
+            if (taskID != InvalidTaskID)
+            {
+                return taskID;
+            }
+        }
     }
+
+    return InvalidTaskID;
 }
 
 void ThreadPool::SchedulerCallback(WorkerThread* thread)
@@ -127,51 +305,41 @@ void ThreadPool::SchedulerCallback(WorkerThread* thread)
     context.pool = this;
     context.threadId = thread->mId;
 
+    tl_currentPool = this;
+    tl_currentWorker = thread;
+
     char threadName[16];
     sprintf(threadName, "Worker %u", thread->mId);
     MTR_META_THREAD_NAME(threadName);
 
-    for (;;)
+    while (thread->mStarted)
     {
-        Task* task = nullptr;
+        context.taskId = FindTask(thread);
+
+        if (context.taskId == InvalidTaskID)
         {
-            std::unique_lock<std::mutex> lock(mTasksQueueMutex);
+            std::unique_lock<std::mutex> lock(mSleepMutex);
 
-            std::deque<TaskID>* queue = nullptr;
+            // announce going to sleep before checking queues for the last time,
+            // so a concurrent enqueue either gets noticed here or wakes this thread up
+            mNumSleepingThreads++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
 
-            // wait for new task
-            while (thread->mStarted)
+            while (thread->mStarted && (context.taskId = FindTask(thread)) == InvalidTaskID)
             {
-                // find queue with pending tasks
-                queue = nullptr;
-                for (uint32_t i = 0; i < NumPriorities; ++i)
-                {
-                    if (!mTasksQueues[i].empty())
-                    {
-                        queue = &mTasksQueues[i];
-                        break;
-                    }
-                }
-
-                if (queue != nullptr)
-                {
-                    break;
-                }
-
-                mTaskQueueCV.wait(lock);
+                mSleepCV.wait(lock);
             }
 
-            if (!thread->mStarted)
+            mNumSleepingThreads--;
+
+            if (context.taskId == InvalidTaskID)
             {
                 break;
             }
-
-            // pop a task from the queue
-            context.taskId = queue->front();
-            task = &mTasks[context.taskId];
-            queue->pop_front();
         }
 
+        Task* task = &mTasks[context.taskId];
+
         if (task->mCallback)
         {
             // Queued -> Executing
@@ -215,38 +383,38 @@ void ThreadPool::FinishTask(TaskID taskID)
     // Note: loop instead of recursion to avoid stack overflow in case of long dependency chains
     while (taskToFinish != InvalidTaskID)
     {
-        TaskID parentTask;
-        Waitable* waitable = nullptr;
+        Task& task = mTasks[taskToFinish];
 
+        const int32_t tasksLeft = --task.mTasksLeft;
+        assert(tasksLeft >= 0); // Tasks counter underflow
+        if (tasksLeft > 0)
         {
-            // TODO lockless
-            std::unique_lock<std::mutex> lock(mTaskListMutex);
-
-            Task& task = mTasks[taskToFinish];
-
-            parentTask = task.mParent;
-            waitable = task.mWaitable;
+            return;
+        }
 
-            const int32_t tasksLeft = --task.mTasksLeft;
-            assert(tasksLeft >= 0); // Tasks counter underflow
-            if (tasksLeft > 0)
-            {
-                return;
-            }
+        const TaskID parentTask = task.mParent;
+        const TaskID continuation = task.mContinuation;
+        Waitable* waitable = task.mWaitable;
 
-            // notify about fullfilling the dependency
+        // close dependent tasks list and notify about fullfilling the dependency
+        {
+            TaskID dependentID = task.mHead.exchange(Task::ClosedListID, std::memory_order_acq_rel);
+            while (dependentID != InvalidTaskID)
             {
-                TaskID siblingID = task.mHead;
-                while (siblingID != InvalidTaskID)
-                {
-                    OnTaskDependencyFullfilled_NoLock(siblingID);
-                    siblingID = mTasks[siblingID].mSibling;
-                }
+                // read sibling first, the dependent task may get executed and freed right after being enqueued
+                const TaskID siblingID = mTasks[dependentID].mSibling;
+                OnTaskUnblocked(dependentID);
+                dependentID = siblingID;
             }
+        }
 
-            FreeTask_NoLock(taskToFinish);
+        if (continuation != InvalidTaskID)
+        {
+            OnTaskUnblocked(continuation);
         }
 
+        FreeTask(taskToFinish);
+
         // notify waitable object
         if (waitable)
         {
@@ -258,24 +426,43 @@ void ThreadPool::FinishTask(TaskID taskID)
     }
 }
 
-void ThreadPool::EnqueueTaskInternal_NoLock(TaskID taskID)
+void ThreadPool::EnqueueTaskInternal(TaskID taskID)
 {
     Task& task = mTasks[taskID];
 
     const Task::State oldState = task.mState.exchange(Task::State::Queued);
     assert(Task::State::Created == oldState); // Task is expected to be in 'Created' state
-    assert((Task::Flag_IsDispatched | Task::Flag_DependencyFullfilled) == task.mDependencyState);
+    assert(0 == task.mBlockersLeft);
     (void)oldState;
 
-    // push to queue
+    if (tl_currentPool == this)
+    {
+        // worker thread pushes to its own queue, idle workers will steal from it
+        tl_currentWorker->mQueues[task.mPriority].Push(taskID);
+    }
+    else
     {
-        std::unique_lock<std::mutex> lock(mTasksQueueMutex);
-        mTasksQueues[task.mPriority].push_back(taskID);
-        mTaskQueueCV.notify_all();
+        std::unique_lock<std::mutex> lock(mSharedQueueMutex);
+        mSharedQueues[task.mPriority].push_back(taskID);
+        mNumSharedTasks++;
     }
+
+    WakeUpWorker();
 }
 
-void ThreadPool::FreeTask_NoLock(TaskID taskID)
+void ThreadPool::WakeUpWorker()
+{
+    // pairs with the fence in SchedulerCallback, see comment there
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (mNumSleepingThreads.load(std::memory_order_relaxed) > 0)
+    {
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleepCV.notify_one();
+    }
+}
+
+void ThreadPool::FreeTask(TaskID taskID)
 {
     assert(taskID < mTasks.size());
 
@@ -285,26 +472,43 @@ void ThreadPool::FreeTask_NoLock(TaskID taskID)
     assert(Task::State::Finished == oldState); // Task is expected to be in 'Finished' state
     (void)oldState;
 
-    task.mNextFree = mFirstFreeTask;
-    mFirstFreeTask = taskID;
+    uint64_t head = mFreeListHead.load(std::memory_order_relaxed);
+    uint64_t newHead;
+    do
+    {
+        task.mNextFree.store(static_cast<TaskID>(head), std::memory_order_relaxed);
+        newHead = (((head >> 32) + 1) << 32) | taskID;
+    }
+    while (!mFreeListHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
 }
 
-TaskID ThreadPool::AllocateTask_NoLock()
+TaskID ThreadPool::AllocateTask()
 {
-    if (mFirstFreeTask == InvalidTaskID)
+    uint64_t head = mFreeListHead.load(std::memory_order_acquire);
+    TaskID taskID;
+    for (;;)
     {
-        return InvalidTaskID;
+        taskID = static_cast<TaskID>(head);
+        if (taskID == InvalidTaskID)
+        {
+            return InvalidTaskID;
+        }
+
+        // bumping the tag prevents ABA problem when the task gets popped and pushed back in the meantime
+        const TaskID nextFree = mTasks[taskID].mNextFree.load(std::memory_order_relaxed);
+        const uint64_t newHead = (((head >> 32) + 1) << 32) | nextFree;
+        if (mFreeListHead.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+        {
+            break;
+        }
     }
 
-    Task& task = mTasks[mFirstFreeTask];
+    Task& task = mTasks[taskID];
 
     const Task::State oldState = task.mState.exchange(Task::State::Queued);
     assert(Task::State::Invalid == oldState); // Task is expected to be in 'Invalid' state
     (void)oldState;
 
-    TaskID newNextFree = task.mNextFree;
-    TaskID taskID = mFirstFreeTask;
-    mFirstFreeTask = newNextFree;
     return taskID;
 }
 
@@ -312,10 +516,7 @@ TaskID ThreadPool::CreateTask(const TaskDesc& desc)
 {
     assert(desc.priority < NumPriorities);
 
-    // TODO lockless
-    std::unique_lock<std::mutex> lock(mTaskListMutex);
-
-    TaskID taskID = AllocateTask_NoLock();
+    TaskID taskID = AllocateTask();
     assert(taskID != InvalidTaskID);
 
     if (taskID == InvalidTaskID)
@@ -325,7 +526,6 @@ TaskID ThreadPool::CreateTask(const TaskDesc& desc)
 
     Task& task = mTasks[taskID];
     task.Reset();
-    task.mDependencyState = 0;
     task.mPriority = desc.priority;
     task.mTasksLeft = 1;
     task.mCallback = desc.function;
@@ -336,69 +536,67 @@ TaskID ThreadPool::CreateTask(const TaskDesc& desc)
     task.mState = Task::State::Created;
     task.mDebugName = desc.debugName;
 
+    // blocked by dispatch and dependency (the latter is removed below if already finished)
+    task.mBlockersLeft = 2;
+
     if (desc.parent != InvalidTaskID)
     {
         mTasks[desc.parent].mTasksLeft++;
     }
 
-    TaskID dependencyID = mTasks[taskID].mDependency;
-
     bool dependencyFullfilled = true;
-    if (dependencyID != InvalidTaskID)
+    if (desc.dependency != InvalidTaskID)
     {
-        Task& dependency = mTasks[dependencyID];
+        Task& dependency = mTasks[desc.dependency];
 
         assert(Task::State::Invalid != dependency.mState); // Invalid state of dependency task
 
-        //NFE_SCOPED_LOCK(mFinishedTasksMutex); // TODO: how to get rid of it?
-        if (dependency.mTasksLeft > 0)
+        // append to dependency list, unless the dependency has already finished and closed it
+        TaskID head = dependency.mHead.load(std::memory_order_acquire);
+        while (head != Task::ClosedListID)
         {
-            // update dependency list
-            if (dependency.mTail != InvalidTaskID)
+            task.mSibling = head;
+            if (dependency.mHead.compare_exchange_weak(head, taskID, std::memory_order_acq_rel, std::memory_order_acquire))
             {
-                mTasks[dependency.mTail].mSibling = taskID;
-            }
-            else
-            {
-                dependency.mHead = taskID;
+                dependencyFullfilled = false;
+                break;
             }
-
-            dependency.mTail = taskID;
-            dependencyFullfilled = false;
         }
     }
 
     if (dependencyFullfilled)
     {
-        task.mDependencyState = Task::Flag_DependencyFullfilled;
+        task.mBlockersLeft--;
     }
 
     return taskID;
 }
 
-void ThreadPool::DispatchTask(TaskID taskID)
+void ThreadPool::SetContinuation(TaskID taskID, TaskID continuationID)
 {
     assert(taskID != InvalidTaskID);
-
-    // TODO lockless
-    std::unique_lock<std::mutex> lock(mTaskListMutex);
+    assert(continuationID != InvalidTaskID);
 
     Task& task = mTasks[taskID];
+    Task& continuation = mTasks[continuationID];
 
     assert(Task::State::Created == task.mState); // Task is expected to be in 'Created' state
+    assert(Task::State::Created == continuation.mState); // Continuation is expected to be in 'Created' state
+    assert(task.mContinuation == InvalidTaskID); // Task already has a continuation
 
-    const uint8_t oldDependencyState = task.mDependencyState.fetch_or(Task::Flag_IsDispatched);
+    continuation.mBlockersLeft++;
+    task.mContinuation = continuationID;
+}
 
-    assert((oldDependencyState & Task::Flag_IsDispatched) == 0); // Task already dispatched
+void ThreadPool::DispatchTask(TaskID taskID)
+{
+    assert(taskID != InvalidTaskID);
+    assert(Task::State::Created == mTasks[taskID].mState); // Task is expected to be in 'Created' state
 
-    // can enqueue only if not dispatched yet, but dependency was fullfilled
-    if (Task::Flag_DependencyFullfilled == oldDependencyState)
-    {
-        EnqueueTaskInternal_NoLock(taskID);
-    }
+    OnTaskUnblocked(taskID);
 }
 
-void ThreadPool::OnTaskDependencyFullfilled_NoLock(TaskID taskID)
+void ThreadPool::OnTaskUnblocked(TaskID taskID)
 {
     assert(taskID != InvalidTaskID);
 
@@ -406,14 +604,12 @@ void ThreadPool::OnTaskDependencyFullfilled_NoLock(TaskID taskID)
 
     assert(Task::State::Created == task.mState); // Task is expected to be in 'Created' state
 
-    const uint8_t oldDependencyState = task.mDependencyState.fetch_or(Task::Flag_DependencyFullfilled);
+    const int32_t blockersLeft = --task.mBlockersLeft;
+    assert(blockersLeft >= 0); // Task dispatched or unblocked too many times
 
-    assert((oldDependencyState & Task::Flag_DependencyFullfilled) == 0); // Task should not have dependency fullfilled
-
-    // can enqueue only if was dispatched
-    if (Task::Flag_IsDispatched == oldDependencyState)
+    if (blockersLeft == 0)
     {
-        EnqueueTaskInternal_NoLock(taskID);
+        EnqueueTaskInternal(taskID);
     }
 }
 
@@ -463,6 +659,13 @@ void TaskBuilder::Fence(Waitable* waitable)
 {
     ThreadPool& tp = ThreadPool::GetInstance();
 
+    TaskDesc fenceDesc;
+    fenceDesc.debugName = "TaskBuilder::Fence";
+    fenceDesc.waitable = waitable;
+    fenceDesc.dependency = mDependencyTask; // in case there are no pending tasks since previous fence
+
+    const TaskID fence = tp.CreateTask(fenceDesc);
+
     // flush previous dependency
     if (mDependencyTask != InvalidTaskID)
     {
@@ -470,26 +673,15 @@ void TaskBuilder::Fence(Waitable* waitable)
         mDependencyTask = InvalidTaskID;
     }
 
-    TaskDesc depDesc;
-    depDesc.debugName = "TaskBuilder::Fence";
-    depDesc.waitable = waitable;
-
-    TaskID dependency = tp.CreateTask(depDesc);
-
-    // flush pending tasks and link them to dependency task
+    // flush pending tasks, the fence task starts when all of them finish
     for (uint32_t i = 0; i < mNumPendingTasks; ++i)
     {
-        TaskDesc desc;
-        desc.debugName = "TaskBuilder::Fence/Sub";
-        desc.parent = dependency;
-        desc.dependency = mPendingTasks[i];
-        tp.CreateAndDispatchTask(desc);
-
+        tp.SetContinuation(mPendingTasks[i], fence);
         tp.DispatchTask(mPendingTasks[i]);
     }
     mNumPendingTasks = 0;
 
-    mDependencyTask = dependency;
+    mDependencyTask = fence;
 }
 
 void TaskBuilder::Task(const char* debugName, const TaskFunction& func)
@@ -521,98 +713,99 @@ void TaskBuilder::CustomTask(TaskID customTask)
 
 void TaskBuilder::ParallelFor(const char* debugName, uint32_t arraySize, const ParallelForTaskFunction& func, uint32_t maxThread)
 {
+    PushParallelForTask(debugName, arraySize, [func](const TaskContext& context, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            func(context, i);
+        }
+    }, 0, maxThread);
+}
+
+void TaskBuilder::ParallelForRange(const char* debugName, uint32_t arraySize, const ParallelForRangeTaskFunction& func, uint32_t grainSize, uint32_t maxThread)
+{
+    PushParallelForTask(debugName, arraySize, func, grainSize, maxThread);
+}
+
+TaskID TaskBuilder::PushParallelForTask(const char* debugName, uint32_t arraySize, const ParallelForRangeTaskFunction& func, uint32_t grainSize, uint32_t maxThread)
+{
+    // number of chunks per thread when choosing grain size automatically, so threads can balance uneven work
+    static constexpr uint32_t ChunksPerThread = 8;
+
     ThreadPool& tp = ThreadPool::GetInstance();
 
     if (arraySize == 0)
     {
-        return;
+        return InvalidTaskID;
     }
 
-    TaskDesc desc;
-    desc.debugName = debugName;
-    desc.parent = mParentTask;
-    desc.dependency = mDependencyTask;
-
-    TaskID parallelForTask = tp.CreateTask(desc);
-    mPendingTasks[mNumPendingTasks++] = parallelForTask;
+    const uint32_t numThreads = tp.GetNumThreads();
+    const uint32_t maxTasks = maxThread > 0 ? std::min(numThreads, maxThread) : numThreads;
 
-    const uint32_t numThreads = std::thread::hardware_concurrency();
-    uint32_t numTasksToSpawn = std::min(arraySize, numThreads);
-
-    if (maxThread > 1)
+    if (grainSize == 0)
     {
-        numTasksToSpawn = std::min(numThreads, maxThread);
+        grainSize = std::max(1u, arraySize / (maxTasks * ChunksPerThread));
     }
 
-    struct alignas(64) ThreadData
-    {
-        uint32_t elementOffset = 0; // base element
-        uint32_t numElements = 0;
-        std::atomic<uint32_t> counter = 0;
-        uint32_t threadDataIndex = 0;
+    const uint32_t numChunks = (arraySize + grainSize - 1) / grainSize;
+    const uint32_t numTasks = std::min(numChunks, maxTasks);
 
-        ThreadData() = default;
-        ThreadData(const ThreadData & other)
-            : elementOffset(other.elementOffset)
-            , numElements(other.numElements)
-            , counter(other.counter.load())
-            , threadDataIndex(other.threadDataIndex)
-        {}
+    struct alignas(CACHELINE_SIZE) SharedState
+    {
+        std::atomic<uint32_t> nextElement = 0;
     };
 
     // TODO get rid of dynamic allocation, e.g. by using some kind of pool
-    using ThreadDataPtr = std::shared_ptr<std::vector<ThreadData>>;
-    ThreadDataPtr threadDataPtr = std::make_shared<std::vector<ThreadData>>();
-    threadDataPtr->resize(numThreads);
+    std::shared_ptr<SharedState> state = std::make_shared<SharedState>();
 
-    // subdivide work
+    // each task grabs chunks of elements until there are none left
+    const TaskFunction processChunks = [state, func, arraySize, grainSize](const TaskContext& context)
     {
-        uint32_t totalElements = 0;
-        for (uint32_t i = 0; i < numTasksToSpawn; ++i)
+        for (;;)
         {
-            ThreadData& threadData = (*threadDataPtr)[i];
-            threadData.numElements = (arraySize / numTasksToSpawn) + ((arraySize % numTasksToSpawn > i) ? 1 : 0);
-            threadData.elementOffset = totalElements;
-            ASSERT(threadData.numElements + threadData.elementOffset <= arraySize);
-            totalElements += threadData.numElements;
+            const uint32_t begin = state->nextElement.fetch_add(grainSize, std::memory_order_relaxed);
+            if (begin >= arraySize)
+            {
+                break;
+            }
+            func(context, begin, begin + std::min(grainSize, arraySize - begin));
         }
-        ASSERT(totalElements == arraySize);
-    }
+    };
 
-    for (uint32_t i = 0; i < numTasksToSpawn; ++i)
+    // the parallel-for task spawns helper tasks when it starts and then processes chunks itself,
+    // so helper tasks are created only once the dependency is fulfilled and land in worker's local queue
+    TaskDesc desc;
+    desc.debugName = debugName;
+    desc.parent = mParentTask;
+    desc.dependency = mDependencyTask;
+    desc.function = [processChunks, numTasks, debugName](const TaskContext& context)
     {
-        TaskDesc subTaskDesc;
-        subTaskDesc.debugName = debugName;
-        subTaskDesc.parent = parallelForTask;
-        subTaskDesc.dependency = mDependencyTask;
-        subTaskDesc.function = [func, threadDataPtr, numTasksToSpawn, arraySize](const TaskContext& context)
+        for (uint32_t i = 1; i < numTasks; ++i)
         {
-            // consume elements assigned to each thread (starting from self)
-            for (uint32_t threadDataOffset = 0; threadDataOffset < numTasksToSpawn; ++threadDataOffset)
-            {
-                uint32_t threadDataIndex = context.threadId + threadDataOffset;
-                if (threadDataIndex >= numTasksToSpawn)
-                {
-                    threadDataIndex -= numTasksToSpawn;
-                }
-
-                ThreadData& threadData = (*threadDataPtr)[threadDataIndex];
-
-                if (threadData.counter.load() < threadData.numElements)
-                {
-                    uint32_t index;
-                    while ((index = threadData.counter++) < threadData.numElements)
-                    {
-                        (void)arraySize;
-                        ASSERT(threadData.elementOffset + index < arraySize);
-                        func(context, static_cast<uint32_t>(threadData.elementOffset + index));
-                    }
-                }
-            }
-        };
+            TaskDesc subTaskDesc(processChunks);
+            subTaskDesc.debugName = debugName;
+            subTaskDesc.parent = context.taskId;
+            context.pool->CreateAndDispatchTask(subTaskDesc);
+        }
 
-        tp.CreateAndDispatchTask(subTaskDesc);
-    }
+        processChunks(context);
+    };
+
+    const TaskID parallelForTask = tp.CreateTask(desc);
+    mPendingTasks[mNumPendingTasks++] = parallelForTask;
+    return parallelForTask;
+}
+
+void TaskBuilder::PushContinuation(const char* debugName, TaskID task, const TaskFunction& func)
+{
+    ThreadPool& tp = ThreadPool::GetInstance();
+
+    TaskDesc desc(func);
+    desc.debugName = debugName;
+    desc.parent = mParentTask;
+    desc.dependency = task != InvalidTaskID ? task : mDependencyTask;
+
+    mPendingTasks[mNumPendingTasks++] = tp.CreateTask(desc);
 }
 
 } // namespace threadpool
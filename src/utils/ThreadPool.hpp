@@ -4,6 +4,7 @@
 
 #include <thread>
 #include <condition_variable>
+#include <mutex>
 #include <functional>
 #include <atomic>
 #include <memory>
@@ -16,6 +17,8 @@ namespace threadpool {
 
 class ThreadPool;
 
+template<typename T> class Async;
+
 /**
  * Thread pool task unique identifier.
  */
@@ -23,6 +26,8 @@ using TaskID = uint32_t;
 
 static constexpr TaskID InvalidTaskID = UINT32_MAX;
 
+static constexpr uint32_t NumTaskPriorities = 3;
+
 /**
  * Task execution context.
  */
@@ -39,6 +44,12 @@ using TaskFunction = std::function<void(const TaskContext& context)>;
 // Parallel-for callback
 using ParallelForTaskFunction = std::function<void(const TaskContext& context, uint32_t arrayIndex)>;
 
+// Parallel-for callback processing range of elements [begin, end)
+using ParallelForRangeTaskFunction = std::function<void(const TaskContext& context, uint32_t begin, uint32_t end)>;
+
+// Coroutine factory (see Async.hpp)
+using AsyncTaskFunction = std::function<Async<void>()>;
+
 
 // Structure describing task, used during Task creation.
 struct TaskDesc
@@ -88,23 +99,23 @@ public:
         Finished,
     };
 
-    static const uint8_t Flag_IsDispatched = 1;
-    static const uint8_t Flag_DependencyFullfilled = 2;
+    // marks dependent tasks list of a finished task, no more tasks can be appended
+    static constexpr TaskID ClosedListID = InvalidTaskID - 1;
 
     TaskFunction mCallback;  //< task routine
 
     std::atomic<State> mState;
-    std::atomic<uint8_t> mDependencyState;
+
+    // Number of events left before the task can be queued:
+    // dispatch, unfinished dependency and unfinished tasks this task is a continuation of
+    std::atomic<int32_t> mBlockersLeft;
 
     // Number of sub-tasks left to complete.
     // If reaches 0, then whole task is considered as finished.
     std::atomic<int32_t> mTasksLeft;
 
-    union
-    {
-        TaskID mParent;
-        TaskID mNextFree;   //< free tasks list
-    };
+    TaskID mParent;
+    std::atomic<TaskID> mNextFree;  //< free tasks list
 
     // optional waitable object (it gets notified in the task is finished)
     Waitable* mWaitable;
@@ -112,10 +123,10 @@ public:
     const char* mDebugName;
 
     // Dependency pointers:
-    TaskID mDependency;  //< dependency tasks ID
-    TaskID mHead;        //< the first task that is dependent on this task
-    TaskID mTail;        //< the last task that is dependent on this task
-    TaskID mSibling;     //< the next task that is dependent on the same "mDependency" task
+    TaskID mDependency;             //< dependency tasks ID
+    std::atomic<TaskID> mHead;      //< the most recently added task that is dependent on this task (or ClosedListID once finished)
+    TaskID mSibling;                //< the next task that is dependent on the same "mDependency" task
+    TaskID mContinuation;           //< task unblocked when this task finishes (see ThreadPool::SetContinuation)
 
     uint8_t mPriority;
 
@@ -126,17 +137,55 @@ public:
     void Reset();
 };
 
+/**
+ * @brief Chase-Lev work-stealing deque of task IDs.
+ * @remarks Only the owner thread can call Push and Pop (LIFO end), any thread can call Steal (FIFO end).
+ *          The buffer grows when full, retired buffers are kept until destruction, so concurrent thieves
+ *          never read from freed memory.
+ */
+class TaskDeque final
+{
+public:
+    TaskDeque();
+    ~TaskDeque();
+
+    void Push(TaskID taskID);
+    TaskID Pop();
+    TaskID Steal();
+
+private:
+    struct Buffer
+    {
+        int64_t mask;
+        std::unique_ptr<std::atomic<TaskID>[]> elements;
+
+        Buffer(int64_t size);
+        TaskID Get(int64_t index) const { return elements[index & mask].load(std::memory_order_relaxed); }
+        void Put(int64_t index, TaskID taskID) { elements[index & mask].store(taskID, std::memory_order_relaxed); }
+    };
+
+    Buffer* Grow(Buffer* buffer, int64_t bottom, int64_t top);
+
+    alignas(CACHELINE_SIZE) std::atomic<int64_t> mTop;
+    alignas(CACHELINE_SIZE) std::atomic<int64_t> mBottom;
+    std::atomic<Buffer*> mBuffer;
+    std::vector<std::unique_ptr<Buffer>> mBuffers; // current and retired buffers (owner thread only)
+};
+
 // Thread pool's worker thread
 class WorkerThread
 {
     friend class ThreadPool;
 
-    std::thread mThread;
+    // per-priority local queues
+    TaskDeque mQueues[NumTaskPriorities];
+
     uint32_t mId;                     // thread number
     std::atomic<bool> mStarted;     // if set to false, exit the thread
+    std::thread mThread;
 
 public:
-    WorkerThread(ThreadPool* pool, uint32_t id);
+    WorkerThread(uint32_t id);
     ~WorkerThread();
 };
 
@@ -154,10 +203,14 @@ class ThreadPool final
 public:
 
     static constexpr uint32_t TasksCapacity = 1024 * 512;
-    static constexpr uint32_t NumPriorities = 3;
+    static constexpr uint32_t NumPriorities = NumTaskPriorities;
     static constexpr uint32_t MaxPriority = NumPriorities - 1;
 
     ThreadPool();
+
+    // create standalone thread pool with given number of worker threads
+    explicit ThreadPool(uint32_t numThreads);
+
     ~ThreadPool();
 
     static ThreadPool& GetInstance();
@@ -176,20 +229,30 @@ public:
         DispatchTask(CreateTask(desc));
     }
 
+    // Make 'continuationID' wait for 'taskID' to finish, in addition to its own dependency.
+    // Each task can have only one continuation, but a continuation can wait for any number of tasks.
+    // NOTE: Both tasks must be created, but not yet dispatched.
+    void SetContinuation(TaskID taskID, TaskID continuationID);
+
     uint32_t GetNumThreads() const { return static_cast<uint32_t>(mThreads.size()); }
 
 private:
 
+    ThreadPool(uint32_t numThreads, bool isGlobalInstance);
     ThreadPool(const ThreadPool&) = delete;
     ThreadPool(ThreadPool&&) = delete;
 
     void SchedulerCallback(WorkerThread* thread);
 
-    TaskID AllocateTask_NoLock();
-    void FreeTask_NoLock(TaskID taskID);
+    // find a task in local queue, shared queue or steal it from other workers
+    TaskID FindTask(WorkerThread* thread);
+
+    TaskID AllocateTask();
+    void FreeTask(TaskID taskID);
     void FinishTask(TaskID taskID);
-    void EnqueueTaskInternal_NoLock(TaskID taskID);
-    void OnTaskDependencyFullfilled_NoLock(TaskID taskID);
+    void EnqueueTaskInternal(TaskID taskID);
+    void OnTaskUnblocked(TaskID taskID);
+    void WakeUpWorker();
 
     // create "num" additional worker threads
     void SpawnWorkerThreads(uint32_t num);
@@ -199,14 +262,22 @@ private:
     // Worker threads variables:
     std::vector<WorkerThreadPtr> mThreads;
 
-    // queues for tasks with "Queued" state
-    std::deque<TaskID> mTasksQueues[NumPriorities];
-    std::mutex mTasksQueueMutex;                 //< lock for "mTasksQueue" access
-    std::condition_variable mTaskQueueCV;         //< CV for notifying about a new task in the queue
+    // queues for tasks enqueued from outside of worker threads
+    std::deque<TaskID> mSharedQueues[NumPriorities];
+    std::mutex mSharedQueueMutex;
+    std::atomic<uint32_t> mNumSharedTasks;
+
+    // idle workers sleep here
+    std::mutex mSleepMutex;
+    std::condition_variable mSleepCV;
+    std::atomic<uint32_t> mNumSleepingThreads;
 
-    std::mutex mTaskListMutex;
     std::vector<Task> mTasks; // TODO growable fixed-size allocator
-    TaskID mFirstFreeTask;
+
+    // lock-free free list head: task ID in lower 32 bits, ABA tag in upper 32 bits
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> mFreeListHead;
+
+    const bool mIsGlobalInstance;
 };
 
 // helper class that allows easy task-graph building
@@ -231,12 +302,39 @@ public:
     // push parallel-for task
     void ParallelFor(const char* debugName, uint32_t arraySize, const ParallelForTaskFunction& func, uint32_t maxThread = 0);
 
+    // push parallel-for task processing ranges of elements
+    // elements are handed out in chunks of 'grainSize' elements (0 means automatic grain size)
+    void ParallelForRange(const char* debugName, uint32_t arraySize, const ParallelForRangeTaskFunction& func, uint32_t grainSize = 0, uint32_t maxThread = 0);
+
+    // push parallel reduction
+    // 'func(context, begin, end, partial)' accumulates range of elements into per-thread partial result (default constructed T),
+    // then all the partials are merged into 'result' with 'combine(result, partial)' once all the ranges are processed
+    // Note: 'result' must stay valid until the tasks are finished
+    template<typename T, typename Func, typename CombineFunc>
+    void ParallelReduce(const char* debugName, uint32_t arraySize, T& result, const Func& func, const CombineFunc& combine, uint32_t grainSize = 0);
+
+    // push a coroutine task (defined in Async.cpp)
+    // The coroutine is started on a worker thread and the task is considered finished once the coroutine finishes,
+    // so worker threads are free to run other tasks while the coroutine is suspended (e.g. waiting for I/O)
+    void AsyncTask(const char* debugName, const AsyncTaskFunction& func);
+
     // Push a sync point
     // All tasks pushed after the fence will start only when all the tasks pushed before the fence finish execution
     // Optionally signals waitable object
     void Fence(Waitable* waitable = nullptr);
 
 private:
+    TaskID PushParallelForTask(const char* debugName, uint32_t arraySize, const ParallelForRangeTaskFunction& func, uint32_t grainSize, uint32_t maxThread);
+
+    // push a task that starts after 'task' is finished
+    void PushContinuation(const char* debugName, TaskID task, const TaskFunction& func);
+
+    template<typename T>
+    struct alignas(CACHELINE_SIZE) ReducePartial
+    {
+        T value{};
+    };
+
     // forbid dynamic allocation (only stack allocation is allowed)
     void* operator new(size_t size) = delete;
     void operator delete(void* ptr) = delete;
@@ -254,4 +352,27 @@ private:
     uint32_t mNumPendingTasks = 0;
 };
 
+template<typename T, typename Func, typename CombineFunc>
+void TaskBuilder::ParallelReduce(const char* debugName, uint32_t arraySize, T& result, const Func& func, const CombineFunc& combine, uint32_t grainSize)
+{
+    // one partial per worker thread, each in separate cache line
+    using PartialsPtr = std::shared_ptr<std::vector<ReducePartial<T>>>;
+    PartialsPtr partials = std::make_shared<std::vector<ReducePartial<T>>>(ThreadPool::GetInstance().GetNumThreads());
+
+    const TaskID parallelForTask = PushParallelForTask(debugName, arraySize,
+        [partials, func](const TaskContext& context, uint32_t begin, uint32_t end)
+        {
+            func(context, begin, end, (*partials)[context.threadId].value);
+        },
+        grainSize, 0);
+
+    PushContinuation(debugName, parallelForTask, [partials, &result, combine](const TaskContext&)
+    {
+        for (const ReducePartial<T>& partial : *partials)
+        {
+            combine(result, partial.value);
+        }
+    });
+}
+
 } // namespace threadpool
@@ -0,0 +1,128 @@
+#include "Common.hpp"
+#include "ThreadPool.hpp"
+
+#include "../backend/Waitable.hpp"
+#include "../backend/Time.hpp"
+
+#include <iomanip>
+
+using namespace threadpool;
+
+namespace {
+
+// all the tasks are created by the main thread (goes through shared queue)
+static float RunFlatTasks(ThreadPool& pool, uint32_t numTasks)
+{
+    const TimePoint startTime = TimePoint::GetCurrent();
+
+    Waitable waitable;
+    {
+        TaskDesc rootDesc;
+        rootDesc.debugName = "Root";
+        rootDesc.waitable = &waitable;
+        const TaskID rootTask = pool.CreateTask(rootDesc);
+
+        for (uint32_t i = 0; i < numTasks; ++i)
+        {
+            TaskDesc desc([](const TaskContext&) {});
+            desc.parent = rootTask;
+            pool.CreateAndDispatchTask(desc);
+        }
+
+        pool.DispatchTask(rootTask);
+    }
+    waitable.Wait();
+
+    return (TimePoint::GetCurrent() - startTime).ToSeconds();
+}
+
+static void SpawnTree(const TaskContext& context, uint32_t depth)
+{
+    if (depth == 0)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        TaskDesc desc([depth](const TaskContext& ctx) { SpawnTree(ctx, depth - 1); });
+        desc.parent = context.taskId;
+        context.pool->CreateAndDispatchTask(desc);
+    }
+}
+
+// binary tree of tasks, spawned by the worker threads (goes through local queues and stealing)
+static float RunTaskTree(ThreadPool& pool, uint32_t depth)
+{
+    const TimePoint startTime = TimePoint::GetCurrent();
+
+    Waitable waitable;
+    {
+        TaskDesc rootDesc([depth](const TaskContext& ctx) { SpawnTree(ctx, depth); });
+        rootDesc.debugName = "Root";
+        rootDesc.waitable = &waitable;
+        pool.CreateAndDispatchTask(rootDesc);
+    }
+    waitable.Wait();
+
+    return (TimePoint::GetCurrent() - startTime).ToSeconds();
+}
+
+// parallel-for over many cheap elements on the global thread pool
+static float RunParallelFor(uint32_t numElements, std::vector<uint32_t>& data)
+{
+    const TimePoint startTime = TimePoint::GetCurrent();
+
+    Waitable waitable;
+    {
+        TaskBuilder taskBuilder(waitable);
+        taskBuilder.ParallelFor("ParallelFor", numElements, [&data](const TaskContext&, uint32_t i)
+        {
+            data[i] = i * i;
+        });
+    }
+    waitable.Wait();
+
+    return (TimePoint::GetCurrent() - startTime).ToSeconds();
+}
+
+} // namespace
+
+void BenchmarkThreadPool(const std::vector<std::string>& args)
+{
+    const uint32_t numTasks = args.size() > 0 ? std::stoi(args[0]) : 100000;
+    const uint32_t maxThreads = args.size() > 1 ? std::stoi(args[1]) : 128;
+
+    // tree with roughly the same number of tasks
+    uint32_t treeDepth = 1;
+    while ((2u << (treeDepth + 1)) <= numTasks) treeDepth++;
+    const uint32_t numTreeTasks = (2u << treeDepth) - 1;
+
+    {
+        const uint32_t numElements = 10000000;
+        std::vector<uint32_t> data(numElements);
+        RunParallelFor(numElements, data);
+        const float time = RunParallelFor(numElements, data);
+        std::cout << "ParallelFor (global pool, " << ThreadPool::GetInstance().GetNumThreads() << " threads): "
+            << static_cast<uint64_t>(numElements / time) << " elements/s" << std::endl;
+    }
+
+    std::cout << "Threads      Flat tasks/s      Tree tasks/s" << std::endl;
+
+    for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        ThreadPool pool(numThreads);
+
+        // warm-up
+        RunFlatTasks(pool, 1000);
+
+        const float flatTime = RunFlatTasks(pool, numTasks);
+        const float treeTime = RunTaskTree(pool, treeDepth);
+
+        std::cout
+            << std::setw(7) << numThreads
+            << std::setw(18) << static_cast<uint64_t>(numTasks / flatTime)
+            << std::setw(18) << static_cast<uint64_t>(numTreeTasks / treeTime)
+            << std::endl;
+    }
+}
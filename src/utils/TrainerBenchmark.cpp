@@ -0,0 +1,205 @@
+#include "Common.hpp"
+#include "net/SparseBinaryInputNode.hpp"
+#include "net/FullyConnectedNode.hpp"
+#include "net/ActivationNode.hpp"
+#include "net/WeightsStorage.hpp"
+#include "net/Gradient.hpp"
+
+#include "../backend/PackedNeuralNetwork.hpp"
+#include "../backend/Time.hpp"
+
+#include <random>
+#include <memory>
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+
+static const char* GetSimdLevelName()
+{
+#if defined(USE_AVX512)
+    return "AVX-512";
+#elif defined(USE_AVX)
+    return "AVX2/FMA";
+#else
+    return "scalar";
+#endif
+}
+
+template<typename Func>
+static void Measure(const char* name, uint32_t numSamples, const char* unit, const Func& func)
+{
+    // warm up caches first
+    func(std::min(numSamples, 1000u));
+
+    const TimePoint startTime = TimePoint::GetCurrent();
+    func(numSamples);
+    const float time = (TimePoint::GetCurrent() - startTime).ToSeconds();
+
+    std::cout
+        << std::left << std::setw(40) << name
+        << std::right << std::setw(12) << static_cast<uint64_t>(numSamples / time) << " " << unit << "/s" << std::endl;
+}
+
+static void FillRandom(nn::Values& values, std::mt19937& gen, float minValue, float maxValue)
+{
+    std::uniform_real_distribution<float> distr(minValue, maxValue);
+    for (float& x : values) x = distr(gen);
+}
+
+static void BenchmarkSparseBinaryInputNode(uint32_t numSamples, std::mt19937& gen)
+{
+    const uint32_t numInputs = nn::NumNetworkInputs;
+    const uint32_t numOutputs = 1024;
+    const uint32_t numFeatures = 30;
+
+    nn::WeightsStoragePtr weights = std::make_shared<nn::WeightsStorage>(numInputs, numOutputs, 1);
+    weights->m_isSparse = true;
+    weights->Init(numFeatures);
+
+    nn::SparseBinaryInputNode node(numInputs, numOutputs, weights);
+    std::unique_ptr<nn::INodeContext> ctx(node.CreateContext());
+
+    std::vector<uint16_t> features(numFeatures);
+    {
+        std::uniform_int_distribution<uint32_t> distr(0, numInputs - 1);
+        for (uint16_t& f : features) f = static_cast<uint16_t>(distr(gen));
+        std::sort(features.begin(), features.end());
+    }
+    static_cast<nn::SparseBinaryInputNode::Context&>(*ctx).sparseInputs = features;
+
+    nn::Values error(numOutputs);
+    FillRandom(error, gen, -1.0f, 1.0f);
+
+    nn::Gradients gradients;
+    gradients.Init(numInputs, numOutputs, 1, true);
+
+    Measure("SparseBinaryInput 1024 (30 feat) fwd", numSamples, "samples", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; ++i) node.Run(*ctx);
+    });
+
+    Measure("SparseBinaryInput 1024 (30 feat) bwd", numSamples, "samples", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; ++i) node.Backpropagate(error, *ctx, gradients);
+    });
+
+    nn::WeightsStorage::WeightsUpdateOptions options;
+    options.learningRate = 0.001f;
+    Measure("SparseBinaryInput 1024 Adam", numSamples, "rows", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            const uint32_t row = features[i % numFeatures];
+            weights->Update_Adam(gradients.m_variants[0].FindSparseRow(row), 0, row, options);
+        }
+    });
+}
+
+static void BenchmarkActivationNode(uint32_t numSamples, std::mt19937& gen)
+{
+    const uint32_t numOutputs = 2048;
+
+    nn::WeightsStoragePtr weights = std::make_shared<nn::WeightsStorage>(1, numOutputs, 1);
+    const nn::NodePtr previousNode = std::make_shared<nn::FullyConnectedNode>(nullptr, 1, numOutputs, weights);
+    const nn::NodePtr node = std::make_shared<nn::ActivationNode>(previousNode, nn::ActivationFunction::CReLU);
+    std::unique_ptr<nn::INodeContext> ctx(node->CreateContext());
+
+    nn::Values inputs(numOutputs);
+    FillRandom(inputs, gen, -0.5f, 1.5f);
+    ctx->inputs = inputs;
+
+    nn::Values error(numOutputs);
+    FillRandom(error, gen, -1.0f, 1.0f);
+
+    nn::Gradients gradients;
+
+    Measure("CReLU 2048 fwd", numSamples, "samples", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; ++i) node->Run(*ctx);
+    });
+
+    Measure("CReLU 2048 bwd", numSamples, "samples", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; ++i) node->Backpropagate(error, *ctx, gradients);
+    });
+}
+
+static void BenchmarkFullyConnectedNode(uint32_t numSamples, std::mt19937& gen, uint32_t numInputs, uint32_t numOutputs, uint32_t numVariants)
+{
+    nn::WeightsStoragePtr weights = std::make_shared<nn::WeightsStorage>(numInputs, numOutputs, numVariants);
+    weights->Init(numInputs);
+
+    const nn::NodePtr node = std::make_shared<nn::FullyConnectedNode>(nullptr, numInputs, numOutputs, weights);
+
+    // use a few contexts, so the batched backward pass can be measured as well
+    std::vector<std::unique_ptr<nn::INodeContext>> contexts;
+    std::vector<nn::INodeContext*> contextPtrs;
+    std::vector<nn::Values> inputs(nn::MaxBatchSize, nn::Values(numInputs));
+    std::vector<nn::Values> errors(nn::MaxBatchSize, nn::Values(numOutputs));
+    std::vector<const nn::Values*> errorPtrs;
+    for (uint32_t i = 0; i < nn::MaxBatchSize; ++i)
+    {
+        contexts.emplace_back(node->CreateContext());
+        FillRandom(inputs[i], gen, 0.0f, 1.0f);
+        contexts.back()->inputs = inputs[i];
+        contexts.back()->variant = i % numVariants;
+        contextPtrs.push_back(contexts.back().get());
+
+        FillRandom(errors[i], gen, -1.0f, 1.0f);
+        errorPtrs.push_back(&errors[i]);
+    }
+
+    nn::Gradients gradients;
+    gradients.Init(numInputs, numOutputs, numVariants, false);
+
+    const std::string prefix = "FullyConnected " + std::to_string(numInputs) + "x" + std::to_string(numOutputs) + " ";
+
+    Measure((prefix + "fwd").c_str(), numSamples, "samples", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; ++i) node->Run(*contextPtrs[i % nn::MaxBatchSize]);
+    });
+
+    Measure((prefix + "bwd").c_str(), numSamples, "samples", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            const uint32_t index = i % nn::MaxBatchSize;
+            node->Backpropagate(errors[index], *contextPtrs[index], gradients);
+        }
+    });
+
+    Measure((prefix + "bwd (batched)").c_str(), numSamples, "samples", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; i += nn::MaxBatchSize)
+        {
+            node->BackpropagateBatch(errorPtrs, contextPtrs, gradients);
+        }
+    });
+
+    nn::WeightsStorage::WeightsUpdateOptions options;
+    options.learningRate = 0.001f;
+    Measure((prefix + "Adam").c_str(), numSamples, "rows", [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            const uint32_t row = i % (numInputs + 1);
+            weights->Update_Adam(gradients.m_variants[0].m_values.data() + row * numOutputs, 0, row, options);
+        }
+    });
+}
+
+} // namespace
+
+void BenchmarkTrainerNodes(const std::vector<std::string>& args)
+{
+    const uint32_t numSamples = args.size() > 0 ? std::stoi(args[0]) : 200000;
+
+    std::cout << "SIMD level: " << GetSimdLevelName() << std::endl;
+
+    std::mt19937 gen;
+    BenchmarkSparseBinaryInputNode(numSamples, gen);
+    BenchmarkActivationNode(numSamples, gen);
+    BenchmarkFullyConnectedNode(numSamples, gen, 2048, 1, 8);
+    BenchmarkFullyConnectedNode(numSamples, gen, 512, 32, 1);
+}
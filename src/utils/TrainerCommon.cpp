@@ -5,12 +5,13 @@
 #include "../backend/Math.hpp"
 #include "../backend/Evaluate.hpp"
 #include "../backend/NeuralNetworkEvaluator.hpp"
+#include "../backend/Time.hpp"
 
 #include <filesystem>
 
 static_assert(sizeof(PositionEntry) == 32, "Invalid PositionEntry size");
 
-bool TrainingDataLoader::Init(std::mt19937& gen, const std::string& trainingDataPath)
+bool TrainingDataLoader::Init(std::mt19937& gen, const std::string& trainingDataPath, bool useMemoryMapping)
 {
     uint64_t totalDataSize = 0;
 
@@ -19,26 +20,56 @@ bool TrainingDataLoader::Init(std::mt19937& gen, const std::string& trainingData
     for (const auto& path : std::filesystem::directory_iterator(trainingDataPath))
     {
         const std::string& fileName = path.path().string();
-        auto fileStream = std::make_unique<FileInputStream>(fileName.c_str());
 
-        uint64_t fileSize = fileStream->GetSize();
+        std::unique_ptr<MmapInputStream> mappedStream;
+        std::unique_ptr<FileInputStream> fileStream;
+        bool isOpen = false;
+        uint64_t fileSize = 0;
+
+        if (useMemoryMapping)
+        {
+            mappedStream = std::make_unique<MmapInputStream>(fileName.c_str());
+            isOpen = mappedStream->IsOpen();
+            fileSize = mappedStream->GetSize();
+        }
+        else
+        {
+            fileStream = std::make_unique<FileInputStream>(fileName.c_str());
+            isOpen = fileStream->IsOpen();
+            fileSize = isOpen ? fileStream->GetSize() : 0;
+        }
+
         totalDataSize += fileSize;
 
-        if (fileStream->IsOpen() && fileSize > sizeof(PositionEntry))
+        if (isOpen && fileSize > sizeof(PositionEntry))
         {
             std::cout << "Using " << fileName << std::endl;
 
             InputFileContext& ctx = mContexts.emplace_back();
-            ctx.fileStream = std::move(fileStream);
             ctx.fileName = fileName;
             ctx.fileSize = fileSize;
+            ctx.numEntries = fileSize / sizeof(PositionEntry);
+
+            if (mappedStream)
+            {
+                // each file is read sequentially (starting from a random location)
+                mappedStream->Advise(MmapInputStream::AccessPattern::Sequential);
+                ctx.entries = reinterpret_cast<const PositionEntry*>(mappedStream->GetData());
+                ctx.mappedStream = std::move(mappedStream);
+            }
+            else
+            {
+                ctx.fileStream = std::move(fileStream);
+            }
 
             // Seek to random location so that each stream starts at different position.
             {
-                const uint64_t numEntries = fileSize / sizeof(PositionEntry);
-                std::uniform_int_distribution<uint64_t> distr(0, numEntries - 1);
-                const uint64_t entryIndex = distr(gen);
-                ctx.fileStream->SetPosition(entryIndex * sizeof(PositionEntry));
+                std::uniform_int_distribution<uint64_t> distr(0, ctx.numEntries - 1);
+                ctx.entryIndex = distr(gen);
+                if (ctx.fileStream)
+                {
+                    ctx.fileStream->SetPosition(ctx.entryIndex * sizeof(PositionEntry));
+                }
             }
 
             // Set a small, random skipping probability.
@@ -70,16 +101,80 @@ bool TrainingDataLoader::Init(std::mt19937& gen, const std::string& trainingData
     return !mContexts.empty();
 }
 
-uint32_t TrainingDataLoader::SampleInputFileIndex(double u) const
+void TrainingEntrySet::Reserve(size_t numEntries, size_t numFeaturesPerEntry, bool storePositions)
+{
+    mStorePositions = storePositions;
+    mEntries.reserve(numEntries);
+    mFeatures.reserve(2 * numEntries * numFeaturesPerEntry);
+    if (storePositions)
+    {
+        mPositions.reserve(numEntries);
+    }
+}
+
+void TrainingEntrySet::Clear()
+{
+    mEntries.clear();
+    mFeatures.clear();
+    mPositions.clear();
+}
+
+void TrainingEntrySet::AddEntry(const uint16_t* whiteFeatures, const uint16_t* blackFeatures, uint32_t numFeatures, uint32_t networkVariant, float output, const Position* pos)
+{
+    ASSERT(mFeatures.size() + 2 * numFeatures <= UINT32_MAX);
+    ASSERT(numFeatures <= UINT16_MAX);
+
+    Entry& entry = mEntries.emplace_back();
+    entry.featuresOffset = static_cast<uint32_t>(mFeatures.size());
+    entry.numFeatures = static_cast<uint16_t>(numFeatures);
+    entry.networkVariant = static_cast<uint16_t>(networkVariant);
+    entry.output = output;
+
+    mFeatures.insert(mFeatures.end(), whiteFeatures, whiteFeatures + numFeatures);
+    mFeatures.insert(mFeatures.end(), blackFeatures, blackFeatures + numFeatures);
+
+    if (mStorePositions)
+    {
+        ASSERT(pos);
+        mPositions.push_back(*pos);
+    }
+}
+
+void TrainingEntrySet::GetNetworkInput(size_t index, nn::InputDesc& outInputDesc) const
+{
+    const Entry& entry = mEntries[index];
+
+    outInputDesc.variant = entry.networkVariant;
+
+    outInputDesc.inputs[0].mode = nn::InputMode::SparseBinary;
+    outInputDesc.inputs[0].binaryFeatures = GetWhiteFeatures(index);
+    outInputDesc.inputs[0].numFeatures = entry.numFeatures;
+
+    outInputDesc.inputs[1].mode = nn::InputMode::SparseBinary;
+    outInputDesc.inputs[1].binaryFeatures = GetBlackFeatures(index);
+    outInputDesc.inputs[1].numFeatures = entry.numFeatures;
+}
+
+void TrainingEntrySet::Swap(TrainingEntrySet& other)
+{
+    mEntries.swap(other.mEntries);
+    mFeatures.swap(other.mFeatures);
+    mPositions.swap(other.mPositions);
+    std::swap(mStorePositions, other.mStorePositions);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static uint32_t SampleFromCDF(const std::vector<double>& cdf, double u)
 {
     uint32_t low = 0u;
-    uint32_t high = static_cast<uint32_t>(mContexts.size());
+    uint32_t high = static_cast<uint32_t>(cdf.size() - 1);
 
     // binary search
     while (low < high)
     {
         uint32_t mid = (low + high) / 2u;
-        if (u >= mCDF[mid])
+        if (u >= cdf[mid])
         {
             low = mid + 1u;
         }
@@ -92,7 +187,12 @@ uint32_t TrainingDataLoader::SampleInputFileIndex(double u) const
     return low - 1u;
 }
 
-bool TrainingDataLoader::FetchNextPosition(std::mt19937& gen, PositionEntry& outEntry, Position& outPosition, uint64_t kingBucketMask)
+uint32_t TrainingDataLoader::SampleInputFileIndex(double u) const
+{
+    return SampleFromCDF(mCDF, u);
+}
+
+bool TrainingDataLoader::FetchNextPosition(std::mt19937& gen, const PositionEntry*& outEntry, Position& outPosition, uint64_t kingBucketMask)
 {
     std::uniform_real_distribution<double> distr;
     const double u = distr(gen);
@@ -105,32 +205,107 @@ bool TrainingDataLoader::FetchNextPosition(std::mt19937& gen, PositionEntry& out
     return mContexts[fileIndex].FetchNextPosition(gen, outEntry, outPosition, kingBucketMask);
 }
 
-bool TrainingDataLoader::InputFileContext::FetchNextPosition(std::mt19937& gen, PositionEntry& outEntry, Position& outPosition, uint64_t kingBucketMask)
+// stochastic filtering of training positions (shared by all data loaders)
+static bool ShouldSkipEntry(std::mt19937& gen, ScoreType score, uint8_t wdlScore, uint32_t halfMoveCount, uint32_t moveCount, int32_t numPieces)
 {
-    for (;;)
+    // skip drawn game based half-move counter
+    if (wdlScore == (uint8_t)Game::Score::Draw)
     {
-        if (!fileStream->Read(&outEntry, sizeof(PositionEntry)))
+        const float hmcSkipProb = (float)halfMoveCount / 120.0f;
+        std::bernoulli_distribution skippingDistr(hmcSkipProb);
+        if (skippingDistr(gen))
+            return true;
+    }
+
+    // skip early moves
+    if (moveCount < 10 && numPieces > 24)
+        return true;
+
+    // skip based on piece count
+    {
+        if (numPieces <= 3)
+            return true;
+
+        if (numPieces <= 4 && std::bernoulli_distribution(0.75f)(gen))
+            return true;
+
+        const float pieceCountSkipProb = Sqr(static_cast<float>(numPieces - 28) / 40.0f);
+        if (pieceCountSkipProb > 0.0f && std::bernoulli_distribution(pieceCountSkipProb)(gen))
+            return true;
+    }
+
+    // skip based on WDL
+    // the idea is to skip positions where for instance eval is high, but game result is loss
+    {
+        const uint32_t ply = 2 * moveCount;
+        const float w = EvalToWinProbability(score / 100.0f, ply);
+        const float l = EvalToWinProbability(-score / 100.0f, ply);
+        const float d = 1.0f - w - l;
+
+        float prob = d;
+        if (wdlScore == (uint8_t)Game::Score::WhiteWins) prob = w;
+        if (wdlScore == (uint8_t)Game::Score::BlackWins) prob = l;
+
+        const float maxSkippingProb = 0.25f;
+        std::bernoulli_distribution skippingDistr(maxSkippingProb * (1.0f - prob));
+        if (skippingDistr(gen))
+            return true;
+    }
+
+    return false;
+}
+
+const PositionEntry* TrainingDataLoader::InputFileContext::ReadNextEntry()
+{
+    if (entries)
+    {
+        // memory mapped file: no copy needed
+        if (entryIndex >= numEntries)
         {
-            // if read failed, reset to the file beginning and try again
+            std::cout << "Resetting stream " << fileName << std::endl;
+            entryIndex = 0;
+        }
 
-            if (fileStream->GetPosition() > 0)
-            {
-                std::cout << "Resetting stream " << fileName << std::endl;
-                fileStream->SetPosition(0);
-            }
-            else
-            {
-                return false;
-            }
+        return entries + entryIndex++;
+    }
 
-            if (!fileStream->Read(&outEntry, sizeof(PositionEntry)))
-            {
-                return false;
-            }
+    if (!fileStream->Read(&streamEntry, sizeof(PositionEntry)))
+    {
+        // if read failed, reset to the file beginning and try again
+
+        if (fileStream->GetPosition() > 0)
+        {
+            std::cout << "Resetting stream " << fileName << std::endl;
+            fileStream->SetPosition(0);
+        }
+        else
+        {
+            return nullptr;
+        }
+
+        if (!fileStream->Read(&streamEntry, sizeof(PositionEntry)))
+        {
+            return nullptr;
+        }
+    }
+
+    return &streamEntry;
+}
+
+bool TrainingDataLoader::InputFileContext::FetchNextPosition(std::mt19937& gen, const PositionEntry*& outEntry, Position& outPosition, uint64_t kingBucketMask)
+{
+    for (;;)
+    {
+        outEntry = ReadNextEntry();
+        if (!outEntry)
+        {
+            return false;
         }
 
+        const PositionEntry& entry = *outEntry;
+
         // skip invalid scores
-        if (outEntry.score >= CheckmateValue || outEntry.score <= -CheckmateValue)
+        if (entry.score >= CheckmateValue || entry.score <= -CheckmateValue)
             continue;
 
         // constant skipping
@@ -140,7 +315,7 @@ bool TrainingDataLoader::InputFileContext::FetchNextPosition(std::mt19937& gen,
                 continue;
         }
 
-        VERIFY(UnpackPosition(outEntry.pos, outPosition, false));
+        VERIFY(UnpackPosition(entry.pos, outPosition, false));
         ASSERT(outPosition.IsValid());
 
         // filter by king bucket
@@ -156,53 +331,339 @@ bool TrainingDataLoader::InputFileContext::FetchNextPosition(std::mt19937& gen,
         }
         else
         {
-            // skip drawn game based half-move counter
-            if (outEntry.wdlScore == (uint8_t)Game::Score::Draw)
+            if (ShouldSkipEntry(gen, entry.score, entry.wdlScore, entry.pos.halfMoveCount, entry.pos.moveCount, entry.pos.occupied.Count()))
+                continue;
+        }
+
+        return true;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+bool FeaturesDataLoader::Init(std::mt19937& gen, const std::string& featuresDataPath)
+{
+    uint64_t totalDataSize = 0;
+
+    mCDF.push_back(0.0);
+
+    if (!std::filesystem::exists(featuresDataPath))
+    {
+        return false;
+    }
+
+    for (const auto& path : std::filesystem::directory_iterator(featuresDataPath))
+    {
+        const std::string& fileName = path.path().string();
+        auto stream = std::make_unique<MmapInputStream>(fileName.c_str());
+
+        if (stream->IsOpen() && stream->GetSize() > sizeof(FeaturesFileHeader) + sizeof(FeaturesEntryHeader))
+        {
+            const FeaturesFileHeader& header = *reinterpret_cast<const FeaturesFileHeader*>(stream->GetData());
+            if (header.magic != FeaturesFileHeader::MagicNumber ||
+                header.version != FeaturesFileHeader::CurrentVersion ||
+                header.numNetworkInputs != nn::NumNetworkInputs ||
+                header.featuresPerKingBucket != FeaturesFileHeader::FeaturesPerKingBucket ||
+                header.useVirtualFeatures != static_cast<uint32_t>(UseVirtualFeatures))
+            {
+                std::cout << "ERROR: Incompatible features data file (regenerate with prepareTrainingData --features): " << fileName << std::endl;
+                continue;
+            }
+
+            std::cout << "Using " << fileName << std::endl;
+
+            stream->Advise(MmapInputStream::AccessPattern::Sequential);
+
+            InputFileContext& ctx = mContexts.emplace_back();
+            ctx.fileName = fileName;
+            ctx.data = stream->GetData();
+            ctx.size = stream->GetSize();
+            ctx.stream = std::move(stream);
+
+            // Start at random page so that each stream starts at different position.
+            {
+                const uint64_t numPages = (ctx.size + FeaturesDataPageSize - 1) / FeaturesDataPageSize;
+                std::uniform_int_distribution<uint64_t> distr(0, numPages - 1);
+                ctx.offset = std::max<uint64_t>(sizeof(FeaturesFileHeader), distr(gen) * FeaturesDataPageSize);
+            }
+
+            // see TrainingDataLoader::Init
+            {
+                std::uniform_real_distribution<float> distr(0.0f, 0.1f);
+                ctx.skippingProbability = distr(gen);
+            }
+
+            totalDataSize += ctx.size;
+            mCDF.push_back((double)totalDataSize);
+        }
+        else
+        {
+            std::cout << "ERROR: Failed to load features data file: " << fileName << std::endl;
+        }
+    }
+
+    if (totalDataSize > 0)
+    {
+        // normalize
+        for (double& v : mCDF)
+        {
+            v /= static_cast<double>(totalDataSize);
+        }
+    }
+
+    return !mContexts.empty();
+}
+
+bool FeaturesDataLoader::FetchNextEntry(std::mt19937& gen, const FeaturesEntryHeader*& outEntry, uint64_t kingBucketMask)
+{
+    std::uniform_real_distribution<double> distr;
+    const double u = distr(gen);
+    const uint32_t fileIndex = SampleFromCDF(mCDF, u);
+    ASSERT(fileIndex < mContexts.size());
+
+    if (fileIndex >= mContexts.size())
+        return false;
+
+    return mContexts[fileIndex].FetchNextEntry(gen, outEntry, kingBucketMask);
+}
+
+const FeaturesEntryHeader* FeaturesDataLoader::InputFileContext::ReadNextEntry()
+{
+    for (uint32_t numResets = 0; numResets < 2; )
+    {
+        const uint64_t pageEnd = std::min<uint64_t>(size, (offset / FeaturesDataPageSize + 1) * FeaturesDataPageSize);
+
+        if (offset + sizeof(FeaturesEntryHeader) <= pageEnd)
+        {
+            const FeaturesEntryHeader* entry = reinterpret_cast<const FeaturesEntryHeader*>(data + offset);
+            if (entry->numFeatures > 0 && offset + entry->GetEntrySize() <= pageEnd)
             {
-                const float hmcSkipProb = (float)outEntry.pos.halfMoveCount / 120.0f;
-                std::bernoulli_distribution skippingDistr(hmcSkipProb);
-                if (skippingDistr(gen))
-                    continue;
+                offset += entry->GetEntrySize();
+                return entry;
             }
+        }
+
+        // page padding, skip to next page
+        offset = pageEnd;
+
+        if (offset >= size)
+        {
+            std::cout << "Resetting stream " << fileName << std::endl;
+            offset = sizeof(FeaturesFileHeader);
+            numResets++;
+        }
+    }
+
+    return nullptr;
+}
 
-            const int32_t numPieces = outEntry.pos.occupied.Count();
+bool FeaturesDataLoader::InputFileContext::FetchNextEntry(std::mt19937& gen, const FeaturesEntryHeader*& outEntry, uint64_t kingBucketMask)
+{
+    for (;;)
+    {
+        outEntry = ReadNextEntry();
+        if (!outEntry)
+        {
+            return false;
+        }
+
+        const FeaturesEntryHeader& entry = *outEntry;
+
+        // skip invalid scores
+        if (entry.score >= CheckmateValue || entry.score <= -CheckmateValue)
+            continue;
+
+        // constant skipping
+        {
+            std::bernoulli_distribution skippingDistr(skippingProbability);
+            if (skippingDistr(gen))
+                continue;
+        }
+
+        // filter by king bucket
+        if (kingBucketMask != UINT64_MAX)
+        {
+            // all features of a perspective belong to the same king bucket
+            const uint32_t whiteKingBucket = entry.GetWhiteFeatures()[0] / FeaturesFileHeader::FeaturesPerKingBucket;
+            const uint32_t blackKingBucket = entry.GetBlackFeatures()[0] / FeaturesFileHeader::FeaturesPerKingBucket;
 
-            // skip early moves
-            if (outEntry.pos.moveCount < 10 && numPieces > 24)
+            if ((((1ull << whiteKingBucket) & kingBucketMask) == 0ull) && (((1ull << blackKingBucket) & kingBucketMask) == 0ull))
+                continue;
+        }
+        else
+        {
+            if (ShouldSkipEntry(gen, entry.score, entry.wdlScore, entry.halfMoveCount, entry.moveCount, entry.numFeatures))
                 continue;
+        }
+
+        return true;
+    }
+}
+
+bool ConvertTrainingDataToFeatures(const std::string& inputPath, const std::string& outputPath)
+{
+    MmapInputStream inputFile(inputPath.c_str());
+    if (!inputFile.IsOpen())
+    {
+        std::cout << "ERROR: Failed to open training data file: " << inputPath << std::endl;
+        return false;
+    }
+
+    FileOutputStream outputFile(outputPath.c_str());
+    if (!outputFile.IsOpen())
+    {
+        std::cout << "ERROR: Failed to open output features data file: " << outputPath << std::endl;
+        return false;
+    }
+
+    inputFile.Advise(MmapInputStream::AccessPattern::Sequential);
+
+    const PositionEntry* entries = reinterpret_cast<const PositionEntry*>(inputFile.GetData());
+    const uint64_t numEntries = inputFile.GetSize() / sizeof(PositionEntry);
+
+    std::vector<uint8_t> page;
+    page.reserve(FeaturesDataPageSize);
 
-            // skip based on piece count
+    // file header occupies the beginning of the first page
+    {
+        const FeaturesFileHeader header = { FeaturesFileHeader::MagicNumber, FeaturesFileHeader::CurrentVersion, nn::NumNetworkInputs, FeaturesFileHeader::FeaturesPerKingBucket, UseVirtualFeatures };
+        const uint8_t* headerData = reinterpret_cast<const uint8_t*>(&header);
+        page.insert(page.end(), headerData, headerData + sizeof(header));
+    }
+
+    const auto flushPage = [&]()
+    {
+        page.resize(FeaturesDataPageSize, 0);
+        const bool result = outputFile.Write(page.data(), page.size());
+        page.clear();
+        return result;
+    };
+
+    Position pos;
+    for (uint64_t i = 0; i < numEntries; ++i)
+    {
+        const PositionEntry& entry = entries[i];
+
+        if (!UnpackPosition(entry.pos, pos, false))
+        {
+            std::cout << "ERROR: Invalid position in training data file " << inputPath << " entry=" << i << std::endl;
+            return false;
+        }
+        ASSERT(pos.GetSideToMove() == White);
+
+        uint16_t features[2 * MaxFeaturesPerEntry];
+        const uint32_t numWhiteFeatures = PositionToFeaturesVector<UseVirtualFeatures>(pos, features, White);
+        const uint32_t numBlackFeatures = PositionToFeaturesVector<UseVirtualFeatures>(pos, features + numWhiteFeatures, Black);
+        ASSERT(numWhiteFeatures == numBlackFeatures);
+        ASSERT(numWhiteFeatures <= MaxFeaturesPerEntry);
+
+        FeaturesEntryHeader header{};
+        header.score = entry.score;
+        header.wdlScore = entry.wdlScore;
+        header.tbScore = entry.tbScore;
+        header.moveCount = entry.pos.moveCount;
+        header.halfMoveCount = entry.pos.halfMoveCount;
+        header.numFeatures = static_cast<uint8_t>(numWhiteFeatures);
+        header.networkVariant = static_cast<uint8_t>(GetNetworkVariant(pos));
+
+        if (page.size() + header.GetEntrySize() > FeaturesDataPageSize)
+        {
+            if (!flushPage())
             {
-                if (numPieces <= 3)
-                    continue;
+                std::cout << "ERROR: Failed to write features data file: " << outputPath << std::endl;
+                return false;
+            }
+        }
+
+        const uint8_t* headerData = reinterpret_cast<const uint8_t*>(&header);
+        const uint8_t* featuresData = reinterpret_cast<const uint8_t*>(features);
+        page.insert(page.end(), headerData, headerData + sizeof(header));
+        page.insert(page.end(), featuresData, featuresData + (numWhiteFeatures + numBlackFeatures) * sizeof(uint16_t));
+    }
+
+    if (!page.empty() && !flushPage())
+    {
+        std::cout << "ERROR: Failed to write features data file: " << outputPath << std::endl;
+        return false;
+    }
+
+    return true;
+}
 
-                if (numPieces <= 4 && std::bernoulli_distribution(0.75f)(gen))
-                    continue;
+// Compares training data loading (including features extraction) throughput:
+// file stream vs. memory mapped positions vs. pre-featurized data.
+// Usage: benchTrainingDataLoader [trainingDataPath] [numPositions] [featuresDataPath]
+void BenchmarkTrainingDataLoader(const std::vector<std::string>& args)
+{
+    const std::string trainingDataPath = args.size() > 0 ? args[0] : DATA_PATH "trainingData";
+    const uint32_t numPositions = args.size() > 1 ? std::stoi(args[1]) : 10000000;
+    const std::string featuresDataPath = args.size() > 2 ? args[2] : DATA_PATH "trainingDataFeatures";
 
-                const float pieceCountSkipProb = Sqr(static_cast<float>(numPieces - 28) / 40.0f);
-                if (pieceCountSkipProb > 0.0f && std::bernoulli_distribution(pieceCountSkipProb)(gen))
-                    continue;
+    const auto printResult = [numPositions](const char* name, float time, uint64_t checksum)
+    {
+        std::cout
+            << name << numPositions << " positions, "
+            << time << " s, "
+            << (numPositions / time) << " pos/s "
+            << "(checksum " << checksum << ")" << std::endl;
+    };
+
+    for (const bool useMemoryMapping : { false, true })
+    {
+        std::mt19937 gen;
+        TrainingDataLoader loader;
+        if (!loader.Init(gen, trainingDataPath, useMemoryMapping))
+        {
+            std::cout << "ERROR: Failed to initialize data loader" << std::endl;
+            return;
+        }
+
+        const TimePoint startTime = TimePoint::GetCurrent();
+
+        Position pos;
+        const PositionEntry* entry = nullptr;
+        uint16_t features[MaxFeaturesPerEntry];
+        uint64_t checksum = 0; // prevent the loop from being optimized out
+        for (uint32_t i = 0; i < numPositions; ++i)
+        {
+            if (!loader.FetchNextPosition(gen, entry, pos, UINT64_MAX))
+            {
+                std::cout << "ERROR: Failed to fetch position" << std::endl;
+                return;
             }
+            const uint32_t numWhiteFeatures = PositionToFeaturesVector(pos, features, White);
+            checksum += features[numWhiteFeatures - 1];
+            const uint32_t numBlackFeatures = PositionToFeaturesVector(pos, features, Black);
+            checksum += features[numBlackFeatures - 1];
+        }
+
+        printResult(useMemoryMapping ? "Memory mapped:  " : "File stream:    ", (TimePoint::GetCurrent() - startTime).ToSeconds(), checksum);
+    }
 
-            // skip based on WDL
-            // the idea is to skip positions where for instance eval is high, but game result is loss
+    {
+        std::mt19937 gen;
+        FeaturesDataLoader loader;
+        if (!loader.Init(gen, featuresDataPath))
+        {
+            std::cout << "No pre-featurized data found in " << featuresDataPath << std::endl;
+            return;
+        }
+
+        const TimePoint startTime = TimePoint::GetCurrent();
+
+        const FeaturesEntryHeader* entry = nullptr;
+        uint64_t checksum = 0;
+        for (uint32_t i = 0; i < numPositions; ++i)
+        {
+            if (!loader.FetchNextEntry(gen, entry, UINT64_MAX))
             {
-                const uint32_t ply = 2 * outEntry.pos.moveCount;
-                const float w = EvalToWinProbability(outEntry.score / 100.0f, ply);
-                const float l = EvalToWinProbability(-outEntry.score / 100.0f, ply);
-                const float d = 1.0f - w - l;
-
-                float prob = d;
-                if (outEntry.wdlScore == (uint8_t)Game::Score::WhiteWins) prob = w;
-                if (outEntry.wdlScore == (uint8_t)Game::Score::BlackWins) prob = l;
-
-                const float maxSkippingProb = 0.25f;
-                std::bernoulli_distribution skippingDistr(maxSkippingProb * (1.0f - prob));
-                if (skippingDistr(gen))
-                    continue;
+                std::cout << "ERROR: Failed to fetch entry" << std::endl;
+                return;
             }
+            checksum += entry->GetWhiteFeatures()[entry->numFeatures - 1];
+            checksum += entry->GetBlackFeatures()[entry->numFeatures - 1];
         }
 
-        return true;
+        printResult("Pre-featurized: ", (TimePoint::GetCurrent() - startTime).ToSeconds(), checksum);
     }
 }
@@ -15,13 +15,96 @@ struct PositionEntry
     uint8_t tbScore = 0xFF;
 };
 
-struct TrainingEntry
+// Pre-featurized training data entry (see ConvertTrainingDataToFeatures).
+// The header is followed by white and black perspective feature indices (numFeatures each).
+// Data file consists of fixed-size pages and entries never cross page boundary,
+// so reading can start at any page. Unused page tail is filled with zeros.
+#pragma pack(push, 1)
+struct FeaturesEntryHeader
 {
-    Position pos;
-    std::vector<uint16_t> whiteFeatures;
-    std::vector<uint16_t> blackFeatures;
-    float output = 0.0f;
-    uint32_t networkVariant = 0;
+    ScoreType score;
+    uint8_t wdlScore;
+    uint8_t tbScore;
+    uint16_t moveCount;
+    uint8_t halfMoveCount;
+    uint8_t numFeatures;        // number of features per perspective (zero marks page padding)
+    uint8_t networkVariant;
+    uint8_t padding;
+
+    const uint16_t* GetWhiteFeatures() const { return reinterpret_cast<const uint16_t*>(this + 1); }
+    const uint16_t* GetBlackFeatures() const { return GetWhiteFeatures() + numFeatures; }
+    uint32_t GetEntrySize() const { return sizeof(FeaturesEntryHeader) + 2u * numFeatures * sizeof(uint16_t); }
+};
+#pragma pack(pop)
+
+// include virtual (king bucket independent) piece features in network inputs
+// Note: shared by the trainer and pre-featurized data converter, so both produce the same inputs
+// #define USE_VIRTUAL_FEATURES
+
+#ifdef USE_VIRTUAL_FEATURES
+static constexpr bool UseVirtualFeatures = true;
+static constexpr uint32_t MaxFeaturesPerEntry = 64;
+#else
+static constexpr bool UseVirtualFeatures = false;
+static constexpr uint32_t MaxFeaturesPerEntry = 32;
+#endif // USE_VIRTUAL_FEATURES
+
+static constexpr uint32_t FeaturesDataPageSize = 64 * 1024;
+
+// Pre-featurized training data file header, stored at the beginning of the first page.
+// Feature indices are only meaningful for the network input layout they were generated with.
+struct FeaturesFileHeader
+{
+    static constexpr uint32_t MagicNumber = 'CFTR';
+    static constexpr uint32_t CurrentVersion = 2;
+
+    // feature index layout: king bucket * FeaturesPerKingBucket + piece * 64 + square
+    static constexpr uint32_t FeaturesPerKingBucket = 12 * 64;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numNetworkInputs;
+    uint32_t featuresPerKingBucket;
+    uint32_t useVirtualFeatures;
+};
+
+static_assert(sizeof(FeaturesFileHeader) == 20, "Invalid features file header size");
+
+// Flat storage of training entries.
+// Features of all entries are kept in one contiguous pool, so refilling the set
+// doesn't allocate memory once the capacity is reached.
+class TrainingEntrySet
+{
+public:
+    struct Entry
+    {
+        uint32_t featuresOffset = 0;    // white features followed by black features
+        uint16_t numFeatures = 0;       // number of features per perspective
+        uint16_t networkVariant = 0;
+        float output = 0.0f;
+    };
+
+    // positions are needed only for validation
+    void Reserve(size_t numEntries, size_t numFeaturesPerEntry, bool storePositions);
+    void Clear();
+
+    void AddEntry(const uint16_t* whiteFeatures, const uint16_t* blackFeatures, uint32_t numFeatures, uint32_t networkVariant, float output, const Position* pos = nullptr);
+
+    size_t GetSize() const { return mEntries.size(); }
+    const Entry& GetEntry(size_t index) const { return mEntries[index]; }
+    const uint16_t* GetWhiteFeatures(size_t index) const { return mFeatures.data() + mEntries[index].featuresOffset; }
+    const uint16_t* GetBlackFeatures(size_t index) const { return GetWhiteFeatures(index) + mEntries[index].numFeatures; }
+    const Position& GetPosition(size_t index) const { ASSERT(mStorePositions); return mPositions[index]; }
+
+    void GetNetworkInput(size_t index, nn::InputDesc& outInputDesc) const;
+
+    void Swap(TrainingEntrySet& other);
+
+private:
+    std::vector<Entry> mEntries;
+    std::vector<uint16_t> mFeatures;
+    std::vector<Position> mPositions;
+    bool mStorePositions = false;
 };
 
 class TrainingDataLoader
@@ -29,27 +112,36 @@ class TrainingDataLoader
 public:
 
     // initialize the loader at given directory
+    // Note: memory mapping can be disabled to read files through regular file stream
     bool Init(
         std::mt19937& gen,
-        const std::string& trainingDataPath = "../../../data/trainingData");
+        const std::string& trainingDataPath = "../../../data/trainingData",
+        bool useMemoryMapping = true);
 
     // sample new position from the training set
-    bool FetchNextPosition(std::mt19937& gen, PositionEntry& outEntry, Position& outPosition, uint64_t kingBucketMask);
+    // Note: returned entry points to loader's internal storage (memory mapped file),
+    // it's valid until next call or as long as the loader is alive (memory mapping)
+    bool FetchNextPosition(std::mt19937& gen, const PositionEntry*& outEntry, Position& outPosition, uint64_t kingBucketMask);
 
 private:
 
     struct InputFileContext
     {
-        std::unique_ptr<FileInputStream> fileStream;
+        std::unique_ptr<MmapInputStream> mappedStream;
+        std::unique_ptr<FileInputStream> fileStream; // used when memory mapping is disabled
         std::string fileName;
         uint64_t fileSize = 0;
 
-        static constexpr uint32_t BufferSize = 64;
-        std::array<PositionEntry, BufferSize> buffer;
-        uint32_t bufferOffset = 0;
+        // memory mapped file contents
+        const PositionEntry* entries = nullptr;
+        uint64_t numEntries = 0;
+        uint64_t entryIndex = 0;
+
+        PositionEntry streamEntry;
         float skippingProbability = 0.0f;
 
-        bool FetchNextPosition(std::mt19937& gen, PositionEntry& outEntry, Position& outPosition, uint64_t kingBucketMask);
+        const PositionEntry* ReadNextEntry();
+        bool FetchNextPosition(std::mt19937& gen, const PositionEntry*& outEntry, Position& outPosition, uint64_t kingBucketMask);
     };
 
     std::vector<InputFileContext> mContexts;
@@ -60,3 +152,40 @@ private:
 
     uint32_t SampleInputFileIndex(double u) const;
 };
+
+// Loader for pre-featurized training data.
+// Applies the same filtering as TrainingDataLoader, but without unpacking positions.
+class FeaturesDataLoader
+{
+public:
+
+    // initialize the loader at given directory
+    bool Init(
+        std::mt19937& gen,
+        const std::string& featuresDataPath = "../../../data/trainingDataFeatures");
+
+    // sample new entry from the training set
+    // Note: returned entry points directly to memory mapped file
+    bool FetchNextEntry(std::mt19937& gen, const FeaturesEntryHeader*& outEntry, uint64_t kingBucketMask);
+
+private:
+
+    struct InputFileContext
+    {
+        std::unique_ptr<MmapInputStream> stream;
+        std::string fileName;
+        const uint8_t* data = nullptr;
+        uint64_t size = 0;
+        uint64_t offset = 0;
+        float skippingProbability = 0.0f;
+
+        const FeaturesEntryHeader* ReadNextEntry();
+        bool FetchNextEntry(std::mt19937& gen, const FeaturesEntryHeader*& outEntry, uint64_t kingBucketMask);
+    };
+
+    std::vector<InputFileContext> mContexts;
+    std::vector<double> mCDF;
+};
+
+// convert training data file (PositionEntry array) to pre-featurized format
+bool ConvertTrainingDataToFeatures(const std::string& inputPath, const std::string& outputPath);
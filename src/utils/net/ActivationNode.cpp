@@ -51,6 +51,28 @@ void ActivationNode::Run(INodeContext& ctx) const
 
     size_t i = 0;
 
+#ifdef USE_AVX512
+    {
+        float* outputsPtr = ctx.outputs.data();
+        const float* valuesPtr = ctx.inputs.data();
+        if (mActivationFunc == ActivationFunction::ReLU)
+        {
+            for (; i + 16 <= m_numOutputs; i += 16)
+                _mm512_storeu_ps(outputsPtr + i, ReLU(_mm512_loadu_ps(valuesPtr + i)));
+        }
+        else if (mActivationFunc == ActivationFunction::CReLU)
+        {
+            for (; i + 16 <= m_numOutputs; i += 16)
+                _mm512_storeu_ps(outputsPtr + i, CReLU(_mm512_loadu_ps(valuesPtr + i)));
+        }
+        else if (mActivationFunc == ActivationFunction::SqrCReLU)
+        {
+            for (; i + 16 <= m_numOutputs; i += 16)
+                _mm512_storeu_ps(outputsPtr + i, SqrCReLU(_mm512_loadu_ps(valuesPtr + i)));
+        }
+    }
+#endif // USE_AVX512
+
 #ifdef USE_AVX
     float* outputsPtr = ctx.outputs.data();
     const float* valuesPtr = ctx.inputs.data();
@@ -68,6 +90,13 @@ void ActivationNode::Run(INodeContext& ctx) const
             _mm256_store_ps(outputsPtr + i, CReLU(_mm256_load_ps(valuesPtr + i)));
         }
     }
+    else if (mActivationFunc == ActivationFunction::SqrCReLU)
+    {
+        for (; i + 8 <= m_numOutputs; i += 8)
+        {
+            _mm256_store_ps(outputsPtr + i, SqrCReLU(_mm256_load_ps(valuesPtr + i)));
+        }
+    }
 #endif // USE_AVX
 
     for (; i < m_numOutputs; i++)
@@ -83,6 +112,33 @@ void ActivationNode::Backpropagate(const Values& error, INodeContext& ctx, Gradi
     ASSERT(ctx.inputError.size() == GetNumInputs());
 
     size_t i = 0;
+
+#ifdef USE_AVX512
+    {
+        const float* errorsPtr = error.data();
+        const float* valuesPtr = ctx.inputs.data();
+        float* inputErrorPtr = ctx.inputError.data();
+        if (mActivationFunc == ActivationFunction::ReLU)
+        {
+            for (; i + 16 <= m_numOutputs; i += 16)
+                _mm512_storeu_ps(inputErrorPtr + i,
+                    ReLUDerivative(_mm512_loadu_ps(valuesPtr + i), _mm512_loadu_ps(errorsPtr + i)));
+        }
+        else if (mActivationFunc == ActivationFunction::CReLU)
+        {
+            for (; i + 16 <= m_numOutputs; i += 16)
+                _mm512_storeu_ps(inputErrorPtr + i,
+                    CReLUDerivative(_mm512_loadu_ps(valuesPtr + i), _mm512_loadu_ps(errorsPtr + i)));
+        }
+        else if (mActivationFunc == ActivationFunction::SqrCReLU)
+        {
+            for (; i + 16 <= m_numOutputs; i += 16)
+                _mm512_storeu_ps(inputErrorPtr + i,
+                    SqrCReLUDerivative(_mm512_loadu_ps(valuesPtr + i), _mm512_loadu_ps(errorsPtr + i)));
+        }
+    }
+#endif // USE_AVX512
+
 #ifdef USE_AVX
     const float* errorsPtr = error.data();
     const float* valuesPtr = ctx.inputs.data();
@@ -98,6 +154,12 @@ void ActivationNode::Backpropagate(const Values& error, INodeContext& ctx, Gradi
             _mm256_store_ps(ctx.inputError.data() + i,
                 CReLUDerivative(_mm256_load_ps(valuesPtr + i), _mm256_load_ps(errorsPtr + i)));
     }
+    else if (mActivationFunc == ActivationFunction::SqrCReLU)
+    {
+        for (; i + 8 <= m_numOutputs; i += 8)
+            _mm256_store_ps(ctx.inputError.data() + i,
+                SqrCReLUDerivative(_mm256_load_ps(valuesPtr + i), _mm256_load_ps(errorsPtr + i)));
+    }
 #endif // USE_AVX
     for (; i < m_numOutputs; i++)
     {
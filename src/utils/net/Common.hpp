@@ -11,7 +11,7 @@ namespace nn {
     class Layer;
     class NeuralNetwork;
 
-using Values = std::vector<float, AlignmentAllocator<float, 32>>;
+using Values = std::vector<float, AlignmentAllocator<float, CACHELINE_SIZE>>;
 
 struct ActiveFeature
 {
@@ -134,8 +134,8 @@ inline __m256 CReLUDerivative(const __m256 x, const __m256 coeff)
 
 inline __m256 SqrCReLU(const __m256 x)
 {
-    return _mm256_min_ps(_mm256_set1_ps(1.0f),
-                         _mm256_max_ps(_mm256_setzero_ps(), _mm256_mul_ps(x, x)));
+    const __m256 clamped = CReLU(x);
+    return _mm256_mul_ps(clamped, clamped);
 }
 inline __m256 SqrCReLUDerivative(const __m256 x, const __m256 coeff)
 {
@@ -147,4 +147,44 @@ inline __m256 SqrCReLUDerivative(const __m256 x, const __m256 coeff)
 
 #endif // USE_AVX
 
+#ifdef USE_AVX512
+
+inline __m512 ReLU(const __m512 x)
+{
+    return _mm512_max_ps(_mm512_setzero_ps(), x);
+}
+inline __m512 ReLUDerivative(const __m512 x, const __m512 coeff)
+{
+    return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ), coeff);
+}
+
+
+inline __m512 CReLU(const __m512 x)
+{
+    return _mm512_min_ps(_mm512_set1_ps(1.0f), _mm512_max_ps(_mm512_setzero_ps(), x));
+}
+inline __m512 CReLUDerivative(const __m512 x, const __m512 coeff)
+{
+    const __mmask16 mask =
+        _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ) &
+        _mm512_cmp_ps_mask(x, _mm512_set1_ps(1.0f), _CMP_LT_OQ);
+    return _mm512_maskz_mov_ps(mask, coeff);
+}
+
+
+inline __m512 SqrCReLU(const __m512 x)
+{
+    const __m512 clamped = CReLU(x);
+    return _mm512_mul_ps(clamped, clamped);
+}
+inline __m512 SqrCReLUDerivative(const __m512 x, const __m512 coeff)
+{
+    const __mmask16 mask =
+        _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ) &
+        _mm512_cmp_ps_mask(x, _mm512_set1_ps(1.0f), _CMP_LT_OQ);
+    return _mm512_maskz_mul_ps(mask, coeff, _mm512_add_ps(x, x));
+}
+
+#endif // USE_AVX512
+
 } // namespace nn
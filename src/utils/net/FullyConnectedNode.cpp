@@ -30,8 +30,33 @@ INLINE static float m256_hadd(__m256 x)
     return _mm_cvtss_f32(sum);
 }
 
+// horizontal sums of 8 vectors, returned as a single vector
+INLINE static __m256 m256_hadd8(const __m256* x)
+{
+    const __m256 sum01 = _mm256_hadd_ps(x[0], x[1]);
+    const __m256 sum23 = _mm256_hadd_ps(x[2], x[3]);
+    const __m256 sum45 = _mm256_hadd_ps(x[4], x[5]);
+    const __m256 sum67 = _mm256_hadd_ps(x[6], x[7]);
+    const __m256 sum0123 = _mm256_hadd_ps(sum01, sum23);
+    const __m256 sum4567 = _mm256_hadd_ps(sum45, sum67);
+    return _mm256_add_ps(
+        _mm256_permute2f128_ps(sum0123, sum4567, 0x20),
+        _mm256_permute2f128_ps(sum0123, sum4567, 0x31));
+}
+
 #endif // USE_AVX
 
+#ifdef USE_AVX512
+
+// fold upper half of a 512-bit vector onto the lower half
+INLINE static __m256 m512_fold(__m512 x)
+{
+    const __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1));
+    return _mm256_add_ps(_mm512_castps512_ps256(x), hi);
+}
+
+#endif // USE_AVX512
+
 FullyConnectedNode::FullyConnectedNode(const NodePtr& previousNode, uint32_t inputSize, uint32_t outputSize, const nn::WeightsStoragePtr& weights)
     : ITrainableNode(previousNode, weights, inputSize, outputSize)
 {
@@ -59,6 +84,19 @@ void FullyConnectedNode::Run(INodeContext& ctx) const
     if (m_numOutputs == 1)
     {
         size_t i = 0;
+#ifdef USE_AVX512
+        {
+            const float* weightsPtr = weights.data();
+            __m512 sum = _mm512_setzero_ps();
+            for (; i + 16 <= m_numInputs; i += 16)
+            {
+                sum = _mm512_fmadd_ps(_mm512_loadu_ps(weightsPtr + i),
+                                      _mm512_loadu_ps(context.inputs.data() + i),
+                                      sum);
+            }
+            ctx.outputs[0] += _mm512_reduce_add_ps(sum);
+        }
+#endif // USE_AVX512
 #ifdef USE_AVX
         const float* weightsPtr = weights.data();
         __m256 sum = _mm256_setzero_ps();
@@ -86,6 +124,20 @@ void FullyConnectedNode::Run(INodeContext& ctx) const
             if (std::abs(inputValue) > c_activationEpsilon)
             {
                 uint32_t i = 0;
+#ifdef USE_AVX512
+                {
+                    const float* weightsPtr = weights.data() + j * m_numOutputs;
+                    float* valuesPtr = ctx.outputs.data();
+                    const __m512 vInputValue = _mm512_set1_ps(inputValue);
+                    for (; i + 16 <= m_numOutputs; i += 16)
+                    {
+                        _mm512_storeu_ps(valuesPtr + i,
+                                         _mm512_fmadd_ps(vInputValue,
+                                                         _mm512_loadu_ps(weightsPtr + i),
+                                                         _mm512_loadu_ps(valuesPtr + i)));
+                    }
+                }
+#endif // USE_AVX512
 #ifdef USE_AVX
                 const float* weightsPtr = weights.data() + j * m_numOutputs;
                 float* valuesPtr = ctx.outputs.data();
@@ -127,16 +179,37 @@ void FullyConnectedNode::Backpropagate(const Values& error, INodeContext& ctx, G
 
     if (m_numOutputs > 1)
     {
-        for (size_t i = 0; i < m_numOutputs; i++)
+        for (size_t j = 0; j < m_numInputs; j++)
         {
-            const float activationError = error[i];
-            if (std::abs(activationError) > c_activationEpsilon)
+            // compute input gradient (dot product of weights row and output error)
+            const float* weightsPtr = weights.data() + j * m_numOutputs;
+            float inputError = 0.0f;
+            size_t i = 0;
+#ifdef USE_AVX512
+            {
+                __m512 sum = _mm512_setzero_ps();
+                for (; i + 16 <= m_numOutputs; i += 16)
+                {
+                    sum = _mm512_fmadd_ps(_mm512_loadu_ps(weightsPtr + i), _mm512_loadu_ps(error.data() + i), sum);
+                }
+                inputError += _mm512_reduce_add_ps(sum);
+            }
+#endif // USE_AVX512
+#ifdef USE_AVX
             {
-                for (size_t j = 0; j < m_numInputs; j++)
+                __m256 sum = _mm256_setzero_ps();
+                for (; i + 8 <= m_numOutputs; i += 8)
                 {
-                    ctx.inputError[j] += weights[j * m_numOutputs + i] * activationError;
+                    sum = _mm256_fmadd_ps(_mm256_loadu_ps(weightsPtr + i), _mm256_loadu_ps(error.data() + i), sum);
                 }
+                inputError += m256_hadd(sum);
+            }
+#endif // USE_AVX
+            for (; i < m_numOutputs; i++)
+            {
+                inputError += weightsPtr[i] * error[i];
             }
+            ctx.inputError[j] = inputError;
         }
 
         for (size_t j = 0; j < m_numInputs; j++)
@@ -146,6 +219,19 @@ void FullyConnectedNode::Backpropagate(const Values& error, INodeContext& ctx, G
             if (std::abs(inputValue) > c_activationEpsilon)
             {
                 size_t i = 0;
+#ifdef USE_AVX512
+                {
+                    float* gradientPtr = gradientsVariant.m_values.data() + j * m_numOutputs;
+                    const __m512 inputValueV = _mm512_set1_ps(inputValue);
+                    for (; i + 16 <= m_numOutputs; i += 16)
+                    {
+                        _mm512_storeu_ps(gradientPtr + i,
+                            _mm512_fmadd_ps(inputValueV,
+                                _mm512_loadu_ps(error.data() + i),
+                                _mm512_loadu_ps(gradientPtr + i)));
+                    }
+                }
+#endif // USE_AVX512
 #ifdef USE_AVX
                 float* gradientPtr = gradientsVariant.m_values.data() + j * m_numOutputs;
                 for (; i + 8 <= m_numOutputs; i += 8)
@@ -160,7 +246,6 @@ void FullyConnectedNode::Backpropagate(const Values& error, INodeContext& ctx, G
                 {
                     gradientsVariant.m_values[j * m_numOutputs + i] += inputValue * error[i];
                 }
-                gradientsVariant.m_dirty[j] = true;
             }
         }
     }
@@ -170,6 +255,27 @@ void FullyConnectedNode::Backpropagate(const Values& error, INodeContext& ctx, G
         if (std::abs(activationError) > c_activationEpsilon)
         {
             size_t j = 0;
+#ifdef USE_AVX512
+            {
+                float* gradientPtr = gradientsVariant.m_values.data();
+                float* inputGradientPtr = ctx.inputError.data();
+                const float* inputPtr = context.inputs.data();
+                const float* weightsPtr = weights.data();
+                const __m512 activationErrorV = _mm512_set1_ps(activationError);
+                for (; j + 16 <= m_numInputs; j += 16)
+                {
+                    // compute input gradient
+                    _mm512_storeu_ps(inputGradientPtr + j,
+                        _mm512_mul_ps(_mm512_loadu_ps(weightsPtr + j), activationErrorV));
+
+                    // compute weights gradient
+                    _mm512_storeu_ps(gradientPtr + j,
+                        _mm512_fmadd_ps(activationErrorV,
+                            _mm512_loadu_ps(inputPtr + j),
+                            _mm512_loadu_ps(gradientPtr + j)));
+                }
+            }
+#endif // USE_AVX512
 #ifdef USE_AVX
             float* gradientPtr = gradientsVariant.m_values.data();
             float* inputGradientPtr = ctx.inputError.data();
@@ -204,8 +310,16 @@ void FullyConnectedNode::Backpropagate(const Values& error, INodeContext& ctx, G
     // add bias gradient
     {
         size_t i = 0;
-#ifdef USE_AVX
         float* gradientPtr = gradientsVariant.m_values.data() + m_numInputs * m_numOutputs;
+#ifdef USE_AVX512
+        for (; i + 16 <= m_numOutputs; i += 16)
+        {
+            _mm512_storeu_ps(gradientPtr + i,
+                _mm512_add_ps(_mm512_loadu_ps(error.data() + i),
+                    _mm512_loadu_ps(gradientPtr + i)));
+        }
+#endif // USE_AVX512
+#ifdef USE_AVX
         for (; i + 8 <= m_numOutputs; i += 8)
         {
             _mm256_store_ps(gradientPtr + i,
@@ -215,10 +329,171 @@ void FullyConnectedNode::Backpropagate(const Values& error, INodeContext& ctx, G
 #endif // USE_AVX
         for (; i < m_numOutputs; i++)
         {
-            gradientsVariant.m_values[m_numInputs * m_numOutputs + i] += error[i];
+            gradientPtr[i] += error[i];
         }
-        gradientsVariant.m_dirty[m_numInputs] = true;
     }
 }
 
+void FullyConnectedNode::BackpropagateBatch(std::span<const Values* const> errors, std::span<INodeContext* const> contexts, Gradients& gradients) const
+{
+    ASSERT(errors.size() == contexts.size());
+    ASSERT(!gradients.m_isSparse);
+
+    // single output variant is already vectorized over inputs
+    if (m_numOutputs == 1)
+    {
+        INode::BackpropagateBatch(errors, contexts, gradients);
+        return;
+    }
+
+    ForEachVariant(contexts, [&](uint32_t variantIndex, std::span<const uint32_t> samples)
+    {
+        const Values& weights = m_weightsStorage->m_variants[variantIndex].m_weights;
+        Gradients::Variant& gradientsVariant = gradients.m_variants[variantIndex];
+
+        uint32_t j = 0;
+
+#ifdef USE_AVX512
+        // same as the AVX blocks below, but with 16-wide rows
+        for (; j + 8 <= m_numInputs && m_numOutputs % 16 == 0; j += 8)
+        {
+            const float* weightsPtr = weights.data() + j * m_numOutputs;
+            float* gradientPtr = gradientsVariant.m_values.data() + j * m_numOutputs;
+
+            for (const uint32_t s : samples)
+            {
+                ASSERT(contexts[s]->inputError.size() == m_numInputs);
+
+                const float* errorPtr = errors[s]->data();
+                const float* inputPtr = contexts[s]->inputs.data() + j;
+
+                __m512 inputErrorV[8];
+                for (uint32_t k = 0; k < 8; ++k)
+                    inputErrorV[k] = _mm512_setzero_ps();
+
+                for (uint32_t i = 0; i < m_numOutputs; i += 16)
+                {
+                    const __m512 errorV = _mm512_loadu_ps(errorPtr + i);
+
+                    for (uint32_t k = 0; k < 8; ++k)
+                    {
+                        // compute input gradient
+                        inputErrorV[k] = _mm512_fmadd_ps(_mm512_loadu_ps(weightsPtr + k * m_numOutputs + i), errorV, inputErrorV[k]);
+
+                        // compute weights gradient
+                        if (std::abs(inputPtr[k]) > c_activationEpsilon)
+                        {
+                            float* ptr = gradientPtr + k * m_numOutputs + i;
+                            _mm512_storeu_ps(ptr, _mm512_fmadd_ps(_mm512_set1_ps(inputPtr[k]), errorV, _mm512_loadu_ps(ptr)));
+                        }
+                    }
+                }
+
+                __m256 foldedV[8];
+                for (uint32_t k = 0; k < 8; ++k)
+                    foldedV[k] = m512_fold(inputErrorV[k]);
+
+                _mm256_storeu_ps(contexts[s]->inputError.data() + j, m256_hadd8(foldedV));
+            }
+        }
+#endif // USE_AVX512
+
+#ifdef USE_AVX
+        // process blocks of 8 inputs, so input errors of a block can be reduced and stored at once
+        // each block of weights and gradients rows is applied to all the samples in the batch
+        for (; j + 8 <= m_numInputs && m_numOutputs % 8 == 0; j += 8)
+        {
+            const float* weightsPtr = weights.data() + j * m_numOutputs;
+            float* gradientPtr = gradientsVariant.m_values.data() + j * m_numOutputs;
+
+            for (const uint32_t s : samples)
+            {
+                ASSERT(contexts[s]->inputError.size() == m_numInputs);
+
+                const float* errorPtr = errors[s]->data();
+                const float* inputPtr = contexts[s]->inputs.data() + j;
+
+                __m256 inputErrorV[8];
+                for (uint32_t k = 0; k < 8; ++k)
+                    inputErrorV[k] = _mm256_setzero_ps();
+
+                for (uint32_t i = 0; i < m_numOutputs; i += 8)
+                {
+                    const __m256 errorV = _mm256_load_ps(errorPtr + i);
+
+                    for (uint32_t k = 0; k < 8; ++k)
+                    {
+                        // compute input gradient
+                        inputErrorV[k] = _mm256_fmadd_ps(_mm256_load_ps(weightsPtr + k * m_numOutputs + i), errorV, inputErrorV[k]);
+
+                        // compute weights gradient
+                        if (std::abs(inputPtr[k]) > c_activationEpsilon)
+                        {
+                            float* ptr = gradientPtr + k * m_numOutputs + i;
+                            _mm256_store_ps(ptr, _mm256_fmadd_ps(_mm256_set1_ps(inputPtr[k]), errorV, _mm256_load_ps(ptr)));
+                        }
+                    }
+                }
+
+                _mm256_storeu_ps(contexts[s]->inputError.data() + j, m256_hadd8(inputErrorV));
+            }
+        }
+#endif // USE_AVX
+
+        for (; j < m_numInputs; j++)
+        {
+            const float* weightsPtr = weights.data() + j * m_numOutputs;
+            float* gradientPtr = gradientsVariant.m_values.data() + j * m_numOutputs;
+
+            for (const uint32_t s : samples)
+            {
+                const float* errorPtr = errors[s]->data();
+                const float inputValue = contexts[s]->inputs[j];
+                const bool hasInput = std::abs(inputValue) > c_activationEpsilon;
+
+                float inputError = 0.0f;
+                for (uint32_t i = 0; i < m_numOutputs; i++)
+                {
+                    inputError += weightsPtr[i] * errorPtr[i];
+                    if (hasInput)
+                    {
+                        gradientPtr[i] += inputValue * errorPtr[i];
+                    }
+                }
+
+                contexts[s]->inputError[j] = inputError;
+            }
+        }
+
+        // add bias gradient
+        float* biasGradientPtr = gradientsVariant.m_values.data() + m_numInputs * m_numOutputs;
+        for (const uint32_t s : samples)
+        {
+            const float* errorPtr = errors[s]->data();
+
+            uint32_t i = 0;
+#ifdef USE_AVX512
+            for (; i + 16 <= m_numOutputs; i += 16)
+            {
+                _mm512_storeu_ps(biasGradientPtr + i,
+                    _mm512_add_ps(_mm512_loadu_ps(errorPtr + i),
+                        _mm512_loadu_ps(biasGradientPtr + i)));
+            }
+#endif // USE_AVX512
+#ifdef USE_AVX
+            for (; i + 8 <= m_numOutputs; i += 8)
+            {
+                _mm256_store_ps(biasGradientPtr + i,
+                    _mm256_add_ps(_mm256_load_ps(errorPtr + i),
+                        _mm256_load_ps(biasGradientPtr + i)));
+            }
+#endif // USE_AVX
+            for (; i < m_numOutputs; i++)
+            {
+                biasGradientPtr[i] += errorPtr[i];
+            }
+        }
+    });
+}
+
 } // namespace nn
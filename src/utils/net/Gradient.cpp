@@ -13,8 +13,18 @@ void Gradients::Init(uint32_t numInputs, uint32_t numOutputs, uint32_t numVarian
     m_variants.resize(numVariants);
     for (Variant& variant : m_variants)
     {
-        variant.m_values.resize((numInputs + 1) * numOutputs, 0.0f);
-        variant.m_dirty.resize(numInputs + 1, false);
+        if (isSparse)
+        {
+            // rows are allocated when touched
+            variant.m_rowSize = numOutputs;
+            variant.m_rowChunks.clear();
+            variant.m_rows.assign(numInputs + 1, nullptr);
+            variant.m_touchedRows.clear();
+        }
+        else
+        {
+            variant.m_values.resize((numInputs + 1) * numOutputs, 0.0f);
+        }
     }
 }
 
@@ -24,26 +34,11 @@ void Gradients::Clear()
     {
         for (Variant& variant : m_variants)
         {
-            // clear only dirty gradients
-            for (size_t i = 0; i <= m_numInputs; ++i)
+            for (const uint32_t row : variant.m_touchedRows)
             {
-                if (variant.m_dirty[i])
-                {
-                    std::fill(
-                        variant.m_values.begin() + i * m_numOutputs,
-                        variant.m_values.begin() + (i + 1) * m_numOutputs,
-                        0.0f);
-                }
+                variant.m_rows[row] = nullptr;
             }
-
-#ifndef CONFIGURATION_FINAL
-            for (size_t i = 0; i < variant.m_values.size(); ++i)
-            {
-                ASSERT(variant.m_values[i] == 0.0f);
-            }
-#endif // CONFIGURATION_FINAL
-
-            std::fill(variant.m_dirty.begin(), variant.m_dirty.end(), false);
+            variant.m_touchedRows.clear();
         }
     }
     else
@@ -61,7 +56,7 @@ void Gradients::Accumulate(Gradients& rhs, uint32_t inputIndex)
     ASSERT(rhs.m_numInputs == m_numInputs);
     ASSERT(rhs.m_numOutputs == m_numOutputs);
     ASSERT(rhs.m_variants.size() == m_variants.size());
-    ASSERT(rhs.m_isSparse == m_isSparse);
+    ASSERT(!m_isSparse && !rhs.m_isSparse);
 
     for (size_t variantIndex = 0; variantIndex < m_variants.size(); ++variantIndex)
     {
@@ -70,20 +65,22 @@ void Gradients::Accumulate(Gradients& rhs, uint32_t inputIndex)
 
         ASSERT(rhsVariant.m_values.size() == variant.m_values.size());
 
-        if (m_isSparse && !rhsVariant.m_dirty[inputIndex])
-            continue;
-
-        // NOTE: not updating dirty flags here, because it's not thread-safe
-        // It will be done later in Accumulate_UpdateDirtyFlags
-        //variant.m_dirty[inputIndex] = true;
-        //rhsVariant.m_dirty[inputIndex] = false;
-
         size_t j = inputIndex * m_numOutputs;
         const size_t j_max = (inputIndex + 1) * m_numOutputs;
 
-#ifdef USE_AVX
         float* values = variant.m_values.data();
         float* rhsValues = rhsVariant.m_values.data();
+
+#ifdef USE_AVX512
+        for (; j + 16 <= j_max; j += 16)
+        {
+            _mm512_storeu_ps(values + j,
+                _mm512_add_ps(_mm512_loadu_ps(values + j), _mm512_loadu_ps(rhsValues + j)));
+            _mm512_storeu_ps(rhsValues + j, _mm512_setzero_ps());
+        }
+#endif // USE_AVX512
+
+#ifdef USE_AVX
         for (; j + 8 <= j_max; j += 8)
         {
             _mm256_store_ps(values + j,
@@ -94,34 +91,8 @@ void Gradients::Accumulate(Gradients& rhs, uint32_t inputIndex)
 
         for (; j < j_max; ++j)
         {
-            variant.m_values[j] += rhsVariant.m_values[j];
-            rhsVariant.m_values[j] = 0.0f;
-        }
-    }
-}
-
-void Gradients::Accumulate_UpdateDirtyFlags(Gradients& rhs, uint32_t inputIndex)
-{
-    ASSERT(inputIndex <= m_numInputs);
-    ASSERT(rhs.m_numInputs == m_numInputs);
-    ASSERT(rhs.m_numOutputs == m_numOutputs);
-    ASSERT(rhs.m_variants.size() == m_variants.size());
-    ASSERT(rhs.m_isSparse == m_isSparse);
-
-    for (size_t variantIndex = 0; variantIndex < m_variants.size(); ++variantIndex)
-    {
-        Variant& variant = m_variants[variantIndex];
-        Variant& rhsVariant = rhs.m_variants[variantIndex];
-
-        ASSERT(rhsVariant.m_values.size() == variant.m_values.size());
-
-        if (m_isSparse)
-        {
-            if (rhsVariant.m_dirty[inputIndex])
-            {
-                variant.m_dirty[inputIndex] = true;
-                rhsVariant.m_dirty[inputIndex] = false;
-            }
+            values[j] += rhsValues[j];
+            rhsValues[j] = 0.0f;
         }
     }
 }
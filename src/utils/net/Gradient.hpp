@@ -4,24 +4,65 @@
 
 namespace nn {
 
-// Sparse gradients for WeightsStorage
+// Gradients for WeightsStorage
+// Dense gradients keep all the rows (one row per input).
+// Sparse gradients keep only rows touched since last Clear() in a pool of fixed-size chunks,
+// so memory usage and clearing cost are proportional to number of touched rows.
 struct Gradients
 {
+    static constexpr uint32_t SparseRowsPerChunk = 64;
+
     uint32_t            m_numInputs = 0;
     uint32_t            m_numOutputs = 0;
     bool                m_isSparse = false;
 
     struct Variant
     {
-        Values              m_values;
-        std::vector<bool>   m_dirty;
+        Values                  m_values;       // dense only: (numInputs + 1) x numOutputs
+        std::vector<Values>     m_rowChunks;    // sparse only: pool of touched rows, grown on demand and kept between Clear() calls
+        std::vector<float*>     m_rows;         // sparse only: pointer to each row in the pool (nullptr if not touched)
+        std::vector<uint32_t>   m_touchedRows;  // sparse only: list of touched rows
+        uint32_t                m_rowSize = 0;
+
+        // get gradients row, allocate it in the pool if not touched yet
+        // Note: growing the pool adds new chunks, so returned pointers stay valid until Clear()
+        INLINE float* GetSparseRow(uint32_t row)
+        {
+            float*& rowPtr = m_rows[row];
+            if (!rowPtr)
+            {
+                const size_t slot = m_touchedRows.size();
+                if (slot / SparseRowsPerChunk >= m_rowChunks.size())
+                {
+                    m_rowChunks.emplace_back(SparseRowsPerChunk * m_rowSize);
+                }
+                rowPtr = m_rowChunks[slot / SparseRowsPerChunk].data() + (slot % SparseRowsPerChunk) * m_rowSize;
+                std::fill(rowPtr, rowPtr + m_rowSize, 0.0f);
+                m_touchedRows.push_back(row);
+            }
+            return rowPtr;
+        }
+
+        // returns nullptr if the row was not touched
+        INLINE const float* FindSparseRow(uint32_t row) const
+        {
+            return m_rows[row];
+        }
+
+        // get row that was already allocated with GetSparseRow()
+        INLINE float* GetTouchedSparseRow(uint32_t row)
+        {
+            ASSERT(m_rows[row]);
+            return m_rows[row];
+        }
     };
     std::vector<Variant> m_variants;
 
     void Init(uint32_t numInputs, uint32_t numOutputs, uint32_t numVariants, bool isSparse);
     void Clear();
+
+    // accumulate (and clear) dense gradients row
     void Accumulate(Gradients& rhs, uint32_t inputIndex);
-    void Accumulate_UpdateDirtyFlags(Gradients& rhs, uint32_t inputIndex);
 };
 
 } // namespace nn
@@ -305,83 +305,107 @@ void NeuralNetwork::Init(const std::vector<NodePtr>& nodes)
     m_nodes = nodes;
 }
 
-const Values& NeuralNetwork::Run(const InputDesc& inputDesc, NeuralNetworkRunContext& ctx) const
+void NeuralNetwork::BindNodeInputs(size_t nodeIndex, const InputDesc& inputDesc, NeuralNetworkRunContext& ctx) const
 {
-    ASSERT(m_nodes.size() == ctx.nodeContexts.size());
+    const size_t i = nodeIndex;
+    const NodePtr& node = m_nodes[i];
 
-    for (size_t i = 0; i < m_nodes.size(); i++)
+    if (node->IsCombining())
     {
-        const NodePtr& node = m_nodes[i];
-
-        if (node->IsCombining())
-        {
-            const ICombiningNode* concatNode = static_cast<const ICombiningNode*>(node.get());
-            ICombiningNode::Context& nodeCtx = static_cast<ICombiningNode::Context&>(*ctx.nodeContexts[i]);
+        const ICombiningNode* concatNode = static_cast<const ICombiningNode*>(node.get());
+        ICombiningNode::Context& nodeCtx = static_cast<ICombiningNode::Context&>(*ctx.nodeContexts[i]);
 
-            // match node context inputs to the outputs of the previous nodes
-            for (size_t j = 0; j < i; j++)
-            {
-                if (m_nodes[j].get() == concatNode->GetInputNode(0))
-                {
-                    nodeCtx.inputs = ctx.nodeContexts[j]->outputs;
-                }
-                else if (m_nodes[j].get() == concatNode->GetInputNode(1))
-                {
-                    nodeCtx.secondaryInputs = ctx.nodeContexts[j]->outputs;
-                }
-            }
-        }
-        else if (node->IsInputNode())
+        // match node context inputs to the outputs of the previous nodes
+        for (size_t j = 0; j < i; j++)
         {
-            ASSERT(i < MaxInputNodes);
-            const NodeInput& input = inputDesc.inputs[i];
-
-            switch (input.mode)
-            {
-            case InputMode::Full:
+            if (m_nodes[j].get() == concatNode->GetInputNode(0))
             {
-                FullyConnectedNode::Context& nodeCtx = static_cast<FullyConnectedNode::Context&>(*ctx.nodeContexts[i]);
-                ASSERT(node->GetInputMode() == InputMode::Full);
-                ASSERT(input.numFeatures == node->GetNumInputs());
-                nodeCtx.inputs = std::span<const float>(input.floatValues, input.numFeatures);
-                node->Run(nodeCtx);
-                break;
+                nodeCtx.inputs = ctx.nodeContexts[j]->outputs;
             }
-            case InputMode::Sparse:
+            else if (m_nodes[j].get() == concatNode->GetInputNode(1))
             {
-                SparseInputNode::Context& nodeCtx = static_cast<SparseInputNode::Context&>(*ctx.nodeContexts[i]);
-                ASSERT(node->GetInputMode() == InputMode::Sparse);
-                ASSERT(input.numFeatures <= node->GetNumInputs());
-                nodeCtx.sparseInputs = std::span<const ActiveFeature>(input.floatFeatures, input.numFeatures);
-                node->Run(nodeCtx);
-                break;
-            }
-            case InputMode::SparseBinary:
-            {
-                SparseBinaryInputNode::Context& nodeCtx = static_cast<SparseBinaryInputNode::Context&>(*ctx.nodeContexts[i]);
-                ASSERT(node->GetInputMode() == InputMode::SparseBinary);
-                ASSERT(input.numFeatures <= node->GetNumInputs());
-                nodeCtx.sparseInputs = std::span<const SparseBinaryInputNode::IndexType>(input.binaryFeatures, input.numFeatures);
-                node->Run(nodeCtx);
-                break;
-            }
-            default:
-                ASSERT(false);
+                nodeCtx.secondaryInputs = ctx.nodeContexts[j]->outputs;
             }
         }
-        else
+    }
+    else if (node->IsInputNode())
+    {
+        ASSERT(i < MaxInputNodes);
+        const NodeInput& input = inputDesc.inputs[i];
+
+        switch (input.mode)
+        {
+        case InputMode::Full:
+        {
+            FullyConnectedNode::Context& nodeCtx = static_cast<FullyConnectedNode::Context&>(*ctx.nodeContexts[i]);
+            ASSERT(node->GetInputMode() == InputMode::Full);
+            ASSERT(input.numFeatures == node->GetNumInputs());
+            nodeCtx.inputs = std::span<const float>(input.floatValues, input.numFeatures);
+            break;
+        }
+        case InputMode::Sparse:
         {
-            ctx.nodeContexts[i]->inputs = ctx.nodeContexts[i - 1]->outputs;
+            SparseInputNode::Context& nodeCtx = static_cast<SparseInputNode::Context&>(*ctx.nodeContexts[i]);
+            ASSERT(node->GetInputMode() == InputMode::Sparse);
+            ASSERT(input.numFeatures <= node->GetNumInputs());
+            nodeCtx.sparseInputs = std::span<const ActiveFeature>(input.floatFeatures, input.numFeatures);
+            break;
+        }
+        case InputMode::SparseBinary:
+        {
+            SparseBinaryInputNode::Context& nodeCtx = static_cast<SparseBinaryInputNode::Context&>(*ctx.nodeContexts[i]);
+            ASSERT(node->GetInputMode() == InputMode::SparseBinary);
+            ASSERT(input.numFeatures <= node->GetNumInputs());
+            nodeCtx.sparseInputs = std::span<const SparseBinaryInputNode::IndexType>(input.binaryFeatures, input.numFeatures);
+            break;
+        }
+        default:
+            ASSERT(false);
         }
+    }
+    else
+    {
+        ctx.nodeContexts[i]->inputs = ctx.nodeContexts[i - 1]->outputs;
+    }
+
+    ctx.nodeContexts[i]->variant = inputDesc.variant;
+}
 
-        ctx.nodeContexts[i]->variant = inputDesc.variant;
+const Values& NeuralNetwork::Run(const InputDesc& inputDesc, NeuralNetworkRunContext& ctx) const
+{
+    ASSERT(m_nodes.size() == ctx.nodeContexts.size());
 
-        node->Run(*ctx.nodeContexts[i]);
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        BindNodeInputs(i, inputDesc, ctx);
+        m_nodes[i]->Run(*ctx.nodeContexts[i]);
     }
 
     return ctx.nodeContexts.back()->outputs;
 }
 
+void NeuralNetwork::RunBatch(std::span<const InputDesc* const> inputDescs, std::span<NeuralNetworkRunContext* const> contexts) const
+{
+    ASSERT(inputDescs.size() == contexts.size());
+    ASSERT(contexts.size() <= MaxBatchSize);
+
+    const size_t batchSize = contexts.size();
+
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        INodeContext* nodeContexts[MaxBatchSize];
+
+        for (size_t j = 0; j < batchSize; ++j)
+        {
+            ASSERT(m_nodes.size() == contexts[j]->nodeContexts.size());
+            BindNodeInputs(i, *inputDescs[j], *contexts[j]);
+            nodeContexts[j] = contexts[j]->nodeContexts[i].get();
+        }
+
+        m_nodes[i]->RunBatch(std::span<INodeContext* const>(nodeContexts, batchSize));
+    }
+}
+
 NeuralNetworkTrainer::NeuralNetworkTrainer()
 {
     m_perThreadData.resize(ThreadPool::GetInstance().GetNumThreads());
@@ -405,9 +429,28 @@ void NeuralNetworkTrainer::Init(NeuralNetwork& network)
         }
     }
 
+    uint32_t maxOutputSize = 0;
+    m_touchedRows.resize(m_weightsStorages.size());
+    for (size_t i = 0; i < m_weightsStorages.size(); ++i)
+    {
+        const WeightsStorage* weightsStorage = m_weightsStorages[i];
+        maxOutputSize = std::max(maxOutputSize, weightsStorage->m_outputSize);
+        if (weightsStorage->m_isSparse)
+        {
+            const size_t numRows = weightsStorage->m_variants.size() * (weightsStorage->m_inputSize + 1);
+            m_touchedRows[i].rows.reserve(numRows);
+            m_touchedRows[i].isTouched.resize(numRows, 0);
+        }
+    }
+
     for (PerThreadData& threadData : m_perThreadData)
     {
-        threadData.runContext.Init(network);
+        threadData.runContexts.resize(MaxBatchSize);
+        for (NeuralNetworkRunContext& runContext : threadData.runContexts)
+        {
+            runContext.Init(network);
+        }
+        threadData.accumulatedGradients.resize(maxOutputSize);
 
         threadData.perWeightsStorageGradients.resize(m_weightsStorages.size());
         for (size_t i = 0; i < m_weightsStorages.size(); ++i)
@@ -451,113 +494,80 @@ size_t NeuralNetworkTrainer::Train(NeuralNetwork& network, const TrainingSet& tr
             }
         };
 
-        const auto backpropagateFunc = [this, &network, &trainingSet, batchIdx, params](uint32_t threadIdx, uint32_t indexInBatch)
+        // process training vectors [begin, end) of the batch, in groups of up to MaxBatchSize vectors
+        const auto backpropagateFunc = [this, &network, &trainingSet, batchIdx, params](uint32_t threadIdx, size_t begin, size_t end)
         {
             PerThreadData& perThreadData = m_perThreadData[threadIdx];
-            NeuralNetworkRunContext& ctx = perThreadData.runContext;
 
-            const size_t vecIndex = batchIdx * params.batchSize + indexInBatch;
-            if (vecIndex >= trainingSet.size()) return;
+            const size_t batchBase = batchIdx * params.batchSize;
+            end = std::min(end, trainingSet.size() - std::min(trainingSet.size(), batchBase));
 
-            const TrainingVector& vec = trainingSet[vecIndex];
-
-            ctx.tempValues = network.Run(vec.input, ctx);
-
-            // train last node
+            for (size_t groupBegin = begin; groupBegin < end; groupBegin += MaxBatchSize)
             {
-                const float errorScale = 2.0f;
+                const size_t groupSize = std::min<size_t>(MaxBatchSize, end - groupBegin);
 
-                // compute gradient (error derivative)
-                if (vec.output.mode == OutputMode::Single)
+                const InputDesc* inputDescs[MaxBatchSize];
+                NeuralNetworkRunContext* contexts[MaxBatchSize];
+                for (size_t j = 0; j < groupSize; ++j)
                 {
-                    ASSERT(ctx.tempValues.size() == 1u);
-                    ctx.tempValues[0] = errorScale * (ctx.tempValues[0] - vec.output.singleValue);
+                    inputDescs[j] = &trainingSet[batchBase + groupBegin + j].input;
+                    contexts[j] = &perThreadData.runContexts[j];
                 }
-                else if (vec.output.mode == OutputMode::Full)
+
+                network.RunBatch(std::span<const InputDesc* const>(inputDescs, groupSize),
+                                 std::span<NeuralNetworkRunContext* const>(contexts, groupSize));
+
+                // compute gradient (error derivative) of last node
+                for (size_t j = 0; j < groupSize; ++j)
                 {
-                    ASSERT(ctx.tempValues.size() == vec.output.numValues);
-                    for (size_t i = 0; i < ctx.tempValues.size(); i++)
+                    const TrainingVector& vec = trainingSet[batchBase + groupBegin + j];
+                    NeuralNetworkRunContext& ctx = *contexts[j];
+
+                    const float errorScale = 2.0f;
+
+                    ctx.tempValues = ctx.nodeContexts.back()->outputs;
+
+                    if (vec.output.mode == OutputMode::Single)
                     {
-                        // compute gradient (error derivative)
-                        ctx.tempValues[i] = errorScale * (ctx.tempValues[i] - vec.output.floatValues[i]);
+                        ASSERT(ctx.tempValues.size() == 1u);
+                        ctx.tempValues[0] = errorScale * (ctx.tempValues[0] - vec.output.singleValue);
+                    }
+                    else if (vec.output.mode == OutputMode::Full)
+                    {
+                        ASSERT(ctx.tempValues.size() == vec.output.numValues);
+                        for (size_t i = 0; i < ctx.tempValues.size(); i++)
+                        {
+                            ctx.tempValues[i] = errorScale * (ctx.tempValues[i] - vec.output.floatValues[i]);
+                        }
+                    }
+                    else
+                    {
+                        ASSERT(false);
                     }
                 }
-                else
-                {
-                    ASSERT(false);
-                }
-
-                ctx.nodeContexts.back()->variant = vec.input.variant;
-
-                network.m_nodes.back()->Backpropagate(
-                    ctx.tempValues,
-                    *ctx.nodeContexts.back(),
-                    *perThreadData.perNodeGradients.back());
-            }
 
-            // train hidden m_nodes
-            if (network.m_nodes.size() > 1)
-            {
-                for (size_t i = network.m_nodes.size() - 1; i-- > 0; )
+                // train nodes, starting from the last one
+                for (size_t i = network.m_nodes.size(); i-- > 0; )
                 {
                     const NodePtr& node = network.m_nodes[i];
                     ASSERT(node);
-                    ASSERT(ctx.inputErrors[i]);
-
-                    ctx.nodeContexts[i]->variant = vec.input.variant;
-
-                    node->Backpropagate(*ctx.inputErrors[i],
-                                        *ctx.nodeContexts[i],
-                                        *perThreadData.perNodeGradients[i]);
-                }
-            }
-        };
-
-        /*
-        const auto updateWeightsFunc = [this, batchIdx, params]()
-        {
-            for (size_t weightsStorageIndex = 0; weightsStorageIndex < m_weightsStorages.size(); ++weightsStorageIndex)
-            {
-                MTR_SCOPE("NeuralNetworkTrainer::Train", "UpdateWeights");
-
-                WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
-                ASSERT(weightsStorage);
 
-                if (!weightsStorage->m_updateWeights) continue;
-
-                WeightsStorage::WeightsUpdateOptions updateOptions;
-                updateOptions.iteration = params.iteration + batchIdx;
-                updateOptions.weightDecay = params.weightDecay;
-                updateOptions.learningRate = params.learningRate;
-                updateOptions.gradientScale = 1.0f; // 1.0f / (float)params.batchSize;
-
-                Gradients& gradients = m_perThreadData.front().perWeightsStorageGradients[weightsStorageIndex];
-
-                for (uint32_t inputIndex = 0; inputIndex <= weightsStorage->m_inputSize; ++inputIndex)
-                {
-                    // accumulate gradients from all per-thread gradients
-                    for (size_t threadIdx = 1; threadIdx < m_perThreadData.size(); ++threadIdx)
+                    INodeContext* nodeContexts[MaxBatchSize];
+                    const Values* errors[MaxBatchSize];
+                    for (size_t j = 0; j < groupSize; ++j)
                     {
-                        Gradients& srcGradients = m_perThreadData[threadIdx].perWeightsStorageGradients[weightsStorageIndex];
-                        gradients.Accumulate(srcGradients, inputIndex);
+                        NeuralNetworkRunContext& ctx = *contexts[j];
+                        nodeContexts[j] = ctx.nodeContexts[i].get();
+                        errors[j] = (i + 1 == network.m_nodes.size()) ? &ctx.tempValues : ctx.inputErrors[i];
+                        ASSERT(errors[j]);
                     }
 
-                    // apply weights update
-                    switch (params.optimizer)
-                    {
-                    case Optimizer::Adadelta:
-                        weightsStorage->Update_Adadelta(gradients, inputIndex, updateOptions);
-                        break;
-                    case Optimizer::Adam:
-                        weightsStorage->Update_Adam(gradients, inputIndex, updateOptions);
-                        break;
-                    default:
-                        DEBUG_BREAK();
-                    }
+                    node->BackpropagateBatch(std::span<const Values* const>(errors, groupSize),
+                                             std::span<INodeContext* const>(nodeContexts, groupSize),
+                                             *perThreadData.perNodeGradients[i]);
                 }
             }
         };
-        */
 
         if (taskBuilder && params.batchSize > 64) // multi-threaded
         {
@@ -575,107 +585,229 @@ size_t NeuralNetworkTrainer::Train(NeuralNetwork& network, const TrainingSet& tr
 
             taskBuilder->Fence();
 
-            taskBuilder->ParallelFor("Backpropagate", (uint32_t)params.batchSize,
-                                     [backpropagateFunc](const TaskContext& taskCtx, uint32_t indexInBatch)
+            // process the batch in ranges of full groups instead of scheduling every training vector separately
+            taskBuilder->ParallelForRange("Backpropagate", (uint32_t)params.batchSize,
+                                          [backpropagateFunc](const TaskContext& taskCtx, uint32_t begin, uint32_t end)
             {
-                backpropagateFunc(taskCtx.threadId, indexInBatch);
-            });
+                backpropagateFunc(taskCtx.threadId, begin, end);
+            }, MaxBatchSize);
 
             taskBuilder->Fence();
 
-            for (size_t weightsStorageIndex = 0; weightsStorageIndex < m_weightsStorages.size(); ++weightsStorageIndex)
-            {
-                MTR_SCOPE("NeuralNetworkTrainer::Train", "UpdateWeights");
+            const size_t iteration = params.iteration + batchIdx;
 
-                WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
+            // dense weights: accumulate and update every row
+            // sparse weights: gather union of rows touched by any thread
+            for (uint32_t weightsStorageIndex = 0; weightsStorageIndex < m_weightsStorages.size(); ++weightsStorageIndex)
+            {
+                const WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
                 ASSERT(weightsStorage);
 
                 if (!weightsStorage->m_updateWeights) continue;
 
-                //for (uint32_t inputIndex = 0; inputIndex <= weightsStorage->m_inputSize; ++inputIndex)
-                taskBuilder->ParallelFor("UpdateWeights", weightsStorage->m_inputSize + 1,
-                    [this, weightsStorageIndex, params, batchIdx](const TaskContext&, uint32_t inputIndex)
+                if (weightsStorage->m_isSparse)
                 {
-                    WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
-                    ASSERT(weightsStorage);
-
-                    Gradients& gradients = m_perThreadData.front().perWeightsStorageGradients[weightsStorageIndex];
-
-                    // accumulate gradients from all per-thread gradients
-                    for (size_t threadIdx = 1; threadIdx < m_perThreadData.size(); ++threadIdx)
+                    taskBuilder->Task("MergeTouchedRows", [this, weightsStorageIndex](const TaskContext&)
                     {
-                        Gradients& srcGradients = m_perThreadData[threadIdx].perWeightsStorageGradients[weightsStorageIndex];
-                        gradients.Accumulate(srcGradients, inputIndex);
-                    }
-
-                    WeightsStorage::WeightsUpdateOptions updateOptions;
-                    updateOptions.iteration = params.iteration + batchIdx;
-                    updateOptions.weightDecay = params.weightDecay;
-                    updateOptions.learningRate = params.learningRate;
-                    updateOptions.gradientScale = 1.0f; // 1.0f / (float)params.batchSize;
-
-                    // apply weights update
-                    switch (params.optimizer)
+                        MergeTouchedRows(weightsStorageIndex);
+                    });
+                }
+                else
+                {
+                    taskBuilder->ParallelForRange("UpdateWeights", weightsStorage->m_inputSize + 1,
+                        [this, weightsStorageIndex, params, iteration](const TaskContext&, uint32_t begin, uint32_t end)
                     {
-                    case Optimizer::Adadelta:
-                        weightsStorage->Update_Adadelta(gradients, inputIndex, updateOptions);
-                        break;
-                    case Optimizer::Adam:
-                        weightsStorage->Update_Adam(gradients, inputIndex, updateOptions);
-                        break;
-                    default:
-                        DEBUG_BREAK();
-                    }
-                });
+                        for (uint32_t inputIndex = begin; inputIndex < end; ++inputIndex)
+                        {
+                            UpdateDenseRow(weightsStorageIndex, inputIndex, params, iteration);
+                        }
+                    });
+                }
             }
 
             taskBuilder->Fence();
 
-            taskBuilder->Task("UpdateGradientsDirtyFlag", [this](const TaskContext&)
+            // sparse weights: reduce and update touched rows only
+            // each row is owned by exactly one shard, so no synchronization is needed
+            const uint32_t numShards = 4 * (uint32_t)m_perThreadData.size();
+            for (uint32_t weightsStorageIndex = 0; weightsStorageIndex < m_weightsStorages.size(); ++weightsStorageIndex)
             {
-                for (size_t weightsStorageIndex = 0; weightsStorageIndex < m_weightsStorages.size(); ++weightsStorageIndex)
+                const WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
+                ASSERT(weightsStorage);
+
+                if (!weightsStorage->m_updateWeights) continue;
+                if (!weightsStorage->m_isSparse) continue;
+
+                taskBuilder->ParallelFor("UpdateSparseWeights", numShards,
+                    [this, weightsStorageIndex, numShards, params, iteration](const TaskContext& taskCtx, uint32_t shardIndex)
                 {
-                    WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
-                    ASSERT(weightsStorage);
+                    UpdateSparseRows(weightsStorageIndex, taskCtx.threadId, shardIndex, numShards, params, iteration);
+                });
+            }
+        }
+        else // single-threaded
+        {
+            const uint32_t dummyThreadIdx = 0;
 
-                    if (!weightsStorage->m_updateWeights) continue;
-                    if (!weightsStorage->m_isSparse) continue;
+            clearGradientsFunc(dummyThreadIdx);
 
-                    Gradients& gradients = m_perThreadData.front().perWeightsStorageGradients[weightsStorageIndex];
+            backpropagateFunc(dummyThreadIdx, 0, params.batchSize);
 
-                    for (size_t threadIdx = 1; threadIdx < m_perThreadData.size(); ++threadIdx)
-                    {
-                        Gradients& srcGradients = m_perThreadData[threadIdx].perWeightsStorageGradients[weightsStorageIndex];
-                        for (uint32_t i = 0; i < weightsStorage->m_inputSize + 1; ++i)
-                        {
-                            gradients.Accumulate_UpdateDirtyFlags(srcGradients, i);
+            for (uint32_t weightsStorageIndex = 0; weightsStorageIndex < m_weightsStorages.size(); ++weightsStorageIndex)
+            {
+                const WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
+                ASSERT(weightsStorage);
 
-                            //for (const Gradients::Variant& variant : srcGradients.m_variants)
-                            //{
-                            //    ASSERT(!variant.m_dirty[i]);
-                            //}
-                        }
+                if (!weightsStorage->m_updateWeights) continue;
+
+                if (weightsStorage->m_isSparse)
+                {
+                    MergeTouchedRows(weightsStorageIndex);
+                    UpdateSparseRows(weightsStorageIndex, dummyThreadIdx, 0, 1, params, params.iteration + batchIdx);
+                }
+                else
+                {
+                    for (uint32_t inputIndex = 0; inputIndex <= weightsStorage->m_inputSize; ++inputIndex)
+                    {
+                        UpdateDenseRow(weightsStorageIndex, inputIndex, params, params.iteration + batchIdx);
                     }
                 }
-            });
+            }
         }
-        else // single-threaded
-        {
-            const uint32_t dummyThreadIdx = 0;
+    }
 
-            clearGradientsFunc(dummyThreadIdx);
+    return numBatches;
+}
+
+void NeuralNetworkTrainer::MergeTouchedRows(uint32_t weightsStorageIndex)
+{
+    MTR_SCOPE("NeuralNetworkTrainer::Train", "MergeTouchedRows");
+
+    const WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
+    ASSERT(weightsStorage->m_isSparse);
+
+    TouchedRows& touchedRows = m_touchedRows[weightsStorageIndex];
+    touchedRows.rows.clear();
+
+    const uint32_t numRowsPerVariant = weightsStorage->m_inputSize + 1;
 
-            for (uint32_t indexInBatch = 0; indexInBatch < (uint32_t)params.batchSize; ++indexInBatch)
+    for (const PerThreadData& threadData : m_perThreadData)
+    {
+        const Gradients& gradients = threadData.perWeightsStorageGradients[weightsStorageIndex];
+        for (uint32_t variantIndex = 0; variantIndex < gradients.m_variants.size(); ++variantIndex)
+        {
+            for (const uint32_t inputIndex : gradients.m_variants[variantIndex].m_touchedRows)
             {
-                backpropagateFunc(dummyThreadIdx, indexInBatch);
+                const uint32_t rowIndex = variantIndex * numRowsPerVariant + inputIndex;
+                if (!touchedRows.isTouched[rowIndex])
+                {
+                    touchedRows.isTouched[rowIndex] = 1;
+                    touchedRows.rows.push_back(rowIndex);
+                }
             }
+        }
+    }
+}
+
+static void UpdateWeightsRow(WeightsStorage& weightsStorage, const float* gradients, uint32_t variantIndex, uint32_t inputIndex, const TrainParams& params, size_t iteration)
+{
+    WeightsStorage::WeightsUpdateOptions updateOptions;
+    updateOptions.iteration = iteration;
+    updateOptions.weightDecay = params.weightDecay;
+    updateOptions.learningRate = params.learningRate;
+    updateOptions.gradientScale = 1.0f; // 1.0f / (float)params.batchSize;
+
+    switch (params.optimizer)
+    {
+    case Optimizer::Adadelta:
+        weightsStorage.Update_Adadelta(gradients, variantIndex, inputIndex, updateOptions);
+        break;
+    case Optimizer::Adam:
+        weightsStorage.Update_Adam(gradients, variantIndex, inputIndex, updateOptions);
+        break;
+    default:
+        DEBUG_BREAK();
+    }
+}
+
+void NeuralNetworkTrainer::UpdateSparseRows(uint32_t weightsStorageIndex, uint32_t threadIdx, uint32_t shardIndex, uint32_t numShards, const TrainParams& params, size_t iteration)
+{
+    WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
+    ASSERT(weightsStorage->m_isSparse);
+
+    TouchedRows& touchedRows = m_touchedRows[weightsStorageIndex];
+
+    const size_t numRows = touchedRows.rows.size();
+    const size_t begin = numRows * shardIndex / numShards;
+    const size_t end = numRows * (shardIndex + 1) / numShards;
+    if (begin >= end) return;
 
-            //TODO
-            //updateWeightsFunc();
+    MTR_SCOPE("NeuralNetworkTrainer::Train", "UpdateSparseRows");
+
+    const uint32_t numOutputs = weightsStorage->m_outputSize;
+    const uint32_t numRowsPerVariant = weightsStorage->m_inputSize + 1;
+    float* accumulated = m_perThreadData[threadIdx].accumulatedGradients.data();
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        const uint32_t rowIndex = touchedRows.rows[i];
+        const uint32_t variantIndex = rowIndex / numRowsPerVariant;
+        const uint32_t inputIndex = rowIndex % numRowsPerVariant;
+
+        // sum the row over all threads that touched it
+        std::fill(accumulated, accumulated + numOutputs, 0.0f);
+        for (const PerThreadData& threadData : m_perThreadData)
+        {
+            const Gradients& gradients = threadData.perWeightsStorageGradients[weightsStorageIndex];
+            const float* rowGradients = gradients.m_variants[variantIndex].FindSparseRow(inputIndex);
+            if (!rowGradients) continue;
+
+            uint32_t j = 0;
+#ifdef USE_AVX512
+            for (; j + 16 <= numOutputs; j += 16)
+            {
+                _mm512_storeu_ps(accumulated + j,
+                    _mm512_add_ps(_mm512_loadu_ps(accumulated + j), _mm512_loadu_ps(rowGradients + j)));
+            }
+#endif // USE_AVX512
+#ifdef USE_AVX
+            for (; j + 8 <= numOutputs; j += 8)
+            {
+                _mm256_store_ps(accumulated + j,
+                    _mm256_add_ps(_mm256_load_ps(accumulated + j), _mm256_load_ps(rowGradients + j)));
+            }
+#endif // USE_AVX
+            for (; j < numOutputs; ++j)
+            {
+                accumulated[j] += rowGradients[j];
+            }
         }
+
+        UpdateWeightsRow(*weightsStorage, accumulated, variantIndex, inputIndex, params, iteration);
+
+        touchedRows.isTouched[rowIndex] = 0;
     }
+}
 
-    return numBatches;
+void NeuralNetworkTrainer::UpdateDenseRow(uint32_t weightsStorageIndex, uint32_t inputIndex, const TrainParams& params, size_t iteration)
+{
+    WeightsStorage* weightsStorage = m_weightsStorages[weightsStorageIndex];
+    ASSERT(!weightsStorage->m_isSparse);
+
+    Gradients& gradients = m_perThreadData.front().perWeightsStorageGradients[weightsStorageIndex];
+
+    // accumulate gradients from all per-thread gradients
+    for (size_t threadIdx = 1; threadIdx < m_perThreadData.size(); ++threadIdx)
+    {
+        Gradients& srcGradients = m_perThreadData[threadIdx].perWeightsStorageGradients[weightsStorageIndex];
+        gradients.Accumulate(srcGradients, inputIndex);
+    }
+
+    for (uint32_t variantIndex = 0; variantIndex < gradients.m_variants.size(); ++variantIndex)
+    {
+        const float* rowGradients = gradients.m_variants[variantIndex].m_values.data() + inputIndex * weightsStorage->m_outputSize;
+        UpdateWeightsRow(*weightsStorage, rowGradients, variantIndex, inputIndex, params, iteration);
+    }
 }
 
 void NeuralNetwork::PrintStats() const
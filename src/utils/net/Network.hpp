@@ -126,10 +126,17 @@ public:
     // Calculate neural network output based on input
     const Values& Run(const InputDesc& inputDesc, NeuralNetworkRunContext& ctx) const;
 
+    // Calculate neural network outputs for a group of samples (up to MaxBatchSize)
+    // Nodes are evaluated layer by layer, so each node processes all the samples at once
+    void RunBatch(std::span<const InputDesc* const> inputDescs, std::span<NeuralNetworkRunContext* const> contexts) const;
+
     void PrintStats() const;
 
 private:
 
+    // bind node context to the network input or to the previous nodes outputs
+    void BindNodeInputs(size_t nodeIndex, const InputDesc& inputDesc, NeuralNetworkRunContext& ctx) const;
+
     std::vector<NodePtr> m_nodes;
 };
 
@@ -164,10 +171,23 @@ private:
     {
         std::vector<Gradients*> perNodeGradients;
         std::vector<Gradients>  perWeightsStorageGradients;
-        NeuralNetworkRunContext runContext;
+        std::vector<NeuralNetworkRunContext> runContexts;   // one per sample in a group of MaxBatchSize
+        Values                  accumulatedGradients;   // temporary row used when reducing sparse gradients
+    };
+
+    // union of rows touched by any thread in current batch (sparse weights storages only)
+    struct TouchedRows
+    {
+        std::vector<uint32_t>   rows;       // encoded as variantIndex * (inputSize + 1) + inputIndex
+        std::vector<uint8_t>    isTouched;  // deduplication flags, indexed the same way
     };
 
+    void MergeTouchedRows(uint32_t weightsStorageIndex);
+    void UpdateSparseRows(uint32_t weightsStorageIndex, uint32_t threadIdx, uint32_t shardIndex, uint32_t numShards, const TrainParams& params, size_t iteration);
+    void UpdateDenseRow(uint32_t weightsStorageIndex, uint32_t inputIndex, const TrainParams& params, size_t iteration);
+
     std::vector<WeightsStorage*> m_weightsStorages;
+    std::vector<TouchedRows> m_touchedRows;
     std::vector<PerThreadData> m_perThreadData;
 };
 
@@ -10,4 +10,22 @@ INode::INode(uint32_t numInputs, uint32_t numOutputs)
 {
 }
 
+void INode::RunBatch(std::span<INodeContext* const> contexts) const
+{
+    for (INodeContext* ctx : contexts)
+    {
+        Run(*ctx);
+    }
+}
+
+void INode::BackpropagateBatch(std::span<const Values* const> errors, std::span<INodeContext* const> contexts, Gradients& gradients) const
+{
+    ASSERT(errors.size() == contexts.size());
+
+    for (size_t i = 0; i < contexts.size(); ++i)
+    {
+        Backpropagate(*errors[i], *contexts[i], gradients);
+    }
+}
+
 } // namespace nn
@@ -10,6 +10,9 @@ namespace nn {
 // how many nodes in the network can be input nodes
 static constexpr uint32_t MaxInputNodes = 4;
 
+// max number of samples processed by a single INode::RunBatch/BackpropagateBatch call
+static constexpr uint32_t MaxBatchSize = 16;
+
 struct Gradients;
 
 enum class InputMode : uint8_t
@@ -54,6 +57,11 @@ public:
     virtual void Run(INodeContext& ctx) const = 0;
     virtual void Backpropagate(const Values& error, INodeContext& ctx, Gradients& gradients) const = 0;
 
+    // Run/backpropagate a group of independent samples (one context per sample)
+    // Default implementation processes samples one by one
+    virtual void RunBatch(std::span<INodeContext* const> contexts) const;
+    virtual void BackpropagateBatch(std::span<const Values* const> errors, std::span<INodeContext* const> contexts, Gradients& gradients) const;
+
     virtual bool IsTrainable() const { return false; }
     virtual bool IsInputNode() const { return false; }
     virtual bool IsCombining() const { return false; }
@@ -22,6 +22,42 @@ void SparseBinaryInputNode::Run(INodeContext& ctx) const
     ASSERT(ctx.outputs.size() == m_numOutputs);
     ASSERT(m_numOutputs % (c_NumRegisters * 8) == 0);
 
+#ifdef USE_AVX512
+    if (m_numOutputs % (c_NumRegisters * 16) == 0)
+    {
+        const float* biasesPtr = weights.data() + m_numOutputs * m_numInputs;
+        float* valuesPtr = ctx.outputs.data();
+
+        // split processing into tiles of 8 AVX-512 registers
+        const uint32_t numTiles = m_numOutputs / (c_NumRegisters * 16u);
+
+        __m512 regs[c_NumRegisters];
+
+        for (uint32_t tile = 0; tile < numTiles; ++tile)
+        {
+            const uint32_t chunkBase = tile * (c_NumRegisters * 16u);
+
+            // load biases
+            for (uint32_t i = 0; i < c_NumRegisters; ++i)
+                regs[i] = _mm512_loadu_ps(biasesPtr + chunkBase + i * 16u);
+
+            // accumulate active feature weights
+            for (const IndexType featureIdx : context.sparseInputs)
+            {
+                const float* weightsPtr = weights.data() + featureIdx * m_numOutputs;
+                for (uint32_t i = 0; i < c_NumRegisters; ++i)
+                    regs[i] = _mm512_add_ps(regs[i], _mm512_loadu_ps(weightsPtr + chunkBase + i * 16u));
+            }
+
+            // store results
+            for (uint32_t i = 0; i < c_NumRegisters; ++i)
+                _mm512_storeu_ps(valuesPtr + chunkBase + i * 16u, regs[i]);
+        }
+
+        return;
+    }
+#endif // USE_AVX512
+
 #ifdef USE_AVX
 
     const float* biasesPtr = weights.data() + m_numOutputs * m_numInputs;
@@ -85,9 +121,36 @@ void SparseBinaryInputNode::Backpropagate(const Values& error, INodeContext& ctx
 
     ASSERT(gradients.m_isSparse);
 
+    // allocate gradient rows of active features upfront, so the tile loop below only does lookups
+    for (const IndexType featureIdx : context.sparseInputs)
+    {
+        gradientsVariant.GetSparseRow(featureIdx);
+    }
+
+    uint32_t i = 0;
+
+#ifdef USE_AVX512
+    for (; i + 16 <= m_numOutputs; i += 16u)
+    {
+        const __m512 errorV = _mm512_loadu_ps(error.data() + i);
+
+        // skip tile if error is zero in every lane
+        if (0 == _mm512_cmp_ps_mask(errorV, _mm512_setzero_ps(), _CMP_NEQ_OQ))
+            continue;
+
+        // accumulate error to active feature's gradients
+        for (const IndexType featureIdx : context.sparseInputs)
+        {
+            float* gradientPtr = gradientsVariant.GetTouchedSparseRow(featureIdx);
+            _mm512_storeu_ps(gradientPtr + i,
+                _mm512_add_ps(_mm512_loadu_ps(gradientPtr + i), errorV));
+        }
+    }
+#endif // USE_AVX512
+
 #ifdef USE_AVX
 
-    for (uint32_t i = 0; i < m_numOutputs; i += 8u)
+    for (; i < m_numOutputs; i += 8u)
     {
         // load error into AVX register
         const __m256 errorV = _mm256_load_ps(error.data() + i);
@@ -99,38 +162,40 @@ void SparseBinaryInputNode::Backpropagate(const Values& error, INodeContext& ctx
         // accumulate error to active feature's gradients
         for (const IndexType featureIdx : context.sparseInputs)
         {
-            float* gradientPtr = gradientsVariant.m_values.data() + featureIdx * m_numOutputs;
+            float* gradientPtr = gradientsVariant.GetTouchedSparseRow(featureIdx);
             _mm256_store_ps(gradientPtr + i,
                 _mm256_add_ps(_mm256_load_ps(gradientPtr + i), errorV));
         }
     }
 
-    // mark gradients as dirty
-    for (const IndexType featureIdx : context.sparseInputs)
-    {
-        gradientsVariant.m_dirty[featureIdx] = true;
-    }
-
 #else
 
     // update gradient of active features
     for (const IndexType j : context.sparseInputs)
     {
-        for (size_t i = 0; i < m_numOutputs; i++)
+        float* gradientPtr = gradientsVariant.GetTouchedSparseRow(j);
+        for (i = 0; i < m_numOutputs; i++)
         {
             // not multiplying by input value, because it's equal to 1.0
-            gradientsVariant.m_values[j * m_numOutputs + i] += error[i];
+            gradientPtr[i] += error[i];
         }
-        gradientsVariant.m_dirty[j] = true;
     }
 #endif // USE_AVX
 
 
     // add bias gradient
     {
-        size_t i = 0;
+        float* gradientPtr = gradientsVariant.GetSparseRow(m_numInputs);
+        i = 0;
+#ifdef USE_AVX512
+        for (; i + 16 <= m_numOutputs; i += 16)
+        {
+            _mm512_storeu_ps(gradientPtr + i,
+                _mm512_add_ps(_mm512_loadu_ps(error.data() + i),
+                    _mm512_loadu_ps(gradientPtr + i)));
+        }
+#endif // USE_AVX512
 #ifdef USE_AVX
-        float* gradientPtr = gradientsVariant.m_values.data() + m_numInputs * m_numOutputs;
         for (; i + 8 <= m_numOutputs; i += 8)
         {
             _mm256_store_ps(gradientPtr + i,
@@ -140,10 +205,105 @@ void SparseBinaryInputNode::Backpropagate(const Values& error, INodeContext& ctx
 #endif // USE_AVX
         for (; i < m_numOutputs; i++)
         {
-            gradientsVariant.m_values[m_numInputs * m_numOutputs + i] += error[i];
+            gradientPtr[i] += error[i];
         }
-        gradientsVariant.m_dirty[m_numInputs] = true;
     }
 }
 
+void SparseBinaryInputNode::BackpropagateBatch(std::span<const Values* const> errors, std::span<INodeContext* const> contexts, Gradients& gradients) const
+{
+    ASSERT(errors.size() == contexts.size());
+    ASSERT(gradients.m_isSparse);
+
+#ifdef USE_AVX
+
+    ForEachVariant(contexts, [&](uint32_t variantIndex, std::span<const uint32_t> samples)
+    {
+        Gradients::Variant& gradientsVariant = gradients.m_variants[variantIndex];
+
+        float* biasGradientPtr = gradientsVariant.GetSparseRow(m_numInputs);
+
+        for (const uint32_t s : samples)
+        {
+            const Context& context = static_cast<const Context&>(*contexts[s]);
+            const float* errorPtr = errors[s]->data();
+
+            // allocate gradient rows of active features upfront, so the tile loop below only does lookups
+            for (const IndexType featureIdx : context.sparseInputs)
+            {
+                gradientsVariant.GetSparseRow(featureIdx);
+            }
+
+            uint32_t i = 0;
+
+#ifdef USE_AVX512
+            for (; i + 16 <= m_numOutputs; i += 16u)
+            {
+                const __m512 errorV = _mm512_loadu_ps(errorPtr + i);
+
+                // skip tile if error is zero in every lane
+                if (0 == _mm512_cmp_ps_mask(errorV, _mm512_setzero_ps(), _CMP_NEQ_OQ))
+                    continue;
+
+                // accumulate error to active feature's gradients
+                for (const IndexType featureIdx : context.sparseInputs)
+                {
+                    float* gradientPtr = gradientsVariant.GetTouchedSparseRow(featureIdx);
+                    _mm512_storeu_ps(gradientPtr + i,
+                        _mm512_add_ps(_mm512_loadu_ps(gradientPtr + i), errorV));
+                }
+            }
+#endif // USE_AVX512
+
+            for (; i < m_numOutputs; i += 8u)
+            {
+                const __m256 errorV = _mm256_load_ps(errorPtr + i);
+
+                // skip tile if error is zero in every lane
+                if (0xFF == _mm256_movemask_ps(_mm256_cmp_ps(errorV, _mm256_setzero_ps(), _CMP_EQ_OQ)))
+                    continue;
+
+                // accumulate error to active feature's gradients
+                for (const IndexType featureIdx : context.sparseInputs)
+                {
+                    float* gradientPtr = gradientsVariant.GetTouchedSparseRow(featureIdx);
+                    _mm256_store_ps(gradientPtr + i,
+                        _mm256_add_ps(_mm256_load_ps(gradientPtr + i), errorV));
+                }
+            }
+        }
+
+        // add bias gradient, summed over the whole batch
+        uint32_t i = 0;
+
+#ifdef USE_AVX512
+        for (; i + 16 <= m_numOutputs; i += 16u)
+        {
+            __m512 biasErrorV = _mm512_loadu_ps(biasGradientPtr + i);
+            for (const uint32_t s : samples)
+            {
+                biasErrorV = _mm512_add_ps(biasErrorV, _mm512_loadu_ps(errors[s]->data() + i));
+            }
+            _mm512_storeu_ps(biasGradientPtr + i, biasErrorV);
+        }
+#endif // USE_AVX512
+
+        for (; i < m_numOutputs; i += 8u)
+        {
+            __m256 biasErrorV = _mm256_load_ps(biasGradientPtr + i);
+            for (const uint32_t s : samples)
+            {
+                biasErrorV = _mm256_add_ps(biasErrorV, _mm256_load_ps(errors[s]->data() + i));
+            }
+            _mm256_store_ps(biasGradientPtr + i, biasErrorV);
+        }
+    });
+
+#else
+
+    INode::BackpropagateBatch(errors, contexts, gradients);
+
+#endif // USE_AVX
+}
+
 } // namespace nn
@@ -27,6 +27,7 @@ public:
 
     void Run(INodeContext& ctx) const override;
     void Backpropagate(const Values& error, INodeContext& ctx, Gradients& gradients) const override;
+    void BackpropagateBatch(std::span<const Values* const> errors, std::span<INodeContext* const> contexts, Gradients& gradients) const override;
     virtual InputMode GetInputMode() const override { return InputMode::SparseBinary; }
     virtual bool IsInputNode() const override { return true; }
 };
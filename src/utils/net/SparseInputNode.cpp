@@ -28,10 +28,24 @@ void SparseInputNode::Run(INodeContext& ctx) const
 
         size_t i = 0;
 
-#ifdef USE_AVX
-        const __m256 vInputValue = _mm256_set1_ps(feature.value);
         const float* weightsPtr = weights.data() + feature.index * m_numOutputs;
         float* valuesPtr = ctx.outputs.data();
+
+#ifdef USE_AVX512
+        {
+            const __m512 vInputValue = _mm512_set1_ps(feature.value);
+            for (; i + 16 <= m_numOutputs; i += 16)
+            {
+                _mm512_storeu_ps(valuesPtr + i,
+                                 _mm512_fmadd_ps(vInputValue,
+                                                 _mm512_loadu_ps(weightsPtr + i),
+                                                 _mm512_loadu_ps(valuesPtr + i)));
+            }
+        }
+#endif // USE_AVX512
+
+#ifdef USE_AVX
+        const __m256 vInputValue = _mm256_set1_ps(feature.value);
         for (; i + 8 <= m_numOutputs; i += 8)
         {
             _mm256_store_ps(valuesPtr + i,
@@ -43,7 +57,7 @@ void SparseInputNode::Run(INodeContext& ctx) const
 
         for (; i < m_numOutputs; i++)
         {
-            ctx.outputs[i] += weights[feature.index * m_numOutputs + i] * feature.value;
+            valuesPtr[i] += weightsPtr[i] * feature.value;
         }
     }
 }
@@ -61,9 +75,19 @@ void SparseInputNode::Backpropagate(const Values& error, INodeContext& ctx, Grad
     // update gradient of active features
     for (const ActiveFeature& feature : context.sparseInputs)
     {
+        float* gradientPtr = gradientsVariant.GetSparseRow(feature.index);
         size_t i = 0;
+#ifdef USE_AVX512
+        {
+            const __m512 vInputValue = _mm512_set1_ps(feature.value);
+            for (; i + 16 <= m_numOutputs; i += 16)
+            {
+                _mm512_storeu_ps(gradientPtr + i,
+                    _mm512_fmadd_ps(vInputValue, _mm512_loadu_ps(error.data() + i), _mm512_loadu_ps(gradientPtr + i)));
+            }
+        }
+#endif // USE_AVX512
 #ifdef USE_AVX
-        float* gradientPtr = gradientsVariant.m_values.data() + feature.index * m_numOutputs;
         const __m256 vInputValue = _mm256_set1_ps(feature.value);
         for (; i + 8 <= m_numOutputs; i += 8)
         {
@@ -73,16 +97,23 @@ void SparseInputNode::Backpropagate(const Values& error, INodeContext& ctx, Grad
 #endif // USE_AVX
         for (; i < m_numOutputs; i++)
         {
-            gradientsVariant.m_values[feature.index * m_numOutputs + i] += feature.value * error[i];
+            gradientPtr[i] += feature.value * error[i];
         }
-        gradientsVariant.m_dirty[feature.index] = true;
     }
 
     // add bias gradient
     {
+        float* gradientPtr = gradientsVariant.GetSparseRow(m_numInputs);
         size_t i = 0;
+#ifdef USE_AVX512
+        for (; i + 16 <= m_numOutputs; i += 16)
+        {
+            _mm512_storeu_ps(gradientPtr + i,
+                _mm512_add_ps(_mm512_loadu_ps(error.data() + i),
+                    _mm512_loadu_ps(gradientPtr + i)));
+        }
+#endif // USE_AVX512
 #ifdef USE_AVX
-        float* gradientPtr = gradientsVariant.m_values.data() + m_numInputs * m_numOutputs;
         for (; i + 8 <= m_numOutputs; i += 8)
         {
             _mm256_store_ps(gradientPtr + i,
@@ -92,9 +123,8 @@ void SparseInputNode::Backpropagate(const Values& error, INodeContext& ctx, Grad
 #endif // USE_AVX
         for (; i < m_numOutputs; i++)
         {
-            gradientsVariant.m_values[m_numInputs * m_numOutputs + i] += error[i];
+            gradientPtr[i] += error[i];
         }
-        gradientsVariant.m_dirty[m_numInputs] = true;
     }
 }
 
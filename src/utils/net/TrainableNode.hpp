@@ -20,6 +20,41 @@ public:
     WeightsStorage* GetWeightsStorage() const { return m_weightsStorage.get(); }
 
 protected:
+
+    // split a batch into groups of samples sharing the same weights variant
+    // and call func(variantIndex, sampleIndices) for each group
+    template<typename Func>
+    void ForEachVariant(std::span<INodeContext* const> contexts, const Func& func) const
+    {
+        ASSERT(contexts.size() <= MaxBatchSize);
+        ASSERT(!m_weightsStorage->m_variants.empty());
+
+        uint32_t variantIndices[MaxBatchSize];
+        for (size_t i = 0; i < contexts.size(); ++i)
+        {
+            variantIndices[i] = std::min<uint32_t>(contexts[i]->variant, (uint32_t)m_weightsStorage->m_variants.size() - 1);
+        }
+
+        uint32_t processedMask = 0;
+        for (uint32_t i = 0; i < contexts.size(); ++i)
+        {
+            if (processedMask & (1u << i)) continue;
+
+            uint32_t sampleIndices[MaxBatchSize];
+            uint32_t numSamples = 0;
+            for (uint32_t j = i; j < contexts.size(); ++j)
+            {
+                if (variantIndices[j] == variantIndices[i])
+                {
+                    sampleIndices[numSamples++] = j;
+                    processedMask |= 1u << j;
+                }
+            }
+
+            func(variantIndices[i], std::span<const uint32_t>(sampleIndices, numSamples));
+        }
+    }
+
     WeightsStoragePtr m_weightsStorage;
     NodePtr m_previousNode;
 };
@@ -1,5 +1,4 @@
 #include "WeightsStorage.hpp"
-#include "Gradient.hpp"
 #include "../minitrace/minitrace.h"
 
 #include <algorithm>
@@ -66,216 +65,295 @@ void WeightsStorage::Init(uint32_t numActiveNeurons, float bias)
     }
 }
 
-void WeightsStorage::Update_Adadelta(const Gradients& gradients, uint32_t inputIndex, const WeightsUpdateOptions& options)
+void WeightsStorage::Update_Adadelta(const float* gradients, uint32_t variantIndex, uint32_t inputIndex, const WeightsUpdateOptions& options)
 {
     ASSERT(inputIndex <= m_inputSize);
-    ASSERT(gradients.m_numInputs == m_inputSize);
-    ASSERT(gradients.m_numOutputs == m_outputSize);
-    ASSERT(gradients.m_variants.size() == m_variants.size());
+    ASSERT(variantIndex < m_variants.size());
 
-    for (size_t variantIndex = 0; variantIndex < m_variants.size(); ++variantIndex)
-    {
-        Variant& variant = m_variants[variantIndex];
-        const Gradients::Variant& gradientsVariant = gradients.m_variants[variantIndex];
-
-        ASSERT(gradientsVariant.m_values.size() == (m_inputSize + 1) * m_outputSize);
+    Variant& variant = m_variants[variantIndex];
 
-        const float cRho = 0.95f;
-        const float cEpsilon = 1.0e-8f;
+    const float cRho = 0.95f;
+    const float cEpsilon = 1.0e-8f;
 
 #ifdef USE_AVX
-        const __m256 cOneMinusRhoVec = _mm256_set1_ps(1.0f - cRho);
-        const __m256 cRhoVec = _mm256_set1_ps(cRho);
-        const __m256 cEpsilonVec = _mm256_set1_ps(cEpsilon);
-        const __m256 gradientScaleVec = _mm256_set1_ps(options.gradientScale);
+    const __m256 cOneMinusRhoVec = _mm256_set1_ps(1.0f - cRho);
+    const __m256 cRhoVec = _mm256_set1_ps(cRho);
+    const __m256 cEpsilonVec = _mm256_set1_ps(cEpsilon);
+    const __m256 gradientScaleVec = _mm256_set1_ps(options.gradientScale);
 #endif
 
-        {
-            const float maxWeightValue = inputIndex < m_inputSize ? m_weightsRange : m_biasRange;
+    {
+        const float maxWeightValue = inputIndex < m_inputSize ? m_weightsRange : m_biasRange;
 
-            size_t i = 0;
+        size_t i = 0;
 
-#ifdef USE_AVX
-            const __m256 minValueV = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_set1_ps(maxWeightValue));
-            const __m256 maxValueV = _mm256_set1_ps(maxWeightValue);
-            for (; i + 8 <= m_outputSize; i += 8)
+#ifdef USE_AVX512
+        {
+            const __m512 cOneMinusRhoVec = _mm512_set1_ps(1.0f - cRho);
+            const __m512 cRhoVec = _mm512_set1_ps(cRho);
+            const __m512 cEpsilonVec = _mm512_set1_ps(cEpsilon);
+            const __m512 gradientScaleVec = _mm512_set1_ps(options.gradientScale);
+            const __m512 minValueV = _mm512_set1_ps(-maxWeightValue);
+            const __m512 maxValueV = _mm512_set1_ps(maxWeightValue);
+            for (; i + 16 <= m_outputSize; i += 16)
             {
                 float* mPtr = variant.m_gradientMoment1.data() + inputIndex * m_outputSize + i;
                 float* vPtr = variant.m_gradientMoment2.data() + inputIndex * m_outputSize + i;
                 float* wPtr = variant.m_weights.data() + inputIndex * m_outputSize + i;
-                float* wMaskPtr = m_weightsMask.data() + inputIndex * m_outputSize + i;
-                const float* gPtr = gradientsVariant.m_values.data() + inputIndex * m_outputSize + i;
+                const float* wMaskPtr = m_weightsMask.data() + inputIndex * m_outputSize + i;
+                const float* gPtr = gradients + i;
 
-                __m256 g = _mm256_mul_ps(gradientScaleVec, _mm256_load_ps(gPtr));
-                __m256 v = _mm256_load_ps(vPtr);
-                __m256 m = _mm256_load_ps(mPtr);
-                __m256 w = _mm256_load_ps(wPtr);
-                const __m256 wMask = _mm256_load_ps(wMaskPtr);
+                __m512 g = _mm512_mul_ps(gradientScaleVec, _mm512_loadu_ps(gPtr));
+                __m512 v = _mm512_loadu_ps(vPtr);
+                __m512 m = _mm512_loadu_ps(mPtr);
+                __m512 w = _mm512_loadu_ps(wPtr);
+                const __m512 wMask = _mm512_loadu_ps(wMaskPtr);
 
                 // weight decay
-                g = _mm256_fmadd_ps(w, _mm256_set1_ps(options.weightDecay), g);
+                g = _mm512_fmadd_ps(w, _mm512_set1_ps(options.weightDecay), g);
 
                 // ADADELTA algorithm
-                m = _mm256_fmadd_ps(cOneMinusRhoVec, _mm256_mul_ps(g, g), _mm256_mul_ps(cRhoVec, m));
-                __m256 delta = _mm256_mul_ps(g, _mm256_sqrt_ps(_mm256_div_ps(_mm256_add_ps(v, cEpsilonVec), _mm256_add_ps(m, cEpsilonVec))));
-                v = _mm256_fmadd_ps(cOneMinusRhoVec, _mm256_mul_ps(delta, delta), _mm256_mul_ps(cRhoVec, v));
-                delta = _mm256_mul_ps(wMask, delta);
-                w = _mm256_fnmadd_ps(delta, _mm256_set1_ps(options.learningRate), w);
+                m = _mm512_fmadd_ps(cOneMinusRhoVec, _mm512_mul_ps(g, g), _mm512_mul_ps(cRhoVec, m));
+                __m512 delta = _mm512_mul_ps(g, _mm512_sqrt_ps(_mm512_div_ps(_mm512_add_ps(v, cEpsilonVec), _mm512_add_ps(m, cEpsilonVec))));
+                v = _mm512_fmadd_ps(cOneMinusRhoVec, _mm512_mul_ps(delta, delta), _mm512_mul_ps(cRhoVec, v));
+                delta = _mm512_mul_ps(wMask, delta);
+                w = _mm512_fnmadd_ps(delta, _mm512_set1_ps(options.learningRate), w);
 
                 // clamping
-                w = _mm256_min_ps(w, maxValueV);
-                w = _mm256_max_ps(w, minValueV);
+                w = _mm512_min_ps(w, maxValueV);
+                w = _mm512_max_ps(w, minValueV);
 
-                _mm256_store_ps(vPtr, v);
-                _mm256_store_ps(mPtr, m);
-                _mm256_store_ps(wPtr, w);
+                _mm512_storeu_ps(vPtr, v);
+                _mm512_storeu_ps(mPtr, m);
+                _mm512_storeu_ps(wPtr, w);
             }
+        }
+#endif // USE_AVX512
+
+#ifdef USE_AVX
+        const __m256 minValueV = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_set1_ps(maxWeightValue));
+        const __m256 maxValueV = _mm256_set1_ps(maxWeightValue);
+        for (; i + 8 <= m_outputSize; i += 8)
+        {
+            float* mPtr = variant.m_gradientMoment1.data() + inputIndex * m_outputSize + i;
+            float* vPtr = variant.m_gradientMoment2.data() + inputIndex * m_outputSize + i;
+            float* wPtr = variant.m_weights.data() + inputIndex * m_outputSize + i;
+            float* wMaskPtr = m_weightsMask.data() + inputIndex * m_outputSize + i;
+            const float* gPtr = gradients + i;
+
+            __m256 g = _mm256_mul_ps(gradientScaleVec, _mm256_load_ps(gPtr));
+            __m256 v = _mm256_load_ps(vPtr);
+            __m256 m = _mm256_load_ps(mPtr);
+            __m256 w = _mm256_load_ps(wPtr);
+            const __m256 wMask = _mm256_load_ps(wMaskPtr);
+
+            // weight decay
+            g = _mm256_fmadd_ps(w, _mm256_set1_ps(options.weightDecay), g);
+
+            // ADADELTA algorithm
+            m = _mm256_fmadd_ps(cOneMinusRhoVec, _mm256_mul_ps(g, g), _mm256_mul_ps(cRhoVec, m));
+            __m256 delta = _mm256_mul_ps(g, _mm256_sqrt_ps(_mm256_div_ps(_mm256_add_ps(v, cEpsilonVec), _mm256_add_ps(m, cEpsilonVec))));
+            v = _mm256_fmadd_ps(cOneMinusRhoVec, _mm256_mul_ps(delta, delta), _mm256_mul_ps(cRhoVec, v));
+            delta = _mm256_mul_ps(wMask, delta);
+            w = _mm256_fnmadd_ps(delta, _mm256_set1_ps(options.learningRate), w);
+
+            // clamping
+            w = _mm256_min_ps(w, maxValueV);
+            w = _mm256_max_ps(w, minValueV);
+
+            _mm256_store_ps(vPtr, v);
+            _mm256_store_ps(mPtr, m);
+            _mm256_store_ps(wPtr, w);
+        }
 #endif // USE_AVX
 
-            for (; i < m_outputSize; ++i)
-            {
-                float& m = variant.m_gradientMoment1[inputIndex * m_outputSize + i];
-                float& v = variant.m_gradientMoment2[inputIndex * m_outputSize + i];
-                float& w = variant.m_weights[inputIndex * m_outputSize + i];
-                const float& wMask = m_weightsMask[inputIndex * m_outputSize + i];
-                float g = options.gradientScale * gradientsVariant.m_values[inputIndex * m_outputSize + i];
+        for (; i < m_outputSize; ++i)
+        {
+            float& m = variant.m_gradientMoment1[inputIndex * m_outputSize + i];
+            float& v = variant.m_gradientMoment2[inputIndex * m_outputSize + i];
+            float& w = variant.m_weights[inputIndex * m_outputSize + i];
+            const float& wMask = m_weightsMask[inputIndex * m_outputSize + i];
+            float g = options.gradientScale * gradients[i];
 
-                ASSERT(!std::isnan(g));
-                ASSERT(v >= 0.0f);
-                ASSERT(m >= 0.0f);
+            ASSERT(!std::isnan(g));
+            ASSERT(v >= 0.0f);
+            ASSERT(m >= 0.0f);
 
-                // weight decay
-                g += w * options.weightDecay;
+            // weight decay
+            g += w * options.weightDecay;
 
-                // ADADELTA algorithm
-                m = cRho * m + (1.0f - cRho) * g * g;
-                ASSERT(!std::isnan(m));
+            // ADADELTA algorithm
+            m = cRho * m + (1.0f - cRho) * g * g;
+            ASSERT(!std::isnan(m));
 
-                const float delta = g * sqrtf((v + cEpsilon) / (m + cEpsilon));
-                v = cRho * v + (1.0f - cRho) * delta * delta;
-                ASSERT(!std::isnan(v));
+            const float delta = g * sqrtf((v + cEpsilon) / (m + cEpsilon));
+            v = cRho * v + (1.0f - cRho) * delta * delta;
+            ASSERT(!std::isnan(v));
 
-                w -= wMask * options.learningRate * delta;
-                ASSERT(!std::isnan(w));
+            w -= wMask * options.learningRate * delta;
+            ASSERT(!std::isnan(w));
 
-                // clamping
-                w = std::clamp(w, -maxWeightValue, maxWeightValue);
-            }
+            // clamping
+            w = std::clamp(w, -maxWeightValue, maxWeightValue);
         }
     }
 }
 
-void WeightsStorage::Update_Adam(const Gradients& gradients, uint32_t inputIndex, const WeightsUpdateOptions& options)
+void WeightsStorage::Update_Adam(const float* gradients, uint32_t variantIndex, uint32_t inputIndex, const WeightsUpdateOptions& options)
 {
-    ASSERT(gradients.m_numInputs == m_inputSize);
-    ASSERT(gradients.m_numOutputs == m_outputSize);
-    ASSERT(gradients.m_variants.size() == m_variants.size());
-
-    for (size_t variantIndex = 0; variantIndex < m_variants.size(); ++variantIndex)
-    {
-        Variant& variant = m_variants[variantIndex];
-        const Gradients::Variant& gradientsVariant = gradients.m_variants[variantIndex];
+    ASSERT(inputIndex <= m_inputSize);
+    ASSERT(variantIndex < m_variants.size());
 
-        ASSERT(gradientsVariant.m_values.size() == (m_inputSize + 1) * m_outputSize);
+    Variant& variant = m_variants[variantIndex];
 
-        const float cBeta1 = 0.9f;
-        const float cBeta2 = 0.999f;
-        const float cEpsilon = 1.0e-8f;
+    const float cBeta1 = 0.9f;
+    const float cBeta2 = 0.999f;
+    const float cEpsilon = 1.0e-8f;
 
-        const float cIter = (float)(options.iteration + 1);
-        const float cBeta1Mult = 1.0f / (1.0f - powf(cBeta1, cIter));
-        const float cBeta2Mult = 1.0f / (1.0f - powf(cBeta2, cIter));
+    const float cIter = (float)(options.iteration + 1);
+    const float cBeta1Mult = 1.0f / (1.0f - powf(cBeta1, cIter));
+    const float cBeta2Mult = 1.0f / (1.0f - powf(cBeta2, cIter));
 
 #ifdef USE_AVX
-        const __m256 cOneMinusBeta1Vec = _mm256_set1_ps(1.0f - cBeta1);
-        const __m256 cBeta1Vec = _mm256_set1_ps(cBeta1);
-        const __m256 cOneMinusBeta2Vec = _mm256_set1_ps(1.0f - cBeta2);
-        const __m256 cBeta2Vec = _mm256_set1_ps(cBeta2);
-        const __m256 cEpsilonVec = _mm256_set1_ps(cEpsilon);
-        const __m256 gradientScaleVec = _mm256_set1_ps(options.gradientScale);
+    const __m256 cOneMinusBeta1Vec = _mm256_set1_ps(1.0f - cBeta1);
+    const __m256 cBeta1Vec = _mm256_set1_ps(cBeta1);
+    const __m256 cOneMinusBeta2Vec = _mm256_set1_ps(1.0f - cBeta2);
+    const __m256 cBeta2Vec = _mm256_set1_ps(cBeta2);
+    const __m256 cEpsilonVec = _mm256_set1_ps(cEpsilon);
+    const __m256 gradientScaleVec = _mm256_set1_ps(options.gradientScale);
 #endif
 
-        {
-            const float maxWeightValue = inputIndex < m_inputSize ? m_weightsRange : m_biasRange;
+    {
+        const float maxWeightValue = inputIndex < m_inputSize ? m_weightsRange : m_biasRange;
 
-            size_t i = 0;
+        size_t i = 0;
 
-#ifdef USE_AVX
-            const __m256 minValueV = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_set1_ps(maxWeightValue));
-            const __m256 maxValueV = _mm256_set1_ps(maxWeightValue);
-            for (; i + 8 <= m_outputSize; i += 8)
+#ifdef USE_AVX512
+        {
+            const __m512 cOneMinusBeta1Vec = _mm512_set1_ps(1.0f - cBeta1);
+            const __m512 cBeta1Vec = _mm512_set1_ps(cBeta1);
+            const __m512 cOneMinusBeta2Vec = _mm512_set1_ps(1.0f - cBeta2);
+            const __m512 cBeta2Vec = _mm512_set1_ps(cBeta2);
+            const __m512 cEpsilonVec = _mm512_set1_ps(cEpsilon);
+            const __m512 gradientScaleVec = _mm512_set1_ps(options.gradientScale);
+            const __m512 minValueV = _mm512_set1_ps(-maxWeightValue);
+            const __m512 maxValueV = _mm512_set1_ps(maxWeightValue);
+            for (; i + 16 <= m_outputSize; i += 16)
             {
                 float* mPtr = variant.m_gradientMoment1.data() + inputIndex * m_outputSize + i;
                 float* vPtr = variant.m_gradientMoment2.data() + inputIndex * m_outputSize + i;
                 float* wPtr = variant.m_weights.data() + inputIndex * m_outputSize + i;
-                float* wMaskPtr = m_weightsMask.data() + inputIndex * m_outputSize + i;
-                const float* gPtr = gradientsVariant.m_values.data() + inputIndex * m_outputSize + i;
+                const float* wMaskPtr = m_weightsMask.data() + inputIndex * m_outputSize + i;
+                const float* gPtr = gradients + i;
 
-                __m256 g = _mm256_mul_ps(gradientScaleVec, _mm256_load_ps(gPtr));
-                __m256 v = _mm256_load_ps(vPtr);
-                __m256 m = _mm256_load_ps(mPtr);
-                __m256 w = _mm256_load_ps(wPtr);
-                const __m256 wMask = _mm256_load_ps(wMaskPtr);
+                const __m512 g = _mm512_mul_ps(gradientScaleVec, _mm512_loadu_ps(gPtr));
+                __m512 v = _mm512_loadu_ps(vPtr);
+                __m512 m = _mm512_loadu_ps(mPtr);
+                __m512 w = _mm512_loadu_ps(wPtr);
+                const __m512 wMask = _mm512_loadu_ps(wMaskPtr);
 
                 // update biased first moment estimate
-                m = _mm256_fmadd_ps(cOneMinusBeta1Vec, g, _mm256_mul_ps(cBeta1Vec, m));
+                m = _mm512_fmadd_ps(cOneMinusBeta1Vec, g, _mm512_mul_ps(cBeta1Vec, m));
 
                 // update biased second moment estimate
-                v = _mm256_fmadd_ps(cOneMinusBeta2Vec, _mm256_mul_ps(g, g), _mm256_mul_ps(cBeta2Vec, v));
+                v = _mm512_fmadd_ps(cOneMinusBeta2Vec, _mm512_mul_ps(g, g), _mm512_mul_ps(cBeta2Vec, v));
 
                 // compute bias-corrected moment estimates
-                const __m256 m_hat = _mm256_mul_ps(m, _mm256_set1_ps(cBeta1Mult));
-                const __m256 v_hat = _mm256_mul_ps(v, _mm256_set1_ps(cBeta2Mult));
+                const __m512 m_hat = _mm512_mul_ps(m, _mm512_set1_ps(cBeta1Mult));
+                const __m512 v_hat = _mm512_mul_ps(v, _mm512_set1_ps(cBeta2Mult));
 
                 // compute final weight change
-                __m256 delta = _mm256_div_ps(m_hat, _mm256_add_ps(cEpsilonVec, _mm256_sqrt_ps(v_hat)));
-                delta = _mm256_fmadd_ps(w, _mm256_set1_ps(options.weightDecay), delta); // weight decay
-                delta = _mm256_mul_ps(wMask, delta);
-                w = _mm256_fnmadd_ps(delta, _mm256_set1_ps(options.learningRate), w);
+                __m512 delta = _mm512_div_ps(m_hat, _mm512_add_ps(cEpsilonVec, _mm512_sqrt_ps(v_hat)));
+                delta = _mm512_fmadd_ps(w, _mm512_set1_ps(options.weightDecay), delta); // weight decay
+                delta = _mm512_mul_ps(wMask, delta);
+                w = _mm512_fnmadd_ps(delta, _mm512_set1_ps(options.learningRate), w);
 
                 // clamping
-                w = _mm256_min_ps(w, maxValueV);
-                w = _mm256_max_ps(w, minValueV);
+                w = _mm512_min_ps(w, maxValueV);
+                w = _mm512_max_ps(w, minValueV);
 
-                _mm256_store_ps(vPtr, v);
-                _mm256_store_ps(mPtr, m);
-                _mm256_store_ps(wPtr, w);
+                _mm512_storeu_ps(vPtr, v);
+                _mm512_storeu_ps(mPtr, m);
+                _mm512_storeu_ps(wPtr, w);
             }
+        }
+#endif // USE_AVX512
+
+#ifdef USE_AVX
+        const __m256 minValueV = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_set1_ps(maxWeightValue));
+        const __m256 maxValueV = _mm256_set1_ps(maxWeightValue);
+        for (; i + 8 <= m_outputSize; i += 8)
+        {
+            float* mPtr = variant.m_gradientMoment1.data() + inputIndex * m_outputSize + i;
+            float* vPtr = variant.m_gradientMoment2.data() + inputIndex * m_outputSize + i;
+            float* wPtr = variant.m_weights.data() + inputIndex * m_outputSize + i;
+            float* wMaskPtr = m_weightsMask.data() + inputIndex * m_outputSize + i;
+            const float* gPtr = gradients + i;
+
+            __m256 g = _mm256_mul_ps(gradientScaleVec, _mm256_load_ps(gPtr));
+            __m256 v = _mm256_load_ps(vPtr);
+            __m256 m = _mm256_load_ps(mPtr);
+            __m256 w = _mm256_load_ps(wPtr);
+            const __m256 wMask = _mm256_load_ps(wMaskPtr);
+
+            // update biased first moment estimate
+            m = _mm256_fmadd_ps(cOneMinusBeta1Vec, g, _mm256_mul_ps(cBeta1Vec, m));
+
+            // update biased second moment estimate
+            v = _mm256_fmadd_ps(cOneMinusBeta2Vec, _mm256_mul_ps(g, g), _mm256_mul_ps(cBeta2Vec, v));
+
+            // compute bias-corrected moment estimates
+            const __m256 m_hat = _mm256_mul_ps(m, _mm256_set1_ps(cBeta1Mult));
+            const __m256 v_hat = _mm256_mul_ps(v, _mm256_set1_ps(cBeta2Mult));
+
+            // compute final weight change
+            __m256 delta = _mm256_div_ps(m_hat, _mm256_add_ps(cEpsilonVec, _mm256_sqrt_ps(v_hat)));
+            delta = _mm256_fmadd_ps(w, _mm256_set1_ps(options.weightDecay), delta); // weight decay
+            delta = _mm256_mul_ps(wMask, delta);
+            w = _mm256_fnmadd_ps(delta, _mm256_set1_ps(options.learningRate), w);
+
+            // clamping
+            w = _mm256_min_ps(w, maxValueV);
+            w = _mm256_max_ps(w, minValueV);
+
+            _mm256_store_ps(vPtr, v);
+            _mm256_store_ps(mPtr, m);
+            _mm256_store_ps(wPtr, w);
+        }
 #endif // USE_AVX
 
-            for (; i < m_outputSize; ++i)
-            {
-                float& m = variant.m_gradientMoment1[inputIndex * m_outputSize + i];
-                float& v = variant.m_gradientMoment2[inputIndex * m_outputSize + i];
-                float& w = variant.m_weights[inputIndex * m_outputSize + i];
-                const float wMask = m_weightsMask[inputIndex * m_outputSize + i];
-                float g = options.gradientScale * gradientsVariant.m_values[inputIndex * m_outputSize + i];
+        for (; i < m_outputSize; ++i)
+        {
+            float& m = variant.m_gradientMoment1[inputIndex * m_outputSize + i];
+            float& v = variant.m_gradientMoment2[inputIndex * m_outputSize + i];
+            float& w = variant.m_weights[inputIndex * m_outputSize + i];
+            const float wMask = m_weightsMask[inputIndex * m_outputSize + i];
+            float g = options.gradientScale * gradients[i];
 
-                ASSERT(!std::isnan(g));
-                ASSERT(v >= 0.0f);
+            ASSERT(!std::isnan(g));
+            ASSERT(v >= 0.0f);
 
-                // update biased first moment estimate
-                m = cBeta1 * m + (1.0f - cBeta1) * g;
-                ASSERT(!std::isnan(m));
+            // update biased first moment estimate
+            m = cBeta1 * m + (1.0f - cBeta1) * g;
+            ASSERT(!std::isnan(m));
 
-                // update biased second moment estimate
-                v = cBeta2 * v + (1.0f - cBeta2) * g * g;
-                ASSERT(!std::isnan(v));
+            // update biased second moment estimate
+            v = cBeta2 * v + (1.0f - cBeta2) * g * g;
+            ASSERT(!std::isnan(v));
 
-                // compute bias-corrected moment estimates
-                const float m_hat = m * cBeta1Mult;
-                const float v_hat = v * cBeta2Mult;
+            // compute bias-corrected moment estimates
+            const float m_hat = m * cBeta1Mult;
+            const float v_hat = v * cBeta2Mult;
 
-                // compute final weight change
-                const float delta = options.learningRate * (m_hat / (cEpsilon + sqrtf(v_hat)) + w * options.weightDecay);
-                ASSERT(!std::isnan(delta));
+            // compute final weight change
+            const float delta = options.learningRate * (m_hat / (cEpsilon + sqrtf(v_hat)) + w * options.weightDecay);
+            ASSERT(!std::isnan(delta));
 
-                w -= wMask * delta;
-                ASSERT(!std::isnan(w));
+            w -= wMask * delta;
+            ASSERT(!std::isnan(w));
 
-                // clamping
-                w = std::clamp(w, -maxWeightValue, maxWeightValue);
-            }
+            // clamping
+            w = std::clamp(w, -maxWeightValue, maxWeightValue);
         }
     }
 }
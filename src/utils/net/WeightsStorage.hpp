@@ -4,8 +4,6 @@
 
 namespace nn {
 
-struct Gradients;
-
 struct WeightsStorage
 {
 public:
@@ -21,8 +19,10 @@ public:
         size_t iteration = 0;
     };
 
-    void Update_Adadelta(const Gradients& gradients, uint32_t inputIndex, const WeightsUpdateOptions& options);
-    void Update_Adam(const Gradients& gradients, uint32_t inputIndex, const WeightsUpdateOptions& options);
+    // update single row of weights of given variant
+    // 'gradients' points to accumulated gradients row (m_outputSize elements)
+    void Update_Adadelta(const float* gradients, uint32_t variantIndex, uint32_t inputIndex, const WeightsUpdateOptions& options);
+    void Update_Adam(const float* gradients, uint32_t variantIndex, uint32_t inputIndex, const WeightsUpdateOptions& options);
 
     uint32_t m_inputSize = 0;
     uint32_t m_outputSize = 0;